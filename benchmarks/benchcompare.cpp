@@ -0,0 +1,140 @@
+#include "json.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+
+// mm3d_bench_compare <baseline.json> <current.json> [--threshold <percent>] [--metric median|min|mean]
+// Compares two mm3d_bench result files and exits with 1 when a benchmark got slower than the threshold allows
+namespace
+{
+	struct Measurement
+	{
+		double value = 0.0; // nanoseconds per iteration of the chosen metric
+		double stddev = 0.0;
+	};
+
+	bool LoadResults(const std::string& path, const std::string& metric, std::map<std::string, Measurement>& results)
+	{
+		std::ifstream in(path, std::ios::binary);
+		if (!in)
+		{
+			fprintf(stderr, "Could not open %s\n", path.c_str());
+			return false;
+		}
+		std::stringstream text;
+		text << in.rdbuf();
+
+		JsonValue root;
+		std::string error;
+		if (!ParseJson(text.str(), root, &error))
+		{
+			fprintf(stderr, "Could not parse %s: %s\n", path.c_str(), error.c_str());
+			return false;
+		}
+		const JsonValue* benchmarks = root.Find("benchmarks");
+		if (!benchmarks || !benchmarks->IsArray())
+		{
+			fprintf(stderr, "%s has no benchmarks\n", path.c_str());
+			return false;
+		}
+
+		std::string key = metric + "_ns";
+		for (const JsonValue& benchmark : benchmarks->GetElements())
+		{
+			const JsonValue* name = benchmark.Find("name");
+			const JsonValue* value = benchmark.Find(key);
+			const JsonValue* stddev = benchmark.Find("stddev_ns");
+			if (!name || !value)
+			{
+				continue;
+			}
+			results[name->GetString()] = { value->GetNumber(), stddev ? stddev->GetNumber() : 0.0 };
+		}
+		return true;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::string baselinePath, currentPath, metric = "median";
+	double threshold = 5.0;
+	bool isValid = true;
+	for (int i = 1; i < argc; i++)
+	{
+		bool hasValue = i + 1 < argc;
+		if (strcmp(argv[i], "--threshold") == 0 && hasValue)
+			threshold = atof(argv[++i]);
+		else if (strcmp(argv[i], "--metric") == 0 && hasValue)
+			metric = argv[++i];
+		else if (baselinePath.empty())
+			baselinePath = argv[i];
+		else if (currentPath.empty())
+			currentPath = argv[i];
+		else
+			isValid = false;
+	}
+	if (!isValid || baselinePath.empty() || currentPath.empty() || (metric != "median" && metric != "min" && metric != "mean"))
+	{
+		fprintf(stderr, "Usage: %s <baseline.json> <current.json> [--threshold <percent>] [--metric median|min|mean]\n", argv[0]);
+		return 2;
+	}
+
+	std::map<std::string, Measurement> baseline, current;
+	if (!LoadResults(baselinePath, metric, baseline) || !LoadResults(currentPath, metric, current))
+	{
+		return 2;
+	}
+
+	uint32_t regressions = 0, improvements = 0, noisy = 0;
+	printf("%-48s %14s %14s %9s\n", "benchmark", "baseline ns", "current ns", "change");
+	for (const auto& [name, now] : current)
+	{
+		auto it = baseline.find(name);
+		if (it == baseline.end())
+		{
+			printf("%-48s %14s %14.1f %9s  new\n", name.c_str(), "-", now.value, "");
+			continue;
+		}
+
+		const Measurement& before = it->second;
+		double change = before.value > 0.0 ? (now.value - before.value) / before.value * 100.0 : 0.0;
+		// a change the spread of the two runs can explain on its own is not trusted either way
+		bool isWithinNoise = std::abs(now.value - before.value) <= std::hypot(before.stddev, now.stddev);
+		const char* verdict = "";
+		if (std::abs(change) > threshold)
+		{
+			if (isWithinNoise)
+			{
+				verdict = "noisy";
+				noisy++;
+			}
+			else if (change > 0.0)
+			{
+				verdict = "REGRESSION";
+				regressions++;
+			}
+			else
+			{
+				verdict = "improved";
+				improvements++;
+			}
+		}
+		printf("%-48s %14.1f %14.1f %+8.1f%%  %s\n", name.c_str(), before.value, now.value, change, verdict);
+	}
+	for (const auto& [name, before] : baseline)
+	{
+		if (!current.count(name))
+		{
+			printf("%-48s %14.1f %14s %9s  missing\n", name.c_str(), before.value, "-", "");
+		}
+	}
+
+	printf("\n%u regressions, %u improvements, %u noisy beyond %.1f%% on the %s\n", regressions, improvements, noisy, threshold, metric.c_str());
+	return regressions > 0 ? 1 : 0;
+}
@@ -0,0 +1,318 @@
+#include "benchmark.hpp"
+#include "headlesscontext.hpp"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <numeric>
+
+namespace
+{
+	constexpr uint64_t MaxIterations = 1ull << 30;
+	constexpr double CalibrationMargin = 1.2; // aims a little past the minimum sample time
+
+	struct RegisteredBenchmark
+	{
+		std::string name;
+		BenchmarkFunction fn;
+	};
+
+	std::vector<RegisteredBenchmark>& GetRegistry()
+	{
+		static std::vector<RegisteredBenchmark> registry;
+		return registry;
+	}
+
+	std::unique_ptr<HeadlessContext> glContext;
+	bool isGlContextTried = false;
+
+	struct BenchmarkResult
+	{
+		std::string name;
+		uint64_t iterations = 0;
+		size_t sampleCount = 0;
+		double min = 0.0, median = 0.0, mean = 0.0, max = 0.0, stddev = 0.0; // nanoseconds per iteration
+		double itemsPerSecond = 0.0, bytesPerSecond = 0.0;
+	};
+
+	BenchmarkResult Summarize(const std::string& name, const BenchmarkRun& run)
+	{
+		BenchmarkResult result;
+		result.name = name;
+		result.iterations = run.GetIterations();
+		std::vector<double> samples = run.GetSamples();
+		result.sampleCount = samples.size();
+		if (samples.empty())
+		{
+			return result;
+		}
+
+		std::sort(samples.begin(), samples.end());
+		size_t middle = samples.size() / 2;
+		result.min = samples.front();
+		result.max = samples.back();
+		result.median = samples.size() % 2 ? samples[middle] : (samples[middle - 1] + samples[middle]) * 0.5;
+		result.mean = std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size();
+		double variance = 0.0;
+		for (double sample : samples)
+		{
+			variance += (sample - result.mean) * (sample - result.mean);
+		}
+		result.stddev = std::sqrt(variance / samples.size());
+		result.itemsPerSecond = run.GetItemsPerIteration() * 1e9 / result.median;
+		result.bytesPerSecond = run.GetBytesPerIteration() * 1e9 / result.median;
+		return result;
+	}
+
+	void WriteJsonString(std::ostream& out, const std::string& text)
+	{
+		out << '"';
+		for (char c : text)
+		{
+			if (c == '"' || c == '\\')
+			{
+				out << '\\' << c;
+			}
+			else if ((unsigned char)c < 0x20)
+			{
+				char escaped[8];
+				snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+				out << escaped;
+			}
+			else
+			{
+				out << c;
+			}
+		}
+		out << '"';
+	}
+
+	bool WriteResults(const std::string& path, const std::vector<BenchmarkResult>& results)
+	{
+		std::error_code ec;
+		std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+		std::ofstream out(path, std::ios::binary | std::ios::trunc);
+		if (!out)
+		{
+			fprintf(stderr, "Could not open %s for writing\n", path.c_str());
+			return false;
+		}
+
+		char date[32];
+		time_t now = time(nullptr);
+		strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+		out.precision(17);
+		out << "{\n\t\"context\": {\n\t\t\"date\": \"" << date << "\",\n\t\t\"build\": ";
+#ifdef NDEBUG
+		WriteJsonString(out, "release");
+#else
+		WriteJsonString(out, "debug");
+#endif
+		out << ",\n\t\t\"compiler\": ";
+#if defined(__clang__)
+		WriteJsonString(out, std::string("clang ") + __clang_version__);
+#elif defined(__GNUC__)
+		WriteJsonString(out, std::string("gcc ") + __VERSION__);
+#else
+		WriteJsonString(out, "unknown");
+#endif
+		out << ",\n\t\t\"renderer\": ";
+		WriteJsonString(out, glContext ? (const char*)glGetString(GL_RENDERER) : "none");
+		out << "\n\t},\n\t\"benchmarks\": [";
+		for (size_t i = 0; i < results.size(); i++)
+		{
+			const BenchmarkResult& result = results[i];
+			out << (i ? ",\n" : "\n") << "\t\t{ \"name\": ";
+			WriteJsonString(out, result.name);
+			out << ", \"iterations\": " << result.iterations << ", \"samples\": " << result.sampleCount
+				<< ", \"min_ns\": " << result.min << ", \"median_ns\": " << result.median << ", \"mean_ns\": " << result.mean
+				<< ", \"max_ns\": " << result.max << ", \"stddev_ns\": " << result.stddev;
+			if (result.itemsPerSecond > 0.0)
+			{
+				out << ", \"items_per_second\": " << result.itemsPerSecond;
+			}
+			if (result.bytesPerSecond > 0.0)
+			{
+				out << ", \"bytes_per_second\": " << result.bytesPerSecond;
+			}
+			out << " }";
+		}
+		out << "\n\t]\n}\n";
+		return (bool)out;
+	}
+
+	std::string FormatTime(double nanoseconds)
+	{
+		char text[32];
+		if (nanoseconds < 1e3)
+			snprintf(text, sizeof(text), "%.1f ns", nanoseconds);
+		else if (nanoseconds < 1e6)
+			snprintf(text, sizeof(text), "%.2f us", nanoseconds / 1e3);
+		else if (nanoseconds < 1e9)
+			snprintf(text, sizeof(text), "%.2f ms", nanoseconds / 1e6);
+		else
+			snprintf(text, sizeof(text), "%.2f s", nanoseconds / 1e9);
+		return text;
+	}
+}
+
+BenchmarkRun::BenchmarkRun(std::chrono::nanoseconds minSampleTime, uint32_t sampleCount)
+	: mMinSampleTime(minSampleTime)
+	, mSampleCount(std::max(sampleCount, 1u))
+	, mIterations(1)
+	, mRemaining(0)
+	, mIsCalibrated(false)
+	, mIsTiming(false)
+	, mItemsPerIteration(0.0)
+	, mBytesPerIteration(0.0)
+{
+
+}
+
+bool BenchmarkRun::NextSample()
+{
+	auto now = std::chrono::steady_clock::now();
+	if (mIsTiming)
+	{
+		auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(now - mSampleStart);
+		if (!mIsCalibrated)
+		{
+			// the calibration samples double as warm up and are not kept
+			if (elapsed < mMinSampleTime && mIterations < MaxIterations)
+			{
+				double scale = (double)mMinSampleTime.count() / std::max<int64_t>(elapsed.count(), 1) * CalibrationMargin;
+				mIterations = std::min<uint64_t>(MaxIterations, std::max<uint64_t>(mIterations * 2, (uint64_t)(mIterations * std::min(scale, 100.0))));
+			}
+			else
+			{
+				mIsCalibrated = true;
+			}
+		}
+		else
+		{
+			mSamples.push_back((double)elapsed.count() / mIterations);
+			if (mSamples.size() >= mSampleCount)
+			{
+				mIsTiming = false;
+				return false;
+			}
+		}
+	}
+
+	mRemaining = mIterations - 1;
+	mIsTiming = true;
+	mSampleStart = std::chrono::steady_clock::now();
+	return true;
+}
+
+bool RegisterBenchmark(const std::string& name, BenchmarkFunction fn)
+{
+	GetRegistry().push_back({ name, std::move(fn) });
+	return true;
+}
+
+bool EnsureGlContext()
+{
+	if (!isGlContextTried)
+	{
+		isGlContextTried = true;
+		auto context = std::make_unique<HeadlessContext>();
+		if (context->Create() && context->MakeCurrent() && gladLoadGLLoader((GLADloadproc)HeadlessContext::GetProcAddress))
+		{
+			glContext = std::move(context);
+		}
+	}
+	return glContext != nullptr;
+}
+
+// mm3d_bench [--filter <text>] [--out <results.json>] [--samples <count>] [--min-sample-ms <ms>] [--list]
+int main(int argc, char** argv)
+{
+	std::string filter, outputPath;
+	uint32_t sampleCount = 10;
+	double minSampleMs = 20.0;
+	bool isListing = false;
+	for (int i = 1; i < argc; i++)
+	{
+		bool hasValue = i + 1 < argc;
+		if (strcmp(argv[i], "--filter") == 0 && hasValue)
+			filter = argv[++i];
+		else if (strcmp(argv[i], "--out") == 0 && hasValue)
+			outputPath = argv[++i];
+		else if (strcmp(argv[i], "--samples") == 0 && hasValue)
+			sampleCount = (uint32_t)std::max(atoi(argv[++i]), 1);
+		else if (strcmp(argv[i], "--min-sample-ms") == 0 && hasValue)
+			minSampleMs = std::max(atof(argv[++i]), 0.001);
+		else if (strcmp(argv[i], "--list") == 0)
+			isListing = true;
+		else
+		{
+			fprintf(stderr, "Usage: %s [--filter <text>] [--out <results.json>] [--samples <count>] [--min-sample-ms <ms>] [--list]\n", argv[0]);
+			return 2;
+		}
+	}
+
+#ifdef MM3D_SOURCE_DIR
+	// resource paths are relative to the repository, like the editor's
+	std::error_code ec;
+	std::filesystem::current_path(MM3D_SOURCE_DIR, ec);
+#endif
+
+	std::vector<RegisteredBenchmark> benchmarks = GetRegistry();
+	std::sort(benchmarks.begin(), benchmarks.end(), [](const RegisteredBenchmark& a, const RegisteredBenchmark& b) { return a.name < b.name; });
+	std::vector<BenchmarkResult> results;
+	auto minSampleTime = std::chrono::nanoseconds((int64_t)(minSampleMs * 1e6));
+	for (const RegisteredBenchmark& benchmark : benchmarks)
+	{
+		if (!filter.empty() && benchmark.name.find(filter) == std::string::npos)
+		{
+			continue;
+		}
+		if (isListing)
+		{
+			printf("%s\n", benchmark.name.c_str());
+			continue;
+		}
+
+		BenchmarkRun run(minSampleTime, sampleCount);
+		benchmark.fn(run);
+		if (!run.GetSkipReason().empty() || run.GetSamples().empty())
+		{
+			printf("%-48s skipped: %s\n", benchmark.name.c_str(), run.GetSkipReason().empty() ? "no samples" : run.GetSkipReason().c_str());
+			continue;
+		}
+
+		BenchmarkResult result = Summarize(benchmark.name, run);
+		printf("%-48s %12s median %12s min  +-%5.1f%%  x%llu", result.name.c_str(), FormatTime(result.median).c_str(), FormatTime(result.min).c_str(),
+			result.stddev / result.mean * 100.0, (unsigned long long)result.iterations);
+		if (result.itemsPerSecond > 0.0)
+		{
+			printf("  %.3g items/s", result.itemsPerSecond);
+		}
+		if (result.bytesPerSecond > 0.0)
+		{
+			printf("  %.1f MB/s", result.bytesPerSecond / (1024.0 * 1024.0));
+		}
+		printf("\n");
+		fflush(stdout);
+		results.push_back(std::move(result));
+	}
+
+	if (!outputPath.empty() && !isListing)
+	{
+		if (!WriteResults(outputPath, results))
+		{
+			return 1;
+		}
+		printf("Wrote %zu results to %s\n", results.size(), outputPath.c_str());
+	}
+	return 0;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Keeps the compiler from dropping work whose result is never read
+template<typename T>
+inline void DoNotOptimize(const T& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	asm volatile("" : : "r,m"(value) : "memory");
+#else
+	static volatile const void* sink;
+	sink = &value;
+#endif
+}
+
+// Handed to a benchmark, which sets up, then loops while Next() returns true around the work it measures. Only the
+// loop is timed. It first grows the iteration count until a sample takes long enough to time reliably, then takes
+// the configured number of samples of that many iterations each.
+class BenchmarkRun
+{
+public:
+	BenchmarkRun(std::chrono::nanoseconds minSampleTime, uint32_t sampleCount);
+
+	bool Next()
+	{
+		if (mRemaining > 0)
+		{
+			mRemaining--;
+			return true;
+		}
+		return NextSample();
+	}
+
+	// Reported per second along with the times
+	void SetItemsPerIteration(double items) { mItemsPerIteration = items; }
+	void SetBytesPerIteration(double bytes) { mBytesPerIteration = bytes; }
+	// Nothing is reported, for setups that do not work on this machine
+	void Skip(const std::string& reason) { mSkipReason = reason; }
+
+	uint64_t GetIterations() const { return mIterations; }
+	const std::vector<double>& GetSamples() const { return mSamples; } // nanoseconds per iteration
+	double GetItemsPerIteration() const { return mItemsPerIteration; }
+	double GetBytesPerIteration() const { return mBytesPerIteration; }
+	const std::string& GetSkipReason() const { return mSkipReason; }
+
+private:
+	bool NextSample();
+
+private:
+	std::chrono::nanoseconds mMinSampleTime;
+	uint32_t mSampleCount;
+	uint64_t mIterations;
+	uint64_t mRemaining;
+	bool mIsCalibrated;
+	bool mIsTiming;
+	std::chrono::steady_clock::time_point mSampleStart;
+	std::vector<double> mSamples;
+	double mItemsPerIteration;
+	double mBytesPerIteration;
+	std::string mSkipReason;
+};
+
+using BenchmarkFunction = std::function<void(BenchmarkRun&)>;
+
+// Benchmarks register themselves during static initialization, named group/case/parameters
+bool RegisterBenchmark(const std::string& name, BenchmarkFunction fn);
+
+// A headless GL context on the calling thread, created by the first benchmark that needs one. False when neither
+// EGL nor OSMesa is available, those benchmarks skip themselves then.
+bool EnsureGlContext();
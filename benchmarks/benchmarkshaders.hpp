@@ -0,0 +1,39 @@
+#pragma once
+
+// Shaped like the editor's textured shader with a few material parameters, kept inline so the benchmarks do not
+// depend on what is in resources/shaders
+inline const char* BenchmarkVertexShader = R"(#version 330 core
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec2 texcoords;
+
+out vec2 uvs;
+
+uniform mat4 proj = mat4(1.0);
+uniform mat4 view = mat4(1.0);
+uniform mat4 model = mat4(1.0);
+
+void main()
+{
+	uvs = texcoords;
+	gl_Position = proj * view * model * vec4(position, 1.0);
+})";
+
+inline const char* BenchmarkFragmentShader = R"(#version 330 core
+out vec4 outColor;
+
+in vec2 uvs;
+
+uniform sampler2D tex;
+uniform vec4 tint = vec4(1.0);
+uniform float exposure = 1.0;
+uniform float params[8];
+
+void main()
+{
+	float offset = 0.0;
+	for (int i = 0; i < 8; i++)
+	{
+		offset += params[i] * 0.001;
+	}
+	outColor = texture(tex, uvs) * tint * exposure + vec4(offset);
+})";
@@ -0,0 +1,325 @@
+#include "benchmark.hpp"
+#include "benchmarkshaders.hpp"
+#include "commandbuffer.hpp"
+#include "material.hpp"
+#include "meshimporter.hpp"
+#include "resourcepool.hpp"
+#include "scenerenderer.hpp"
+#include "shader.hpp"
+#include "texture.hpp"
+#include "vfs.hpp"
+
+#include <glad/glad.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+	void TransformCompose(BenchmarkRun& run, uint32_t count)
+	{
+		std::mt19937 random(1);
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+		std::vector<Entity> entities(count);
+		for (Entity& e : entities)
+		{
+			e.translate = glm::vec3(unit(random), unit(random), unit(random)) * 100.0f;
+			e.angle = unit(random) * 180.0f;
+			e.rotate = glm::normalize(glm::vec3(unit(random), unit(random), unit(random)) + glm::vec3(0.0f, 2.0f, 0.0f));
+			e.scale = glm::vec3(1.0f + unit(random) * 0.5f);
+		}
+
+		run.SetItemsPerIteration(count);
+		while (run.Next())
+		{
+			for (Entity& e : entities)
+			{
+				UpdateModel(e);
+			}
+			DoNotOptimize(entities.data());
+		}
+	}
+
+	// A material with the uniforms a typical editor material carries, plus padding ones to scale the count
+	Material CreateBenchmarkMaterial(Handle<Shader> shader, uint32_t extraFloats)
+	{
+		Material material(shader);
+		material.SetUniformValue("tint", glm::vec4(0.8f, 0.6f, 0.4f, 1.0f));
+		material.SetUniformValue("exposure", 1.2f);
+		material.SetUniformValue("tex", 0);
+		for (uint32_t i = 0; i < extraFloats; i++)
+		{
+			material.SetUniformValue("params[" + std::to_string(i) + "]", (float)i);
+		}
+		return material;
+	}
+
+	// Records the uniform commands only, the cost on the main thread per material switch
+	void MaterialUniformRecord(BenchmarkRun& run, uint32_t extraFloats)
+	{
+		if (!EnsureGlContext())
+		{
+			run.Skip("no headless GL context");
+			return;
+		}
+		ResourcePool<Shader> shaders;
+		Handle<Shader> shaderHandle = shaders.Create(BenchmarkVertexShader, BenchmarkFragmentShader);
+		const Shader& shader = *shaders.Get(shaderHandle);
+		Material material = CreateBenchmarkMaterial(shaderHandle, extraFloats);
+		CommandBuffer commands;
+
+		run.SetItemsPerIteration(1);
+		while (run.Next())
+		{
+			commands.Reset();
+			material.UpdateShaderUniforms(commands, shader);
+			DoNotOptimize(commands.GetCommandCount());
+		}
+	}
+
+	// Records and replays them into GL, including the driver's uniform upload
+	void MaterialUniformUpload(BenchmarkRun& run, uint32_t extraFloats)
+	{
+		if (!EnsureGlContext())
+		{
+			run.Skip("no headless GL context");
+			return;
+		}
+		ResourcePool<Shader> shaders;
+		Handle<Shader> shaderHandle = shaders.Create(BenchmarkVertexShader, BenchmarkFragmentShader);
+		const Shader& shader = *shaders.Get(shaderHandle);
+		Material material = CreateBenchmarkMaterial(shaderHandle, extraFloats);
+		CommandBuffer commands;
+
+		run.SetItemsPerIteration(1);
+		while (run.Next())
+		{
+			commands.Reset();
+			shader.Bind(commands);
+			material.UpdateShaderUniforms(commands, shader);
+			commands.Execute();
+		}
+		glFinish();
+	}
+
+	void UniformLookup(BenchmarkRun& run, bool isPresent)
+	{
+		if (!EnsureGlContext())
+		{
+			run.Skip("no headless GL context");
+			return;
+		}
+		Shader shader(BenchmarkVertexShader, BenchmarkFragmentShader);
+		const std::vector<std::string> names = isPresent
+			? std::vector<std::string>{ "proj", "view", "model", "tint", "exposure", "tex", "params[0]", "params[7]" }
+			: std::vector<std::string>{ "projection", "lightDir", "roughness", "metallic", "albedo", "normalMap", "time", "fog" };
+
+		run.SetItemsPerIteration((double)names.size());
+		while (run.Next())
+		{
+			int sum = 0;
+			for (const std::string& name : names)
+			{
+				sum += shader.GetUniformLocation(name);
+			}
+			DoNotOptimize(sum);
+		}
+	}
+
+	void TextureDecode(BenchmarkRun& run, const std::string& path)
+	{
+		VfsFile file;
+		if (!VirtualFileSystem::Get().Open(path, file))
+		{
+			run.Skip("could not read " + path);
+			return;
+		}
+
+		run.SetBytesPerIteration((double)file.GetSize());
+		while (run.Next())
+		{
+			TextureImage image;
+			if (!DecodeTexture(path, image))
+			{
+				run.Skip("could not decode " + path);
+				return;
+			}
+			DoNotOptimize(image.pixels.get());
+		}
+	}
+
+	// A UV sphere as OBJ text with positions, texcoords and normals, imported straight from memory
+	std::string GenerateSphereObj(uint32_t rings, uint32_t segments)
+	{
+		std::string obj;
+		char line[128];
+		const float pi = 3.14159265f;
+		for (uint32_t r = 0; r <= rings; r++)
+		{
+			for (uint32_t s = 0; s <= segments; s++)
+			{
+				float theta = pi * r / rings, phi = 2.0f * pi * s / segments;
+				glm::vec3 n(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+				snprintf(line, sizeof(line), "v %f %f %f\nvt %f %f\nvn %f %f %f\n", n.x, n.y, n.z, (float)s / segments, (float)r / rings, n.x, n.y, n.z);
+				obj += line;
+			}
+		}
+		for (uint32_t r = 0; r < rings; r++)
+		{
+			for (uint32_t s = 0; s < segments; s++)
+			{
+				uint32_t a = r * (segments + 1) + s + 1, b = a + segments + 1;
+				snprintf(line, sizeof(line), "f %u/%u/%u %u/%u/%u %u/%u/%u\nf %u/%u/%u %u/%u/%u %u/%u/%u\n",
+					a, a, a, b, b, b, a + 1, a + 1, a + 1, a + 1, a + 1, a + 1, b, b, b, b + 1, b + 1, b + 1);
+				obj += line;
+			}
+		}
+		return obj;
+	}
+
+	// The same sphere as a binary glTF with float attributes and 32 bit indices
+	std::string GenerateSphereGlb(uint32_t rings, uint32_t segments)
+	{
+		const float pi = 3.14159265f;
+		uint32_t vertexCount = (rings + 1) * (segments + 1);
+		std::vector<float> positions, uvs;
+		std::vector<uint32_t> indices;
+		positions.reserve(vertexCount * 3);
+		uvs.reserve(vertexCount * 2);
+		for (uint32_t r = 0; r <= rings; r++)
+		{
+			for (uint32_t s = 0; s <= segments; s++)
+			{
+				float theta = pi * r / rings, phi = 2.0f * pi * s / segments;
+				positions.insert(positions.end(), { std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi) });
+				uvs.insert(uvs.end(), { (float)s / segments, 1.0f - (float)r / rings });
+			}
+		}
+		for (uint32_t r = 0; r < rings; r++)
+		{
+			for (uint32_t s = 0; s < segments; s++)
+			{
+				uint32_t a = r * (segments + 1) + s, b = a + segments + 1;
+				indices.insert(indices.end(), { a, b, a + 1, a + 1, b, b + 1 });
+			}
+		}
+
+		// positions double as the normals of a unit sphere
+		size_t positionBytes = positions.size() * sizeof(float), uvBytes = uvs.size() * sizeof(float), indexBytes = indices.size() * sizeof(uint32_t);
+		std::string bin(positionBytes + uvBytes + indexBytes, '\0');
+		memcpy(bin.data(), positions.data(), positionBytes);
+		memcpy(bin.data() + positionBytes, uvs.data(), uvBytes);
+		memcpy(bin.data() + positionBytes + uvBytes, indices.data(), indexBytes);
+
+		char json[1024];
+		snprintf(json, sizeof(json),
+			"{\"asset\":{\"version\":\"2.0\"},\"scene\":0,\"scenes\":[{\"nodes\":[0]}],\"nodes\":[{\"mesh\":0}],"
+			"\"meshes\":[{\"primitives\":[{\"attributes\":{\"POSITION\":0,\"NORMAL\":0,\"TEXCOORD_0\":1},\"indices\":2}]}],"
+			"\"buffers\":[{\"byteLength\":%zu}],"
+			"\"bufferViews\":[{\"buffer\":0,\"byteLength\":%zu},{\"buffer\":0,\"byteOffset\":%zu,\"byteLength\":%zu},{\"buffer\":0,\"byteOffset\":%zu,\"byteLength\":%zu}],"
+			"\"accessors\":[{\"bufferView\":0,\"componentType\":5126,\"count\":%u,\"type\":\"VEC3\"},"
+			"{\"bufferView\":1,\"componentType\":5126,\"count\":%u,\"type\":\"VEC2\"},"
+			"{\"bufferView\":2,\"componentType\":5125,\"count\":%zu,\"type\":\"SCALAR\"}]}",
+			bin.size(), positionBytes, positionBytes, uvBytes, positionBytes + uvBytes, indexBytes, vertexCount, vertexCount, indices.size());
+		std::string text = json;
+		text.resize((text.size() + 3) & ~(size_t)3, ' ');
+
+		std::string glb;
+		auto appendU32 = [&](uint32_t value) { glb.append((const char*)&value, sizeof(value)); };
+		appendU32(0x46546C67); // "glTF"
+		appendU32(2);
+		appendU32((uint32_t)(12 + 8 + text.size() + 8 + bin.size()));
+		appendU32((uint32_t)text.size());
+		appendU32(0x4E4F534A); // "JSON"
+		glb += text;
+		appendU32((uint32_t)bin.size());
+		appendU32(0x004E4942); // "BIN"
+		glb += bin;
+		return glb;
+	}
+
+	// Reports both the input MB/s and the triangles/s of the imported mesh
+	void MeshImportData(BenchmarkRun& run, const std::string& path, const std::string& data)
+	{
+		MeshData source;
+		if (!ImportMesh(path, data.data(), data.size(), source))
+		{
+			run.Skip("could not import the generated " + path);
+			return;
+		}
+
+		run.SetBytesPerIteration((double)data.size());
+		run.SetItemsPerIteration(source.GetTriangleCount());
+		while (run.Next())
+		{
+			MeshData mesh;
+			ImportMesh(path, data.data(), data.size(), mesh);
+			DoNotOptimize(mesh.indices.data());
+		}
+	}
+
+	void MeshImportFile(BenchmarkRun& run, const std::string& path)
+	{
+		run.SetItemsPerIteration(1);
+		while (run.Next())
+		{
+			MeshData mesh;
+			if (!ImportMesh(path, mesh))
+			{
+				run.Skip("could not import " + path);
+				return;
+			}
+			DoNotOptimize(mesh.indices.data());
+		}
+	}
+
+	void MeshQuantize(BenchmarkRun& run, uint32_t rings, uint32_t segments)
+	{
+		std::string obj = GenerateSphereObj(rings, segments);
+		MeshData source;
+		if (!ImportObj(obj.data(), obj.size(), source))
+		{
+			run.Skip("could not import the generated sphere");
+			return;
+		}
+
+		run.SetItemsPerIteration(source.GetVertexCount());
+		while (run.Next())
+		{
+			MeshData mesh = source;
+			QuantizeMesh(mesh);
+			DoNotOptimize(mesh.vertices.data());
+		}
+	}
+
+	bool isRegistered = [] {
+		for (uint32_t count : { 1000u, 100000u })
+		{
+			RegisterBenchmark("transform/compose/" + std::to_string(count), [count](BenchmarkRun& run) { TransformCompose(run, count); });
+		}
+		for (uint32_t extraFloats : { 0u, 8u })
+		{
+			std::string suffix = "/" + std::to_string(extraFloats + 3) + "_uniforms";
+			RegisterBenchmark("material/record" + suffix, [extraFloats](BenchmarkRun& run) { MaterialUniformRecord(run, extraFloats); });
+			RegisterBenchmark("material/upload" + suffix, [extraFloats](BenchmarkRun& run) { MaterialUniformUpload(run, extraFloats); });
+		}
+		RegisterBenchmark("shader/uniform_lookup/hit", [](BenchmarkRun& run) { UniformLookup(run, true); });
+		RegisterBenchmark("shader/uniform_lookup/miss", [](BenchmarkRun& run) { UniformLookup(run, false); });
+		RegisterBenchmark("texture/decode/png", [](BenchmarkRun& run) { TextureDecode(run, "resources/textures/awesomeface.png"); });
+		RegisterBenchmark("texture/decode/jpg", [](BenchmarkRun& run) { TextureDecode(run, "resources/textures/wall2.jpg"); });
+		// the large spheres are 2M triangles, about 200 MB of OBJ text and 40 MB of GLB
+		for (auto [rings, segments] : { std::pair<uint32_t, uint32_t>{ 64, 128 }, { 1024, 1024 } })
+		{
+			std::string suffix = "/sphere_" + std::to_string(rings) + "x" + std::to_string(segments);
+			RegisterBenchmark("mesh/import_obj" + suffix, [=](BenchmarkRun& run) { MeshImportData(run, "sphere.obj", GenerateSphereObj(rings, segments)); });
+			RegisterBenchmark("mesh/import_glb" + suffix, [=](BenchmarkRun& run) { MeshImportData(run, "sphere.glb", GenerateSphereGlb(rings, segments)); });
+		}
+		RegisterBenchmark("mesh/import_obj/pyramid", [](BenchmarkRun& run) { MeshImportFile(run, "resources/meshes/pyramid.obj"); });
+		RegisterBenchmark("mesh/quantize/sphere_64x128", [](BenchmarkRun& run) { MeshQuantize(run, 64, 128); });
+		return true;
+	}();
+}
@@ -0,0 +1,167 @@
+#include "benchmark.hpp"
+#include "benchmarkshaders.hpp"
+#include "commandbuffer.hpp"
+#include "framearena.hpp"
+#include "framebuffer.hpp"
+#include "material.hpp"
+#include "meshimporter.hpp"
+#include "resourcepool.hpp"
+#include "scenerenderer.hpp"
+#include "shader.hpp"
+#include "texture.hpp"
+#include "vertex.hpp"
+
+#include <glad/glad.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+	constexpr uint32_t SceneSize = 512; // framebuffer width and height
+	const std::string SceneMesh = "resources/meshes/pyramid.obj";
+	const std::string SceneTexture = "resources/textures/wall2.jpg";
+
+	// entityCount entities spread over a grid in view, drawn with materialCount materials that each own their shader
+	// like the editor's do, all with one mesh and texture
+	class BenchmarkScene
+	{
+	public:
+		bool Create(uint32_t entityCount, uint32_t materialCount)
+		{
+			MeshData mesh;
+			if (!ImportMesh(SceneMesh, mesh))
+			{
+				return false;
+			}
+			Handle<VertexArray> va = mVertexArrays.Add(CreateVertexArray(mesh));
+			Handle<Texture> texture = mTextures.Create(SceneTexture);
+			mFramebuffer = std::make_unique<Framebuffer>(SceneSize, SceneSize);
+
+			std::vector<Handle<Object>> objects;
+			for (uint32_t i = 0; i < materialCount; i++)
+			{
+				Handle<Shader> shader = mShaders.Create(BenchmarkVertexShader, BenchmarkFragmentShader);
+				if (!mShaders.Get(shader)->GetError().empty())
+				{
+					return false;
+				}
+				Material material(shader, texture);
+				float hue = (float)i / materialCount;
+				material.SetUniformValue("tint", glm::vec4(hue, 1.0f - hue, 0.5f, 1.0f));
+				material.SetUniformValue("exposure", 1.0f + hue);
+				material.SetUniformValue("tex", 0);
+				Object object;
+				object.va = va;
+				object.mat = mMaterials.Create(material);
+				objects.push_back(mObjects.Create(object));
+			}
+
+			// entities are interleaved over the materials so the draw list has to sort them back together
+			uint32_t side = (uint32_t)std::ceil(std::sqrt((float)entityCount));
+			float spacing = 40.0f / side;
+			mEntities.resize(entityCount);
+			for (uint32_t i = 0; i < entityCount; i++)
+			{
+				Entity& entity = mEntities[i];
+				entity.object = objects[i % materialCount];
+				entity.translate = glm::vec3((i % side) * spacing - 20.0f, (i / side) * spacing - 20.0f, -30.0f);
+				entity.angle = (float)(i * 37 % 360);
+				entity.scale = glm::vec3(spacing * 0.4f);
+				UpdateModel(entity);
+			}
+
+			mView = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+			mProjection = glm::perspective(glm::radians(70.0f), 1.0f, 0.1f, 100.0f);
+			return true;
+		}
+
+		// The editor's frame without ImGui: the draw list is built and recorded into the scene framebuffer
+		void Record(CommandBuffer& commands)
+		{
+			mArena.Reset();
+			FrameVector<DrawItem> drawList(&mArena);
+			drawList.reserve(mEntities.size());
+			DrawListBuilder builder({ mObjects, mMaterials, mVertexArrays, mShaders, mTextures }, mProjection * mView, drawList);
+			for (const Entity& entity : mEntities)
+			{
+				builder.Add(entity);
+			}
+			builder.Finish();
+
+			commands.BindFramebuffer(mFramebuffer->GetFB());
+			commands.Viewport(0, 0, SceneSize, SceneSize);
+			commands.Enable(GL_DEPTH_TEST);
+			commands.ClearColor(glm::vec4(0.1f, 0.1f, 0.1f, 1.0f));
+			commands.Clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			RecordDrawList(commands, drawList, mView, mProjection);
+			commands.BindFramebuffer(0);
+		}
+
+	private:
+		ResourcePool<Shader> mShaders;
+		ResourcePool<Texture> mTextures;
+		ResourcePool<Material> mMaterials;
+		ResourcePool<VertexArray> mVertexArrays;
+		ResourcePool<Object> mObjects;
+		std::unique_ptr<Framebuffer> mFramebuffer;
+		std::vector<Entity> mEntities;
+		glm::mat4 mView, mProjection;
+		FrameArena mArena;
+	};
+
+	// Building and recording the draw list on the main thread
+	void SceneRecord(BenchmarkRun& run, uint32_t entityCount, uint32_t materialCount)
+	{
+		BenchmarkScene scene;
+		if (!EnsureGlContext() || !scene.Create(entityCount, materialCount))
+		{
+			run.Skip("no headless GL context or scene resources");
+			return;
+		}
+		CommandBuffer commands;
+
+		run.SetItemsPerIteration(entityCount);
+		while (run.Next())
+		{
+			commands.Reset();
+			scene.Record(commands);
+			DoNotOptimize(commands.GetCommandCount());
+		}
+	}
+
+	// A whole frame: recording, replaying into GL and waiting for the GPU to finish it
+	void SceneFrame(BenchmarkRun& run, uint32_t entityCount, uint32_t materialCount)
+	{
+		BenchmarkScene scene;
+		if (!EnsureGlContext() || !scene.Create(entityCount, materialCount))
+		{
+			run.Skip("no headless GL context or scene resources");
+			return;
+		}
+		CommandBuffer commands;
+
+		run.SetItemsPerIteration(entityCount);
+		while (run.Next())
+		{
+			commands.Reset();
+			scene.Record(commands);
+			commands.Execute();
+			glFinish();
+		}
+	}
+
+	bool isRegistered = [] {
+		const std::pair<uint32_t, uint32_t> sizes[] = { { 1000, 1 }, { 1000, 16 }, { 10000, 16 }, { 10000, 128 } };
+		for (auto [entityCount, materialCount] : sizes)
+		{
+			std::string suffix = "/" + std::to_string(entityCount) + "x" + std::to_string(materialCount);
+			RegisterBenchmark("scene/record" + suffix, [=](BenchmarkRun& run) { SceneRecord(run, entityCount, materialCount); });
+			RegisterBenchmark("scene/frame" + suffix, [=](BenchmarkRun& run) { SceneFrame(run, entityCount, materialCount); });
+		}
+		return true;
+	}();
+}
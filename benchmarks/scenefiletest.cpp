@@ -0,0 +1,292 @@
+#include "scenefile.hpp"
+#include "stressscene.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// mm3d_scenefile_test [directory] [--read-budget <seconds>]
+// Writes scenes the way App::SaveScene fills them in, reads them back and compares every field bit for bit. Reading
+// the million entity scene back has to fit the budget, 0 turns the check off for slow machines.
+namespace
+{
+	uint32_t failures = 0;
+
+	void Fail(const std::string& scene, const std::string& what)
+	{
+		if (failures++ < 20)
+		{
+			fprintf(stderr, "%s: %s differs after the round trip\n", scene.c_str(), what.c_str());
+		}
+	}
+
+	template<typename T>
+	bool IsSame(const T& a, const T& b)
+	{
+		return memcmp(&a, &b, sizeof(T)) == 0; // bitwise, so -0.0 and NaN payloads count too
+	}
+
+	template<typename T>
+	void CompareValues(const std::string& scene, const std::string& what, const std::vector<T>& expected, const std::vector<T>& actual)
+	{
+		if (expected.size() != actual.size())
+		{
+			Fail(scene, what + " count");
+			return;
+		}
+		for (size_t i = 0; i < expected.size(); i++)
+		{
+			if (!IsSame(expected[i], actual[i]))
+			{
+				Fail(scene, what + " " + std::to_string(i));
+				return;
+			}
+		}
+	}
+
+	void CompareStrings(const std::string& scene, const std::string& what, const std::vector<std::string>& expected, const std::vector<std::string>& actual)
+	{
+		if (expected != actual)
+		{
+			Fail(scene, what);
+		}
+	}
+
+	void CompareScenes(const std::string& scene, const SceneFileData& expected, const SceneFileData& actual)
+	{
+		if (expected.textures != actual.textures)
+		{
+			Fail(scene, "textures");
+		}
+		if (expected.shaders != actual.shaders)
+		{
+			Fail(scene, "shaders");
+		}
+
+		if (expected.materials.size() != actual.materials.size())
+		{
+			Fail(scene, "material count");
+		}
+		for (size_t i = 0; i < std::min(expected.materials.size(), actual.materials.size()); i++)
+		{
+			const SceneMaterial& a = expected.materials[i];
+			const SceneMaterial& b = actual.materials[i];
+			std::string what = "material " + a.name;
+			if (a.name != b.name || a.vertexSource != b.vertexSource || a.fragmentSource != b.fragmentSource || a.texture != b.texture)
+			{
+				Fail(scene, what);
+			}
+			if (a.uniforms.size() != b.uniforms.size())
+			{
+				Fail(scene, what + " uniform count");
+				continue;
+			}
+			for (size_t u = 0; u < a.uniforms.size(); u++)
+			{
+				if (a.uniforms[u].name != b.uniforms[u].name || a.uniforms[u].type != b.uniforms[u].type || !IsSame(a.uniforms[u].values, b.uniforms[u].values))
+				{
+					Fail(scene, what + " uniform " + a.uniforms[u].name);
+				}
+			}
+		}
+
+		if (expected.objects.size() != actual.objects.size())
+		{
+			Fail(scene, "object count");
+		}
+		for (size_t i = 0; i < std::min(expected.objects.size(), actual.objects.size()); i++)
+		{
+			const SceneObject& a = expected.objects[i];
+			const SceneObject& b = actual.objects[i];
+			if (a.name != b.name || a.vaName != b.vaName || a.matName != b.matName)
+			{
+				Fail(scene, "object " + a.name);
+			}
+		}
+
+		const SceneEntities& a = expected.entities;
+		const SceneEntities& b = actual.entities;
+		CompareStrings(scene, "entity names", a.names, b.names);
+		CompareStrings(scene, "entity objects", a.objects, b.objects);
+		CompareValues(scene, "entity translate", a.translates, b.translates);
+		CompareValues(scene, "entity angle", a.angles, b.angles);
+		CompareValues(scene, "entity axis", a.axes, b.axes);
+		CompareValues(scene, "entity scale", a.scales, b.scales);
+	}
+
+	SceneUniform MakeUniform(const std::string& name, SceneUniformType type, uint32_t valueCount, float first)
+	{
+		SceneUniform uniform;
+		uniform.name = name;
+		uniform.type = type;
+		for (uint32_t i = 0; i < valueCount; i++)
+		{
+			uniform.values[i] = first + i * 0.25f;
+		}
+		return uniform;
+	}
+
+	// Every kind of resource the editor saves, with the corner cases of each
+	SceneFileData MakeSmallScene()
+	{
+		SceneFileData scene;
+		scene.textures = { { "wall2.jpg", "resources/textures/wall2.jpg" }, { "awesomeface.png", "resources/textures/awesomeface.png" } };
+		scene.shaders = { { "simple.vert", "#version 330 core\nvoid main() {}\n" }, { "empty.frag", "" } };
+
+		SceneMaterial textured;
+		textured.name = "textured";
+		textured.vertexSource = scene.shaders[0].second;
+		textured.fragmentSource = "#version 330 core\nout vec4 color;\nvoid main() { color = vec4(1.0); }\n";
+		textured.texture = "wall2.jpg";
+		SceneUniform tex = MakeUniform("tex", SceneUniformType::Int, 0, 0.0f);
+		int32_t unit = -3;
+		memcpy(tex.values, &unit, sizeof(unit)); // ints are stored bitwise
+		textured.uniforms = {
+			tex,
+			MakeUniform("exposure", SceneUniformType::Float, 1, -0.0f),
+			MakeUniform("offset", SceneUniformType::Float2, 2, 1.5f),
+			MakeUniform("light", SceneUniformType::Float3, 3, -2.0f),
+			MakeUniform("tint", SceneUniformType::Float4, 4, 0.125f),
+			MakeUniform("normalMatrix", SceneUniformType::Mat3, 9, 3.0f),
+			MakeUniform("params[7]", SceneUniformType::Mat4, 16, 1e-30f),
+		};
+		scene.materials.push_back(textured);
+
+		SceneMaterial plain;
+		plain.name = "plain, no texture or uniforms";
+		plain.vertexSource = textured.vertexSource;
+		plain.fragmentSource = textured.fragmentSource;
+		scene.materials.push_back(plain);
+
+		scene.objects = { { "cube", "cube", "textured" }, { "pyramid", "pyramid.obj", "plain, no texture or uniforms" } };
+
+		SceneEntities& entities = scene.entities;
+		entities.Resize(4);
+		const char* names[] = { "cube", "pyramid/child", "", "entity of a deleted object" };
+		const char* objects[] = { "cube", "pyramid", "cube", "" };
+		for (size_t i = 0; i < 4; i++)
+		{
+			entities.names[i] = names[i];
+			entities.objects[i] = objects[i];
+			entities.translates[i] = glm::vec3(i * 1.5f, -(float)i, 1e20f);
+			entities.angles[i] = i * 90.0f - 180.0f;
+			entities.axes[i] = glm::normalize(glm::vec3(1.0f, (float)i, 0.5f));
+			entities.scales[i] = glm::vec3(0.5f, 1.0f, 2.0f) * (float)(i + 1);
+		}
+		return scene;
+	}
+
+	// The target size of the format: a million entities over a few dozen objects, generated like the stress scene
+	bool MakeLargeScene(SceneFileData& scene)
+	{
+		StressSceneSettings settings;
+		settings.entityCount = 1000000;
+		settings.layout = StressLayout::Clustered;
+		settings.hierarchyDepth = 3;
+		settings.seed = 7;
+
+		scene = MakeSmallScene();
+		scene.objects.clear();
+		std::vector<std::string> objectNames;
+		for (uint32_t i = 0; i < 32; i++)
+		{
+			objectNames.push_back("stress/object/" + std::to_string(i));
+			scene.objects.push_back({ objectNames.back(), i % 2 ? "cube" : "pyramid.obj", scene.materials[i % scene.materials.size()].name });
+		}
+
+		StressSceneEntities generated;
+		if (!GenerateStressEntities(settings, objectNames, generated))
+		{
+			return false;
+		}
+		scene.entities = std::move(generated.entities);
+		return true;
+	}
+
+	bool RoundTrip(const std::string& name, const SceneFileData& scene, const std::string& path, double readBudget = 0.0)
+	{
+		auto start = std::chrono::steady_clock::now();
+		if (!WriteSceneFile(path, scene))
+		{
+			Fail(name, "write");
+			return false;
+		}
+		auto written = std::chrono::steady_clock::now();
+		SceneFileData loaded;
+		if (!ReadSceneFile(path, loaded))
+		{
+			Fail(name, "read");
+			return false;
+		}
+		auto read = std::chrono::steady_clock::now();
+
+		uint32_t before = failures;
+		CompareScenes(name, scene, loaded);
+		double readSeconds = std::chrono::duration<double>(read - written).count();
+		if (readBudget > 0.0 && readSeconds > readBudget)
+		{
+			fprintf(stderr, "%s: reading took %.3fs, over the budget of %.3fs\n", name.c_str(), readSeconds, readBudget);
+			failures++;
+		}
+		printf("%-8s %8zu entities  %8.1f MB  write %.3fs  read %.3fs  %s\n", name.c_str(), scene.entities.GetCount(),
+			std::filesystem::file_size(path) / (1024.0 * 1024.0), std::chrono::duration<double>(written - start).count(),
+			readSeconds, failures == before ? "ok" : "FAILED");
+		return failures == before;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::filesystem::path directory = std::filesystem::temp_directory_path();
+	double readBudget = 1.0;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--read-budget") == 0 && i + 1 < argc)
+			readBudget = atof(argv[++i]);
+		else
+			directory = argv[i];
+	}
+
+	SceneFileData small = MakeSmallScene();
+	RoundTrip("small", small, (directory / "mm3d_roundtrip_small.mm3s").string());
+
+	SceneFileData empty;
+	RoundTrip("empty", empty, (directory / "mm3d_roundtrip_empty.mm3s").string());
+
+	SceneFileData large;
+	if (!MakeLargeScene(large))
+	{
+		Fail("large", "generation");
+	}
+	else
+	{
+		RoundTrip("large", large, (directory / "mm3d_roundtrip_large.mm3s").string(), readBudget);
+	}
+
+	// a file cut short has to be refused, not read past its end
+	std::string truncatedPath = (directory / "mm3d_roundtrip_truncated.mm3s").string();
+	std::error_code ec;
+	std::filesystem::copy_file(directory / "mm3d_roundtrip_small.mm3s", truncatedPath, std::filesystem::copy_options::overwrite_existing, ec);
+	std::filesystem::resize_file(truncatedPath, std::filesystem::file_size(truncatedPath, ec) / 2, ec);
+	SceneFileData truncated;
+	if (ec || ReadSceneFile(truncatedPath, truncated))
+	{
+		Fail("truncated", "rejection");
+	}
+
+	for (const char* name : { "small", "empty", "large", "truncated" })
+	{
+		std::filesystem::remove(directory / ("mm3d_roundtrip_" + std::string(name) + ".mm3s"), ec);
+	}
+	if (failures > 0)
+	{
+		fprintf(stderr, "%u failures\n", failures);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+
+// Totals of every operator new since startup, on all threads. The global operators are replaced in
+// allocationcounter.cpp, take the difference of two calls to see what a stretch of code allocated.
+struct AllocationStats
+{
+	uint64_t count = 0;
+	uint64_t bytes = 0;
+
+	AllocationStats operator-(const AllocationStats& other) const { return { count - other.count, bytes - other.bytes }; }
+};
+
+AllocationStats GetAllocationStats();
@@ -2,53 +2,135 @@
 
 #include <glm/glm.hpp>
 
+#include "resourcepool.hpp"
+#include "nameregistry.hpp"
+#include "framearena.hpp"
+#include "commandbuffer.hpp"
+#include "searchindex.hpp"
+#include "allocationcounter.hpp"
+#include "scenerenderer.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <future>
 #include <memory>
 #include <unordered_map>
 #include <map>
 #include <string>
+#include <vector>
 
 struct GLFWwindow;
 struct InputTextCallback_UserData;
 
 class Framebuffer;
 
-class VertexArray;
-class Material;
-struct Object
+// Everything the fixed step advances. The last two steps are kept, frames are drawn in between.
+struct SimulationState
 {
-	std::string vaName, matName;
-	std::shared_ptr<VertexArray> va;
-	std::shared_ptr<Material> mat;
+	uint64_t step = 0;
+	glm::vec3 cameraPosition = glm::vec3(0.0f);
 };
-struct Entity
+
+// A spinning stress entity. FixedUpdate turns its angle, frames draw it between the angles of the last two steps.
+struct DynamicEntity
+{
+	Entity* entity;
+	float spin; // degrees per second
+	float previousAngle; // unwrapped, the current one minus the last step's turn
+};
+
+// What a run without a window renders, see App::InitializeHeadless
+struct HeadlessSettings
+{
+	uint32_t frameCount = 1; // rendered once every asset is loaded
+	std::string scenePath; // loaded over the autosave when set
+	std::string outputPath; // the last frame is written here when set, .png, .exr or .ppm
+	uint32_t turntableFrames = 0; // when set, a turntable of as many frames is written instead, see FormatSequencePath
+	std::string replayPath; // an input recording played once the scene is loaded, the output is written after it
+	std::string timingsPath; // the replayed frames are profiled to path.json and path.csv, empty picks a path
+};
+
+// A full turn around target, starting from and keeping the camera's distance and height
+struct TurntableSettings
 {
-	std::shared_ptr<Object> object;
-	glm::vec3 translate = glm::vec3(0.0f);
-	float angle = 0.0f;
-	glm::vec3 rotate = glm::vec3(0.0f, 1.0f, 0.0f);
-	glm::vec3 scale = glm::vec3(1.0f);
-	glm::mat4 model = glm::mat4(1.0f);
+	uint32_t frameCount = 120;
+	glm::vec3 target = glm::vec3(0.0f);
 };
 
-class Shader;
-class Texture;
+struct ImGuiDrawSnapshot;
+
+enum class EntitySort
+{
+	Name,
+	Object,
+	Material
+};
 
 class Camera;
+class EditJournal;
+struct JournalRecord;
+class AssetManager;
+class AssetDatabase;
+class HeadlessContext;
+class FramebufferReadback;
+class ImageExporter;
+class InputRecorder;
+class InputReplay;
+struct InputEvent;
+using AssetId = uint32_t;
+struct SceneFileData;
+struct SceneMaterial;
+struct SceneObject;
+struct SceneEntities;
+struct StressSceneSettings;
 
 class App
 {
 public:
 	App();
+	~App();
 
 	bool Initialize();
+	// Renders the scene into the offscreen framebuffer without a window, display or ImGui, see HeadlessContext
+	bool InitializeHeadless(const HeadlessSettings& settings);
 	void Update();
 	void Render();
 	void Shutdown();
 
+	bool SaveScene(const std::string& path);
+	bool LoadScene(const std::string& path); // replaces materials, objects and entities, textures and shaders are merged
+
+	// Profiles the next frameCount frames and writes path.json (Chrome trace) and path.csv, an empty path picks one
+	void StartProfileCapture(uint32_t frameCount, const std::string& path = "");
+	// The scene view is read back and written on the thread pool a few frames later
+	void SaveImage(const std::string& path);
+	void StartTurntable(const TurntableSettings& settings, const std::string& pattern);
+	bool IsExporting() const;
+
+	// Records camera input and edits with their times, see InputRecorder
+	bool StartInputRecording(const std::string& path);
+	void StopInputRecording();
+	// Plays a recording back with one simulation step per frame, live camera input is ignored meanwhile. Edits are
+	// applied to the scene as it is, which should be the one the recording started on.
+	bool StartInputReplay(const std::string& path);
+	void StopInputReplay();
+	// Generates a stress scene once the assets requested so far are in, see GenerateStressEntities. Entities of an
+	// earlier run with the same prefix are replaced.
+	void GenerateStressScene(const StressSceneSettings& settings);
+
+	bool IsRecordingInput() const { return mInputRecorder != nullptr; }
+	bool IsReplayingInput() const { return mInputReplay != nullptr; }
+
 	bool IsRunning() const { return mIsRunning; }
+	bool IsHeadless() const { return mHeadlessContext != nullptr; }
 private:
 	bool mIsRunning;
 
+	std::unique_ptr<HeadlessContext> mHeadlessContext;
+	HeadlessSettings mHeadless;
+	uint32_t mHeadlessFrames; // rendered since the assets finished loading
+	bool mIsHeadlessSceneLoaded;
+
 	double mDeltaTime, mLastFrame, mCurrentFrame;
 	
 	static int mWindowWidth, mWindowHeight;
@@ -58,30 +140,113 @@ private:
 	std::shared_ptr<VertexArray> mFramebufferRect;
 	std::shared_ptr<Shader> mFramebufferShader;
 
-	std::map<std::string, std::shared_ptr<Texture>> mTextures;
-	std::map<std::string, std::string> mShaders;
-	std::map<std::string, std::shared_ptr<Material>> mMaterials;
-	std::map<std::string, std::shared_ptr<VertexArray>> mVAs;
-	std::map<std::string, std::shared_ptr<Object>> mObjects;
-	std::unordered_map<std::string, std::shared_ptr<Entity>> mEntities;
+	// resources are owned by the pools, the maps name them
+	ResourcePool<Texture> mTexturePool;
+	ResourcePool<Shader> mShaderPool;
+	ResourcePool<Material> mMaterialPool;
+	ResourcePool<VertexArray> mVertexArrayPool;
+	ResourcePool<Object> mObjectPool;
+
+	NameRegistry<Handle<Texture>> mTextures;
+	NameRegistry<std::string> mShaders; // sources
+	NameRegistry<Handle<Material>> mMaterials;
+	NameRegistry<Handle<VertexArray>> mVAs;
+	NameRegistry<Handle<Object>> mObjects;
+	std::unordered_map<std::string, Entity> mEntities;
+	SearchIndex<Entity> mEntityIndex; // names and entities point into mEntities
+	std::vector<DynamicEntity> mDynamicEntities;
 
 	static Camera* mCamera;
 	static bool mIsUsingCamera;
 	static float mLastX, mLastY;
 	static bool mFirstMouse;
+	static int mUiFramesPending; // UI frames still to draw after the last input event
+	static std::unique_ptr<InputRecorder> mInputRecorder; // static, the GLFW callbacks record into it
+	static std::unique_ptr<InputReplay> mInputReplay;
+	uint32_t mMovementKeys; // CameraMovement bits held this frame
 	glm::mat4 mView, mProjection;
 	glm::vec4 mClearColor;
 
+	// simulation runs at a fixed rate apart from rendering, the view interpolates between the last two steps
+	SimulationState mSimulation[2]; // previous and current
+	double mSimulationAccumulator; // time not simulated yet, less than a step after Update
+	float mSimulationAlpha;
+	uint32_t mSimulationSteps; // taken in the last Update
+
 	bool mInSceneView;
 
+	// transient per frame data, reset at the end of Render
+	FrameArena mFrameArena;
+	size_t mFrameArenaUsed;
+	AllocationStats mFrameAllocations, mFrameAllocationStart;
+	uint32_t mDrawCount, mCulledCount;
+
+	// a frame is recorded into one buffer while the render thread replays the other
+	CommandBuffer mCommandBuffers[2];
+	std::unique_ptr<ImGuiDrawSnapshot> mImGuiSnapshots[2];
+	uint32_t mCommandBufferIndex;
+	uint32_t mCommandCount;
+	size_t mCommandBytes;
+
+	// on demand, the loop sleeps while nothing changes and the scene texture is only redrawn when damaged
+	bool mIsOnDemandRendering;
+	bool mIsSceneDamaged;
+	glm::mat4 mRenderedView, mRenderedProjection;
+
+	// image export, the frames to write are requested one per rendered frame while the readback ring and the
+	// exporter have room, so a sequence runs as fast as it renders
+	std::unique_ptr<FramebufferReadback> mReadback;
+	std::unique_ptr<ImageExporter> mExporter;
+	std::string mExportPath; // a sequence pattern when more than one frame is exported
+	uint32_t mExportFrameCount, mExportFrame; // to request, requested so far
+	bool mIsTurntable;
+	glm::vec3 mTurntableTarget;
+	float mTurntableRadius, mTurntableHeight, mTurntableAngle;
+
+	std::unique_ptr<StressSceneSettings> mPendingStressScene;
+	double mStressSceneSeconds; // the last generation took
+
+	std::unique_ptr<EditJournal> mJournal;
+	std::future<bool> mCompaction; // the autosave snapshot being written on the thread pool
+	bool mIsCompactionQueued; // asked for while one was being written
+	std::unique_ptr<AssetManager> mAssets;
+	std::unique_ptr<AssetDatabase> mAssetDatabase;
+
 	std::shared_ptr<InputTextCallback_UserData> mTextData;
 	std::shared_ptr<InputTextCallback_UserData> mEditShaderTextData;
 
+	bool LoadGl(void* (*getProcAddress)(const char*));
 	void LoadAssets();
+	void FinishHeadlessFrame();
+	void RequestAssets();
+	AssetId RequestTexture(const std::string& name, const std::string& path, const std::vector<AssetId>& dependencies = {});
+	void RequestScene(const std::string& path, const std::vector<AssetId>& dependencies, std::function<void()> onLoaded);
+	bool AddSceneMaterial(const SceneMaterial& material);
+	bool AddSceneObject(const SceneObject& object);
+	Handle<Material> SetMaterial(NameId name, std::unique_ptr<Shader> shader, NameId texture);
+	void DestroyMaterial(NameId name);
+	void DestroyObject(NameId name);
+	void CollectResources();
+	Entity& SetEntity(std::string name, const Entity& entity);
+	void DestroyEntity(const std::string& name);
+	void ClearEntities();
+	void DestroyEntities(std::string_view prefix); // every entity whose name starts with prefix
+	bool BuildStressScene(const StressSceneSettings& settings);
+	void AddSceneEntities(SceneEntities& entities, size_t begin, size_t end);
+	void RestoreAutosave(const std::vector<AssetId>& dependencies);
+	void SnapshotScene(SceneFileData& scene);
+	void CompactJournal();
+	void RecordEdit(const JournalRecord& record);
+	void RecordEntityTransform(const std::string& name);
+	void ApplyJournalRecord(const JournalRecord& record);
 	void ProcessInput();
+	void ApplyInputEvent(const InputEvent& event);
+	void FixedUpdate();
+	void InterpolateDynamicEntities();
 	static void MouseCallback(GLFWwindow* window, double xposIn, double yposIn);
 	static void ScrollCallback(GLFWwindow* window, double xoffset, double yoffset);
 	static void FramebufferResizeCallback(GLFWwindow* window, int width, int height);
 	void ImGuiRender();
-	void RenderEntity(std::shared_ptr<Entity> entity);
+	void BuildEntityRows(std::vector<uint32_t>& rows, std::string_view query, NameId objectFilter, NameId materialFilter, EntitySort sort) const;
+	void BuildDrawList(FrameVector<DrawItem>& drawList);
 };
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+constexpr uint32_t AssetDatabaseVersion = 1;
+
+struct AssetRecord
+{
+	uint64_t contentHash = 0; // XXH64 of the source file
+	uint64_t size = 0;
+	int64_t modifiedTime = 0; // file clock ticks
+	uint64_t settingsHash = 0; // import settings the artifacts were derived with
+	std::vector<std::string> artifacts; // derived files, e.g. mesh cache entries
+};
+
+struct AssetDatabaseStats
+{
+	uint32_t checked = 0;
+	uint32_t rehashed = 0; // size or modification time moved
+	uint32_t changed = 0; // content differs from the record, artifacts dropped
+	uint32_t removed = 0;
+	double seconds = 0.0;
+};
+
+// Source files by path with what was derived from them. A warm start only stats every source, files whose size
+// or modification time moved are rehashed and keep their artifacts when the content turns out to be the same.
+// All methods are thread safe.
+class AssetDatabase
+{
+public:
+	AssetDatabase();
+
+	bool Load(const std::string& path);
+	bool Save(); // to the path given to Load, only when something changed
+
+	// Brings the records up to date with the given sources, in parallel on the thread pool. Records of paths
+	// not in the list are dropped.
+	void Refresh(const std::vector<std::string>& paths, AssetDatabaseStats* stats = nullptr);
+
+	bool Find(const std::string& path, AssetRecord& record) const;
+
+	// Artifacts derived from the current content with these settings
+	bool GetArtifacts(const std::string& path, uint64_t settingsHash, std::vector<std::string>& artifacts) const;
+	void SetArtifacts(const std::string& path, uint64_t settingsHash, std::vector<std::string> artifacts);
+
+private:
+	mutable std::mutex mMutex;
+	std::unordered_map<std::string, AssetRecord> mRecords;
+	std::string mPath;
+	bool mIsDirty;
+};
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class ThreadPool;
+
+using AssetId = uint32_t;
+constexpr AssetId InvalidAsset = UINT32_MAX;
+
+enum class AssetState : uint8_t
+{
+	Waiting, // for dependencies
+	Loading, // CPU work on a worker thread
+	Uploading, // queued for the main thread
+	Ready,
+	Failed
+};
+
+struct AssetProgress
+{
+	uint32_t total = 0;
+	uint32_t ready = 0;
+	uint32_t failed = 0;
+
+	bool IsDone() const { return ready + failed == total; }
+	float GetFraction() const { return total ? (float)(ready + failed) / total : 1.0f; }
+};
+
+// Loads assets as a dependency graph. An asset starts once all its dependencies finished: load runs on a worker
+// thread, then upload runs on the main thread inside Update, which spends at most a time budget per frame so GL
+// uploads never stall the UI. Either step may be empty. A failed dependency does not fail its dependents, they
+// check for what they need the same way the synchronous loaders do.
+class AssetManager
+{
+public:
+	AssetManager(ThreadPool& pool);
+	~AssetManager(); // waits for loads still running
+
+	AssetManager(const AssetManager&) = delete;
+	AssetManager& operator=(const AssetManager&) = delete;
+
+	// Main thread only, also allowed from inside an upload step
+	AssetId Request(const std::string& name, const std::vector<AssetId>& dependencies, std::function<bool()> load, std::function<bool()> upload = nullptr);
+	AssetId Find(const std::string& name) const;
+
+	void Update(double budgetSeconds); // runs queued uploads, at least one per call
+
+	AssetState GetState(AssetId id) const;
+	AssetProgress GetProgress() const;
+	std::vector<std::string> GetPending(size_t maxCount) const; // names of assets not finished yet
+
+private:
+	struct Asset
+	{
+		std::string name;
+		AssetState state = AssetState::Waiting;
+		uint32_t waitingOn = 0;
+		std::vector<AssetId> dependents;
+		std::function<bool()> load;
+		std::function<bool()> upload;
+	};
+
+	void Start(AssetId id); // mMutex held
+	void Finish(AssetId id, bool succeeded); // mMutex held
+
+private:
+	ThreadPool& mPool;
+	std::deque<Asset> mAssets; // indexed by AssetId, a deque so references stay valid while it grows
+	std::unordered_map<std::string, AssetId> mNames;
+	std::deque<AssetId> mUploads;
+	AssetProgress mProgress;
+	uint32_t mLoadsInFlight;
+
+	mutable std::mutex mMutex;
+	std::condition_variable mLoadsDone;
+};
@@ -19,8 +19,13 @@ public:
     Camera(glm::vec3 position = glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f), float yaw = -90.0, float pitch = 0.0f);
 
     inline glm::mat4 GetViewMatrix() { return glm::lookAt(mPosition, mPosition + mFront, mUp); }
+    inline glm::mat4 GetViewMatrix(const glm::vec3& position) const { return glm::lookAt(position, position + mFront, mUp); } // looking from elsewhere
     const float GetZoom() { return mZoom; }
     const glm::vec3 GetPosition() { return mPosition; }
+    float GetYaw() const { return mYaw; }
+    float GetPitch() const { return mPitch; }
+
+    void SetState(const glm::vec3& position, float yaw, float pitch, float zoom);
 
     void ProcessKeyboard(CameraMovement direction, float deltaTime);
     void ProcessMouseMovement(float xoffset, float yoffset, bool constrainPitch = true);
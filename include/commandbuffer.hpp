@@ -0,0 +1,87 @@
+#pragma once
+
+#include "framearena.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+
+enum class CommandType : uint16_t
+{
+	Jump, // continues in the next chunk
+	End,
+	BindFramebuffer,
+	Viewport,
+	Enable,
+	Disable,
+	ClearColor,
+	Clear,
+	BindProgram,
+	BindTexture,
+	BindVertexArray,
+	UniformInt,
+	UniformFloat,
+	UniformFloat2,
+	UniformFloat3,
+	UniformFloat4,
+	UniformMat3,
+	UniformMat4,
+	DrawElements,
+	DrawArrays,
+	Callback
+};
+
+// GL work recorded on the main thread and replayed on the render thread. Commands are packed back to back in chunks
+// taken from the buffer's own arena, each one a small header followed by its arguments, so recording a frame does
+// not touch the heap once the arena has grown to fit. Everything is referenced by GL name and uniform location,
+// replaying never looks at a Shader or VertexArray that may be gone by then.
+class CommandBuffer
+{
+public:
+	CommandBuffer(size_t initialSize = 1 << 16);
+
+	CommandBuffer(const CommandBuffer&) = delete;
+	CommandBuffer& operator=(const CommandBuffer&) = delete;
+
+	void BindFramebuffer(uint32_t framebuffer);
+	void Viewport(int32_t x, int32_t y, int32_t width, int32_t height);
+	void Enable(uint32_t capability);
+	void Disable(uint32_t capability);
+	void ClearColor(const glm::vec4& color);
+	void Clear(uint32_t mask);
+
+	void BindProgram(uint32_t program);
+	void BindTexture(uint32_t texture); // to GL_TEXTURE_2D of unit 0
+	void BindVertexArray(uint32_t vertexArray);
+
+	// Applies to the program bound before, a location of -1 records nothing
+	void SetUniform(int32_t location, int val);
+	void SetUniform(int32_t location, float val);
+	void SetUniform(int32_t location, const glm::vec2& val);
+	void SetUniform(int32_t location, const glm::vec3& val);
+	void SetUniform(int32_t location, const glm::vec4& val);
+	void SetUniform(int32_t location, const glm::mat3& val);
+	void SetUniform(int32_t location, const glm::mat4& val);
+
+	void DrawElements(uint32_t mode, uint32_t count, uint32_t indexType);
+	void DrawArrays(uint32_t mode, uint32_t count);
+
+	// Runs fn(data) on the render thread in order with the rest, data has to outlive the replay
+	void Callback(void (*fn)(void*), void* data);
+
+	void Execute() const;
+	void Reset();
+
+	uint32_t GetCommandCount() const { return mCommandCount; }
+	size_t GetSize() const { return mArena.GetUsed(); }
+
+private:
+	void* Push(CommandType type, size_t argumentSize);
+
+private:
+	FrameArena mArena;
+	uint8_t* mFirst;
+	uint8_t* mWrite;
+	uint8_t* mChunkEnd;
+	uint32_t mCommandCount;
+};
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class JournalRecordType : uint8_t
+{
+	CreateEntity,
+	DestroyEntity,
+	SetEntityTransform,
+	CreateObject,
+	DestroyObject,
+	CreateMaterial,
+	DestroyMaterial
+};
+
+// One edit made in the editor. Records hold absolute values so replaying a record twice gives the same scene.
+struct JournalRecord
+{
+	JournalRecordType type = JournalRecordType::CreateEntity;
+	std::string name;
+
+	std::string object; // CreateEntity
+	std::string vaName, matName; // CreateObject
+	std::string vertexSource, fragmentSource, texture; // CreateMaterial
+
+	// CreateEntity, SetEntityTransform
+	glm::vec3 translate = glm::vec3(0.0f);
+	float angle = 0.0f;
+	glm::vec3 axis = glm::vec3(0.0f, 1.0f, 0.0f);
+	glm::vec3 scale = glm::vec3(1.0f);
+};
+
+// Append only log of edits on top of the last scene snapshot. Records are encoded on the calling thread and
+// written plus synced to disk in batches on a background thread, so recording an edit never waits on the disk.
+// On disk every record is: uint32 payload size, uint32 checksum of the payload, payload.
+class EditJournal
+{
+public:
+	EditJournal();
+	~EditJournal();
+
+	EditJournal(const EditJournal&) = delete;
+	EditJournal& operator=(const EditJournal&) = delete;
+
+	// Opens the journal for appending, anything past validSize (a torn record from a crash) is cut off first
+	bool Open(const std::string& path, uint64_t validSize);
+	void Close(); // writes out everything still pending
+
+	void Append(const JournalRecord& record);
+
+	// Drops all records, used right after a snapshot containing them was written
+	bool Reset();
+
+	// Moves the records so far to retiredPath and goes on with an empty journal, so a snapshot of the scene as it
+	// is now can be written in the background while new edits are recorded. Records of an earlier retired segment
+	// that was never covered by a snapshot stay in front of them. Remove retiredPath once the snapshot is written,
+	// until then recovery replays it before the journal.
+	bool Rotate(const std::string& retiredPath);
+
+	uint64_t GetSize() const; // written and pending bytes
+
+	// Calls fn for every intact record in order and returns the size of the intact part of the file
+	static uint64_t Replay(const std::string& path, const std::function<void(const JournalRecord&)>& fn);
+
+	// One record as the journal stores it, for files that carry edits along with other data
+	static void Encode(const JournalRecord& record, std::vector<uint8_t>& out);
+	// Returns the size of the record at data, 0 when it is torn or corrupt
+	static size_t Decode(const uint8_t* data, size_t size, JournalRecord& record);
+
+private:
+	void WriterLoop();
+	bool WriteBatch(const std::vector<uint8_t>& batch);
+
+private:
+	static constexpr std::chrono::milliseconds BatchInterval{ 200 };
+
+	std::string mPath;
+	FILE* mFile;
+	std::atomic<uint64_t> mWrittenBytes;
+
+	std::thread mWriter;
+	std::vector<uint8_t> mPending;
+	mutable std::mutex mMutex;
+	std::mutex mFileMutex;
+	std::condition_variable mCondition;
+	bool mIsStopping;
+};
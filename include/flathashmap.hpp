@@ -0,0 +1,203 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Open addressing hash map for integer ids with linear probing, entries live in one array. The all ones key marks
+// empty slots and can't be stored. Inserting may move entries, so pointers into the map only last until then.
+template<typename K, typename V>
+class FlatHashMap
+{
+	static_assert(std::is_unsigned<K>::value, "FlatHashMap keys are unsigned ids");
+
+public:
+	static constexpr K EmptyKey = (K)~(K)0;
+
+	struct Entry
+	{
+		K key = EmptyKey;
+		V value = {};
+	};
+
+	template<typename EntryType>
+	class Iterator
+	{
+	public:
+		Iterator(EntryType* entry, EntryType* end)
+			: mEntry(entry)
+			, mEnd(end)
+		{
+			Skip();
+		}
+
+		EntryType& operator*() const { return *mEntry; }
+		EntryType* operator->() const { return mEntry; }
+		Iterator& operator++() { mEntry++; Skip(); return *this; }
+		bool operator==(const Iterator& other) const { return mEntry == other.mEntry; }
+
+	private:
+		void Skip()
+		{
+			while (mEntry != mEnd && mEntry->key == EmptyKey)
+			{
+				mEntry++;
+			}
+		}
+
+		EntryType* mEntry;
+		EntryType* mEnd;
+	};
+
+	FlatHashMap()
+		: mSize(0)
+	{
+
+	}
+
+	V* Find(K key)
+	{
+		if (mSize == 0 || key == EmptyKey)
+		{
+			return nullptr;
+		}
+		for (size_t i = GetIdealSlot(key);; i = (i + 1) & GetMask())
+		{
+			if (mEntries[i].key == key)
+			{
+				return &mEntries[i].value;
+			}
+			if (mEntries[i].key == EmptyKey)
+			{
+				return nullptr;
+			}
+		}
+	}
+
+	const V* Find(K key) const { return const_cast<FlatHashMap*>(this)->Find(key); }
+	bool Contains(K key) const { return Find(key) != nullptr; }
+
+	// Returns false and leaves the existing value alone when the key is already present
+	bool Insert(K key, V value)
+	{
+		if (Find(key))
+		{
+			return false;
+		}
+		Emplace(key) = std::move(value);
+		return true;
+	}
+
+	void InsertOrAssign(K key, V value)
+	{
+		V* existing = Find(key);
+		if (existing)
+		{
+			*existing = std::move(value);
+		}
+		else
+		{
+			Emplace(key) = std::move(value);
+		}
+	}
+
+	V& operator[](K key)
+	{
+		V* existing = Find(key);
+		return existing ? *existing : Emplace(key);
+	}
+
+	bool Erase(K key)
+	{
+		if (mSize == 0 || key == EmptyKey)
+		{
+			return false;
+		}
+		size_t i = GetIdealSlot(key);
+		while (mEntries[i].key != key)
+		{
+			if (mEntries[i].key == EmptyKey)
+			{
+				return false;
+			}
+			i = (i + 1) & GetMask();
+		}
+
+		// backward shift: pull later entries of the probe chain into the hole so lookups never need tombstones
+		for (size_t j = (i + 1) & GetMask(); mEntries[j].key != EmptyKey; j = (j + 1) & GetMask())
+		{
+			size_t ideal = GetIdealSlot(mEntries[j].key);
+			bool canMove = i <= j ? (ideal <= i || ideal > j) : (ideal <= i && ideal > j);
+			if (canMove)
+			{
+				mEntries[i] = std::move(mEntries[j]);
+				i = j;
+			}
+		}
+		mEntries[i] = Entry();
+		mSize--;
+		return true;
+	}
+
+	void Clear()
+	{
+		mEntries.clear();
+		mSize = 0;
+	}
+
+	size_t GetSize() const { return mSize; }
+	bool IsEmpty() const { return mSize == 0; }
+
+	Iterator<Entry> begin() { return { mEntries.data(), mEntries.data() + mEntries.size() }; }
+	Iterator<Entry> end() { return { mEntries.data() + mEntries.size(), mEntries.data() + mEntries.size() }; }
+	Iterator<const Entry> begin() const { return { mEntries.data(), mEntries.data() + mEntries.size() }; }
+	Iterator<const Entry> end() const { return { mEntries.data() + mEntries.size(), mEntries.data() + mEntries.size() }; }
+
+private:
+	size_t GetMask() const { return mEntries.size() - 1; }
+
+	size_t GetIdealSlot(K key) const
+	{
+		// ids are often sequential, mix them so neighbours don't pile up in one run
+		uint64_t h = (uint64_t)key * 0x9E3779B97F4A7C15ull;
+		return (size_t)(h >> 32) & GetMask();
+	}
+
+	V& Emplace(K key)
+	{
+		// keep the load under 3/4 so probe chains stay short
+		if ((mSize + 1) * 4 > mEntries.size() * 3)
+		{
+			Grow();
+		}
+		size_t i = GetIdealSlot(key);
+		while (mEntries[i].key != EmptyKey)
+		{
+			i = (i + 1) & GetMask();
+		}
+		mEntries[i].key = key;
+		mSize++;
+		return mEntries[i].value;
+	}
+
+	void Grow()
+	{
+		std::vector<Entry> old = std::move(mEntries);
+		mEntries.clear();
+		mEntries.resize(old.empty() ? 16 : old.size() * 2);
+		mSize = 0;
+		for (auto& entry : old)
+		{
+			if (entry.key != EmptyKey)
+			{
+				Emplace(entry.key) = std::move(entry.value);
+			}
+		}
+	}
+
+private:
+	std::vector<Entry> mEntries;
+	size_t mSize;
+};
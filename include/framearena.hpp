@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+// Bump allocator for data that only lives until the end of the frame. Nothing is freed on its own, Reset drops
+// everything at once. A frame that outgrows the block chains more blocks, the next Reset folds them into one block
+// big enough for that frame, so once the size settles frames no longer touch the heap.
+// Doubles as a pmr resource: FrameVector<T> v(&arena);
+class FrameArena : public std::pmr::memory_resource
+{
+public:
+	explicit FrameArena(size_t initialSize = 1 << 20);
+	~FrameArena();
+
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator=(const FrameArena&) = delete;
+
+	void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+	template<typename T>
+	T* Allocate(size_t count)
+	{
+		return static_cast<T*>(Allocate(count * sizeof(T), alignof(T)));
+	}
+
+	void Reset();
+
+	size_t GetUsed() const { return mUsed; } // bytes handed out since the last Reset
+	size_t GetCapacity() const;
+
+private:
+	void* do_allocate(size_t bytes, size_t alignment) override { return Allocate(bytes, alignment); }
+	void do_deallocate(void*, size_t, size_t) override {}
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+	void AddBlock(size_t size);
+
+private:
+	struct Block
+	{
+		std::unique_ptr<std::byte[]> data;
+		size_t size;
+	};
+
+	std::vector<Block> mBlocks;
+	size_t mOffset; // into the last block
+	size_t mUsed;
+};
+
+template<typename T>
+using FrameVector = std::pmr::vector<T>;
+using FrameString = std::pmr::string;
@@ -3,6 +3,7 @@
 #include <glm/glm.hpp>
 
 #include <cstdint>
+#include <vector>
 
 class Framebuffer
 {
@@ -17,6 +18,9 @@ public:
 	void SetClearColour(const glm::vec4& cc) { mClearColour = cc; }
 	const glm::vec4& GetClearColour() { return mClearColour; }
 
+	// Color attachment as RGBA8 with the bottom row first, after everything submitted so far has been drawn
+	void ReadPixels(std::vector<uint8_t>& pixels) const;
+
 private:
 	uint32_t mFB;
 	uint32_t mTextureId;
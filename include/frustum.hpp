@@ -0,0 +1,14 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// View frustum as six inward facing planes, xyz is the normal and w the distance
+struct Frustum
+{
+	glm::vec4 planes[6];
+
+	static Frustum FromMatrix(const glm::mat4& viewProjection);
+
+	// Local space box transformed by model, conservative: a box near a frustum corner may pass
+	bool IsBoxVisible(const glm::vec3& boundsMin, const glm::vec3& boundsMax, const glm::mat4& model) const;
+};
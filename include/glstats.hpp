@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+
+// Counts of the GL calls made during one frame
+struct GlFrameStats
+{
+	uint32_t drawCalls = 0;
+	uint64_t triangles = 0;
+	uint32_t stateChanges = 0; // binds, enables and viewports that changed something
+	uint32_t redundantBinds = 0; // binds of what was already bound
+	uint32_t uniformUploads = 0;
+	uint64_t bufferUploadBytes = 0;
+	uint64_t textureUploadBytes = 0;
+};
+
+enum class GlObjectType
+{
+	Buffer,
+	Texture,
+	VertexArray,
+	Framebuffer,
+	Renderbuffer,
+	Program,
+	Shader,
+	Query,
+	Count
+};
+
+// GL objects alive right now and an estimate of the memory behind them
+struct GlObjectStats
+{
+	uint32_t counts[(int)GlObjectType::Count] = {};
+	uint64_t bytes[(int)GlObjectType::Count] = {}; // buffers, textures and renderbuffers only
+};
+
+// Swaps the glad function pointers for wrappers that count calls and track bindings and objects before forwarding.
+// Everything but the getters runs on the thread owning the context. Calls made through other loaders, like the one
+// of ImGui's GL backend, are not seen, and neither are objects created while it was not installed.
+class GlStats
+{
+public:
+	static GlStats& Get();
+	static const char* GetObjectTypeName(GlObjectType type);
+
+	void Install();
+	void Uninstall();
+	bool IsInstalled() const { return mIsInstalled; }
+
+	// On the context's thread once the frame is submitted, publishes its counts and starts the next frame
+	void EndFrame();
+
+	GlFrameStats GetFrameStats() const;
+	GlObjectStats GetObjectStats() const;
+
+	// Used by the wrappers
+	GlFrameStats& GetCurrentFrame() { return mFrame; }
+	void AddObject(GlObjectType type, uint32_t name);
+	void RemoveObject(GlObjectType type, uint32_t name);
+	void SetObjectBytes(GlObjectType type, uint32_t name, uint64_t bytes);
+	void SetTextureImageBytes(uint32_t name, uint32_t image, uint64_t bytes); // image is a mip level and cube face
+
+private:
+	GlStats();
+
+private:
+	bool mIsInstalled;
+	GlFrameStats mFrame;
+
+	std::unordered_map<uint32_t, uint64_t> mObjects[(int)GlObjectType::Count]; // name to bytes
+	std::map<uint64_t, uint64_t> mTextureImages; // name << 32 | image to bytes
+	GlObjectStats mObjectStats;
+
+	mutable std::mutex mPublishedMutex;
+	GlFrameStats mPublishedFrame;
+	GlObjectStats mPublishedObjects;
+};
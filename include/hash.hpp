@@ -0,0 +1,10 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+
+// XXH64 of the given bytes
+uint64_t HashBytes(const void* data, size_t size, uint64_t seed = 0);
+
+inline uint64_t HashString(std::string_view str, uint64_t seed = 0) { return HashBytes(str.data(), str.size(), seed); }
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <memory>
+
+// OpenGL 3.3 core context without a window or display, from EGL's surfaceless platform or else OSMesa. Both libraries
+// are opened at run time, neither is needed to build or to run with a window. Not available on Windows.
+class HeadlessContext
+{
+public:
+	HeadlessContext();
+	~HeadlessContext();
+
+	HeadlessContext(const HeadlessContext&) = delete;
+	HeadlessContext& operator=(const HeadlessContext&) = delete;
+
+	bool Create();
+	void Destroy();
+
+	// on the thread that is going to use it, a context is current on one thread at a time
+	bool MakeCurrent();
+	void ReleaseCurrent();
+
+	bool IsCreated() const { return mLibrary != nullptr; }
+	const char* GetBackendName() const;
+
+	// GL loader for glad, resolves from the context created last
+	static void* GetProcAddress(const char* name);
+
+private:
+	struct Library;
+
+	bool CreateEgl();
+	bool CreateOsMesa();
+
+	std::unique_ptr<Library> mLibrary;
+	inline static Library* mActiveLibrary = nullptr;
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// 8 bit RGBA pixels, top row first
+struct ImageRgba8
+{
+	uint32_t width = 0, height = 0;
+	std::vector<uint8_t> pixels;
+};
+
+bool WritePng(const std::string& path, const ImageRgba8& image);
+// Half float RGBA, the sRGB pixels converted to linear
+bool WriteExr(const std::string& path, const ImageRgba8& image);
+bool WritePpm(const std::string& path, const ImageRgba8& image);
+// Picks the format by extension: .png, .exr or .ppm
+bool WriteImage(const std::string& path, const ImageRgba8& image);
+
+// The path of one image of a sequence: the last run of # in pattern becomes the zero padded index, a pattern without
+// one gets -0000 appended to its stem
+std::string FormatSequencePath(const std::string& pattern, uint32_t index);
+
+// Encodes and writes images on the thread pool. Callers check CanAccept first, so a slow disk holds back new work
+// instead of queueing up frames in memory. reserved counts the images still on their way to Write.
+class ImageExporter
+{
+public:
+	explicit ImageExporter(uint32_t maxInFlight);
+	~ImageExporter();
+
+	bool CanAccept(uint32_t reserved = 0) const { return mInFlight.load() + reserved < mMaxInFlight; }
+	void Write(std::string path, ImageRgba8&& image); // any thread
+	void WaitIdle();
+	void WaitForRoom(); // until CanAccept()
+	void ResetCounts() { mWritten = 0; mFailed = 0; } // between batches, once idle
+
+	uint32_t GetInFlight() const { return mInFlight.load(); }
+	uint32_t GetWrittenCount() const { return mWritten.load(); }
+	uint32_t GetFailedCount() const { return mFailed.load(); }
+
+private:
+	uint32_t mMaxInFlight;
+	std::atomic<uint32_t> mInFlight, mWritten, mFailed;
+	std::mutex mMutex;
+	std::condition_variable mImageDone;
+};
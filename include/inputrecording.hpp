@@ -0,0 +1,104 @@
+#pragma once
+
+#include "editjournal.hpp"
+
+#include <glm/glm.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+enum class InputEventType : uint8_t
+{
+	Keys, // bits of the held CameraMovement keys
+	CameraMode, // InputCameraFlags
+	MouseMove, // offset in value
+	Scroll, // offset in value.y
+	Edit,
+	End
+};
+
+enum InputCameraFlags : uint32_t
+{
+	InputCameraInUse = 1 << 0,
+	InputCameraSceneView = 1 << 1
+};
+
+struct InputEvent
+{
+	InputEventType type = InputEventType::End;
+	double time = 0.0; // seconds since the recording started
+	uint32_t bits = 0; // Keys, CameraMode
+	glm::vec2 value = glm::vec2(0.0f); // MouseMove, Scroll
+	JournalRecord edit; // Edit
+};
+
+// Where the camera was when a recording started, a replay starts from there
+struct InputRecordingStart
+{
+	glm::vec3 cameraPosition = glm::vec3(0.0f);
+	float yaw = 0.0f, pitch = 0.0f, zoom = 0.0f;
+};
+
+constexpr uint32_t InputRecordingVersion = 1;
+
+// Writes input and edit events with their times to a compact binary file: "MM3R", the version and the start, then per
+// event its type, the microseconds since the previous event as a varint and the payload. Edits are stored as
+// journal records. Keys and camera mode are states, only their changes are written.
+class InputRecorder
+{
+public:
+	InputRecorder();
+	~InputRecorder();
+
+	InputRecorder(const InputRecorder&) = delete;
+	InputRecorder& operator=(const InputRecorder&) = delete;
+
+	bool Open(const std::string& path, const InputRecordingStart& start);
+	void Close(); // ends the recording at the current time
+
+	bool IsOpen() const { return mFile != nullptr; }
+	double GetTime() const;
+	uint32_t GetEventCount() const { return mEventCount; }
+
+	void Record(const InputEvent& event); // the time is taken now, event.time is ignored
+
+private:
+	void Flush();
+
+private:
+	FILE* mFile;
+	std::string mPath;
+	std::chrono::steady_clock::time_point mStart;
+	uint64_t mLastMicroseconds;
+	uint32_t mLastKeys, mLastCameraMode;
+	uint32_t mEventCount;
+	std::vector<uint8_t> mBuffer;
+};
+
+// Plays a recording back at whatever rate it is advanced, so with a fixed step every run sees the same events
+// on the same frames
+class InputReplay
+{
+public:
+	bool Open(const std::string& path);
+
+	// Hands fn the events up to the current time, then moves it on by deltaTime
+	void Advance(double deltaTime, const std::function<void(const InputEvent&)>& fn);
+
+	bool IsFinished() const { return mNext >= mEvents.size(); }
+	const InputRecordingStart& GetStart() const { return mStart; }
+	double GetTime() const { return mTime; }
+	double GetDuration() const { return mEvents.empty() ? 0.0 : mEvents.back().time; }
+	uint32_t GetFrameCount(double deltaTime) const { return (uint32_t)(GetDuration() / deltaTime) + 1; } // Advance calls until finished
+	size_t GetEventCount() const { return mEvents.size(); }
+
+private:
+	InputRecordingStart mStart;
+	std::vector<InputEvent> mEvents;
+	size_t mNext = 0;
+	double mTime = 0.0;
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <utility>
+
+enum class JsonType
+{
+	Null,
+	Bool,
+	Number,
+	String,
+	Array,
+	Object
+};
+
+class JsonValue
+{
+public:
+	JsonValue() : mType(JsonType::Null), mNumber(0.0), mBool(false) {}
+
+	JsonType GetType() const { return mType; }
+	bool IsNull() const { return mType == JsonType::Null; }
+	bool IsArray() const { return mType == JsonType::Array; }
+	bool IsObject() const { return mType == JsonType::Object; }
+
+	double GetNumber(double defaultValue = 0.0) const { return mType == JsonType::Number ? mNumber : defaultValue; }
+	bool GetBool(bool defaultValue = false) const { return mType == JsonType::Bool ? mBool : defaultValue; }
+	const std::string& GetString() const { return mString; }
+
+	size_t GetSize() const { return mType == JsonType::Object ? mMembers.size() : mElements.size(); }
+	const JsonValue& operator[](size_t index) const;
+	const std::vector<JsonValue>& GetElements() const { return mElements; }
+	const std::vector<std::pair<std::string, JsonValue>>& GetMembers() const { return mMembers; }
+
+	// Returns nullptr when the key is missing or this is not an object
+	const JsonValue* Find(std::string_view key) const;
+
+private:
+	friend class JsonParser;
+
+	JsonType mType;
+	double mNumber;
+	bool mBool;
+	std::string mString;
+	std::vector<JsonValue> mElements;
+	std::vector<std::pair<std::string, JsonValue>> mMembers;
+};
+
+bool ParseJson(std::string_view text, JsonValue& out, std::string* error = nullptr);
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <cstdio>
+
 #ifdef NDEBUG
-#define LOG(msg) (void)0
+#define LOG(...) (void)0
 #else 
-#define LOG(msg, ...) printf(msg, __VA_ARGS__), printf("\n")
+#define LOG(msg, ...) printf(msg, ##__VA_ARGS__), printf("\n")
 #endif
\ No newline at end of file
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// LZ4 block format (no frame header), compatible with the reference LZ4_compress_default/LZ4_decompress_safe
+
+inline size_t Lz4CompressBound(size_t size) { return size + size / 255 + 16; }
+
+// Returns the compressed size, or 0 when dstCapacity is below Lz4CompressBound(srcSize)
+size_t Lz4Compress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity);
+
+// Fails on malformed input or when the output does not come out at exactly dstSize bytes
+bool Lz4Decompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize);
@@ -7,21 +7,32 @@
 
 #include <glm/glm.hpp>
 
+#include "resourcepool.hpp"
+
+class CommandBuffer;
 class Shader;
 class Texture;
 
 class Material
 {
 public:
-	Material(std::shared_ptr<Shader> shader, std::shared_ptr<Texture> texture = nullptr);
+	Material(Handle<Shader> shader, Handle<Texture> texture = {});
 	Material(const Material& other);
 
-	inline Shader* GetShader() const { return mShader.get(); }
-	inline Texture* GetTexture() const { return mTexture ? mTexture.get() : nullptr; }
+	inline Handle<Shader> GetShader() const { return mShader; }
+	inline Handle<Texture> GetTexture() const { return mTexture; }
+
+	const std::unordered_map<std::string, int>& GetUniformInts() const { return mUniformInts; }
+	const std::unordered_map<std::string, float>& GetUniformFloats() const { return mUniformFloats; }
+	const std::unordered_map<std::string, glm::vec2>& GetUniformFloat2s() const { return mUniformFloat2s; }
+	const std::unordered_map<std::string, glm::vec3>& GetUniformFloat3s() const { return mUniformFloat3s; }
+	const std::unordered_map<std::string, glm::vec4>& GetUniformFloat4s() const { return mUniformFloat4s; }
+	const std::unordered_map<std::string, glm::mat3>& GetUniformMat3s() const { return mUniformMat3s; }
+	const std::unordered_map<std::string, glm::mat4>& GetUniformMat4s() const { return mUniformMat4s; }
 
-	void SetShader(std::shared_ptr<Shader> shader);
-	void SetTexture(std::shared_ptr<Texture> texture);
-	void UpdateShaderUniforms();
+	void SetShader(Handle<Shader> shader);
+	void SetTexture(Handle<Texture> texture);
+	void UpdateShaderUniforms(CommandBuffer& commands, const Shader& shader) const;
 
 #define GETUNIFORMVALUE(mapName, defaultReturn) \
 const auto& it = mapName.find(name);\
@@ -61,8 +72,8 @@ return defaultReturn;
 	}
 
 private:
-	std::shared_ptr<Shader> mShader;
-	std::shared_ptr<Texture> mTexture;
+	Handle<Shader> mShader;
+	Handle<Texture> mTexture;
 
 	// Data
 	std::unordered_map<std::string, int> mUniformInts;
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "mappedfile.hpp"
+#include "meshimporter.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+class VertexArray;
+
+constexpr uint32_t MeshCacheVersion = 4;
+constexpr uint32_t MeshCacheMaxAttributes = 8;
+constexpr uint32_t MeshCacheAlignment = 64; // every section starts on a cache line
+
+// On disk layout: header, vertex data, index data, lod table. Offsets are from the start of the file.
+struct MeshCacheHeader
+{
+	char magic[4]; // "MM3M"
+	uint32_t version;
+	uint64_t sourceHash;
+	uint64_t fileSize;
+
+	uint32_t vertexCount;
+	uint32_t indexCount;
+	uint32_t stride; // bytes per vertex
+	uint32_t attributeCount;
+	uint32_t layout[MeshCacheMaxAttributes]; // per attribute: count | type << 8 | normalized << 16
+
+	float boundsMin[3];
+	float boundsMax[3];
+
+	uint32_t lodCount;
+	uint32_t indexSize; // 2 or 4 bytes
+	uint64_t vertexOffset;
+	uint64_t indexOffset;
+	uint64_t lodOffset;
+};
+
+struct MeshCacheLod
+{
+	uint32_t firstIndex;
+	uint32_t indexCount;
+	float error; // max deviation from lod 0 in object space units
+	uint32_t reserved;
+};
+
+// A mesh cache file mapped into memory, the vertex and index data are used straight from the mapping
+class MeshCache
+{
+public:
+	MeshCache();
+
+	bool Open(const std::string& path, uint64_t sourceHash);
+	bool Open(const std::string& path); // any source, for callers that track the source hash themselves
+
+	const MeshCacheHeader& GetHeader() const { return *mHeader; }
+	const void* GetVertexData() const { return mFile.GetData() + mHeader->vertexOffset; }
+	const void* GetIndexData() const { return mFile.GetData() + mHeader->indexOffset; } // indexSize bytes per index
+	const MeshCacheLod* GetLods() const { return (const MeshCacheLod*)(mFile.GetData() + mHeader->lodOffset); }
+
+	std::unique_ptr<VertexArray> CreateVertexArray() const;
+
+private:
+	MappedFile mFile;
+	const MeshCacheHeader* mHeader;
+};
+
+uint64_t HashMeshSource(const void* data, size_t size);
+std::string GetMeshCachePath(const std::string& cacheDirectory, uint64_t sourceHash);
+bool WriteMeshCache(const std::string& path, const MeshData& mesh, uint64_t sourceHash);
+
+// Removes the least recently used entries until the ones left take at most maxBytes, opening an entry counts as a
+// use. Entries are named by content, so this is also what drops the ones of sources that changed since.
+uint32_t TrimMeshCache(const std::string& cacheDirectory, uint64_t maxBytes);
+
+// The CPU part of LoadMeshCached, safe to run on a worker thread: maps the cache entry when the source is unchanged,
+// otherwise imports, optimizes and quantizes the mesh and writes the entry. CreateVertexArray uploads the result.
+class PreparedMesh
+{
+public:
+	PreparedMesh();
+
+	bool Prepare(const std::string& path, const std::string& cacheDirectory, MeshImportStats* stats = nullptr);
+	bool PrepareFromCache(const std::string& cachePath, MeshImportStats* stats = nullptr); // skips reading the source
+	bool IsFromCache() const { return mFromCache; }
+	const std::string& GetCachePath() const { return mCachePath; } // empty when the entry could not be written
+
+	std::unique_ptr<VertexArray> CreateVertexArray() const;
+
+private:
+	MeshCache mCache;
+	MeshData mMesh;
+	std::string mCachePath;
+	bool mFromCache;
+};
+
+// Loads the mesh from its cache entry when the source is unchanged, otherwise imports it and writes the entry
+std::shared_ptr<VertexArray> LoadMeshCached(const std::string& path, const std::string& cacheDirectory, MeshImportStats* stats = nullptr, bool* fromCache = nullptr);
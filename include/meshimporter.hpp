@@ -0,0 +1,69 @@
+#pragma once
+
+#include "vertex.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class VertexArray;
+
+struct MeshData
+{
+	std::vector<uint8_t> vertices; // interleaved, described by layout
+	std::vector<uint32_t> indices;
+	std::vector<VertexAttribute> layout; // same as VertexBuffer::SetLayout
+	glm::vec3 boundsMin = glm::vec3(0.0f);
+	glm::vec3 boundsMax = glm::vec3(0.0f);
+
+	uint32_t GetVertexStride() const; // no of bytes per vertex
+	uint32_t GetVertexCount() const;
+	uint32_t GetTriangleCount() const { return (uint32_t)indices.size() / 3; }
+};
+
+struct MeshImportStats
+{
+	size_t bytes = 0;
+	uint32_t vertices = 0;
+	uint32_t triangles = 0;
+	double seconds = 0.0;
+
+	double GetMegabytesPerSecond() const { return seconds > 0.0 ? (bytes / (1024.0 * 1024.0)) / seconds : 0.0; }
+	double GetTrianglesPerSecond() const { return seconds > 0.0 ? triangles / seconds : 0.0; }
+};
+
+struct MeshQuantizationSettings
+{
+	float maxPositionError = 0.0005f; // relative to the bounds diagonal
+	float maxUvError = 1.0f / 2048.0f;
+	float maxNormalError = 0.005f; // in radians, 10 bit components stay within about 0.002
+	bool packNormals = true;
+};
+
+// Max error actually introduced per attribute, an attribute that would exceed its bound is left as floats
+struct MeshQuantizationResult
+{
+	bool halfPositions = false;
+	bool halfUvs = false;
+	bool packedNormals = false;
+	float positionError = 0.0f;
+	float uvError = 0.0f;
+	float normalError = 0.0f; // in radians
+};
+
+// Imported meshes use the float layout { 3, 2, 3 }: position, texcoords, normal.
+// Missing texcoords or normals are zero filled so the existing shaders can be used as they are.
+bool ImportMesh(const std::string& path, MeshData& mesh, MeshImportStats* stats = nullptr);
+bool ImportMesh(const std::string& path, const char* data, size_t size, MeshData& mesh, MeshImportStats* stats = nullptr); // path only picks the format and resolves external buffers
+bool ImportObj(const char* data, size_t size, MeshData& mesh);
+bool ImportGltf(const char* data, size_t size, const std::string& baseDirectory, MeshData& mesh);
+bool ImportGlb(const char* data, size_t size, const std::string& baseDirectory, MeshData& mesh);
+
+// Converts an imported float mesh to half positions (padded to 4), half texcoords and 10:10:10:2 normals
+// where the error bounds allow it. This halves the vertex size of a typical mesh.
+bool QuantizeMesh(MeshData& mesh, const MeshQuantizationSettings& settings = {}, MeshQuantizationResult* result = nullptr);
+
+std::unique_ptr<VertexArray> CreateVertexArray(const MeshData& mesh);
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct MeshData;
+
+constexpr uint32_t DefaultVertexCacheSize = 16; // post transform FIFO size assumed for typical GPUs
+
+struct VertexCacheStatistics
+{
+	uint32_t vertexTransforms = 0; // cache misses of a simulated FIFO cache
+	float acmr = 0.0f; // average cache miss ratio, transforms per triangle (0.5 at best, 3 at worst)
+	float atvr = 0.0f; // average transform to vertex ratio, transforms per referenced vertex (1 at best)
+};
+
+struct MeshOptimizationStats
+{
+	VertexCacheStatistics before;
+	VertexCacheStatistics after;
+	uint32_t clusterCount = 0;
+	double seconds = 0.0;
+};
+
+VertexCacheStatistics AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, uint32_t vertexCount, uint32_t cacheSize = DefaultVertexCacheSize);
+
+// Reorders triangles for post transform cache reuse using Tipsify (Sander et al. 2007). When clusters is not null it
+// receives the first triangle of every run that starts with a cold cache, followed by the triangle count.
+// destination must not alias indices.
+void OptimizeVertexCache(uint32_t* destination, const uint32_t* indices, size_t indexCount, uint32_t vertexCount,
+	uint32_t cacheSize = DefaultVertexCacheSize, std::vector<uint32_t>* clusters = nullptr);
+
+// Splits cache optimized triangles into clusters and sorts them so outward facing clusters draw first. threshold
+// is how much worse than the Tipsify result the local ACMR may get, 1.05 keeps at least 95% of the cache gains.
+// Returns the number of clusters. destination must not alias indices.
+uint32_t OptimizeOverdraw(uint32_t* destination, const uint32_t* indices, size_t indexCount, const float* positions, uint32_t vertexCount,
+	size_t positionStride, const std::vector<uint32_t>& hardClusters, uint32_t cacheSize = DefaultVertexCacheSize, float threshold = 1.05f);
+
+// Renumbers vertices in the order the index buffer first references them and drops unused vertices
+void OptimizeVertexFetch(MeshData& mesh);
+
+// Runs all passes above on a mesh with float positions as its first attribute
+bool OptimizeMesh(MeshData& mesh, MeshOptimizationStats* stats = nullptr);
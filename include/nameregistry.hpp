@@ -0,0 +1,103 @@
+#pragma once
+
+#include "flathashmap.hpp"
+#include "stringinterner.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+// Assets of one kind by interned name. The sorted name list UI widgets show is cached and only rebuilt after
+// the registry changed, GetVersion lets callers cache lists derived from it the same way.
+template<typename V>
+class NameRegistry
+{
+public:
+	NameRegistry()
+		: mVersion(0)
+		, mSortedVersion(UINT32_MAX)
+	{
+
+	}
+
+	V* Find(NameId name) { return mMap.Find(name); }
+	const V* Find(NameId name) const { return mMap.Find(name); }
+	bool Contains(NameId name) const { return mMap.Contains(name); }
+
+	bool Insert(NameId name, V value)
+	{
+		bool inserted = mMap.Insert(name, std::move(value));
+		mVersion += inserted;
+		return inserted;
+	}
+
+	void InsertOrAssign(NameId name, V value)
+	{
+		mVersion += !mMap.Contains(name);
+		mMap.InsertOrAssign(name, std::move(value));
+	}
+
+	bool Erase(NameId name)
+	{
+		bool erased = mMap.Erase(name);
+		mVersion += erased;
+		return erased;
+	}
+
+	void Clear()
+	{
+		mMap.Clear();
+		mVersion++;
+	}
+
+	size_t GetSize() const { return mMap.GetSize(); }
+	bool IsEmpty() const { return mMap.IsEmpty(); }
+	uint32_t GetVersion() const { return mVersion; }
+
+	// In name order
+	const std::vector<NameId>& GetSortedIds() const
+	{
+		UpdateSorted();
+		return mSortedIds;
+	}
+
+	const std::vector<const char*>& GetSortedNames() const
+	{
+		UpdateSorted();
+		return mSortedNames;
+	}
+
+	auto begin() { return mMap.begin(); }
+	auto end() { return mMap.end(); }
+	auto begin() const { return mMap.begin(); }
+	auto end() const { return mMap.end(); }
+
+private:
+	void UpdateSorted() const
+	{
+		if (mSortedVersion == mVersion)
+		{
+			return;
+		}
+		mSortedIds.clear();
+		for (const auto& entry : mMap)
+		{
+			mSortedIds.push_back(entry.key);
+		}
+		std::sort(mSortedIds.begin(), mSortedIds.end(), [](NameId a, NameId b) { return strcmp(GetName(a), GetName(b)) < 0; });
+		mSortedNames.clear();
+		for (NameId id : mSortedIds)
+		{
+			mSortedNames.push_back(GetName(id));
+		}
+		mSortedVersion = mVersion;
+	}
+
+private:
+	FlatHashMap<NameId, V> mMap;
+	uint32_t mVersion;
+
+	mutable uint32_t mSortedVersion;
+	mutable std::vector<NameId> mSortedIds;
+	mutable std::vector<const char*> mSortedNames;
+};
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <string>
+
+struct ProfileCapture;
+
+// Trace Event Format, opens in Perfetto and chrome://tracing. Zones become complete events on one track per lane,
+// counters become counter tracks.
+bool WriteChromeTrace(const ProfileCapture& capture, const std::string& path);
+
+// One row per frame: its length, every counter and the time spent in every zone
+bool WriteProfileCsv(const ProfileCapture& capture, const std::string& path);
@@ -0,0 +1,215 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+class CommandBuffer;
+
+struct ProfileEvent
+{
+	const char* name; // a string literal, zones are told apart by it
+	uint64_t start, end; // nanoseconds since the profiler started
+	uint32_t depth; // nesting on its thread, 0 for outermost
+};
+
+// Events of one thread, or of the GPU, inside the captured frame
+struct ProfileLane
+{
+	std::string name;
+	bool isGpu = false;
+	std::vector<ProfileEvent> events;
+};
+
+struct ProfileZoneStats
+{
+	std::string_view name;
+	bool isGpu;
+	float lastMs, minMs, avgMs, p99Ms; // time per frame, over the frames the zone showed up in
+	uint32_t sampleCount;
+};
+
+// Every event and counter of a run of frames, handed over after the last one
+struct ProfileCapture
+{
+	struct Frame
+	{
+		uint64_t begin, end;
+		std::vector<std::pair<uint32_t, ProfileEvent>> events; // lane index and event
+		std::vector<std::pair<const char*, double>> counters;
+	};
+
+	std::vector<std::string> laneNames;
+	std::vector<bool> laneIsGpu;
+	std::vector<Frame> frames;
+};
+
+// Scoped CPU zones and GL timer queries. Every thread writes finished zones into its own ring without locking, the
+// main thread drains them once per frame into a timeline of the last frame and rolling per zone statistics.
+// Disabled, a zone costs one relaxed atomic load.
+class Profiler
+{
+public:
+	Profiler();
+	~Profiler();
+
+	static Profiler& Get();
+	static uint64_t GetTime();
+
+	static bool IsEnabled() { return mIsEnabled.load(std::memory_order_relaxed); }
+	void SetEnabled(bool isEnabled);
+
+	bool IsPaused() const { return mIsPaused; }
+	void SetPaused(bool isPaused) { mIsPaused = isPaused; } // keeps the captured frame and statistics as they are
+
+	void SetThreadName(const char* name); // lanes are named after the thread that filled them
+
+	// Main thread, around the work of one frame
+	void BeginFrame();
+	void EndFrame();
+
+	// Recorded into commands so the timer queries run on the render thread. GL_TIME_ELAPSED queries do not nest,
+	// GPU zones must not overlap. Results are read two frames later and only if they are ready, nothing waits on them.
+	void BeginGpuZone(CommandBuffer& commands, const char* name);
+	void EndGpuZone(CommandBuffer& commands);
+	void EndGpuFrame(CommandBuffer& commands);
+
+	// Per frame values captured along with the zones, draw calls or heap bytes for example. Kept until set again.
+	void SetCounter(const char* name, double value);
+	const std::vector<std::pair<const char*, double>>& GetCounters() const { return mCounters; }
+
+	// Records everything of the next frameCount frames, enabling the profiler meanwhile. onComplete runs on the main
+	// thread in EndFrame of the last frame.
+	void StartCapture(uint32_t frameCount, std::function<void(std::shared_ptr<ProfileCapture>)> onComplete);
+	bool IsCapturing() const { return mCapture != nullptr; }
+	uint32_t GetCapturedFrames() const { return mCapture ? (uint32_t)mCapture->frames.size() : 0; }
+
+	uint64_t GetFrameBegin() const { return mFrameBegin; }
+	uint64_t GetFrameEnd() const { return mFrameEnd; }
+	const std::vector<ProfileLane>& GetFrameLanes() const { return mLanes; }
+	void GetZoneStats(std::vector<ProfileZoneStats>& stats) const;
+	uint64_t GetDroppedEvents() const;
+
+	// Used by ProfileZone
+	void PushEvent(const ProfileEvent& event);
+	uint32_t EnterZone();
+
+private:
+	struct Ring;
+	struct ZoneSamples;
+
+	// releases the ring of a thread that exits, the next new thread takes it over
+	struct ThreadRing
+	{
+		Ring* ring = nullptr;
+		~ThreadRing();
+	};
+
+	Ring* GetThreadRing();
+	Ring* CreateRing(const char* name, bool isGpu);
+	uint32_t GetZoneIndex(const char* name, bool isGpu);
+
+	static void GpuBegin(void* name);
+	static void GpuEnd(void*);
+	static void GpuFrameEnd(void*);
+
+private:
+	inline static std::atomic<bool> mIsEnabled = false;
+	static thread_local ThreadRing mThreadRing;
+	bool mIsPaused;
+
+	mutable std::mutex mRingsMutex; // rings are only ever added
+	std::vector<std::unique_ptr<Ring>> mRings;
+	Ring* mGpuRing;
+
+	uint64_t mFrameBegin, mFrameEnd; // of the captured frame
+	uint64_t mCurrentFrameBegin;
+	std::vector<ProfileLane> mLanes;
+	std::vector<ProfileEvent> mDrained; // scratch
+
+	std::vector<std::pair<const char*, double>> mCounters;
+
+	std::shared_ptr<ProfileCapture> mCapture;
+	uint32_t mCaptureFrameCount;
+	bool mWasEnabledBeforeCapture;
+	std::function<void(std::shared_ptr<ProfileCapture>)> mOnCaptureComplete;
+
+	std::vector<ZoneSamples> mZones;
+	std::vector<uint32_t> mTouchedZones; // zones with time in the frame being drained
+	std::unordered_map<const char*, uint32_t> mZonesByPointer[2]; // cpu, gpu
+	std::unordered_map<std::string_view, uint32_t> mZonesByName[2];
+
+	// render thread only
+	struct GpuQuerySet;
+	std::unique_ptr<GpuQuerySet[]> mGpuQuerySets;
+	uint32_t mGpuQuerySet;
+};
+
+class ProfileZone
+{
+public:
+	explicit ProfileZone(const char* name)
+		: mName(nullptr)
+	{
+		if (Profiler::IsEnabled())
+		{
+			mName = name;
+			mDepth = Profiler::Get().EnterZone();
+			mStart = Profiler::GetTime();
+		}
+	}
+
+	~ProfileZone()
+	{
+		if (mName)
+		{
+			Profiler::Get().PushEvent({ mName, mStart, Profiler::GetTime(), mDepth });
+		}
+	}
+
+	ProfileZone(const ProfileZone&) = delete;
+	ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+	const char* mName;
+	uint64_t mStart;
+	uint32_t mDepth;
+};
+
+class GpuProfileZone
+{
+public:
+	GpuProfileZone(CommandBuffer& commands, const char* name)
+		: mCommands(Profiler::IsEnabled() ? &commands : nullptr)
+	{
+		if (mCommands)
+		{
+			Profiler::Get().BeginGpuZone(commands, name);
+		}
+	}
+
+	~GpuProfileZone()
+	{
+		if (mCommands)
+		{
+			Profiler::Get().EndGpuZone(*mCommands);
+		}
+	}
+
+	GpuProfileZone(const GpuProfileZone&) = delete;
+	GpuProfileZone& operator=(const GpuProfileZone&) = delete;
+
+private:
+	CommandBuffer* mCommands;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_GPU_ZONE(commands, name) GpuProfileZone PROFILE_CONCAT(gpuProfileZone, __LINE__)(commands, name)
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "imageexport.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <vector>
+
+class CommandBuffer;
+class Framebuffer;
+
+// Reads framebuffers back through a ring of pixel buffer objects. glReadPixels into a bound buffer returns at once,
+// a fence tells when the copy has landed and only then is the buffer mapped, so a frame is read while the next ones
+// render. Requests and polls are recorded into command buffers, the reads themselves happen on the render thread.
+class FramebufferReadback
+{
+public:
+	explicit FramebufferReadback(uint32_t ringSize = 3);
+	~FramebufferReadback();
+
+	FramebufferReadback(const FramebufferReadback&) = delete;
+	FramebufferReadback& operator=(const FramebufferReadback&) = delete;
+
+	// Reads the color attachment as the commands recorded before left it. onReady gets the image on the render
+	// thread and should only hand it off. With every buffer of the ring in use, the oldest read is waited for.
+	void Request(CommandBuffer& commands, Framebuffer& framebuffer, std::function<void(ImageRgba8&&)> onReady);
+	// Hands off the reads that have finished without waiting on the rest, once per frame while any are pending
+	void Poll(CommandBuffer& commands);
+	// Main thread, blocks until every request recorded and submitted so far has been handed off
+	void Flush();
+
+	uint32_t GetPendingCount() const { return mPendingCount.load(); }
+
+private:
+	struct Read;
+	struct Slot
+	{
+		uint32_t buffer = 0;
+		size_t size = 0;
+	};
+
+	static void IssueRead(void* read);
+	static void PollReads(void* readback);
+	void Complete(bool isWaiting);
+
+	uint32_t mRingSize;
+	std::atomic<uint32_t> mPendingCount; // requested, not handed off yet
+
+	// render thread only
+	std::vector<Slot> mSlots;
+	std::vector<uint32_t> mFreeSlots;
+	std::deque<Read*> mInFlight; // oldest first
+};
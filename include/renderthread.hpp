@@ -0,0 +1,63 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+class CommandBuffer;
+
+// Owns the GL context once started. The main thread records a frame into a CommandBuffer and submits it, the render
+// thread replays it while the main thread records the next one. GL work outside of frames, creating and uploading
+// resources, goes through Run or Post and is ordered with the frames. Before Start and after Stop both run in place,
+// on whichever thread has the context.
+class RenderThread
+{
+public:
+	RenderThread();
+	~RenderThread();
+
+	static RenderThread& Get();
+
+	// makeCurrent runs first on the new thread, releaseContext last before it exits
+	void Start(std::function<void()> makeCurrent, std::function<void()> releaseContext);
+	void Stop(); // waits for everything submitted so far
+
+	bool IsRunning() const { return mThread.joinable(); }
+	bool IsRenderThread() const;
+
+	// Blocks until fn ran on the render thread, after every frame and task submitted before
+	void Run(const std::function<void()>& fn);
+	// Queues fn behind the frames submitted so far, used to delete GL objects they may still reference
+	void Post(std::function<void()> fn);
+
+	// Hands commands to the render thread. Returns once the frame submitted before has finished, so with two
+	// buffers the caller can record into the other one right away. commands must stay untouched until then.
+	void Submit(const CommandBuffer& commands);
+	void WaitIdle();
+
+	uint64_t GetCompletedFrames() const;
+
+private:
+	void ThreadLoop(std::function<void()> makeCurrent, std::function<void()> releaseContext);
+
+private:
+	struct Job
+	{
+		const CommandBuffer* commands; // a frame, or nullptr for a task
+		std::function<void()> task;
+	};
+
+	std::thread mThread;
+	std::deque<Job> mJobs;
+	mutable std::mutex mMutex;
+	std::condition_variable mJobAdded;
+	std::condition_variable mJobDone;
+	uint64_t mSubmittedJobs;
+	uint64_t mCompletedJobs;
+	uint64_t mSubmittedFrames;
+	uint64_t mCompletedFrames;
+	bool mIsStopping;
+};
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Names a slot in a ResourcePool. A handle whose resource was destroyed resolves to nullptr instead of dangling,
+// even after the slot has been reused, because every reuse bumps the slot generation.
+template<typename T>
+struct Handle
+{
+	uint32_t index = 0;
+	uint32_t generation = 0; // 0 never names a live resource
+
+	bool IsValid() const { return generation != 0; }
+	bool operator==(const Handle& other) const = default;
+};
+
+// Resources behind generational handles. Live resources are kept densely packed for iteration, each behind its
+// own allocation so pointers stay put while the pool grows. Destroy and Replace take effect on handles right away,
+// the resources they drop are only deleted in Collect, so raw pointers taken during a frame stay usable until
+// the frame ends.
+template<typename T>
+class ResourcePool
+{
+public:
+	template<typename... Args>
+	Handle<T> Create(Args&&... args)
+	{
+		return Add(std::make_unique<T>(std::forward<Args>(args)...));
+	}
+
+	Handle<T> Add(std::unique_ptr<T> resource)
+	{
+		uint32_t index;
+		if (!mFreeSlots.empty())
+		{
+			index = mFreeSlots.back();
+			mFreeSlots.pop_back();
+		}
+		else
+		{
+			index = (uint32_t)mSlots.size();
+			mSlots.push_back({ 0, 1, false });
+		}
+
+		Slot& slot = mSlots[index];
+		slot.dense = (uint32_t)mDense.size();
+		mDense.push_back(std::move(resource));
+		mDenseSlots.push_back(index);
+		return { index, slot.generation };
+	}
+
+	T* Get(Handle<T> handle) const
+	{
+		if (handle.index >= mSlots.size() || mSlots[handle.index].generation != handle.generation || mSlots[handle.index].isDestroyed)
+		{
+			return nullptr;
+		}
+		return mDense[mSlots[handle.index].dense].get();
+	}
+
+	bool IsAlive(Handle<T> handle) const { return Get(handle) != nullptr; }
+
+	// Hot swap: every handle to the slot sees the new resource, the old one is deleted in Collect.
+	// resource is left untouched when the handle is stale.
+	bool Replace(Handle<T> handle, std::unique_ptr<T>&& resource)
+	{
+		if (!IsAlive(handle))
+		{
+			return false;
+		}
+		std::unique_ptr<T>& current = mDense[mSlots[handle.index].dense];
+		mRetired.push_back(std::move(current));
+		current = std::move(resource);
+		return true;
+	}
+
+	void Destroy(Handle<T> handle)
+	{
+		if (!IsAlive(handle))
+		{
+			return;
+		}
+		Slot& slot = mSlots[handle.index];
+		slot.generation = slot.generation == UINT32_MAX ? 1 : slot.generation + 1;
+		slot.isDestroyed = true;
+		mPendingSlots.push_back(handle.index);
+	}
+
+	// Deletes everything destroyed or replaced since the last call, meant to run once the frame is submitted
+	void Collect()
+	{
+		for (uint32_t index : mPendingSlots)
+		{
+			// swap with the last live resource to keep the dense array packed
+			uint32_t dense = mSlots[index].dense;
+			uint32_t last = (uint32_t)mDense.size() - 1;
+			mRetired.push_back(std::move(mDense[dense]));
+			mDense[dense] = std::move(mDense[last]);
+			mDenseSlots[dense] = mDenseSlots[last];
+			mSlots[mDenseSlots[dense]].dense = dense;
+			mDense.pop_back();
+			mDenseSlots.pop_back();
+			mSlots[index].isDestroyed = false;
+			mFreeSlots.push_back(index);
+		}
+		mPendingSlots.clear();
+		mRetired.clear();
+	}
+
+	size_t GetCount() const { return mDense.size() - mPendingSlots.size(); }
+
+	// Visits live resources, fn(Handle<T>, T&)
+	template<typename Fn>
+	void ForEach(Fn&& fn) const
+	{
+		for (size_t i = 0; i < mDense.size(); i++)
+		{
+			const Slot& slot = mSlots[mDenseSlots[i]];
+			if (!slot.isDestroyed)
+			{
+				fn(Handle<T>{ mDenseSlots[i], slot.generation }, *mDense[i]);
+			}
+		}
+	}
+
+private:
+	struct Slot
+	{
+		uint32_t dense;
+		uint32_t generation;
+		bool isDestroyed; // until Collect
+	};
+
+	std::vector<Slot> mSlots;
+	std::vector<uint32_t> mFreeSlots;
+	std::vector<std::unique_ptr<T>> mDense;
+	std::vector<uint32_t> mDenseSlots; // slot of every dense entry
+	std::vector<uint32_t> mPendingSlots; // destroyed, removed from mDense in Collect
+	std::vector<std::unique_ptr<T>> mRetired;
+};
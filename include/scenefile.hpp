@@ -0,0 +1,104 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+constexpr uint32_t SceneFileVersion = 1;
+constexpr uint32_t SceneFileAlignment = 16;
+
+enum class SceneSection : uint32_t
+{
+	Strings, // uint32 offsets[count + 1] followed by the characters, every name below is an index in here
+	Textures,
+	Shaders,
+	Materials,
+	Uniforms,
+	Objects,
+	// entities are stored as one array per field so loading them is a bulk copy
+	EntityNames,
+	EntityObjects,
+	EntityTranslates,
+	EntityAngles,
+	EntityAxes,
+	EntityScales,
+	Count
+};
+
+struct SceneSectionEntry
+{
+	uint32_t type;
+	uint32_t count; // no of elements
+	uint64_t offset; // from the start of the file
+	uint64_t size; // in bytes
+};
+
+struct SceneFileHeader
+{
+	char magic[4]; // "MM3S"
+	uint32_t version;
+	uint64_t fileSize;
+	uint32_t sectionCount;
+	uint32_t reserved;
+	SceneSectionEntry sections[(uint32_t)SceneSection::Count];
+};
+
+enum class SceneUniformType : uint32_t
+{
+	Int,
+	Float,
+	Float2,
+	Float3,
+	Float4,
+	Mat3,
+	Mat4
+};
+
+struct SceneUniform
+{
+	std::string name;
+	SceneUniformType type = SceneUniformType::Float;
+	float values[16] = {}; // ints are stored bitwise in values[0]
+};
+
+struct SceneMaterial
+{
+	std::string name;
+	std::string vertexSource, fragmentSource;
+	std::string texture; // name in the texture list, empty for none
+	std::vector<SceneUniform> uniforms;
+};
+
+struct SceneObject
+{
+	std::string name, vaName, matName;
+};
+
+struct SceneEntities
+{
+	std::vector<std::string> names;
+	std::vector<std::string> objects;
+	std::vector<glm::vec3> translates;
+	std::vector<float> angles;
+	std::vector<glm::vec3> axes;
+	std::vector<glm::vec3> scales;
+
+	size_t GetCount() const { return names.size(); }
+	void Resize(size_t count);
+};
+
+// Everything the editor creates, independent of any GL objects
+struct SceneFileData
+{
+	std::vector<std::pair<std::string, std::string>> textures; // name, path
+	std::vector<std::pair<std::string, std::string>> shaders; // name, code
+	std::vector<SceneMaterial> materials;
+	std::vector<SceneObject> objects;
+	SceneEntities entities;
+};
+
+bool WriteSceneFile(const std::string& path, const SceneFileData& scene);
+bool ReadSceneFile(const std::string& path, SceneFileData& scene);
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "resourcepool.hpp"
+#include "nameregistry.hpp"
+#include "framearena.hpp"
+#include "frustum.hpp"
+
+#include <cstdint>
+
+class CommandBuffer;
+class VertexArray;
+class Material;
+class Shader;
+class Texture;
+
+struct Object
+{
+	NameId vaName, matName;
+	Handle<VertexArray> va;
+	Handle<Material> mat;
+};
+struct Entity
+{
+	Handle<Object> object;
+	glm::vec3 translate = glm::vec3(0.0f);
+	float angle = 0.0f;
+	glm::vec3 rotate = glm::vec3(0.0f, 1.0f, 0.0f);
+	glm::vec3 scale = glm::vec3(1.0f);
+	glm::mat4 model = glm::mat4(1.0f);
+};
+
+// Scale, then angle degrees around axis, then translate
+glm::mat4 ComposeModel(const glm::vec3& translate, float angle, const glm::vec3& axis, const glm::vec3& scale);
+void UpdateModel(Entity& e);
+
+// One visible entity with its resources resolved
+struct DrawItem
+{
+	uint64_t sortKey; // material, then vertex array
+	const glm::mat4* model;
+	VertexArray* va;
+	const Material* material;
+	Shader* shader;
+	Texture* texture;
+};
+
+// The pools entities are resolved through
+struct SceneResources
+{
+	const ResourcePool<Object>& objects;
+	const ResourcePool<Material>& materials;
+	const ResourcePool<VertexArray>& vertexArrays;
+	const ResourcePool<Shader>& shaders;
+	const ResourcePool<Texture>& textures;
+};
+
+// Resolves and frustum culls entities into a draw list. An entity whose object, material or mesh was destroyed is
+// skipped, the pointers in the list stay valid as long as the entities and resources do.
+class DrawListBuilder
+{
+public:
+	DrawListBuilder(const SceneResources& resources, const glm::mat4& viewProjection, FrameVector<DrawItem>& drawList);
+
+	void Add(const Entity& entity);
+	// Sorts the draws so the ones of the same material and mesh are next to each other and share their binds
+	void Finish();
+
+	uint32_t GetCulledCount() const { return mCulledCount; }
+private:
+	SceneResources mResources;
+	Frustum mFrustum;
+	FrameVector<DrawItem>& mDrawList;
+	uint32_t mCulledCount;
+};
+
+// Binds every material and mesh once per run of draws and leaves nothing bound
+void RecordDrawList(CommandBuffer& commands, const FrameVector<DrawItem>& drawList, const glm::mat4& view, const glm::mat4& projection);
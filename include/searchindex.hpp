@@ -0,0 +1,241 @@
+#pragma once
+
+#include "flathashmap.hpp"
+#include "hash.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Case insensitive substring search over a changing set of named items. Every name is posted under each of its
+// trigrams, a query only checks the names in the shortest posting list among its own trigrams. Removing leaves stale
+// postings that searches skip, they are dropped once they outnumber the live names.
+// Names are views, the caller keeps them alive until the item is removed.
+template<typename T>
+class SearchIndex
+{
+public:
+	SearchIndex()
+		: mLiveCount(0)
+		, mVersion(0)
+	{
+
+	}
+
+	void Add(std::string_view name, const T* item)
+	{
+		if ((mLiveCount + 1) * 2 > mTable.size())
+		{
+			RebuildTable(std::max<size_t>(64, mTable.size() * 2));
+		}
+		uint64_t hash = HashString(name);
+		size_t position = FindPosition(name, hash);
+		if (mTable[position] != EmptySlot)
+		{
+			mSlots[mTable[position]].item = item;
+			mVersion++;
+			return;
+		}
+		uint32_t slot = (uint32_t)mSlots.size();
+		mSlots.push_back({ name, hash, item, true });
+		mTable[position] = slot;
+		AddPostings(slot);
+		mLiveCount++;
+		mVersion++;
+	}
+
+	bool Remove(std::string_view name)
+	{
+		if (mTable.empty())
+		{
+			return false;
+		}
+		size_t position = FindPosition(name, HashString(name));
+		if (mTable[position] == EmptySlot)
+		{
+			return false;
+		}
+		mSlots[mTable[position]].isAlive = false;
+		ErasePosition(position);
+		mLiveCount--;
+		mVersion++;
+		if (mSlots.size() > 1024 && mLiveCount * 2 < mSlots.size())
+		{
+			Compact();
+		}
+		return true;
+	}
+
+	void Clear()
+	{
+		mSlots.clear();
+		mTable.clear();
+		mPostings.Clear();
+		mLiveCount = 0;
+		mVersion++;
+	}
+
+	// Calls fn(slot) for every live name containing query, in no particular order. Slots stay valid until the next
+	// change to the index.
+	template<typename Fn>
+	void Search(std::string_view query, Fn&& fn) const
+	{
+		std::string lowerQuery(query);
+		std::transform(lowerQuery.begin(), lowerQuery.end(), lowerQuery.begin(), ToLower);
+
+		if (lowerQuery.size() < 3)
+		{
+			for (uint32_t slot = 0; slot < (uint32_t)mSlots.size(); slot++)
+			{
+				if (mSlots[slot].isAlive && ContainsLower(mSlots[slot].name, lowerQuery))
+				{
+					fn(slot);
+				}
+			}
+			return;
+		}
+
+		const std::vector<uint32_t>* candidates = nullptr;
+		for (size_t i = 0; i + 3 <= lowerQuery.size(); i++)
+		{
+			const std::vector<uint32_t>* postings = mPostings.Find(PackTrigram(&lowerQuery[i]));
+			if (!postings)
+			{
+				return;
+			}
+			if (!candidates || postings->size() < candidates->size())
+			{
+				candidates = postings;
+			}
+		}
+		for (uint32_t slot : *candidates)
+		{
+			if (mSlots[slot].isAlive && ContainsLower(mSlots[slot].name, lowerQuery))
+			{
+				fn(slot);
+			}
+		}
+	}
+
+	std::string_view GetName(uint32_t slot) const { return mSlots[slot].name; }
+	const T* GetItem(uint32_t slot) const { return mSlots[slot].item; }
+	bool IsAlive(uint32_t slot) const { return mSlots[slot].isAlive; }
+	uint32_t GetSlotCount() const { return (uint32_t)mSlots.size(); }
+	size_t GetCount() const { return mLiveCount; }
+	uint32_t GetVersion() const { return mVersion; } // changes with every Add, Remove and Clear
+
+private:
+	static constexpr uint32_t EmptySlot = UINT32_MAX;
+
+	size_t FindPosition(std::string_view name, uint64_t hash) const
+	{
+		size_t mask = mTable.size() - 1;
+		for (size_t i = (size_t)hash & mask;; i = (i + 1) & mask)
+		{
+			uint32_t slot = mTable[i];
+			if (slot == EmptySlot || (mSlots[slot].hash == hash && mSlots[slot].name == name))
+			{
+				return i;
+			}
+		}
+	}
+
+	void ErasePosition(size_t i)
+	{
+		// backward shift, same as FlatHashMap
+		size_t mask = mTable.size() - 1;
+		for (size_t j = (i + 1) & mask; mTable[j] != EmptySlot; j = (j + 1) & mask)
+		{
+			size_t ideal = (size_t)mSlots[mTable[j]].hash & mask;
+			bool canMove = i <= j ? (ideal <= i || ideal > j) : (ideal <= i && ideal > j);
+			if (canMove)
+			{
+				mTable[i] = mTable[j];
+				i = j;
+			}
+		}
+		mTable[i] = EmptySlot;
+	}
+
+	void RebuildTable(size_t size)
+	{
+		mTable.assign(size, EmptySlot);
+		size_t mask = size - 1;
+		for (uint32_t slot = 0; slot < (uint32_t)mSlots.size(); slot++)
+		{
+			if (mSlots[slot].isAlive)
+			{
+				size_t i = (size_t)mSlots[slot].hash & mask;
+				while (mTable[i] != EmptySlot)
+				{
+					i = (i + 1) & mask;
+				}
+				mTable[i] = slot;
+			}
+		}
+	}
+
+	static char ToLower(char c) { return c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c; }
+
+	static uint32_t PackTrigram(const char* lower)
+	{
+		return (uint8_t)lower[0] | ((uint32_t)(uint8_t)lower[1] << 8) | ((uint32_t)(uint8_t)lower[2] << 16);
+	}
+
+	static bool ContainsLower(std::string_view text, std::string_view lowerQuery)
+	{
+		auto it = std::search(text.begin(), text.end(), lowerQuery.begin(), lowerQuery.end(), [](char a, char b) { return ToLower(a) == b; });
+		return it != text.end() || lowerQuery.empty();
+	}
+
+	void AddPostings(uint32_t slot)
+	{
+		// a trigram that repeats within the name is only posted once
+		std::string_view name = mSlots[slot].name;
+		mTrigrams.clear();
+		for (size_t i = 0; i + 3 <= name.size(); i++)
+		{
+			char lower[3] = { ToLower(name[i]), ToLower(name[i + 1]), ToLower(name[i + 2]) };
+			mTrigrams.push_back(PackTrigram(lower));
+		}
+		std::sort(mTrigrams.begin(), mTrigrams.end());
+		mTrigrams.erase(std::unique(mTrigrams.begin(), mTrigrams.end()), mTrigrams.end());
+		for (uint32_t trigram : mTrigrams)
+		{
+			mPostings[trigram].push_back(slot);
+		}
+	}
+
+	void Compact()
+	{
+		std::vector<Slot> slots;
+		slots.reserve(mLiveCount);
+		std::copy_if(mSlots.begin(), mSlots.end(), std::back_inserter(slots), [](const Slot& slot) { return slot.isAlive; });
+		mSlots = std::move(slots);
+		RebuildTable(mTable.size());
+		mPostings.Clear();
+		for (uint32_t slot = 0; slot < (uint32_t)mSlots.size(); slot++)
+		{
+			AddPostings(slot);
+		}
+	}
+
+private:
+	struct Slot
+	{
+		std::string_view name;
+		uint64_t hash;
+		const T* item;
+		bool isAlive; // removed slots are only reused after Compact
+	};
+
+	std::vector<Slot> mSlots;
+	std::vector<uint32_t> mTable; // live slots by name hash, open addressing
+	FlatHashMap<uint32_t, std::vector<uint32_t>> mPostings; // by trigram, three lowercase bytes
+	std::vector<uint32_t> mTrigrams; // scratch
+	size_t mLiveCount;
+	uint32_t mVersion;
+};
@@ -5,32 +5,35 @@
 #include <string>
 #include <unordered_map>
 
+class CommandBuffer;
+
 class Shader
 {
 public:
 	Shader(const std::string& vertexCode, const std::string& fragmentCode);
 	~Shader();
 
-	std::string GetVertexShaderSource() const { return mVertexShader; }
-	std::string GetFragmentShaderSource() const { return mFragmentShader; }
+	const std::string& GetVertexShaderSource() const { return mVertexShader; }
+	const std::string& GetFragmentShaderSource() const { return mFragmentShader; }
 	std::string GetError() const { return mError; }
 
-	void Bind();
-	void Unbind();
+	// Recorded into commands, uniforms apply to the program bound before in the same buffer
+	void Bind(CommandBuffer& commands) const;
+	void Unbind(CommandBuffer& commands) const;
+
+	void SetUniformInt(CommandBuffer& commands, const std::string& name, int val) const;
+	void SetUniformFloat(CommandBuffer& commands, const std::string& name, float val) const;
+	void SetUniformFloat2(CommandBuffer& commands, const std::string& name, const glm::vec2& val) const;
+	void SetUniformFloat3(CommandBuffer& commands, const std::string& name, const glm::vec3& val) const;
+	void SetUniformFloat4(CommandBuffer& commands, const std::string& name, const glm::vec4& val) const;
+	void SetUniformMat3(CommandBuffer& commands, const std::string& name, const glm::mat3& mat) const;
+	void SetUniformMat4(CommandBuffer& commands, const std::string& name, const glm::mat4& mat) const;
 
-	void SetUniformInt(const std::string& name, int val);
-	void SetUniformFloat(const std::string& name, float val);
-	void SetUniformFloat2(const std::string& name, float val1, float val2);
-	void SetUniformFloat2(const std::string& name, const glm::vec2& val);
-	void SetUniformFloat3(const std::string& name, float val1, float val2, float val3);
-	void SetUniformFloat3(const std::string& name, const glm::vec3& val);
-	void SetUniformFloat4(const std::string& name, float val1, float val2, float val3, float val4);
-	void SetUniformFloat4(const std::string& name, const glm::vec4& val);
-	void SetUniformMat3(const std::string& name, const glm::mat3& mat);
-	void SetUniformMat4(const std::string& name, const glm::mat4& mat);
+	int GetUniformLocation(const std::string& name) const; // -1 if the program has no such active uniform
 
 private:
-	int GetUniformLocation(const std::string& name);
+	void Compile();
+	void CacheUniformLocations();
 	bool CheckForErrors(unsigned int shaderID, std::string type);
 private:
 	uint32_t mProgramId;
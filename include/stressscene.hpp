@@ -0,0 +1,48 @@
+#pragma once
+
+#include "scenefile.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class StressLayout : uint32_t
+{
+	Grid,
+	Random,
+	Clustered
+};
+
+const char* GetStressLayoutName(StressLayout layout);
+bool ParseStressLayout(const std::string& name, StressLayout& layout);
+
+struct StressSceneSettings
+{
+	uint32_t entityCount = 10000;
+	uint32_t objectCount = 8; // made from the loaded meshes and materialCount materials
+	uint32_t materialCount = 4;
+	StressLayout layout = StressLayout::Grid;
+	uint32_t clusterCount = 16;
+	glm::vec3 center = glm::vec3(0.0f);
+	float extent = 80.0f; // side of the cube the top level is spread over
+	// 1 is flat. Deeper levels are placed around an entity of the level above at half its size and named after it,
+	// prefix/12/3 is the fourth child of prefix/12.
+	uint32_t hierarchyDepth = 1;
+	uint32_t childrenPerEntity = 4;
+	float dynamicRatio = 0.0f; // of the entities, dynamic ones spin
+	uint64_t seed = 1;
+	std::string prefix = "stress"; // of the entity, object and material names
+};
+
+// What the generator made, spins are in degrees per second and 0 for static entities
+struct StressSceneEntities
+{
+	SceneEntities entities;
+	std::vector<float> spins;
+};
+
+// Spreads settings.entityCount entities over the given object names on the thread pool. Every entity draws from its
+// own random sequence seeded from the seed and its index, so a seed makes the same scene on any number of threads.
+bool GenerateStressEntities(const StressSceneSettings& settings, const std::vector<std::string>& objects, StressSceneEntities& out);
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+using NameId = uint32_t;
+constexpr NameId InvalidName = UINT32_MAX;
+
+// Maps strings to dense 32 bit ids. Interned strings are never moved or freed, so GetString pointers stay valid
+// for the lifetime of the program. Not thread safe, names are interned on the main thread.
+class StringInterner
+{
+public:
+	StringInterner();
+
+	static StringInterner& Get();
+
+	NameId Intern(std::string_view str);
+	NameId Find(std::string_view str) const; // InvalidName when the string was never interned
+
+	const char* GetString(NameId id) const { return mStrings[id].data(); } // null terminated
+	std::string_view GetView(NameId id) const { return mStrings[id]; }
+	size_t GetCount() const { return mStrings.size(); }
+
+private:
+	size_t FindSlot(std::string_view str, uint64_t hash) const;
+	void Grow();
+
+private:
+	std::vector<std::unique_ptr<char[]>> mBlocks;
+	size_t mBlockUsed;
+	size_t mBlockSize;
+
+	std::vector<std::string_view> mStrings; // by id
+	std::vector<uint64_t> mHashes; // by id
+	std::vector<NameId> mTable; // open addressing, InvalidName is empty
+};
+
+inline NameId InternName(std::string_view str) { return StringInterner::Get().Intern(str); }
+inline const char* GetName(NameId id) { return StringInterner::Get().GetString(id); }
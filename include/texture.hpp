@@ -1,17 +1,42 @@
 #pragma once
 
+#include <cstdint>
+#include <memory>
 #include <string>
 
+class CommandBuffer;
+
 enum class TextureFilter
 {
 	Nearest,
 	Linear
 };
 
+struct TexturePixelsDeleter
+{
+	void operator()(unsigned char* pixels) const;
+};
+
+// Decoded pixels, produced without touching GL so it can run on a worker thread
+struct TextureImage
+{
+	uint32_t width = 0, height = 0, numChannels = 0;
+	std::unique_ptr<unsigned char, TexturePixelsDeleter> pixels;
+};
+
+bool DecodeTexture(const std::string& path, TextureImage& image);
+
+// Decoded pixels stored raw, reading them back skips the image decoder on warm starts
+constexpr uint32_t TextureCacheVersion = 1;
+std::string GetTextureCachePath(const std::string& cacheDirectory, uint64_t sourceHash);
+bool WriteTextureCache(const std::string& path, const TextureImage& image);
+bool ReadTextureCache(const std::string& path, TextureImage& image);
+
 class Texture
 {
 public:
 	Texture(const std::string& path);
+	Texture(const std::string& path, TextureImage image); // uploads already decoded pixels
 	~Texture();
 
 	uint32_t GetId() const { return mId; }
@@ -21,13 +46,14 @@ public:
 	const std::string& GetPath() const { return mPath; }
 	TextureFilter GetTextureFilter() const { return mFilter; }
 
-	void Bind();
-	void Unbind();
+	void Bind(CommandBuffer& commands) const;
+	void Unbind(CommandBuffer& commands) const;
 
 	void SetTextureFilter(TextureFilter filter);
 
 private:
 	void LoadTexture();
+	static void ApplyTextureFilter(uint32_t id, TextureFilter filter);
 
 private:
 	TextureFilter mFilter;
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+
+class ThreadPool
+{
+public:
+	ThreadPool(uint32_t threadCount = 0); // 0 picks one worker per hardware thread (minus the caller)
+	~ThreadPool();
+
+	static ThreadPool& Get();
+
+	uint32_t GetThreadCount() const { return (uint32_t)mThreads.size(); }
+
+	void Submit(std::function<void()> job);
+
+	// Splits [0, count) into ranges of at least minRange items and blocks until all of them ran.
+	// The calling thread works through the ranges no worker took yet, so it is safe to call from inside a job.
+	void ParallelFor(uint32_t count, uint32_t minRange, const std::function<void(uint32_t begin, uint32_t end)>& fn);
+
+private:
+	void WorkerLoop();
+
+private:
+	std::vector<std::thread> mThreads;
+	std::deque<std::function<void()>> mJobs;
+	std::mutex mMutex;
+	std::condition_variable mCondition;
+	bool mIsStopping;
+};
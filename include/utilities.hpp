@@ -5,14 +5,17 @@
 #include <unordered_set>
 #include <string>
 #include <memory>
+#include <vector>
 
 #include "../external/imgui/imgui.h"
 
 class Texture;
 class Shader;
+class VertexArray;
 
 std::map<std::string, std::string> LoadShaders(std::string directory, std::unordered_set<std::string> extensions);
 std::map<std::string, std::shared_ptr<Texture>> LoadTextures(std::string directory, std::unordered_set<std::string> extensions);
+std::map<std::string, std::shared_ptr<VertexArray>> LoadMeshes(std::string directory, std::unordered_set<std::string> extensions);
 
 struct InputTextCallback_UserData;
 
@@ -1,9 +1,75 @@
 #pragma once
 
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <array>
 #include <cstdint>
+#include <cstring>
 #include <memory>
+#include <new>
+#include <span>
+#include <type_traits>
 #include <vector>
 
+class CommandBuffer;
+
+enum class VertexAttribType : uint8_t
+{
+	Float,
+	HalfFloat,
+	Int2101010Rev, // 4 signed components packed in 32 bits, GL_INT_2_10_10_10_REV
+	UnsignedByte
+};
+
+struct VertexAttribute
+{
+	uint32_t count = 0; // no of components
+	VertexAttribType type = VertexAttribType::Float;
+	bool normalized = false;
+
+	constexpr uint32_t GetSize() const
+	{
+		switch (type)
+		{
+		case VertexAttribType::HalfFloat: return count * 2;
+		case VertexAttribType::Int2101010Rev: return 4;
+		case VertexAttribType::UnsignedByte: return count;
+		default: return count * 4;
+		}
+	}
+
+	bool operator==(const VertexAttribute& other) const = default;
+};
+
+// Compact attribute types
+struct HalfVec2 { uint16_t x, y; };
+struct HalfVec4 { uint16_t x, y, z, w; }; // half positions are padded to 4 so the next attribute stays 4 byte aligned
+struct PackedNormal { uint32_t bits; }; // signed normalized xyz in 10 bits each, w in the top 2
+struct Color8 { uint8_t r, g, b, a; }; // unsigned normalized
+
+template<typename T> struct VertexAttribTraits;
+template<> struct VertexAttribTraits<float> { static constexpr VertexAttribute Attribute = { 1 }; };
+template<> struct VertexAttribTraits<glm::vec2> { static constexpr VertexAttribute Attribute = { 2 }; };
+template<> struct VertexAttribTraits<glm::vec3> { static constexpr VertexAttribute Attribute = { 3 }; };
+template<> struct VertexAttribTraits<glm::vec4> { static constexpr VertexAttribute Attribute = { 4 }; };
+template<> struct VertexAttribTraits<HalfVec2> { static constexpr VertexAttribute Attribute = { 2, VertexAttribType::HalfFloat }; };
+template<> struct VertexAttribTraits<HalfVec4> { static constexpr VertexAttribute Attribute = { 4, VertexAttribType::HalfFloat }; };
+template<> struct VertexAttribTraits<PackedNormal> { static constexpr VertexAttribute Attribute = { 4, VertexAttribType::Int2101010Rev, true }; };
+template<> struct VertexAttribTraits<Color8> { static constexpr VertexAttribute Attribute = { 4, VertexAttribType::UnsignedByte, true }; };
+
+// Compile time layout of an interleaved vertex struct. A vertex type declares its attributes in member order:
+//	struct TexturedVertex { glm::vec3 position; glm::vec2 uv; using Format = VertexFormat<glm::vec3, glm::vec2>; };
+template<typename... Attribs>
+struct VertexFormat
+{
+	static constexpr std::array<VertexAttribute, sizeof...(Attribs)> Layout = { VertexAttribTraits<Attribs>::Attribute... };
+	static constexpr uint32_t Size = (VertexAttribTraits<Attribs>::Attribute.GetSize() + ...);
+};
+
+template<typename V>
+concept VertexType = std::is_trivially_copyable_v<V> && alignof(V) <= 4 && sizeof(V) == V::Format::Size;
+
 class VertexBuffer
 {
 public:
@@ -14,23 +80,110 @@ public:
 	uint32_t GetId() const { return mVB; }
 	uint32_t GetVertexCount() const { return mVertexCount; }
 	uint32_t GetStride() const { return mStride; }
-	const std::vector<uint32_t>& GetLayout() const { return mLayout; }
+	const std::vector<VertexAttribute>& GetLayout() const { return mLayout; }
 
-	void SetLayout(const std::vector<uint32_t>& layout);
+	void SetLayout(const std::vector<uint32_t>& layout); // all float attributes, no of floats each
+	void SetLayout(const std::vector<VertexAttribute>& layout);
 	void Upload(bool dynamic = false);
+	void Upload(const void* data, uint32_t vertexCount, bool dynamic = false); // uploads external memory as is, nothing is copied into mBufferData
 
 	void PushVertex(const std::vector<float>& vert);
+	void SetData(const void* data, uint32_t vertexCount, uint32_t vertexSize);
+
+	template<VertexType V>
+	void SetLayout()
+	{
+		SetLayout(std::vector<VertexAttribute>(V::Format::Layout.begin(), V::Format::Layout.end()));
+	}
+
+	template<VertexType V>
+	void Reserve(uint32_t vertexCount)
+	{
+		mBufferData.reserve(mBufferData.size() + (size_t)vertexCount * sizeof(V));
+	}
+
+	// Appends all vertices with a single copy, the layout is taken from V while the buffer is empty
+	template<VertexType V>
+	void Append(std::span<const V> vertices)
+	{
+		if (!BeginTypedWrite<V>())
+		{
+			return;
+		}
+		size_t offset = mBufferData.size();
+		mBufferData.resize(offset + vertices.size_bytes());
+		memcpy(&mBufferData[offset], vertices.data(), vertices.size_bytes());
+		mVertexCount += (uint32_t)vertices.size();
+	}
+
+	// Constructs one vertex directly inside the buffer
+	template<VertexType V, typename... Args>
+	void EmplaceVertex(Args&&... args)
+	{
+		if (!BeginTypedWrite<V>())
+		{
+			return;
+		}
+		size_t offset = mBufferData.size();
+		mBufferData.resize(offset + sizeof(V));
+		new (&mBufferData[offset]) V{ std::forward<Args>(args)... };
+		mVertexCount++;
+	}
+
+	// Grows the buffer by count vertices and returns them for the caller to fill in place
+	template<VertexType V>
+	std::span<V> Allocate(uint32_t count)
+	{
+		if (!BeginTypedWrite<V>())
+		{
+			return {};
+		}
+		size_t offset = mBufferData.size();
+		mBufferData.resize(offset + (size_t)count * sizeof(V));
+		V* first = reinterpret_cast<V*>(&mBufferData[offset]);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			new (first + i) V;
+		}
+		mVertexCount += count;
+		return std::span<V>(first, count);
+	}
+
+private:
+	void UploadData(const void* data, size_t size, bool dynamic);
+	void LogLayoutMismatch(std::span<const VertexAttribute> layout, uint32_t vertexSize) const;
+
+	// The layout has to match V attribute by attribute, a layout of the same size can still have other types.
+	// An empty buffer takes V's layout, one that already holds other vertices refuses the write.
+	template<VertexType V>
+	bool BeginTypedWrite()
+	{
+		bool isSameLayout = std::equal(mLayout.begin(), mLayout.end(), V::Format::Layout.begin(), V::Format::Layout.end());
+		if (mBufferData.empty())
+		{
+			if (!isSameLayout)
+			{
+				SetLayout<V>();
+			}
+			mVertexSize = sizeof(V);
+			return true;
+		}
+		if (!isSameLayout || mVertexSize != sizeof(V))
+		{
+			LogLayoutMismatch(V::Format::Layout, sizeof(V));
+			return false;
+		}
+		return true;
+	}
 
-	void Bind();
-	void Unbind();
 private:
 	uint32_t mVB;
 
 	uint32_t mVertexCount;
-	uint32_t mPerVertexValueCount; // no of data per vertex
-	std::vector<float> mBufferData; // al vertices data
+	uint32_t mVertexSize; // no of bytes per vertex in mBufferData
+	std::vector<uint8_t> mBufferData; // al vertices data
 
-	std::vector<uint32_t> mLayout; // no of data per attribute, sums up to mPerVertexValueCount
+	std::vector<VertexAttribute> mLayout; // attribute sizes sum up to mStride
 	uint32_t mStride; // no of bytes a vertex covers (with all his attributes)
 	bool mIsUploaded;
 };
@@ -44,17 +197,33 @@ public:
 	bool IsValid() const { return mIsValid; }
 	uint32_t GetVertexCount() const { return mVertexCount; }
 	uint32_t GetElementCount() const { return mElementCount; }
+	uint32_t GetIndexType() const { return mIndexType; } // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT, pass to glDrawElements
+
+	// Local space bounds used for culling, a vertex array without bounds is always drawn
+	bool HasBounds() const { return mHasBounds; }
+	const glm::vec3& GetBoundsMin() const { return mBoundsMin; }
+	const glm::vec3& GetBoundsMax() const { return mBoundsMax; }
+	void SetBounds(const glm::vec3& boundsMin, const glm::vec3& boundsMax);
 
 	void PushBuffer(std::unique_ptr<VertexBuffer> vb);
-	void SetElements(const std::vector<uint32_t>& elements);
+	void SetElements(const std::vector<uint32_t>& elements); // stored as 16 bit when every index fits
+	void SetElements(const uint32_t* elements, uint32_t count);
+	void SetElements(const uint16_t* elements, uint32_t count);
 
 	void Upload();
 
-	void Bind();
-	void Unbind();
+	void Bind(CommandBuffer& commands) const;
+	void Unbind(CommandBuffer& commands) const;
+	void Draw(CommandBuffer& commands) const; // indexed triangles, a triangle strip without elements
+private:
+	void UploadElements(const void* elements, uint32_t count, uint32_t indexType, uint32_t indexSize);
+
 private:
 	bool mIsValid;
+	bool mHasBounds;
+	glm::vec3 mBoundsMin, mBoundsMax;
 	uint32_t mVertexCount, mElementCount;
+	uint32_t mIndexType;
 	uint32_t mVA, mEB;
 	std::vector<std::unique_ptr<VertexBuffer>> mVBs;
 };
\ No newline at end of file
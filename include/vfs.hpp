@@ -0,0 +1,103 @@
+#pragma once
+
+#include "mappedfile.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+constexpr uint32_t PackVersion = 1;
+constexpr uint32_t PackAlignment = 16;
+
+enum PackEntryFlags : uint32_t
+{
+	PackEntryCompressed = 1 << 0 // LZ4 block
+};
+
+// On disk layout: header, entry data, table of contents sorted by name hash, names. Offsets are from the start of the file.
+struct PackHeader
+{
+	char magic[4]; // "MM3P"
+	uint32_t version;
+	uint32_t entryCount;
+	uint32_t reserved;
+	uint64_t tocOffset;
+	uint64_t namesOffset;
+	uint64_t namesSize;
+	uint64_t fileSize;
+};
+
+struct PackEntry
+{
+	uint64_t nameHash;
+	uint32_t nameOffset; // into the names section
+	uint32_t nameLength;
+	uint64_t offset;
+	uint64_t storedSize;
+	uint64_t size; // after decompression
+	uint32_t flags;
+	uint32_t reserved;
+};
+
+// Contents of one file, either a view into a mapping or a decompressed copy
+class VfsFile
+{
+public:
+	VfsFile();
+
+	void Close();
+
+	const uint8_t* GetData() const { return mData; }
+	size_t GetSize() const { return mSize; }
+
+private:
+	friend class VirtualFileSystem;
+
+	MappedFile mMapping; // loose files
+	std::vector<uint8_t> mBuffer; // compressed pack entries
+	const uint8_t* mData;
+	size_t mSize;
+};
+
+// Resolves resource paths like "resources/shaders/basic.vert" against mounted pack files first and falls back to
+// loose files on disk, so development trees work without building a pack
+class VirtualFileSystem
+{
+public:
+	VirtualFileSystem();
+
+	static VirtualFileSystem& Get();
+
+	bool MountPack(const std::string& path);
+	void SetLooseFallback(bool enabled) { mLooseFallback = enabled; }
+
+	bool Exists(const std::string& path) const;
+	bool IsPacked(const std::string& path) const;
+	bool Open(const std::string& path, VfsFile& file) const;
+	bool ReadText(const std::string& path, std::string& text) const;
+
+	// Files directly inside directory with one of the extensions, sorted
+	std::vector<std::string> List(const std::string& directory, const std::unordered_set<std::string>& extensions) const;
+
+	static std::string NormalizePath(const std::string& path);
+
+private:
+	struct Pack
+	{
+		MappedFile file;
+		const PackHeader* header = nullptr;
+		const PackEntry* entries = nullptr;
+		const char* names = nullptr;
+	};
+
+	const PackEntry* Find(const std::string& normalizedPath, const Pack** pack) const;
+
+private:
+	std::vector<std::unique_ptr<Pack>> mPacks;
+	bool mLooseFallback;
+};
+
+// Writes every file below the given directories into one pack, compressing entries where LZ4 saves space
+bool BuildPack(const std::string& outputPath, const std::vector<std::string>& directories, bool compress = true);
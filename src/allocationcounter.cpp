@@ -0,0 +1,135 @@
+#include "allocationcounter.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+	std::atomic<uint64_t> gAllocationCount = 0;
+	std::atomic<uint64_t> gAllocationBytes = 0;
+
+	void* CountedAlloc(size_t size)
+	{
+		gAllocationCount.fetch_add(1, std::memory_order_relaxed);
+		gAllocationBytes.fetch_add(size, std::memory_order_relaxed);
+		return malloc(size ? size : 1);
+	}
+
+	void* CountedAlignedAlloc(size_t size, std::align_val_t alignment)
+	{
+		gAllocationCount.fetch_add(1, std::memory_order_relaxed);
+		gAllocationBytes.fetch_add(size, std::memory_order_relaxed);
+#ifdef _MSC_VER
+		return _aligned_malloc(size ? size : 1, (size_t)alignment);
+#else
+		// aligned_alloc wants the size to be a multiple of the alignment
+		size_t align = (size_t)alignment;
+		return aligned_alloc(align, (size + align - 1) / align * align + (size ? 0 : align));
+#endif
+	}
+
+	void AlignedFree(void* ptr)
+	{
+#ifdef _MSC_VER
+		_aligned_free(ptr);
+#else
+		free(ptr);
+#endif
+	}
+}
+
+AllocationStats GetAllocationStats()
+{
+	return { gAllocationCount.load(std::memory_order_relaxed), gAllocationBytes.load(std::memory_order_relaxed) };
+}
+
+void* operator new(size_t size)
+{
+	void* ptr = CountedAlloc(size);
+	if (!ptr)
+	{
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	return CountedAlloc(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+	return CountedAlloc(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+	void* ptr = CountedAlignedAlloc(size, alignment);
+	if (!ptr)
+	{
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+	return operator new(size, alignment);
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return CountedAlignedAlloc(size, alignment);
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return CountedAlignedAlloc(size, alignment);
+}
+
+void operator delete(void* ptr) noexcept
+{
+	free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+	free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+	free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept
+{
+	free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept
+{
+	AlignedFree(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept
+{
+	AlignedFree(ptr);
+}
+
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept
+{
+	AlignedFree(ptr);
+}
+
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept
+{
+	AlignedFree(ptr);
+}
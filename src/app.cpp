@@ -8,6 +8,22 @@
 #include "material.hpp"
 #include "texture.hpp"
 #include "camera.hpp"
+#include "scenefile.hpp"
+#include "editjournal.hpp"
+#include "assetmanager.hpp"
+#include "assetdatabase.hpp"
+#include "threadpool.hpp"
+#include "meshcache.hpp"
+#include "vfs.hpp"
+#include "renderthread.hpp"
+#include "profiler.hpp"
+#include "profileexport.hpp"
+#include "glstats.hpp"
+#include "headlesscontext.hpp"
+#include "imageexport.hpp"
+#include "readback.hpp"
+#include "inputrecording.hpp"
+#include "stressscene.hpp"
 
 #include "glad/glad.h"
 #include "GLFW/glfw3.h"
@@ -20,29 +36,185 @@
 #include "../external/imgui/imgui_impl_glfw.h"
 #include "../external/imgui/imgui_impl_opengl3.h"
 
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iterator>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+
+namespace
+{
+	const std::string AutosaveScenePath = "resources/scenes/autosave.mm3s";
+	const std::string AutosaveJournalPath = "resources/scenes/autosave.journal";
+	const std::string AutosaveRetiredJournalPath = "resources/scenes/autosave.journal.old"; // until the snapshot covering it is written
+	const std::string ResourcePackPath = "resources.pak";
+	const std::string AssetDatabasePath = "resources/cache/assets.db";
+	const std::string MeshCacheDirectory = "resources/cache/meshes";
+	const std::string TextureCacheDirectory = "resources/cache/textures";
+	constexpr uint64_t MeshCacheMaxBytes = 512ull << 20;
+	constexpr uint64_t JournalCompactSize = 4 << 20; // journal bytes after which it is folded into a new snapshot
+	constexpr double AssetUploadBudget = 0.004; // seconds of GL uploads per frame
+	constexpr size_t EntityChunkSize = 16384;
+	constexpr double IdleWaitTimeout = 0.25; // seconds an idle editor sleeps between checks
+	constexpr int UiSettleFrames = 3; // frames drawn after an input event, ImGui needs a few to settle hover and focus
+	constexpr double SimulationStep = 1.0 / 60.0;
+	constexpr uint32_t MaxSimulationSteps = 8; // per frame, time beyond that is dropped so a stall does not snowball
+	constexpr uint32_t CaptureFrameCount = 120; // frames the capture hotkey records
+	const std::string CaptureDirectory = "captures";
+	constexpr auto HeadlessLoadingWait = std::chrono::milliseconds(1);
+	constexpr uint32_t ReadbackRingSize = 3; // frame N is mapped while N + 2 renders
+	constexpr uint32_t ExportImagesPerThread = 2; // read back or being written, beyond that frames are not requested
+	const std::string StressVertexShader = "simple.vert";
+	const std::string StressFragmentShader = "simple.frag";
+	constexpr uint32_t MinDynamicEntitiesPerJob = 4096;
+
+	// fully saturated, hue in [0, 1)
+	glm::vec4 GetHueColor(float hue)
+	{
+		glm::vec3 rgb = glm::abs(glm::fract(hue + glm::vec3(1.0f, 2.0f / 3.0f, 1.0f / 3.0f)) * 6.0f - 3.0f) - 1.0f;
+		return glm::vec4(glm::clamp(rgb, 0.0f, 1.0f), 1.0f);
+	}
+
+	template<typename T>
+	void AppendSceneUniforms(std::vector<SceneUniform>& uniforms, const std::unordered_map<std::string, T>& values, SceneUniformType type)
+	{
+		static_assert(sizeof(T) <= sizeof(SceneUniform::values));
+		for (const auto& it : values)
+		{
+			SceneUniform uniform;
+			uniform.name = it.first;
+			uniform.type = type;
+			memcpy(uniform.values, &it.second, sizeof(T));
+			uniforms.push_back(uniform);
+		}
+	}
+
+	// An existing name is hot swapped, everything holding its handle picks up the new resource
+	template<typename T>
+	Handle<T> SetNamedResource(ResourcePool<T>& pool, NameRegistry<Handle<T>>& names, NameId name, std::unique_ptr<T> resource)
+	{
+		Handle<T>* existing = names.Find(name);
+		if (existing && pool.Replace(*existing, std::move(resource)))
+		{
+			return *existing;
+		}
+		Handle<T> handle = pool.Add(std::move(resource));
+		names.InsertOrAssign(name, handle);
+		return handle;
+	}
+
+	// Shader names with the given extension, in name order
+	void FilterShaders(const NameRegistry<std::string>& shaders, std::string_view extension, std::vector<NameId>& ids, std::vector<const char*>& names)
+	{
+		ids.clear();
+		names.clear();
+		for (NameId id : shaders.GetSortedIds())
+		{
+			if (StringInterner::Get().GetView(id).ends_with(extension))
+			{
+				ids.push_back(id);
+				names.push_back(GetName(id));
+			}
+		}
+	}
+
+	template<typename T>
+	void SetSceneUniform(Material& material, const SceneUniform& uniform)
+	{
+		T value;
+		memcpy(&value, uniform.values, sizeof(T));
+		material.SetUniformValue<T>(uniform.name, value);
+	}
+}
+
+// ImGui's draw data of one frame, kept for the render thread while ImGui builds the next one. The buffers are swapped
+// with ImGui's lists instead of copied, both sides keep their capacity so steady frames do not allocate.
+struct ImGuiDrawSnapshot
+{
+	ImDrawData drawData;
+	std::vector<std::unique_ptr<ImDrawList>> lists;
+	std::vector<ImDrawList*> listPointers;
+
+	void Capture(ImDrawData* source)
+	{
+		drawData = *source;
+		while (lists.size() < (size_t)source->CmdListsCount)
+		{
+			lists.push_back(std::make_unique<ImDrawList>(nullptr));
+			listPointers.push_back(lists.back().get());
+		}
+		for (int i = 0; i < source->CmdListsCount; i++)
+		{
+			ImDrawList* list = source->CmdLists[i];
+			lists[i]->CmdBuffer.swap(list->CmdBuffer);
+			lists[i]->IdxBuffer.swap(list->IdxBuffer);
+			lists[i]->VtxBuffer.swap(list->VtxBuffer);
+			lists[i]->Flags = list->Flags;
+		}
+		drawData.CmdLists = listPointers.data();
+	}
+};
+
 Camera* App::mCamera = new Camera(glm::vec3(0.0f, 0.0f, 3.0f));
 bool App::mIsUsingCamera = false;
 float App::mLastX = 0.0f;
 float App::mLastY = 0.0f;
 bool App::mFirstMouse = true;
+int App::mUiFramesPending = UiSettleFrames;
+std::unique_ptr<InputRecorder> App::mInputRecorder;
+std::unique_ptr<InputReplay> App::mInputReplay;
 int App::mWindowWidth = 1080;
 int App::mWindowHeight = 720;
 
 App::App()
 	: mIsRunning(false)
+	, mHeadlessFrames(0)
+	, mIsHeadlessSceneLoaded(false)
 	, mDeltaTime(0.0)
 	, mLastFrame(0.0)
 	, mCurrentFrame(0.0)
 	, mAspectRatio(1.5f)
 	, mWindow(nullptr)
+	, mMovementKeys(0)
 	, mView(glm::mat4(0.0f))
 	, mProjection(glm::mat4(0.0f))
 	, mInSceneView(false)
 	, mClearColor(0.3f, 0.3f, 0.3f, 1.0f)
+	, mSimulationAccumulator(0.0)
+	, mSimulationAlpha(0.0f)
+	, mSimulationSteps(0)
+	, mFrameArenaUsed(0)
+	, mFrameAllocationStart(GetAllocationStats())
+	, mDrawCount(0)
+	, mCulledCount(0)
+	, mImGuiSnapshots{ std::make_unique<ImGuiDrawSnapshot>(), std::make_unique<ImGuiDrawSnapshot>() }
+	, mCommandBufferIndex(0)
+	, mCommandCount(0)
+	, mCommandBytes(0)
+	, mIsOnDemandRendering(true)
+	, mIsSceneDamaged(true)
+	, mRenderedView(0.0f)
+	, mRenderedProjection(0.0f)
+	, mExportFrameCount(0)
+	, mExportFrame(0)
+	, mIsTurntable(false)
+	, mTurntableTarget(0.0f)
+	, mTurntableRadius(0.0f)
+	, mTurntableHeight(0.0f)
+	, mTurntableAngle(0.0f)
+	, mStressSceneSeconds(0.0)
+	, mIsCompactionQueued(false)
 {
 	
 }
 
+App::~App()
+{
+
+}
+
 bool App::Initialize()
 {
 	if (glfwInit() == GLFW_FALSE)
@@ -67,9 +239,16 @@ bool App::Initialize()
 	glfwSetScrollCallback(mWindow, ScrollCallback);
 	glfwSetFramebufferSizeCallback(mWindow, FramebufferResizeCallback);
 
-	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+	// set before ImGui installs its own callbacks, which chain to these
+	glfwSetKeyCallback(mWindow, [](GLFWwindow*, int, int, int, int) { mUiFramesPending = UiSettleFrames; });
+	glfwSetCharCallback(mWindow, [](GLFWwindow*, unsigned int) { mUiFramesPending = UiSettleFrames; });
+	glfwSetMouseButtonCallback(mWindow, [](GLFWwindow*, int, int, int) { mUiFramesPending = UiSettleFrames; });
+	glfwSetCursorEnterCallback(mWindow, [](GLFWwindow*, int) { mUiFramesPending = UiSettleFrames; });
+	glfwSetWindowFocusCallback(mWindow, [](GLFWwindow*, int) { mUiFramesPending = UiSettleFrames; });
+	glfwSetWindowRefreshCallback(mWindow, [](GLFWwindow*) { mUiFramesPending = UiSettleFrames; });
+
+	if (!LoadGl((void* (*)(const char*))glfwGetProcAddress))
 	{
-		LOG("Could not load GLAD");
 		return false;
 	}
 
@@ -83,76 +262,312 @@ bool App::Initialize()
 	ImGui_ImplOpenGL3_Init("#version 330");
 	ImGui::PushStyleColor(ImGuiCol_Header, { 0.2f, 0.2f, 0.2f, 0.2f });
 
+	Profiler::Get().SetThreadName("Main");
+
+	LoadAssets();
+
+	mSimulation[0].cameraPosition = mCamera->GetPosition();
+	mSimulation[1] = mSimulation[0];
+
+	// ImGui's font texture and shaders are created here, afterwards only the render thread touches GL
+	ImGui_ImplOpenGL3_NewFrame();
+	glfwMakeContextCurrent(nullptr);
+	GLFWwindow* window = mWindow;
+	RenderThread::Get().Start([window]() { glfwMakeContextCurrent(window); }, []() { glfwMakeContextCurrent(nullptr); });
+
+	mIsRunning = true;
+	return true;
+}
+
+bool App::InitializeHeadless(const HeadlessSettings& settings)
+{
+	mHeadless = settings;
+	mHeadlessContext = std::make_unique<HeadlessContext>();
+	if (!mHeadlessContext->Create() || !mHeadlessContext->MakeCurrent())
+	{
+		mHeadlessContext.reset();
+		return false;
+	}
+	if (!LoadGl(HeadlessContext::GetProcAddress))
+	{
+		return false;
+	}
+	LOG("Rendering headless on %s", (const char*)glGetString(GL_RENDERER));
+
+	Profiler::Get().SetThreadName("Main");
+
 	LoadAssets();
 
-	glViewport(0, -180, mWindowWidth, mWindowWidth);
+	mSimulation[0].cameraPosition = mCamera->GetPosition();
+	mSimulation[1] = mSimulation[0];
+
+	mHeadlessContext->ReleaseCurrent();
+	HeadlessContext* context = mHeadlessContext.get();
+	RenderThread::Get().Start([context]() { context->MakeCurrent(); }, [context]() { context->ReleaseCurrent(); });
 
 	mIsRunning = true;
 	return true;
 }
 
+bool App::LoadGl(void* (*getProcAddress)(const char*))
+{
+	if (!gladLoadGLLoader((GLADloadproc)getProcAddress))
+	{
+		LOG("Could not load GLAD");
+		return false;
+	}
+#ifndef NDEBUG
+	GlStats::Get().Install(); // before anything is created, so the object counts are complete
+#endif
+	return true;
+}
+
 void App::Update()
 {
-	mCurrentFrame = glfwGetTime();
-	mDeltaTime = mCurrentFrame - mLastFrame;
+	Profiler::Get().EndFrame();
+
+	// an idle editor sleeps until an event arrives instead of redrawing the same frame
+	bool isSettling = mSimulation[0].cameraPosition != mSimulation[1].cameraPosition;
+	bool isReadingBack = mExportFrame < mExportFrameCount || mReadback->GetPendingCount() > 0; // reads are polled in by frames, writing needs none
+	bool isBusy = mUiFramesPending > 0 || mIsSceneDamaged || mIsUsingCamera || isSettling || Profiler::Get().IsCapturing() || isReadingBack || mInputReplay || mPendingStressScene
+		|| !mAssets->GetProgress().IsDone();
+	if (IsHeadless())
+	{
+		if (!mAssets->GetProgress().IsDone())
+		{
+			std::this_thread::sleep_for(HeadlessLoadingWait); // nothing is drawn until the workers are done
+		}
+	}
+	else if (mIsOnDemandRendering && !isBusy)
+	{
+		glfwWaitEventsTimeout(IdleWaitTimeout);
+		if (ImGui::GetIO().WantTextInput)
+		{
+			mUiFramesPending = std::max(mUiFramesPending, 1); // keeps the text cursor blinking
+		}
+	}
+	else
+	{
+		glfwPollEvents();
+	}
+
+	Profiler::Get().BeginFrame();
+	PROFILE_ZONE("Update");
+
+	if (IsHeadless() || mInputReplay)
+	{
+		// one step per frame, so a run renders the same frames however long they take
+		mDeltaTime = SimulationStep;
+		mCurrentFrame += SimulationStep;
+	}
+	else
+	{
+		mCurrentFrame = glfwGetTime();
+		mDeltaTime = mCurrentFrame - mLastFrame;
+		ProcessInput();
+	}
 	mLastFrame = mCurrentFrame;
 
-	mView = mCamera->GetViewMatrix();
+	if (mInputReplay && mWindow && glfwGetKey(mWindow, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+	{
+		StopInputReplay(); // the replay may have left the scene view fullscreen, without the UI to stop it from
+	}
+	if (mInputReplay)
+	{
+		if (IsHeadless() && mInputReplay->GetTime() == 0.0)
+		{
+			// exactly the replayed frames, so runs of different builds line up frame by frame
+			StartProfileCapture(mInputReplay->GetFrameCount(SimulationStep), mHeadless.timingsPath);
+		}
+		mInputReplay->Advance(SimulationStep, [this](const InputEvent& event) { ApplyInputEvent(event); });
+		if (mInputReplay->IsFinished())
+		{
+			StopInputReplay();
+		}
+	}
+	else if (mInputRecorder)
+	{
+		InputEvent keys;
+		keys.type = InputEventType::Keys;
+		keys.bits = mMovementKeys;
+		mInputRecorder->Record(keys);
+		InputEvent cameraMode;
+		cameraMode.type = InputEventType::CameraMode;
+		cameraMode.bits = (mIsUsingCamera ? (uint32_t)InputCameraInUse : 0u) | (mInSceneView ? (uint32_t)InputCameraSceneView : 0u);
+		mInputRecorder->Record(cameraMode);
+	}
+
+	mSimulationAccumulator = std::min(mSimulationAccumulator + mDeltaTime, MaxSimulationSteps * SimulationStep);
+	mSimulationSteps = 0;
+	while (mSimulationAccumulator >= SimulationStep)
+	{
+		FixedUpdate();
+		mSimulationAccumulator -= SimulationStep;
+		mSimulationSteps++;
+	}
+	mSimulationAlpha = static_cast<float>(mSimulationAccumulator / SimulationStep);
+	InterpolateDynamicEntities();
+
+	// mouse look is applied as events arrive and is not interpolated, only what the steps move is
+	glm::vec3 cameraPosition = glm::mix(mSimulation[0].cameraPosition, mSimulation[1].cameraPosition, mSimulationAlpha);
+	mView = mCamera->GetViewMatrix(cameraPosition);
+	if (mExportFrame < mExportFrameCount && !mExporter->CanAccept(mReadback->GetPendingCount()))
+	{
+		// the writers are behind, frames that cannot be requested would only take time from them
+		PROFILE_ZONE("Export wait");
+		mReadback->Flush();
+		mExporter->WaitForRoom();
+	}
+	if (mIsTurntable && mExportFrame < mExportFrameCount)
+	{
+		// the frame stays on its angle until it has been requested, a sequence does not depend on the frame rate
+		float angle = mTurntableAngle + glm::two_pi<float>() * mExportFrame / mExportFrameCount;
+		glm::vec3 position = mTurntableTarget + glm::vec3(std::sin(angle) * mTurntableRadius, mTurntableHeight, std::cos(angle) * mTurntableRadius);
+		mView = glm::lookAt(position, mTurntableTarget, glm::vec3(0.0f, 1.0f, 0.0f));
+	}
 
 	mProjection = glm::perspective(glm::radians(mCamera->GetZoom()), static_cast<float>(mWindowWidth / mWindowHeight), 0.1f, 100.0f);
 
-	for (auto& e : mEntities)
 	{
-		glm::mat4 model(1.0f);
-		model = glm::translate(model, e.second->translate);
-		model = glm::rotate(model, glm::radians(e.second->angle), e.second->rotate);
-		model = glm::scale(model, e.second->scale);
-		e.second->model = model;
+		PROFILE_ZONE("Asset uploads");
+		mAssets->Update(AssetUploadBudget);
 	}
 
-	ProcessInput();
+	if (mCompaction.valid() && mCompaction.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+	{
+		mCompaction.get();
+	}
+	if (mJournal && !mCompaction.valid() && (mIsCompactionQueued || mJournal->GetSize() > JournalCompactSize))
+	{
+		CompactJournal();
+	}
 
-	if (glfwWindowShouldClose(mWindow))
+	if (IsHeadless())
+	{
+		if (!mIsHeadlessSceneLoaded && mAssets->GetProgress().IsDone())
+		{
+			mIsHeadlessSceneLoaded = true;
+			if (!mHeadless.scenePath.empty() && !LoadScene(mHeadless.scenePath))
+			{
+				LOG("Could not load scene %s", mHeadless.scenePath.c_str());
+				mIsRunning = false;
+			}
+			if (!mHeadless.replayPath.empty() && !StartInputReplay(mHeadless.replayPath))
+			{
+				mIsRunning = false;
+			}
+		}
+		// the export starts with the last frame, a turntable renders its frames after it
+		bool isExportDue = mIsHeadlessSceneLoaded && !mInputReplay && mExportFrameCount == 0 && mHeadlessFrames + 1 >= mHeadless.frameCount;
+		if (isExportDue && !mHeadless.outputPath.empty())
+		{
+			if (mHeadless.turntableFrames > 0)
+			{
+				TurntableSettings turntable;
+				turntable.frameCount = mHeadless.turntableFrames;
+				StartTurntable(turntable, mHeadless.outputPath);
+			}
+			else
+			{
+				SaveImage(mHeadless.outputPath);
+			}
+		}
+	}
+	else if (glfwWindowShouldClose(mWindow))
 	{
 		mIsRunning = false;
 	}
 
-	glfwPollEvents();
+	// a headless run generates right after loading its scene, so its first frame already shows the result
+	if (mPendingStressScene && mAssets->GetProgress().IsDone() && (!IsHeadless() || mIsHeadlessSceneLoaded))
+	{
+		if (!BuildStressScene(*mPendingStressScene) && IsHeadless())
+		{
+			mIsRunning = false;
+		}
+		mPendingStressScene.reset();
+	}
 }
 
 void App::Render()
 {
-	glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer->GetFB());
-	glViewport(0, 0, mFramebuffer->GetSize().x, mFramebuffer->GetSize().y);
-	glEnable(GL_DEPTH_TEST);
-	glClearColor(mClearColor.r, mClearColor.g, mClearColor.b, mClearColor.a);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	PROFILE_ZONE("Render");
+
+	// the scene texture is kept until something it shows changes, the UI around it only redraws after input
+	// a capture measures whole frames and an export reads them back, nothing is skipped while either runs
+	bool isExportingFrame = mExportFrame < mExportFrameCount;
+	bool isSceneDamaged = !mIsOnDemandRendering || IsHeadless() || Profiler::Get().IsCapturing() || isExportingFrame || mIsSceneDamaged || mView != mRenderedView || mProjection != mRenderedProjection;
+	if (mIsOnDemandRendering && !isSceneDamaged && mUiFramesPending == 0 && mReadback->GetPendingCount() == 0)
+	{
+		CollectResources();
+		return;
+	}
+	if (IsHeadless() && !mIsHeadlessSceneLoaded)
+	{
+		CollectResources();
+		return;
+	}
+	mUiFramesPending = std::max(mUiFramesPending - 1, 0);
+
+	CommandBuffer& commands = mCommandBuffers[mCommandBufferIndex];
+	commands.Reset();
 
-	for (auto& e : mEntities)
+	if (isSceneDamaged)
 	{
-		RenderEntity(e.second);
+		PROFILE_GPU_ZONE(commands, "Scene");
+		commands.BindFramebuffer(mFramebuffer->GetFB());
+		commands.Viewport(0, 0, mFramebuffer->GetSize().x, mFramebuffer->GetSize().y);
+		commands.Enable(GL_DEPTH_TEST);
+		commands.ClearColor(mClearColor);
+		commands.Clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		FrameVector<DrawItem> drawList(&mFrameArena);
+		BuildDrawList(drawList);
+		RecordDrawList(commands, drawList, mView, mProjection);
+
+		mIsSceneDamaged = false;
+		mRenderedView = mView;
+		mRenderedProjection = mProjection;
 	}
 
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-	glViewport(0, -180, mWindowWidth, mWindowWidth);
+	if (isExportingFrame)
+	{
+		std::string path = mExportFrameCount > 1 ? FormatSequencePath(mExportPath, mExportFrame) : mExportPath;
+		ImageExporter* exporter = mExporter.get();
+		mReadback->Request(commands, *mFramebuffer, [exporter, path](ImageRgba8&& image) { exporter->Write(path, std::move(image)); });
+		mExportFrame++;
+	}
+	if (mReadback->GetPendingCount() > 0)
+	{
+		mReadback->Poll(commands);
+	}
 
-	if (mInSceneView)
+	if (IsHeadless())
+	{
+		// no window to show the scene texture in, it is read back instead
+	}
+	else if (mInSceneView && mFramebufferShader)
 	{
-		glDisable(GL_DEPTH_TEST);
+		PROFILE_GPU_ZONE(commands, "Scene view");
+		commands.BindFramebuffer(0);
+		commands.Viewport(0, -180, mWindowWidth, mWindowWidth);
+		commands.Disable(GL_DEPTH_TEST);
 
-		mFramebufferRect->Bind();
-		glBindTexture(GL_TEXTURE_2D, mFramebuffer->GetTextureId());
-		mFramebufferShader->Bind();
+		mFramebufferRect->Bind(commands);
+		commands.BindTexture(mFramebuffer->GetTextureId());
+		mFramebufferShader->Bind(commands);
 
-		glDrawElements(GL_TRIANGLES, mFramebufferRect->GetElementCount(), GL_UNSIGNED_INT, 0);
+		mFramebufferRect->Draw(commands);
 
-		mFramebufferShader->Unbind();
-		glBindTexture(GL_TEXTURE_2D, 0);
-		mFramebufferRect->Unbind();
+		mFramebufferShader->Unbind(commands);
+		commands.BindTexture(0);
+		mFramebufferRect->Unbind(commands);
 	}
 	else 
 	{
-		ImGui_ImplOpenGL3_NewFrame();
+		commands.BindFramebuffer(0);
+		commands.Viewport(0, -180, mWindowWidth, mWindowWidth);
+
 		ImGui_ImplGlfw_NewFrame();
 		ImGui::NewFrame();
 		if (ImGui::GetIO().ConfigFlags & ImGuiConfigFlags_DockingEnable)
@@ -160,79 +575,1057 @@ void App::Render()
 			ImGui::DockSpaceOverViewport(ImGui::GetMainViewport());
 		}
 
-		ImGuiRender();
+		{
+			PROFILE_ZONE("ImGuiRender");
+			ImGuiRender();
+			ImGui::Render();
+		}
+
+		PROFILE_GPU_ZONE(commands, "UI");
+		ImGuiDrawSnapshot& snapshot = *mImGuiSnapshots[mCommandBufferIndex];
+		snapshot.Capture(ImGui::GetDrawData());
+		commands.Callback([](void* drawData) { ImGui_ImplOpenGL3_RenderDrawData((ImDrawData*)drawData); }, &snapshot.drawData);
+	}
+
+	Profiler::Get().EndGpuFrame(commands);
+	commands.Callback([](void* window) {
+		if (window)
+		{
+			PROFILE_ZONE("SwapBuffers");
+			glfwSwapBuffers((GLFWwindow*)window);
+		}
+		GlStats::Get().EndFrame();
+	}, mWindow);
+
+	// returns once the previous frame is done, its buffer is the one recorded into next
+	mCommandCount = commands.GetCommandCount();
+	mCommandBytes = commands.GetSize();
+	{
+		PROFILE_ZONE("Submit");
+		RenderThread::Get().Submit(commands);
+	}
+	mCommandBufferIndex ^= 1;
+
+	if (IsHeadless())
+	{
+		FinishHeadlessFrame();
+	}
+
+	CollectResources();
+
+	mFrameArenaUsed = mFrameArena.GetUsed();
+	mFrameArena.Reset();
+	AllocationStats allocations = GetAllocationStats();
+	mFrameAllocations = allocations - mFrameAllocationStart;
+	mFrameAllocationStart = allocations;
+
+	Profiler& profiler = Profiler::Get();
+	profiler.SetCounter("Draws", mDrawCount);
+	profiler.SetCounter("Culled", mCulledCount);
+	profiler.SetCounter("Render commands", mCommandCount);
+	profiler.SetCounter("Command bytes", (double)mCommandBytes);
+	profiler.SetCounter("Frame arena bytes", (double)mFrameArenaUsed);
+	profiler.SetCounter("Heap allocations", (double)mFrameAllocations.count);
+	profiler.SetCounter("Heap allocated bytes", (double)mFrameAllocations.bytes);
+	profiler.SetCounter("Simulation steps", mSimulationSteps);
+	if (GlStats::Get().IsInstalled())
+	{
+		// of the frame the render thread finished last
+		GlFrameStats glFrame = GlStats::Get().GetFrameStats();
+		GlObjectStats glObjects = GlStats::Get().GetObjectStats();
+		profiler.SetCounter("GL draw calls", glFrame.drawCalls);
+		profiler.SetCounter("GL triangles", (double)glFrame.triangles);
+		profiler.SetCounter("GL state changes", glFrame.stateChanges);
+		profiler.SetCounter("GL redundant binds", glFrame.redundantBinds);
+		profiler.SetCounter("GL uniform uploads", glFrame.uniformUploads);
+		profiler.SetCounter("GL buffer upload bytes", (double)glFrame.bufferUploadBytes);
+		profiler.SetCounter("GL texture upload bytes", (double)glFrame.textureUploadBytes);
+		profiler.SetCounter("GL buffer memory", (double)glObjects.bytes[(int)GlObjectType::Buffer]);
+		profiler.SetCounter("GL texture memory", (double)glObjects.bytes[(int)GlObjectType::Texture]);
+		profiler.SetCounter("GL renderbuffer memory", (double)glObjects.bytes[(int)GlObjectType::Renderbuffer]);
+	}
+}
+
+void App::StartProfileCapture(uint32_t frameCount, const std::string& path)
+{
+	std::string basePath = path;
+	if (basePath.empty())
+	{
+		auto seconds = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+		basePath = CaptureDirectory + "/capture-" + std::to_string(seconds);
+	}
+	LOG("Capturing %u frames to %s", frameCount, basePath.c_str());
+
+	// writing happens on a worker, the frames after the capture are not held up by it
+	Profiler::Get().StartCapture(frameCount, [basePath](std::shared_ptr<ProfileCapture> capture) {
+		ThreadPool::Get().Submit([basePath, capture]() {
+			bool isWritten = WriteChromeTrace(*capture, basePath + ".json");
+			isWritten = WriteProfileCsv(*capture, basePath + ".csv") && isWritten;
+			if (isWritten)
+			{
+				LOG("Wrote profile capture of %zu frames to %s", capture->frames.size(), basePath.c_str());
+			}
+		});
+	});
+}
+
+void App::SaveImage(const std::string& path)
+{
+	mExportPath = path;
+	mExportFrameCount = 1;
+	mExportFrame = 0;
+	mIsTurntable = false;
+	mExporter->ResetCounts();
+}
+
+void App::StartTurntable(const TurntableSettings& settings, const std::string& pattern)
+{
+	glm::vec3 offset = mCamera->GetPosition() - settings.target;
+	mTurntableTarget = settings.target;
+	mTurntableRadius = std::max(glm::length(glm::vec2(offset.x, offset.z)), 0.01f);
+	mTurntableHeight = offset.y;
+	mTurntableAngle = std::atan2(offset.x, offset.z);
+	mIsTurntable = true;
+
+	mExportPath = pattern;
+	mExportFrameCount = std::max(settings.frameCount, 1u);
+	mExportFrame = 0;
+	mExporter->ResetCounts();
+	LOG("Rendering a turntable of %u frames to %s", mExportFrameCount, pattern.c_str());
+}
+
+bool App::IsExporting() const
+{
+	return mExportFrame < mExportFrameCount || (mReadback && mReadback->GetPendingCount() > 0) || (mExporter && mExporter->GetInFlight() > 0);
+}
+
+bool App::StartInputRecording(const std::string& path)
+{
+	if (mInputReplay)
+	{
+		return false;
+	}
+	InputRecordingStart start;
+	start.cameraPosition = mCamera->GetPosition();
+	start.yaw = mCamera->GetYaw();
+	start.pitch = mCamera->GetPitch();
+	start.zoom = mCamera->GetZoom();
+	auto recorder = std::make_unique<InputRecorder>();
+	if (!recorder->Open(path, start))
+	{
+		return false;
+	}
+	mInputRecorder = std::move(recorder);
+	LOG("Recording input to %s", path.c_str());
+	return true;
+}
+
+void App::StopInputRecording()
+{
+	mInputRecorder.reset();
+}
+
+bool App::StartInputReplay(const std::string& path)
+{
+	if (mInputRecorder)
+	{
+		return false;
+	}
+	auto replay = std::make_unique<InputReplay>();
+	if (!replay->Open(path))
+	{
+		return false;
+	}
+
+	// from the recorded camera with nothing carried over, so every replay takes the same steps
+	const InputRecordingStart& start = replay->GetStart();
+	mCamera->SetState(start.cameraPosition, start.yaw, start.pitch, start.zoom);
+	mSimulation[0].cameraPosition = start.cameraPosition;
+	mSimulation[1] = mSimulation[0];
+	mSimulationAccumulator = 0.0;
+	mMovementKeys = 0;
+	mInputReplay = std::move(replay);
+	return true;
+}
+
+void App::StopInputReplay()
+{
+	if (!mInputReplay)
+	{
+		return;
+	}
+	LOG("Replayed %zu input events over %.1f s", mInputReplay->GetEventCount(), mInputReplay->GetDuration());
+	mInputReplay.reset();
+	mMovementKeys = 0;
+	if (mWindow)
+	{
+		// live input takes over where the recording left the camera
+		mIsUsingCamera = false;
+		mInSceneView = false;
+		glfwSetInputMode(mWindow, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
+		mLastFrame = glfwGetTime();
+	}
+}
+
+void App::FinishHeadlessFrame()
+{
+	// a replay profiles its frames, the capture is only handed off at the start of the frame after them
+	if (++mHeadlessFrames < mHeadless.frameCount || mInputReplay || Profiler::Get().IsCapturing() || mExportFrame < mExportFrameCount)
+	{
+		return;
+	}
+	if (!mHeadless.outputPath.empty() && mExportFrameCount == 0)
+	{
+		return; // a replay just ended, the export starts next frame
+	}
+	mIsRunning = false;
+
+	if (mExportFrameCount > 0)
+	{
+		mReadback->Flush();
+		mExporter->WaitIdle();
+		LOG("Wrote %u of %u images to %s", mExporter->GetWrittenCount(), mExportFrameCount, mExportPath.c_str());
+	}
+}
+
+void App::CollectResources()
+{
+	// whatever was destroyed or swapped out during the frame is no longer referenced by it
+	mObjectPool.Collect();
+	mMaterialPool.Collect();
+	mShaderPool.Collect();
+	mTexturePool.Collect();
+	mVertexArrayPool.Collect();
+}
+
+void App::Shutdown()
+{
+	mAssets.reset();
+	if (mAssetDatabase)
+	{
+		mAssetDatabase->Save();
+	}
+	if (mCompaction.valid())
+	{
+		mCompaction.wait();
+	}
+	if (mJournal)
+	{
+		mJournal->Close();
+	}
+	StopInputRecording();
+	delete mCamera;
+	mIsRunning = false;
+	if (mReadback)
+	{
+		mReadback->Flush();
+	}
+	mExporter.reset(); // waits for the images still being written
+	RenderThread::Get().Stop();
+	if (IsHeadless())
+	{
+		mHeadlessContext->MakeCurrent(); // resources still release their GL objects, the context goes with the App
+		mReadback.reset();
+		return;
+	}
+	glfwMakeContextCurrent(mWindow);
+	mReadback.reset();
+	ImGui_ImplOpenGL3_Shutdown();
+	ImGui_ImplGlfw_Shutdown();
+	ImGui::DestroyContext();
+	glfwDestroyWindow(mWindow);
+	glfwTerminate();
+}
+
+bool App::SaveScene(const std::string& path)
+{
+	auto start = std::chrono::steady_clock::now();
+	SceneFileData scene;
+	SnapshotScene(scene);
+	if (!WriteSceneFile(path, scene))
+	{
+		return false;
+	}
+	LOG("Saved scene %s with %zu entities in %.3fs", path.c_str(), scene.entities.GetCount(), std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+	return true;
+}
+
+void App::SnapshotScene(SceneFileData& scene)
+{
+	// names by handle index, the registries only hold live handles. Written in name order so saves are stable.
+	std::unordered_map<uint32_t, NameId> textureNames;
+	for (NameId name : mTextures.GetSortedIds())
+	{
+		Handle<Texture> texture = *mTextures.Find(name);
+		scene.textures.push_back({ GetName(name), mTexturePool.Get(texture)->GetPath() });
+		textureNames[texture.index] = name;
+	}
+
+	for (NameId name : mShaders.GetSortedIds())
+	{
+		scene.shaders.push_back({ GetName(name), *mShaders.Find(name) });
+	}
+
+	for (NameId name : mMaterials.GetSortedIds())
+	{
+		const Material* mat = mMaterialPool.Get(*mMaterials.Find(name));
+		const Shader* shader = mShaderPool.Get(mat->GetShader());
+		SceneMaterial material;
+		material.name = GetName(name);
+		material.vertexSource = shader->GetVertexShaderSource();
+		material.fragmentSource = shader->GetFragmentShaderSource();
+		if (mTexturePool.IsAlive(mat->GetTexture()))
+		{
+			material.texture = GetName(textureNames[mat->GetTexture().index]);
+		}
+		AppendSceneUniforms(material.uniforms, mat->GetUniformInts(), SceneUniformType::Int);
+		AppendSceneUniforms(material.uniforms, mat->GetUniformFloats(), SceneUniformType::Float);
+		AppendSceneUniforms(material.uniforms, mat->GetUniformFloat2s(), SceneUniformType::Float2);
+		AppendSceneUniforms(material.uniforms, mat->GetUniformFloat3s(), SceneUniformType::Float3);
+		AppendSceneUniforms(material.uniforms, mat->GetUniformFloat4s(), SceneUniformType::Float4);
+		AppendSceneUniforms(material.uniforms, mat->GetUniformMat3s(), SceneUniformType::Mat3);
+		AppendSceneUniforms(material.uniforms, mat->GetUniformMat4s(), SceneUniformType::Mat4);
+		scene.materials.push_back(std::move(material));
+	}
+
+	std::unordered_map<uint32_t, NameId> objectNames;
+	for (NameId name : mObjects.GetSortedIds())
+	{
+		Handle<Object> handle = *mObjects.Find(name);
+		const Object* object = mObjectPool.Get(handle);
+		scene.objects.push_back({ GetName(name), GetName(object->vaName), GetName(object->matName) });
+		objectNames[handle.index] = name;
+	}
+
+	// entities of deleted objects are written without an object and dropped on load
+	SceneEntities& entities = scene.entities;
+	entities.Resize(mEntities.size());
+	size_t i = 0;
+	for (const auto& entry : mEntities)
+	{
+		const Entity& e = entry.second;
+		entities.names[i] = entry.first;
+		auto object = objectNames.find(e.object.index);
+		if (mObjectPool.IsAlive(e.object) && object != objectNames.end())
+		{
+			entities.objects[i] = GetName(object->second);
+		}
+		entities.translates[i] = e.translate;
+		entities.angles[i] = e.angle;
+		entities.axes[i] = e.rotate;
+		entities.scales[i] = e.scale;
+		i++;
+	}
+}
+
+bool App::LoadScene(const std::string& path)
+{
+	auto start = std::chrono::steady_clock::now();
+	SceneFileData scene;
+	if (!ReadSceneFile(path, scene))
+	{
+		return false;
+	}
+
+	for (const auto& texture : scene.textures)
+	{
+		NameId name = InternName(texture.first);
+		if (!mTextures.Contains(name) && VirtualFileSystem::Get().Exists(texture.second))
+		{
+			SetNamedResource(mTexturePool, mTextures, name, std::make_unique<Texture>(texture.second));
+			mIsSceneDamaged = true;
+		}
+	}
+
+	// shader files on disk win over the copies stored in the scene
+	for (auto& shader : scene.shaders)
+	{
+		mShaders.Insert(InternName(shader.first), std::move(shader.second));
+	}
+
+	while (!mMaterials.IsEmpty())
+	{
+		DestroyMaterial(mMaterials.begin()->key);
+	}
+	for (const auto& material : scene.materials)
+	{
+		AddSceneMaterial(material);
+	}
+
+	while (!mObjects.IsEmpty())
+	{
+		DestroyObject(mObjects.begin()->key);
+	}
+	for (const auto& object : scene.objects)
+	{
+		AddSceneObject(object);
+	}
+
+	ClearEntities();
+	mEntities.reserve(scene.entities.GetCount());
+	AddSceneEntities(scene.entities, 0, scene.entities.GetCount());
+
+	LOG("Loaded scene %s with %zu entities in %.3fs", path.c_str(), mEntities.size(), std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+	return true;
+}
+
+void App::RequestScene(const std::string& path, const std::vector<AssetId>& dependencies, std::function<void()> onLoaded)
+{
+	// a missing or broken scene still finishes, so onLoaded always runs
+	auto scene = std::make_shared<SceneFileData>();
+	mAssets->Request("scene/" + path, dependencies,
+		[path, scene]() {
+			if (std::filesystem::exists(path))
+			{
+				ReadSceneFile(path, *scene);
+			}
+			return true;
+		},
+		[this, path, scene, onLoaded]() {
+			std::vector<AssetId> parts;
+			for (const auto& texture : scene->textures)
+			{
+				if (!mTextures.Contains(InternName(texture.first)) && mAssets->Find("texture/" + texture.first) == InvalidAsset && VirtualFileSystem::Get().Exists(texture.second))
+				{
+					parts.push_back(RequestTexture(texture.first, texture.second));
+				}
+			}
+
+			for (auto& shader : scene->shaders)
+			{
+				mShaders.Insert(InternName(shader.first), std::move(shader.second));
+			}
+
+			// texture -> material -> object -> entities
+			for (size_t i = 0; i < scene->materials.size(); i++)
+			{
+				const SceneMaterial& material = scene->materials[i];
+				parts.push_back(mAssets->Request("material/" + material.name, { mAssets->Find("texture/" + material.texture) },
+					nullptr, [this, scene, i]() { return AddSceneMaterial(scene->materials[i]); }));
+			}
+
+			std::vector<AssetId> objects;
+			for (size_t i = 0; i < scene->objects.size(); i++)
+			{
+				const SceneObject& object = scene->objects[i];
+				objects.push_back(mAssets->Request("object/" + object.name, { mAssets->Find("material/" + object.matName), mAssets->Find("mesh/" + object.vaName) },
+					nullptr, [this, scene, i]() { return AddSceneObject(scene->objects[i]); }));
+			}
+			parts.insert(parts.end(), objects.begin(), objects.end());
+
+			size_t entityCount = scene->entities.GetCount();
+			mEntities.reserve(mEntities.size() + entityCount);
+			for (size_t begin = 0; begin < entityCount; begin += EntityChunkSize)
+			{
+				size_t end = std::min(begin + EntityChunkSize, entityCount);
+				parts.push_back(mAssets->Request("entities/" + std::to_string(begin), objects, nullptr,
+					[this, scene, begin, end]() { AddSceneEntities(scene->entities, begin, end); return true; }));
+			}
+
+			mAssets->Request("scene loaded/" + path, parts, nullptr, [onLoaded]() {
+				if (onLoaded)
+				{
+					onLoaded();
+				}
+				return true;
+			});
+			return true;
+		});
+}
+
+bool App::AddSceneMaterial(const SceneMaterial& material)
+{
+	auto shader = std::make_unique<Shader>(material.vertexSource, material.fragmentSource);
+	if (shader->GetError().length() != 0)
+	{
+		LOG("Material %s not loaded, shader compilation failed", material.name.c_str());
+		return false;
+	}
+
+	Material* mat = mMaterialPool.Get(SetMaterial(InternName(material.name), std::move(shader), material.texture.empty() ? InvalidName : InternName(material.texture)));
+	for (const auto& uniform : material.uniforms)
+	{
+		switch (uniform.type)
+		{
+		case SceneUniformType::Int: SetSceneUniform<int>(*mat, uniform); break;
+		case SceneUniformType::Float: SetSceneUniform<float>(*mat, uniform); break;
+		case SceneUniformType::Float2: SetSceneUniform<glm::vec2>(*mat, uniform); break;
+		case SceneUniformType::Float3: SetSceneUniform<glm::vec3>(*mat, uniform); break;
+		case SceneUniformType::Float4: SetSceneUniform<glm::vec4>(*mat, uniform); break;
+		case SceneUniformType::Mat3: SetSceneUniform<glm::mat3>(*mat, uniform); break;
+		case SceneUniformType::Mat4: SetSceneUniform<glm::mat4>(*mat, uniform); break;
+		}
+	}
+	return true;
+}
+
+Handle<Material> App::SetMaterial(NameId name, std::unique_ptr<Shader> shader, NameId texture)
+{
+	// every material owns its shader
+	Handle<Material>* old = mMaterials.Find(name);
+	if (old)
+	{
+		mShaderPool.Destroy(mMaterialPool.Get(*old)->GetShader());
+	}
+
+	Handle<Texture>* textureHandle = mTextures.Find(texture);
+	auto material = std::make_unique<Material>(mShaderPool.Add(std::move(shader)), textureHandle ? *textureHandle : Handle<Texture>());
+	mIsSceneDamaged = true;
+	return SetNamedResource(mMaterialPool, mMaterials, name, std::move(material));
+}
+
+void App::DestroyMaterial(NameId name)
+{
+	// objects still using the material stop drawing instead of keeping it alive
+	Handle<Material>* material = mMaterials.Find(name);
+	if (material)
+	{
+		mShaderPool.Destroy(mMaterialPool.Get(*material)->GetShader());
+		mMaterialPool.Destroy(*material);
+		mMaterials.Erase(name);
+		mIsSceneDamaged = true;
+	}
+}
+
+void App::DestroyObject(NameId name)
+{
+	Handle<Object>* object = mObjects.Find(name);
+	if (object)
+	{
+		mObjectPool.Destroy(*object);
+		mObjects.Erase(name);
+		mIsSceneDamaged = true;
+	}
+}
+
+bool App::AddSceneObject(const SceneObject& object)
+{
+	NameId vaName = InternName(object.vaName);
+	NameId matName = InternName(object.matName);
+	Handle<VertexArray>* va = mVAs.Find(vaName);
+	Handle<Material>* mat = mMaterials.Find(matName);
+	if (!va || !mat)
+	{
+		LOG("Object %s not loaded, vertex array or material missing", object.name.c_str());
+		return false;
+	}
+
+	auto o = std::make_unique<Object>();
+	o->vaName = vaName;
+	o->matName = matName;
+	o->va = *va;
+	o->mat = *mat;
+	SetNamedResource(mObjectPool, mObjects, InternName(object.name), std::move(o));
+	mIsSceneDamaged = true;
+	return true;
+}
+
+Entity& App::SetEntity(std::string name, const Entity& entity)
+{
+	// map nodes never move, so the index can point at the key and value
+	auto it = mEntities.insert_or_assign(std::move(name), entity).first;
+	mEntityIndex.Add(it->first, &it->second);
+	UpdateModel(it->second);
+	mIsSceneDamaged = true;
+	return it->second;
+}
+
+void App::DestroyEntity(const std::string& name)
+{
+	auto it = mEntities.find(name);
+	if (it != mEntities.end())
+	{
+		const Entity* entity = &it->second;
+		std::erase_if(mDynamicEntities, [entity](const auto& dynamic) { return dynamic.entity == entity; });
+		mEntityIndex.Remove(it->first);
+		mEntities.erase(it);
+		mIsSceneDamaged = true;
+	}
+}
+
+void App::DestroyEntities(std::string_view prefix)
+{
+	std::unordered_set<const Entity*> destroyed;
+	for (auto it = mEntities.begin(); it != mEntities.end();)
+	{
+		if (it->first.starts_with(prefix))
+		{
+			destroyed.insert(&it->second);
+			mEntityIndex.Remove(it->first);
+			it = mEntities.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+	if (!destroyed.empty())
+	{
+		std::erase_if(mDynamicEntities, [&destroyed](const auto& dynamic) { return destroyed.contains(dynamic.entity); });
+		mIsSceneDamaged = true;
+	}
+}
+
+void App::ClearEntities()
+{
+	mEntityIndex.Clear();
+	mEntities.clear();
+	mDynamicEntities.clear();
+	mIsSceneDamaged = true;
+}
+
+void App::GenerateStressScene(const StressSceneSettings& settings)
+{
+	mPendingStressScene = std::make_unique<StressSceneSettings>(settings);
+}
+
+bool App::BuildStressScene(const StressSceneSettings& settings)
+{
+	PROFILE_ZONE("BuildStressScene");
+	auto start = std::chrono::steady_clock::now();
+	const std::string* vertexCode = mShaders.Find(InternName(StressVertexShader));
+	const std::string* fragmentCode = mShaders.Find(InternName(StressFragmentShader));
+	const std::vector<NameId>& meshes = mVAs.GetSortedIds();
+	if (!vertexCode || !fragmentCode || meshes.empty())
+	{
+		LOG("A stress scene needs the %s and %s shaders and a mesh", StressVertexShader.c_str(), StressFragmentShader.c_str());
+		return false;
+	}
+
+	// the materials only differ in colour, but each one has its own program like every other material
+	uint32_t materialCount = std::max(settings.materialCount, 1u);
+	for (uint32_t i = 0; i < materialCount; i++)
+	{
+		auto shader = std::make_unique<Shader>(*vertexCode, *fragmentCode);
+		if (!shader->GetError().empty())
+		{
+			LOG("Stress scene material not created, shader compilation failed");
+			return false;
+		}
+		Material* material = mMaterialPool.Get(SetMaterial(InternName(settings.prefix + "/material" + std::to_string(i)), std::move(shader), InvalidName));
+		material->SetUniformValue("col", GetHueColor((float)i / materialCount));
+	}
+
+	std::vector<std::string> objectNames;
+	std::unordered_map<std::string_view, Handle<Object>> objects;
+	for (uint32_t i = 0; i < std::max(settings.objectCount, 1u); i++)
+	{
+		std::string name = settings.prefix + "/object" + std::to_string(i);
+		AddSceneObject({ name, GetName(meshes[i % meshes.size()]), settings.prefix + "/material" + std::to_string(i % materialCount) });
+		objectNames.push_back(name);
+	}
+	for (const std::string& name : objectNames)
+	{
+		objects[name] = *mObjects.Find(InternName(name));
+	}
+
+	StressSceneEntities generated;
+	if (!GenerateStressEntities(settings, objectNames, generated))
+	{
+		return false;
+	}
+	double generateSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	DestroyEntities(settings.prefix + "/");
+	SceneEntities& entities = generated.entities;
+	mEntities.reserve(mEntities.size() + entities.GetCount());
+	for (size_t i = 0; i < entities.GetCount(); i++)
+	{
+		Entity e;
+		e.object = objects[entities.objects[i]];
+		e.translate = entities.translates[i];
+		e.angle = entities.angles[i];
+		e.rotate = entities.axes[i];
+		e.scale = entities.scales[i];
+		Entity& entity = SetEntity(std::move(entities.names[i]), e);
+		if (generated.spins[i] != 0.0f)
+		{
+			mDynamicEntities.push_back({ &entity, generated.spins[i], entity.angle });
+		}
+	}
+
+	// far too many entities to journal one by one, the autosave takes them in one go instead
+	CompactJournal();
+	mStressSceneSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	LOG("Generated %zu entities (%zu dynamic) over %zu objects in %.3fs, %.3fs of it on the thread pool", entities.GetCount(), mDynamicEntities.size(),
+		objectNames.size(), mStressSceneSeconds, generateSeconds);
+	return true;
+}
+
+void App::AddSceneEntities(SceneEntities& entities, size_t begin, size_t end)
+{
+	size_t skipped = 0;
+	Handle<Object> object;
+	for (size_t i = begin; i < end; i++)
+	{
+		// entities of the same object are usually stored next to each other
+		if (i == begin || entities.objects[i] != entities.objects[i - 1])
+		{
+			Handle<Object>* found = mObjects.Find(StringInterner::Get().Find(entities.objects[i]));
+			object = found ? *found : Handle<Object>();
+		}
+		if (!object.IsValid())
+		{
+			skipped++;
+			continue;
+		}
+
+		Entity e;
+		e.object = object;
+		e.translate = entities.translates[i];
+		e.angle = entities.angles[i];
+		e.rotate = entities.axes[i];
+		e.scale = entities.scales[i];
+		SetEntity(std::move(entities.names[i]), e);
+	}
+
+	if (skipped > 0)
+	{
+		LOG("%zu entities not loaded, their object is missing", skipped);
+	}
+}
+
+void App::RestoreAutosave(const std::vector<AssetId>& dependencies)
+{
+	// edits made while the autosave is still loading are not journaled
+	RequestScene(AutosaveScenePath, dependencies, [this]() {
+		// a segment left by a snapshot that was not written yet comes first
+		EditJournal::Replay(AutosaveRetiredJournalPath, [this](const JournalRecord& record) { ApplyJournalRecord(record); });
+		uint64_t validSize = EditJournal::Replay(AutosaveJournalPath, [this](const JournalRecord& record) { ApplyJournalRecord(record); });
+		if (IsHeadless())
+		{
+			return; // a batch run leaves the editor's autosave alone
+		}
+		mJournal = std::make_unique<EditJournal>();
+		if (!mJournal->Open(AutosaveJournalPath, validSize))
+		{
+			mJournal.reset();
+		}
+	});
+}
+
+AssetId App::RequestTexture(const std::string& name, const std::string& path, const std::vector<AssetId>& dependencies)
+{
+	// a failed decode still uploads, the texture falls back to its placeholder
+	auto image = std::make_shared<TextureImage>();
+	return mAssets->Request("texture/" + name, dependencies,
+		[this, path, image]() {
+			std::vector<std::string> artifacts;
+			if (mAssetDatabase->GetArtifacts(path, TextureCacheVersion, artifacts) && ReadTextureCache(artifacts[0], *image))
+			{
+				return true;
+			}
+
+			AssetRecord record;
+			if (DecodeTexture(path, *image) && mAssetDatabase->Find(path, record))
+			{
+				std::string cachePath = GetTextureCachePath(TextureCacheDirectory, record.contentHash);
+				if (WriteTextureCache(cachePath, *image))
+				{
+					mAssetDatabase->SetArtifacts(path, TextureCacheVersion, { cachePath });
+				}
+			}
+			return true;
+		},
+		[this, name, path, image]() {
+			SetNamedResource(mTexturePool, mTextures, InternName(name), std::make_unique<Texture>(path, std::move(*image)));
+			mIsSceneDamaged = true;
+			return true;
+		});
+}
+
+void App::RequestAssets()
+{
+	VirtualFileSystem& vfs = VirtualFileSystem::Get();
+	std::vector<std::string> texturePaths = vfs.List("resources/textures", { ".png", ".jpg" });
+	std::vector<std::string> meshPaths = vfs.List("resources/meshes", { ".obj", ".gltf", ".glb" });
+
+	// packed sources are already cooked, only loose files are tracked
+	std::vector<std::string> trackedPaths;
+	for (const auto& paths : { texturePaths, meshPaths })
+	{
+		std::copy_if(paths.begin(), paths.end(), std::back_inserter(trackedPaths), [&vfs](const std::string& path) { return !vfs.IsPacked(path); });
+	}
+
+	AssetId database = mAssets->Request("database", {}, [this, trackedPaths]() {
+		mAssetDatabase->Load(AssetDatabasePath);
+		AssetDatabaseStats stats;
+		mAssetDatabase->Refresh(trackedPaths, &stats);
+		LOG("Checked %u sources in %.3fs: %u rehashed, %u changed, %u removed", stats.checked, stats.seconds, stats.rehashed, stats.changed, stats.removed);
+		// before any mesh maps its entry, a removed entry is simply rebuilt by the mesh that still wants it
+		uint32_t evicted = TrimMeshCache(MeshCacheDirectory, MeshCacheMaxBytes);
+		if (evicted > 0)
+		{
+			LOG("Evicted %u mesh cache entries", evicted);
+		}
+		return true;
+	}, nullptr);
+
+	std::vector<AssetId> assets;
+	for (const auto& path : texturePaths)
+	{
+		assets.push_back(RequestTexture(std::filesystem::path(path).filename().string(), path, { database }));
+	}
+
+	for (const auto& path : vfs.List("resources/shaders", { ".vert", ".frag" }))
+	{
+		std::string name = std::filesystem::path(path).filename().string();
+		auto code = std::make_shared<std::string>();
+		assets.push_back(mAssets->Request("shader/" + name, {},
+			[path, code]() { return VirtualFileSystem::Get().ReadText(path, *code); },
+			[this, name, code]() {
+				mShaders.Insert(InternName(name), std::move(*code));
+				return true;
+			}));
+	}
+
+	mAssets->Request("program/framebuffer", { mAssets->Find("shader/framebuffer.vert"), mAssets->Find("shader/framebuffer.frag") }, nullptr, [this]() {
+		const std::string* vertexCode = mShaders.Find(InternName("framebuffer.vert"));
+		const std::string* fragmentCode = mShaders.Find(InternName("framebuffer.frag"));
+		if (!vertexCode || !fragmentCode)
+		{
+			return false;
+		}
+		mFramebufferShader = std::make_shared<Shader>(*vertexCode, *fragmentCode);
+		return mFramebufferShader->GetError().length() == 0;
+	});
+
+	for (const auto& path : meshPaths)
+	{
+		std::string name = std::filesystem::path(path).filename().string();
+		auto mesh = std::make_shared<PreparedMesh>();
+		auto stats = std::make_shared<MeshImportStats>();
+		assets.push_back(mAssets->Request("mesh/" + name, { database },
+			[this, path, mesh, stats]() {
+				// an unchanged source goes straight to its cache entry without being read and hashed again
+				std::vector<std::string> artifacts;
+				if (mAssetDatabase->GetArtifacts(path, MeshCacheVersion, artifacts) && mesh->PrepareFromCache(artifacts[0], stats.get()))
+				{
+					return true;
+				}
+				if (!mesh->Prepare(path, MeshCacheDirectory, stats.get()))
+				{
+					return false;
+				}
+				if (!mesh->GetCachePath().empty())
+				{
+					mAssetDatabase->SetArtifacts(path, MeshCacheVersion, { mesh->GetCachePath() });
+				}
+				return true;
+			},
+			[this, name, mesh, stats]() {
+				LOG("%s %s: %u vertices, %u triangles in %.3f s (%.1f MB/s, %.0f triangles/s)", mesh->IsFromCache() ? "Loaded cached" : "Imported",
+					name.c_str(), stats->vertices, stats->triangles, stats->seconds, stats->GetMegabytesPerSecond(), stats->GetTrianglesPerSecond());
+				SetNamedResource(mVertexArrayPool, mVAs, InternName(name), mesh->CreateVertexArray());
+				mIsSceneDamaged = true;
+				return true;
+			}));
+	}
+
+	mAssets->Request("database/save", assets, [this]() { return mAssetDatabase->Save(); }, nullptr);
+
+	RestoreAutosave(assets);
+}
+
+void App::CompactJournal()
+{
+	if (!mJournal)
+	{
+		return;
+	}
+	// one snapshot at a time, Update starts the next once this one is written
+	if (mCompaction.valid())
+	{
+		mIsCompactionQueued = true;
+		return;
+	}
+	mIsCompactionQueued = false;
+
+	// the scene is copied here, edits made while it is written go to a fresh journal segment
+	auto start = std::chrono::steady_clock::now();
+	auto scene = std::make_shared<SceneFileData>();
+	SnapshotScene(*scene);
+	if (!mJournal->Rotate(AutosaveRetiredJournalPath))
+	{
+		return;
+	}
+	LOG("Took an autosave snapshot of %zu entities in %.3fs", scene->entities.GetCount(), std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+	auto written = std::make_shared<std::promise<bool>>();
+	mCompaction = written->get_future();
+	ThreadPool::Get().Submit([scene, written]() {
+		// records hold absolute values, so a crash before the segment is removed only replays edits the snapshot already has
+		bool isWritten = WriteSceneFile(AutosaveScenePath, *scene);
+		if (isWritten)
+		{
+			std::error_code ec;
+			std::filesystem::remove(AutosaveRetiredJournalPath, ec);
+		}
+		else
+		{
+			LOG("Could not write the autosave snapshot, its journal segment is kept");
+		}
+		written->set_value(isWritten);
+	});
+}
+
+void App::RecordEdit(const JournalRecord& record)
+{
+	if (mJournal)
+	{
+		mJournal->Append(record);
+	}
+	if (mInputRecorder)
+	{
+		InputEvent event;
+		event.type = InputEventType::Edit;
+		event.edit = record;
+		mInputRecorder->Record(event);
+	}
+}
 
-		ImGui::Render();
-		ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+void App::RecordEntityTransform(const std::string& name)
+{
+	auto it = mEntities.find(name);
+	if (it == mEntities.end())
+	{
+		return;
 	}
 
-	glfwSwapBuffers(mWindow);
+	JournalRecord record;
+	record.type = JournalRecordType::SetEntityTransform;
+	record.name = name;
+	record.translate = it->second.translate;
+	record.angle = it->second.angle;
+	record.axis = it->second.rotate;
+	record.scale = it->second.scale;
+	RecordEdit(record);
 }
 
-void App::Shutdown()
+void App::ApplyJournalRecord(const JournalRecord& record)
 {
-	delete mCamera;
-	mIsRunning = false;
-	ImGui_ImplOpenGL3_Shutdown();
-	ImGui_ImplGlfw_Shutdown();
-	ImGui::DestroyContext();
-	glfwDestroyWindow(mWindow);
-	glfwTerminate();
+	switch (record.type)
+	{
+	case JournalRecordType::CreateEntity:
+	{
+		Handle<Object>* object = mObjects.Find(InternName(record.object));
+		if (!object)
+		{
+			LOG("Journal: entity %s references missing object %s", record.name.c_str(), record.object.c_str());
+			break;
+		}
+		Entity e;
+		e.object = *object;
+		e.translate = record.translate;
+		e.angle = record.angle;
+		e.rotate = record.axis;
+		e.scale = record.scale;
+		SetEntity(record.name, e);
+		break;
+	}
+	case JournalRecordType::DestroyEntity:
+		DestroyEntity(record.name);
+		break;
+	case JournalRecordType::SetEntityTransform:
+	{
+		auto it = mEntities.find(record.name);
+		if (it != mEntities.end())
+		{
+			it->second.translate = record.translate;
+			it->second.angle = record.angle;
+			it->second.rotate = record.axis;
+			it->second.scale = record.scale;
+			UpdateModel(it->second);
+			mIsSceneDamaged = true;
+		}
+		break;
+	}
+	case JournalRecordType::CreateObject:
+		AddSceneObject({ record.name, record.vaName, record.matName });
+		break;
+	case JournalRecordType::DestroyObject:
+		DestroyObject(InternName(record.name));
+		break;
+	case JournalRecordType::CreateMaterial:
+		AddSceneMaterial({ record.name, record.vertexSource, record.fragmentSource, record.texture });
+		break;
+	case JournalRecordType::DestroyMaterial:
+		DestroyMaterial(InternName(record.name));
+		break;
+	}
 }
 
 void App::LoadAssets()
 {
 	mFramebuffer = std::make_shared<Framebuffer>(mWindowWidth, mWindowHeight);
+	mReadback = std::make_unique<FramebufferReadback>(ReadbackRingSize);
+	mExporter = std::make_unique<ImageExporter>(ExportImagesPerThread * std::max(ThreadPool::Get().GetThreadCount(), 1u));
+
+	struct ScreenVertex
+	{
+		glm::vec2 position;
+		glm::vec2 uv;
+		using Format = VertexFormat<glm::vec2, glm::vec2>;
+	};
+
+	struct TexturedVertex
+	{
+		glm::vec3 position;
+		glm::vec2 uv;
+		using Format = VertexFormat<glm::vec3, glm::vec2>;
+	};
 
 	mFramebufferRect = std::make_shared<VertexArray>();
 	{
+		static constexpr ScreenVertex vertices[] = {
+			{ {  1.0f,  1.0f }, { 1.0f, 1.0f } },
+			{ {  1.0f, -1.0f }, { 1.0f, 0.0f } },
+			{ { -1.0f, -1.0f }, { 0.0f, 0.0f } },
+			{ { -1.0f,  1.0f }, { 0.0f, 1.0f } },
+		};
 		std::unique_ptr<VertexBuffer> vb = std::make_unique<VertexBuffer>();
-		vb->PushVertex({ 1.0f,  1.0f,		1.0f, 1.0f });
-		vb->PushVertex({ 1.0f, -1.0f,		1.0f, 0.0f });
-		vb->PushVertex({ -1.0f, -1.0f, 		0.0f, 0.0f });
-		vb->PushVertex({ -1.0f,  1.0f,		0.0f, 1.0f });
-		vb->SetLayout({ 2, 2 });
+		vb->Append<ScreenVertex>(vertices);
 		mFramebufferRect->PushBuffer(std::move(vb));
 	}
 	mFramebufferRect->SetElements({ 0, 3, 1, 1, 3, 2 });
 	mFramebufferRect->Upload();
 
-	std::shared_ptr<VertexArray> cubeVA = std::make_shared<VertexArray>();
+	std::unique_ptr<VertexArray> cubeVA = std::make_unique<VertexArray>();
 	{
+		static constexpr TexturedVertex vertices[] = {
+			{ { -0.5f, -0.5f, -0.5f }, { 0.0f, 0.0f } },
+			{ {  0.5f, -0.5f, -0.5f }, { 1.0f, 0.0f } },
+			{ {  0.5f,  0.5f, -0.5f }, { 1.0f, 1.0f } },
+			{ { -0.5f,  0.5f, -0.5f }, { 0.0f, 1.0f } },
+
+			{ { -0.5f, -0.5f,  0.5f }, { 0.0f, 0.0f } },
+			{ {  0.5f, -0.5f,  0.5f }, { 1.0f, 0.0f } },
+			{ {  0.5f,  0.5f,  0.5f }, { 1.0f, 1.0f } },
+			{ { -0.5f,  0.5f,  0.5f }, { 0.0f, 1.0f } },
+
+			{ { -0.5f,  0.5f,  0.5f }, { 1.0f, 0.0f } },
+			{ { -0.5f,  0.5f, -0.5f }, { 1.0f, 1.0f } },
+			{ { -0.5f, -0.5f, -0.5f }, { 0.0f, 1.0f } },
+			{ { -0.5f, -0.5f,  0.5f }, { 0.0f, 0.0f } },
+
+			{ {  0.5f,  0.5f,  0.5f }, { 1.0f, 0.0f } },
+			{ {  0.5f,  0.5f, -0.5f }, { 1.0f, 1.0f } },
+			{ {  0.5f, -0.5f, -0.5f }, { 0.0f, 1.0f } },
+			{ {  0.5f, -0.5f,  0.5f }, { 0.0f, 0.0f } },
+
+			{ { -0.5f, -0.5f, -0.5f }, { 0.0f, 1.0f } },
+			{ {  0.5f, -0.5f, -0.5f }, { 1.0f, 1.0f } },
+			{ {  0.5f, -0.5f,  0.5f }, { 1.0f, 0.0f } },
+			{ { -0.5f, -0.5f,  0.5f }, { 0.0f, 0.0f } },
+
+			{ { -0.5f,  0.5f, -0.5f }, { 0.0f, 1.0f } },
+			{ {  0.5f,  0.5f, -0.5f }, { 1.0f, 1.0f } },
+			{ {  0.5f,  0.5f,  0.5f }, { 1.0f, 0.0f } },
+			{ { -0.5f,  0.5f,  0.5f }, { 0.0f, 0.0f } },
+		};
 
 		std::unique_ptr<VertexBuffer> vb = std::make_unique<VertexBuffer>();
-		vb->PushVertex({-0.5f, -0.5f, -0.5f, 0.0f, 0.0f });
-		vb->PushVertex({ 0.5f, -0.5f, -0.5f, 1.0f, 0.0f });
-		vb->PushVertex({ 0.5f, 0.5f, -0.5f, 1.0f, 1.0f });
-		vb->PushVertex({-0.5f, 0.5f, -0.5f, 0.0f, 1.0f });
-
-		vb->PushVertex({-0.5f, -0.5f, 0.5f, 0.0f, 0.0f });
-		vb->PushVertex({ 0.5f, -0.5f, 0.5f, 1.0f, 0.0f });
-		vb->PushVertex({ 0.5f, 0.5f, 0.5f, 1.0f, 1.0f });
-		vb->PushVertex({-0.5f, 0.5f, 0.5f, 0.0f, 1.0f });
-
-		vb->PushVertex({-0.5f, 0.5f, 0.5f, 1.0f, 0.0f });
-		vb->PushVertex({-0.5f, 0.5f, -0.5f, 1.0f, 1.0f });
-		vb->PushVertex({-0.5f, -0.5f, -0.5f, 0.0f, 1.0f });
-		vb->PushVertex({-0.5f, -0.5f, 0.5f, 0.0f, 0.0f });
-
-		vb->PushVertex({ 0.5f, 0.5f, 0.5f, 1.0f, 0.0f });
-		vb->PushVertex({ 0.5f, 0.5f, -0.5f, 1.0f, 1.0f });
-		vb->PushVertex({ 0.5f, -0.5f, -0.5f, 0.0f, 1.0f });
-		vb->PushVertex({ 0.5f, -0.5f, 0.5f, 0.0f, 0.0f });
-
-		vb->PushVertex({-0.5f, -0.5f, -0.5f, 0.0f, 1.0f });
-		vb->PushVertex({ 0.5f, -0.5f, -0.5f, 1.0f, 1.0f });
-		vb->PushVertex({ 0.5f, -0.5f, 0.5f, 1.0f, 0.0f });
-		vb->PushVertex({-0.5f, -0.5f, 0.5f, 0.0f, 0.0f });
-
-		vb->PushVertex({-0.5f, 0.5f, -0.5f, 0.0f, 1.0f });
-		vb->PushVertex({ 0.5f, 0.5f, -0.5f, 1.0f, 1.0f });
-		vb->PushVertex({ 0.5f, 0.5f, 0.5f, 1.0f, 0.0f });
-		vb->PushVertex({-0.5f, 0.5f, 0.5f, 0.0f, 0.0f });
-
-		vb->SetLayout({ 3, 2 });
-
+		vb->Append<TexturedVertex>(vertices);
 		cubeVA->PushBuffer(std::move(vb));
 	}
 	cubeVA->SetElements({
@@ -243,35 +1636,109 @@ void App::LoadAssets()
 		18, 17, 16, 18, 16, 19,
 		22, 21, 20, 22, 20, 23
 	});
+	cubeVA->SetBounds(glm::vec3(-0.5f), glm::vec3(0.5f));
 	cubeVA->Upload();
 
-	mVAs.insert({ "cube", cubeVA });
+	SetNamedResource(mVertexArrayPool, mVAs, InternName("cube"), std::move(cubeVA));
 
-	mTextures = LoadTextures("resources/textures", { ".png", ".jpg" });
-	mShaders = LoadShaders("resources/shaders", { ".vert", ".frag" });
+	// packed resources shadow the loose files, which stay available for anything added since the pack was built
+	if (std::filesystem::is_regular_file(ResourcePackPath))
+	{
+		VirtualFileSystem::Get().MountPack(ResourcePackPath);
+	}
 
-	mFramebufferShader = std::make_shared<Shader>(mShaders["framebuffer.vert"], mShaders["framebuffer.frag"]);
+	// everything else streams in while the UI is already running
+	mAssets = std::make_unique<AssetManager>(ThreadPool::Get());
+	mAssetDatabase = std::make_unique<AssetDatabase>();
+	RequestAssets();
 
 	mTextData = std::shared_ptr<InputTextCallback_UserData>();
 }
 
-void App::ProcessInput()
+void App::FixedUpdate()
 {
+	PROFILE_ZONE("FixedUpdate");
+	mSimulation[0] = mSimulation[1];
+
 	if (mIsUsingCamera)
 	{
-		if (glfwGetKey(mWindow, GLFW_KEY_W) == GLFW_PRESS)
-			mCamera->ProcessKeyboard(CameraMovement::FORWARD, static_cast<float>(mDeltaTime));
-		if (glfwGetKey(mWindow, GLFW_KEY_S) == GLFW_PRESS)
-			mCamera->ProcessKeyboard(CameraMovement::BACKWARD, static_cast<float>(mDeltaTime));
-		if (glfwGetKey(mWindow, GLFW_KEY_A) == GLFW_PRESS)
-			mCamera->ProcessKeyboard(CameraMovement::LEFT, static_cast<float>(mDeltaTime));
-		if (glfwGetKey(mWindow, GLFW_KEY_D) == GLFW_PRESS)
-			mCamera->ProcessKeyboard(CameraMovement::RIGHT, static_cast<float>(mDeltaTime));
-		if (glfwGetKey(mWindow, GLFW_KEY_SPACE) == GLFW_PRESS)
-			mCamera->ProcessKeyboard(CameraMovement::UP, static_cast<float>(mDeltaTime));
-		if (glfwGetKey(mWindow, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS)
-			mCamera->ProcessKeyboard(CameraMovement::DOWN, static_cast<float>(mDeltaTime));
+		float step = static_cast<float>(SimulationStep);
+		for (CameraMovement movement : { CameraMovement::FORWARD, CameraMovement::BACKWARD, CameraMovement::LEFT, CameraMovement::RIGHT, CameraMovement::UP, CameraMovement::DOWN })
+		{
+			if (mMovementKeys & (1u << (int)movement))
+			{
+				mCamera->ProcessKeyboard(movement, step);
+			}
+		}
+	}
+
+	if (!mDynamicEntities.empty())
+	{
+		float step = static_cast<float>(SimulationStep);
+		ThreadPool::Get().ParallelFor((uint32_t)mDynamicEntities.size(), MinDynamicEntitiesPerJob, [this, step](uint32_t begin, uint32_t end) {
+			for (uint32_t i = begin; i < end; i++)
+			{
+				// the previous angle is wrapped along with the current one so the two stay a step apart
+				DynamicEntity& dynamic = mDynamicEntities[i];
+				float angle = dynamic.entity->angle + dynamic.spin * step;
+				float wrapped = std::fmod(angle, 360.0f);
+				dynamic.previousAngle = dynamic.entity->angle + wrapped - angle;
+				dynamic.entity->angle = wrapped;
+			}
+		});
+	}
+
+	mSimulation[1].cameraPosition = mCamera->GetPosition();
+	mSimulation[1].step++;
+}
+
+void App::InterpolateDynamicEntities()
+{
+	if (mDynamicEntities.empty())
+	{
+		return;
 	}
+	PROFILE_ZONE("InterpolateDynamicEntities");
+	// the models lag the angles by up to a step, like the camera does
+	ThreadPool::Get().ParallelFor((uint32_t)mDynamicEntities.size(), MinDynamicEntitiesPerJob, [this](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++)
+		{
+			const DynamicEntity& dynamic = mDynamicEntities[i];
+			Entity& e = *dynamic.entity;
+			e.model = ComposeModel(e.translate, glm::mix(dynamic.previousAngle, e.angle, mSimulationAlpha), e.rotate, e.scale);
+		}
+	});
+	mIsSceneDamaged = true;
+}
+
+void App::ProcessInput()
+{
+	static bool wasCaptureKeyDown = false;
+	bool isCaptureKeyDown = glfwGetKey(mWindow, GLFW_KEY_F9) == GLFW_PRESS;
+	if (isCaptureKeyDown && !wasCaptureKeyDown && !Profiler::Get().IsCapturing())
+	{
+		StartProfileCapture(CaptureFrameCount);
+	}
+	wasCaptureKeyDown = isCaptureKeyDown;
+
+	// sampled once a frame, the steps taken in it all see the same keys
+	static constexpr std::pair<int, CameraMovement> movementKeys[] = {
+		{ GLFW_KEY_W, CameraMovement::FORWARD },
+		{ GLFW_KEY_S, CameraMovement::BACKWARD },
+		{ GLFW_KEY_A, CameraMovement::LEFT },
+		{ GLFW_KEY_D, CameraMovement::RIGHT },
+		{ GLFW_KEY_SPACE, CameraMovement::UP },
+		{ GLFW_KEY_LEFT_SHIFT, CameraMovement::DOWN }
+	};
+	mMovementKeys = 0;
+	for (const auto& [key, movement] : movementKeys)
+	{
+		if (glfwGetKey(mWindow, key) == GLFW_PRESS)
+		{
+			mMovementKeys |= 1u << (int)movement;
+		}
+	}
+
 	if (mInSceneView || mIsUsingCamera)
 	{
 		if (glfwGetKey(mWindow, GLFW_KEY_ESCAPE) == GLFW_PRESS)
@@ -283,8 +1750,36 @@ void App::ProcessInput()
 	}
 }
 
+void App::ApplyInputEvent(const InputEvent& event)
+{
+	switch (event.type)
+	{
+	case InputEventType::Keys:
+		mMovementKeys = event.bits;
+		break;
+	case InputEventType::CameraMode:
+		mIsUsingCamera = (event.bits & InputCameraInUse) != 0;
+		mInSceneView = (event.bits & InputCameraSceneView) != 0;
+		break;
+	case InputEventType::MouseMove:
+		mCamera->ProcessMouseMovement(event.value.x, event.value.y);
+		break;
+	case InputEventType::Scroll:
+		mCamera->ProcessMouseScroll(event.value.y);
+		break;
+	case InputEventType::Edit:
+		ApplyJournalRecord(event.edit);
+		RecordEdit(event.edit); // into the autosave journal, the scene has the edit now
+		break;
+	case InputEventType::End:
+		break;
+	}
+}
+
 void App::MouseCallback(GLFWwindow* window, double xposIn, double yposIn)
 {
+	mUiFramesPending = UiSettleFrames;
+
 	float xpos = static_cast<float>(xposIn);
 	float ypos = static_cast<float>(yposIn);
 
@@ -301,38 +1796,321 @@ void App::MouseCallback(GLFWwindow* window, double xposIn, double yposIn)
 	mLastX = xpos;
 	mLastY = ypos;
 
-	if (mIsUsingCamera)
+	if (mIsUsingCamera && !mInputReplay)
 	{
+		if (mInputRecorder)
+		{
+			InputEvent event;
+			event.type = InputEventType::MouseMove;
+			event.value = { xoffset, yoffset };
+			mInputRecorder->Record(event);
+		}
 		mCamera->ProcessMouseMovement(xoffset, yoffset);
 	}
 }
 
 void App::ScrollCallback(GLFWwindow* window, double xoffset, double yoffset)
 {
-	if (mIsUsingCamera)
+	mUiFramesPending = UiSettleFrames;
+	if (mIsUsingCamera && !mInputReplay)
 	{
+		if (mInputRecorder)
+		{
+			InputEvent event;
+			event.type = InputEventType::Scroll;
+			event.value.y = static_cast<float>(yoffset);
+			mInputRecorder->Record(event);
+		}
 		mCamera->ProcessMouseScroll(static_cast<float>(yoffset));
 	}
 }
 
 void App::FramebufferResizeCallback(GLFWwindow* window, int width, int height)
 {
+	mUiFramesPending = UiSettleFrames;
 	mWindowWidth = width;
 	mWindowHeight = height;
-	glViewport(0, 0, mWindowWidth, mWindowHeight);
 }
 
 void App::ImGuiRender()
 {
 	static std::string selectedEntity = "##";
-	static std::string selectedShader = "##";
+	static NameId selectedShader = InvalidName;
 	static bool changedShader = false;
-	static std::string selectedMaterial = "##";
+	static NameId selectedMaterial = InvalidName;
+
+	AssetProgress progress = mAssets->GetProgress();
+	if (!progress.IsDone())
+	{
+		if (ImGui::Begin("Loading"))
+		{
+			ImGui::ProgressBar(progress.GetFraction(), ImVec2(-1.0f, 0.0f));
+			ImGui::Text("%u of %u assets, %u failed", progress.ready + progress.failed, progress.total, progress.failed);
+			for (const auto& name : mAssets->GetPending(10))
+			{
+				ImGui::BulletText("%s", name.c_str());
+			}
+		}
+		ImGui::End();
+	}
+
+	if (ImGui::Begin("Profiler"))
+	{
+		Profiler& profiler = Profiler::Get();
+		bool isEnabled = Profiler::IsEnabled();
+		if (ImGui::Checkbox("Enabled", &isEnabled))
+		{
+			profiler.SetEnabled(isEnabled);
+		}
+		ImGui::SameLine();
+		bool isPaused = profiler.IsPaused();
+		if (ImGui::Checkbox("Pause", &isPaused))
+		{
+			profiler.SetPaused(isPaused);
+		}
+
+		static int captureFrames = CaptureFrameCount;
+		if (profiler.IsCapturing())
+		{
+			ImGui::Text("Capturing frame %u of %d", profiler.GetCapturedFrames() + 1, captureFrames);
+		}
+		else
+		{
+			if (ImGui::Button("Capture (F9)"))
+			{
+				StartProfileCapture((uint32_t)captureFrames);
+			}
+			ImGui::SameLine();
+			ImGui::SetNextItemWidth(100.0f);
+			ImGui::InputInt("Frames", &captureFrames);
+			captureFrames = std::clamp(captureFrames, 1, 100000);
+		}
+
+		uint64_t frameBegin = profiler.GetFrameBegin();
+		double frameLength = (double)std::max<uint64_t>(profiler.GetFrameEnd() - frameBegin, 1);
+		ImGui::Text("Frame: %.3f ms, %llu events dropped", frameLength / 1e6, (unsigned long long)profiler.GetDroppedEvents());
+
+		// one lane per thread, nested zones stacked below their parent
+		const float rowHeight = ImGui::GetTextLineHeight() + 2.0f;
+		const std::vector<ProfileLane>& lanes = profiler.GetFrameLanes();
+		for (size_t laneIndex = 0; laneIndex < lanes.size(); laneIndex++)
+		{
+			const ProfileLane& lane = lanes[laneIndex];
+			if (lane.events.empty())
+			{
+				continue;
+			}
+			uint32_t maxDepth = 0;
+			for (const ProfileEvent& event : lane.events)
+			{
+				maxDepth = std::max(maxDepth, event.depth);
+			}
+
+			ImGui::TextDisabled("%s", lane.name.c_str());
+			ImVec2 origin = ImGui::GetCursorScreenPos();
+			float width = std::max(ImGui::GetContentRegionAvail().x, 1.0f);
+			ImGui::PushID((int)laneIndex);
+			ImGui::InvisibleButton("Lane", { width, rowHeight * (maxDepth + 1) });
+			ImGui::PopID();
+			bool isHovered = ImGui::IsItemHovered();
+			ImVec2 mouse = ImGui::GetMousePos();
+
+			ImDrawList* drawList = ImGui::GetWindowDrawList();
+			for (const ProfileEvent& event : lane.events)
+			{
+				double start = std::max(event.start, frameBegin) - frameBegin;
+				double end = event.end - frameBegin;
+				ImVec2 min = { origin.x + (float)(start / frameLength) * width, origin.y + event.depth * rowHeight };
+				ImVec2 max = { std::max(origin.x + (float)(end / frameLength) * width, min.x + 1.0f), min.y + rowHeight - 1.0f };
+				ImU32 color = lane.isGpu ? IM_COL32(200, 120, 60, 255) : IM_COL32(70, 120, 190, 255);
+				bool isEventHovered = isHovered && mouse.x >= min.x && mouse.x < max.x && mouse.y >= min.y && mouse.y < max.y;
+				drawList->AddRectFilled(min, max, isEventHovered ? IM_COL32(240, 200, 80, 255) : color);
+				if (ImGui::CalcTextSize(event.name).x < max.x - min.x - 4.0f)
+				{
+					drawList->AddText({ min.x + 2.0f, min.y + 1.0f }, IM_COL32_WHITE, event.name);
+				}
+				if (isEventHovered)
+				{
+					ImGui::SetTooltip("%s\n%.3f ms", event.name, (event.end - event.start) / 1e6);
+				}
+			}
+		}
+
+		static std::vector<ProfileZoneStats> zoneStats;
+		profiler.GetZoneStats(zoneStats);
+		std::sort(zoneStats.begin(), zoneStats.end(), [](const ProfileZoneStats& a, const ProfileZoneStats& b) { return a.avgMs > b.avgMs; });
+		if (ImGui::BeginTable("Zones", 5, ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV))
+		{
+			ImGui::TableSetupColumn("Zone");
+			ImGui::TableSetupColumn("Last ms");
+			ImGui::TableSetupColumn("Min ms");
+			ImGui::TableSetupColumn("Avg ms");
+			ImGui::TableSetupColumn("p99 ms");
+			ImGui::TableHeadersRow();
+			for (const ProfileZoneStats& zone : zoneStats)
+			{
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn();
+				ImGui::Text("%s%.*s", zone.isGpu ? "GPU " : "", (int)zone.name.size(), zone.name.data());
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", zone.lastMs);
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", zone.minMs);
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", zone.avgMs);
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", zone.p99Ms);
+			}
+			ImGui::EndTable();
+		}
+	}
+	ImGui::End();
+
+	if (ImGui::Begin("Stats"))
+	{
+		GlStats& glStats = GlStats::Get();
+		bool isInstrumented = glStats.IsInstalled();
+		if (ImGui::Checkbox("Instrument GL calls", &isInstrumented))
+		{
+			RenderThread::Get().Run([isInstrumented]() { isInstrumented ? GlStats::Get().Install() : GlStats::Get().Uninstall(); });
+		}
+		if (glStats.IsInstalled())
+		{
+			GlFrameStats frame = glStats.GetFrameStats();
+			ImGui::SeparatorText("Last frame");
+			ImGui::Text("Draw calls: %u", frame.drawCalls);
+			ImGui::Text("Triangles: %llu", (unsigned long long)frame.triangles);
+			ImGui::Text("State changes: %u, redundant binds: %u", frame.stateChanges, frame.redundantBinds);
+			ImGui::Text("Uniform uploads: %u", frame.uniformUploads);
+			ImGui::Text("Uploads: %.1f KB buffers, %.1f KB textures", frame.bufferUploadBytes / 1024.0, frame.textureUploadBytes / 1024.0);
+
+			GlObjectStats objects = glStats.GetObjectStats();
+			ImGui::SeparatorText("Live objects");
+			if (ImGui::BeginTable("GL objects", 3, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingStretchProp))
+			{
+				ImGui::TableSetupColumn("Type");
+				ImGui::TableSetupColumn("Count");
+				ImGui::TableSetupColumn("Memory");
+				ImGui::TableHeadersRow();
+				uint64_t totalBytes = 0;
+				for (int type = 0; type < (int)GlObjectType::Count; type++)
+				{
+					ImGui::TableNextRow();
+					ImGui::TableNextColumn();
+					ImGui::TextUnformatted(GlStats::GetObjectTypeName((GlObjectType)type));
+					ImGui::TableNextColumn();
+					ImGui::Text("%u", objects.counts[type]);
+					ImGui::TableNextColumn();
+					if (objects.bytes[type] > 0)
+					{
+						ImGui::Text("%.2f MB", objects.bytes[type] / (1024.0 * 1024.0));
+					}
+					totalBytes += objects.bytes[type];
+				}
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn();
+				ImGui::TextUnformatted("Total");
+				ImGui::TableNextColumn();
+				ImGui::TableNextColumn();
+				ImGui::Text("%.2f MB", totalBytes / (1024.0 * 1024.0));
+				ImGui::EndTable();
+			}
+			ImGui::TextDisabled("ImGui's own GL calls are not counted");
+		}
+	}
+	ImGui::End();
+
+	if (ImGui::Begin("Recording"))
+	{
+		static char recordingPath[256] = "recordings/session.mm3r";
+		ImGui::InputText("##Recording path", recordingPath, sizeof(recordingPath));
+		if (mInputRecorder)
+		{
+			ImGui::Text("Recording: %.1f s, %u events", mInputRecorder->GetTime(), mInputRecorder->GetEventCount());
+			if (ImGui::Button("Stop recording"))
+			{
+				StopInputRecording();
+			}
+		}
+		else if (mInputReplay)
+		{
+			ImGui::ProgressBar((float)(mInputReplay->GetTime() / std::max(mInputReplay->GetDuration(), SimulationStep)));
+			ImGui::Text("Replaying %.1f of %.1f s, Escape stops", mInputReplay->GetTime(), mInputReplay->GetDuration());
+			if (ImGui::Button("Stop replay"))
+			{
+				StopInputReplay();
+			}
+		}
+		else
+		{
+			if (ImGui::Button("Record"))
+			{
+				StartInputRecording(recordingPath);
+			}
+			ImGui::SameLine();
+			if (ImGui::Button("Replay"))
+			{
+				StartInputReplay(recordingPath);
+			}
+			ImGui::TextDisabled("Replays start from the recorded camera on the scene as it is");
+		}
+	}
+	ImGui::End();
+
+	if (ImGui::Begin("Export"))
+	{
+		static char imagePath[256] = "renders/render.png";
+		ImGui::InputText("##Image path", imagePath, sizeof(imagePath));
+		ImGui::SameLine();
+		ImGui::BeginDisabled(IsExporting());
+		if (ImGui::Button("Save image"))
+		{
+			SaveImage(imagePath);
+		}
+		ImGui::EndDisabled();
+
+		ImGui::SeparatorText("Turntable");
+		static char turntablePattern[256] = "renders/turntable-####.png";
+		static int turntableFrames = 120;
+		static glm::vec3 turntableTarget(0.0f);
+		ImGui::InputText("Path", turntablePattern, sizeof(turntablePattern));
+		ImGui::TextDisabled("# is replaced by the frame number, .png, .exr or .ppm");
+		ImGui::InputInt("Frames", &turntableFrames);
+		turntableFrames = std::clamp(turntableFrames, 1, 100000);
+		ImGui::DragFloat3("Target", &turntableTarget.x, 0.1f);
+		ImGui::BeginDisabled(IsExporting());
+		if (ImGui::Button("Render turntable"))
+		{
+			TurntableSettings turntable;
+			turntable.frameCount = (uint32_t)turntableFrames;
+			turntable.target = turntableTarget;
+			StartTurntable(turntable, turntablePattern);
+		}
+		ImGui::EndDisabled();
+
+		if (mExportFrameCount > 0)
+		{
+			ImGui::SeparatorText("Progress");
+			ImGui::ProgressBar((float)mExporter->GetWrittenCount() / mExportFrameCount);
+			ImGui::Text("%u requested, %u reading back, %u writing", mExportFrame, mReadback->GetPendingCount(), mExporter->GetInFlight());
+			if (mExporter->GetFailedCount() > 0)
+			{
+				ImGui::TextColored({ 1.0f, 0.4f, 0.4f, 1.0f }, "%u images could not be written", mExporter->GetFailedCount());
+			}
+		}
+	}
+	ImGui::End();
 
 	if (ImGui::Begin("Settings"))
 	{
 		auto camPos = mCamera->GetPosition();
 		ImGui::Text("Camera position x:%.2f, y:%.2f, z:%.2f", camPos.x, camPos.y, camPos.z);
+		ImGui::Text("Simulation: step %llu, %u this frame", (unsigned long long)mSimulation[1].step, mSimulationSteps);
+		ImGui::Text("Entities: %u drawn, %u culled", mDrawCount, mCulledCount);
+		ImGui::Text("Heap allocations last frame: %llu (%llu bytes)", (unsigned long long)mFrameAllocations.count, (unsigned long long)mFrameAllocations.bytes);
+		ImGui::Text("Frame arena: %zu of %zu KB", mFrameArenaUsed / 1024, mFrameArena.GetCapacity() / 1024);
+		ImGui::Text("Render commands: %u, %zu KB", mCommandCount, mCommandBytes / 1024);
+		ImGui::Checkbox("Render on demand", &mIsOnDemandRendering);
 
 		if (ImGui::Button("Go Fullscreen"))
 		{
@@ -340,70 +2118,181 @@ void App::ImGuiRender()
 			mIsUsingCamera = true;
 			glfwSetInputMode(mWindow, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 		}
+
+		ImGui::SeparatorText("Scene");
+		static char scenePath[256] = "resources/scenes/scene.mm3s";
+		ImGui::InputText("##Scene path", scenePath, sizeof(scenePath));
+		if (ImGui::Button("Save scene"))
+		{
+			SaveScene(scenePath);
+		}
+		ImGui::SameLine();
+		if (ImGui::Button("Load scene") && LoadScene(scenePath))
+		{
+			selectedEntity = "##";
+			selectedMaterial = InvalidName;
+			CompactJournal(); // the journal described edits on top of the previous scene
+		}
+
 		ImGui::PushItemWidth(200.0f);
-		ImGui::ColorPicker4("Background Color", &mClearColor.r, ImGuiColorEditFlags_DefaultOptions2_);
+		mIsSceneDamaged |= ImGui::ColorPicker4("Background Color", &mClearColor.r, ImGuiColorEditFlags_DefaultOptions2_);
 	}
 	ImGui::End();
 
 	if (ImGui::Begin("Entities"))
 	{
-		for (auto& entry : mEntities)
+		// the rows are only rebuilt when the query, a filter or the entities change, drawing them only touches the visible ones
+		static char search[64] = { 0 };
+		static NameId objectFilter = InvalidName;
+		static NameId materialFilter = InvalidName;
+		static int sort = 0;
+		static std::vector<uint32_t> rows;
+		static uint32_t indexVersion = UINT32_MAX, objectsVersion = UINT32_MAX, materialsVersion = UINT32_MAX;
+		bool isDirty = indexVersion != mEntityIndex.GetVersion() || objectsVersion != mObjects.GetVersion() || materialsVersion != mMaterials.GetVersion();
+
+		isDirty |= ImGui::InputTextWithHint("##Search", "Search", search, sizeof(search));
+
+		if (ImGui::BeginCombo("Object", objectFilter == InvalidName ? "All" : GetName(objectFilter)))
 		{
-			if (ImGui::Selectable(std::string(entry.first + "##").c_str(), entry.first == selectedEntity))
+			if (ImGui::Selectable("All", objectFilter == InvalidName))
+			{
+				objectFilter = InvalidName;
+				isDirty = true;
+			}
+			for (NameId id : mObjects.GetSortedIds())
 			{
-				if (entry.first == selectedEntity)
+				if (ImGui::Selectable(GetName(id), objectFilter == id))
 				{
-					selectedEntity = "##";
+					objectFilter = id;
+					isDirty = true;
 				}
-				else
+			}
+			ImGui::EndCombo();
+		}
+
+		if (ImGui::BeginCombo("Material", materialFilter == InvalidName ? "All" : GetName(materialFilter)))
+		{
+			if (ImGui::Selectable("All", materialFilter == InvalidName))
+			{
+				materialFilter = InvalidName;
+				isDirty = true;
+			}
+			for (NameId id : mMaterials.GetSortedIds())
+			{
+				if (ImGui::Selectable(GetName(id), materialFilter == id))
 				{
-					selectedEntity = entry.first;
-					ImGui::SetNextWindowFocus();
+					materialFilter = id;
+					isDirty = true;
+				}
+			}
+			ImGui::EndCombo();
+		}
+
+		static const char* sortOptions[] = { "Name", "Object", "Material" };
+		isDirty |= ImGui::Combo("Sort by", &sort, sortOptions, IM_ARRAYSIZE(sortOptions));
+
+		if (isDirty)
+		{
+			BuildEntityRows(rows, search, objectFilter, materialFilter, (EntitySort)sort);
+			indexVersion = mEntityIndex.GetVersion();
+			objectsVersion = mObjects.GetVersion();
+			materialsVersion = mMaterials.GetVersion();
+		}
+		ImGui::Text("%zu of %zu entities", rows.size(), mEntityIndex.GetCount());
+
+		if (ImGui::BeginChild("##Entity list"))
+		{
+			ImGuiListClipper clipper;
+			clipper.Begin((int)rows.size());
+			while (clipper.Step())
+			{
+				for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++)
+				{
+					std::string_view name = mEntityIndex.GetName(rows[row]);
+					bool isSelected = name == selectedEntity;
+					ImGui::PushID(row);
+					if (ImGui::Selectable(name.data(), isSelected))
+					{
+						if (isSelected)
+						{
+							selectedEntity = "##";
+						}
+						else
+						{
+							selectedEntity = name;
+							ImGui::SetWindowFocus("Edit entity");
+						}
+					}
+					ImGui::PopID();
 				}
 			}
 		}
+		ImGui::EndChild();
 	}
 	ImGui::End();
 
 	if (ImGui::Begin("Edit entity"))
 	{
-		if (selectedEntity != "##")
+		auto selected = mEntities.find(selectedEntity);
+		if (selected != mEntities.end())
 		{
-			auto& e = mEntities[selectedEntity];
+			Entity& e = selected->second;
+
+			ImGui::Text("Entity name: %s", selectedEntity.c_str());
 
-			ImGui::Text(std::string("Entity name: " + selectedEntity).c_str());
+			// drags are journaled once when released, not on every frame they change
+			bool edited = false;
+			bool changed = false;
 
 			ImGui::SeparatorText("Position");
-			ImGui::DragFloat3("##Position", &e->translate[0], 0.1f, 0.0f, 0.0f, "%.2f");
+			changed |= ImGui::DragFloat3("##Position", &e.translate[0], 0.1f, 0.0f, 0.0f, "%.2f");
+			edited |= ImGui::IsItemDeactivatedAfterEdit();
 
 			ImGui::SeparatorText("Rotation");
-			bool x = e->rotate[0], y = e->rotate[1], z = e->rotate[2];
+			bool x = e.rotate[0], y = e.rotate[1], z = e.rotate[2];
 			ImGui::Text("Rotate on the");
 			ImGui::SameLine();
 			if (ImGui::Checkbox("X", &x))
 			{
-				e->rotate[0] = x;
+				e.rotate[0] = x;
+				edited = true;
 			}
 			ImGui::SameLine();
 			if (ImGui::Checkbox("Y", &y))
 			{
-				e->rotate[1] = y;
+				e.rotate[1] = y;
+				edited = true;
 			}
 			ImGui::SameLine();
 			if (ImGui::Checkbox("Z", &z))
 			{
-				e->rotate[2] = z;
+				e.rotate[2] = z;
+				edited = true;
 			}
 			ImGui::SameLine();
 			ImGui::Text(" axis");
-			ImGui::DragFloat("##Angle", &e->angle, 1.0f, 0.0f, 0.0f, "%.2f");
+			changed |= ImGui::DragFloat("##Angle", &e.angle, 1.0f, 0.0f, 0.0f, "%.2f");
+			edited |= ImGui::IsItemDeactivatedAfterEdit();
 
 			ImGui::SeparatorText("Scale");
-			ImGui::DragFloat3("##Scale", &e->scale[0], 0.1f, 0.0f, 0.0f, "%.2f");
+			changed |= ImGui::DragFloat3("##Scale", &e.scale[0], 0.1f, 0.0f, 0.0f, "%.2f");
+			edited |= ImGui::IsItemDeactivatedAfterEdit();
+
+			if (changed || edited)
+			{
+				UpdateModel(e);
+				mIsSceneDamaged = true;
+			}
+
+			if (edited)
+			{
+				RecordEntityTransform(selectedEntity);
+			}
 
 			if (ImGui::Button("Destroy"))
 			{
-				mEntities.erase(selectedEntity);
+				DestroyEntity(selectedEntity);
+				RecordEdit({ JournalRecordType::DestroyEntity, selectedEntity });
 				selectedEntity = "##";
 			}
 		}
@@ -423,33 +2312,35 @@ void App::ImGuiRender()
 		static const std::vector<const char*> options{ "Vertex Shader", "Fragment Shader" };
 		ImGui::Combo("Type", &current, options.data(), (int)options.size(), 2);
 
-		if (ImGui::Button("Upload") && strlen(name) && !mShaders.contains(name))
+		if (ImGui::Button("Upload") && strlen(name))
 		{
 			std::string extension = current == 0 ? ".vert" : ".frag";
 			auto nameExt = name + extension;
 
-			mShaders.insert({ nameExt, code });
-			CreateFile("resources/shaders", nameExt, code.data());
+			if (mShaders.Insert(InternName(nameExt), code))
+			{
+				CreateFile("resources/shaders", nameExt, code.data());
 
-			memset(name, 0, 21);
-			code.clear();
+				memset(name, 0, 21);
+				code.clear();
+			}
 		}
 	}
 	ImGui::End();
 
 	if (ImGui::Begin("Shaders"))
 	{
-		for (auto& s : mShaders)
+		for (NameId id : mShaders.GetSortedIds())
 		{
-			if (ImGui::Selectable(s.first.data(), s.first == selectedShader))
+			if (ImGui::Selectable(GetName(id), id == selectedShader))
 			{
-				if (s.first == selectedShader)
+				if (id == selectedShader)
 				{
-					selectedShader = "##";
+					selectedShader = InvalidName;
 				}
 				else
 				{
-					selectedShader = s.first;
+					selectedShader = id;
 					ImGui::SetNextWindowFocus();
 				}
 				changedShader = true;
@@ -462,9 +2353,10 @@ void App::ImGuiRender()
 	{
 		static bool editingShader = false;
 
-		if (selectedShader != "##")
+		if (selectedShader != InvalidName)
 		{
-			ImGui::Text("Shader: %s", selectedShader.data());
+			std::string_view selectedName = StringInterner::Get().GetView(selectedShader);
+			ImGui::Text("Shader: %s", GetName(selectedShader));
 
 			static std::string code;
 			static std::string name;
@@ -474,12 +2366,12 @@ void App::ImGuiRender()
 
 			if (changedShader)
 			{
-				code = mShaders[selectedShader];
+				code = *mShaders.Find(selectedShader);
 
-				auto dotPos = selectedShader.find_first_of('.');
-				name = selectedShader.substr(0, dotPos);
+				auto dotPos = selectedName.find_first_of('.');
+				name = selectedName.substr(0, dotPos);
 
-				auto type = selectedShader.substr(dotPos + 1);
+				auto type = selectedName.substr(dotPos + 1);
 				current = type == "vert" ? 0 : 1;
 
 				changedShader = false;
@@ -500,17 +2392,19 @@ void App::ImGuiRender()
 				static const std::vector<const char*> options{ "Vertex Shader", "Fragment Shader" };
 				ImGui::Combo("New Type", &current, options.data(), (int)options.size(), 2);
 
-				if (ImGui::Button("Save") && newName[0] && (!mShaders.contains(newName) || newName == selectedShader))
+				FrameString nameExt(newName, &mFrameArena);
+				nameExt += current == 0 ? ".vert" : ".frag";
+				NameId newId = StringInterner::Get().Find(nameExt);
+				if (ImGui::Button("Save") && newName[0] && (!mShaders.Contains(newId) || newId == selectedShader))
 				{
-					mShaders.erase(selectedShader);
-					std::string extension = current == 0 ? ".vert" : ".frag";
-					auto nameExt = std::string(newName) + extension;
-					mShaders.insert({ nameExt, code });
+					newId = InternName(nameExt);
+					mShaders.Erase(selectedShader);
+					mShaders.Insert(newId, code);
 
 					LOG(nameExt.data());
-					EditFile("resources/shaders", selectedShader, nameExt, code);
+					EditFile("resources/shaders", std::string(selectedName), std::string(nameExt), code);
 
-					selectedShader = nameExt;
+					selectedShader = newId;
 					changedShader = true;
 				}
 				ImGui::SameLine();
@@ -529,9 +2423,9 @@ void App::ImGuiRender()
 			ImGui::SameLine();
 			if (ImGui::Button("Delete"))
 			{
-				DeleteFile("resources/shaders", selectedShader);
-				mShaders.erase(selectedShader);
-				selectedShader = "##";
+				DeleteFile("resources/shaders", std::string(selectedName));
+				mShaders.Erase(selectedShader);
+				selectedShader = InvalidName;
 			}
 		}
 	}
@@ -539,33 +2433,36 @@ void App::ImGuiRender()
 
 	if (ImGui::Begin("Create material"))
 	{
-		static int currentVertexShader = -1;
-		std::vector<const char*> vertexShaderOptions;
-		for (auto& shader : mShaders)
+		// option lists are only rebuilt when the registries change
+		static uint32_t shaderVersion = UINT32_MAX;
+		static std::vector<NameId> vertexShaderIds, fragmentShaderIds;
+		static std::vector<const char*> vertexShaderOptions, fragmentShaderOptions;
+		if (shaderVersion != mShaders.GetVersion())
 		{
-			auto extension = shader.first.substr(shader.first.find_last_of('.'));
-			if (extension != ".vert") continue;
-			vertexShaderOptions.push_back(shader.first.c_str());
+			FilterShaders(mShaders, ".vert", vertexShaderIds, vertexShaderOptions);
+			FilterShaders(mShaders, ".frag", fragmentShaderIds, fragmentShaderOptions);
+			shaderVersion = mShaders.GetVersion();
 		}
-		ImGui::Combo("Vertex shader", &currentVertexShader, vertexShaderOptions.data(), (int)vertexShaderOptions.size(), 4);
 
-		static int currentFragmentShader = -1;
-		std::vector<const char*> fragmentShaderOptions;
-		for (auto& shader : mShaders)
+		static uint32_t textureVersion = UINT32_MAX;
+		static std::vector<NameId> textureIds;
+		static std::vector<const char*> textureOptions;
+		if (textureVersion != mTextures.GetVersion())
 		{
-			auto extension = shader.first.substr(shader.first.find_last_of('.'));
-			if (extension != ".frag") continue;
-			fragmentShaderOptions.push_back(shader.first.c_str());
+			textureIds.assign(1, InvalidName);
+			textureIds.insert(textureIds.end(), mTextures.GetSortedIds().begin(), mTextures.GetSortedIds().end());
+			textureOptions.assign(1, "None");
+			textureOptions.insert(textureOptions.end(), mTextures.GetSortedNames().begin(), mTextures.GetSortedNames().end());
+			textureVersion = mTextures.GetVersion();
 		}
+
+		static int currentVertexShader = -1;
+		ImGui::Combo("Vertex shader", &currentVertexShader, vertexShaderOptions.data(), (int)vertexShaderOptions.size(), 4);
+
+		static int currentFragmentShader = -1;
 		ImGui::Combo("Fragment shader", &currentFragmentShader, fragmentShaderOptions.data(), (int)fragmentShaderOptions.size(), 4);
 
 		static int currentTexture = 0;
-		std::vector<const char*> textureOptions;
-		textureOptions.push_back("None");
-		for (auto& tex : mTextures)
-		{
-			textureOptions.push_back(tex.first.c_str());
-		}
 		ImGui::Combo("Texture", &currentTexture, textureOptions.data(), (int)textureOptions.size(), 4);
 
 		static char name[21] = { 0 };
@@ -576,19 +2473,26 @@ void App::ImGuiRender()
 
 		if (ImGui::Button("Create"))
 		{
-			if (currentVertexShader != -1 && currentFragmentShader != -1 && strlen(name) && !mMaterials.contains(name))
+			if (currentVertexShader != -1 && currentFragmentShader != -1 && strlen(name) && !mMaterials.Contains(StringInterner::Get().Find(name)))
 			{
-				std::string vertexCode(mShaders[vertexShaderOptions[currentVertexShader]]);
-				std::string fragmentCode(mShaders[fragmentShaderOptions[currentFragmentShader]]);
-				auto shader = std::make_shared<Shader>(vertexCode, fragmentCode);
+				std::string vertexCode(*mShaders.Find(vertexShaderIds[currentVertexShader]));
+				std::string fragmentCode(*mShaders.Find(fragmentShaderIds[currentFragmentShader]));
+				auto shader = std::make_unique<Shader>(vertexCode, fragmentCode);
 				errorMsg = shader->GetError();
 
 				if (errorMsg.length() == 0)
 				{
-					auto mat = std::make_shared<Material>(shader, currentTexture == 0 ? nullptr : mTextures[textureOptions[currentTexture]]);
-					mMaterials.insert({name, mat});
+					SetMaterial(InternName(name), std::move(shader), textureIds[currentTexture]);
 					LOG("Material successfully created: %s", name);
 
+					JournalRecord record;
+					record.type = JournalRecordType::CreateMaterial;
+					record.name = name;
+					record.vertexSource = vertexCode;
+					record.fragmentSource = fragmentCode;
+					record.texture = currentTexture == 0 ? "" : textureOptions[currentTexture];
+					RecordEdit(record);
+
 					memset(name, 0, 21);
 					currentVertexShader = -1;
 					currentFragmentShader = -1;
@@ -627,19 +2531,11 @@ void App::ImGuiRender()
 	if (ImGui::Begin("Create object"))
 	{
 		static int currentVA = -1;
-		std::vector<const char*> vaOptions;
-		for (auto& va : mVAs)
-		{
-			vaOptions.push_back(va.first.c_str());
-		}
+		const auto& vaOptions = mVAs.GetSortedNames();
 		ImGui::Combo("Vertex Array", &currentVA, vaOptions.data(), (int)vaOptions.size(), 4);
 
 		static int currentMaterial = -1;
-		std::vector<const char*> materialOptions;
-		for (auto& mat : mMaterials)
-		{
-			materialOptions.push_back(mat.first.c_str());
-		}
+		const auto& materialOptions = mMaterials.GetSortedNames();
 		ImGui::Combo("Material", &currentMaterial, materialOptions.data(), (int)materialOptions.size(), 4);
 
 		static char name[21] = { 0 };
@@ -647,14 +2543,16 @@ void App::ImGuiRender()
 
 		if (ImGui::Button("Create"))
 		{
-			if (strlen(name) && !mObjects.contains(name) && currentVA != -1 && currentMaterial != -1)
+			if (strlen(name) && !mObjects.Contains(StringInterner::Get().Find(name)) && currentVA != -1 && currentMaterial != -1)
 			{
-				auto object = std::make_shared<Object>();
-				object->vaName = vaOptions[currentVA];
-				object->matName = materialOptions[currentMaterial];
-				object->va = mVAs[vaOptions[currentVA]];
-				object->mat = mMaterials[materialOptions[currentMaterial]];
-				mObjects.insert({ name, object });
+				AddSceneObject({ name, vaOptions[currentVA], materialOptions[currentMaterial] });
+
+				JournalRecord record;
+				record.type = JournalRecordType::CreateObject;
+				record.name = name;
+				record.vaName = vaOptions[currentVA];
+				record.matName = materialOptions[currentMaterial];
+				RecordEdit(record);
 
 				memset(name, 0, 21);
 				currentVA = -1;
@@ -667,11 +2565,7 @@ void App::ImGuiRender()
 	if (ImGui::Begin("Create entity"))
 	{
 		static int current = 0;
-		std::vector<const char*> options;
-		for (auto& asset : mObjects)
-		{
-			options.push_back(asset.first.c_str());
-		}
+		const auto& options = mObjects.GetSortedNames();
 		ImGui::Combo("Object", &current, options.data(), (int)options.size(), 4);
 
 		static glm::vec3 translate = glm::vec3(0.0f);
@@ -682,16 +2576,23 @@ void App::ImGuiRender()
 
 		if (ImGui::Button("Create"))
 		{
-			if (strlen(name))
+			if (strlen(name) && current < (int)options.size())
 			{
 				if (!mEntities.contains(name))
 				{
-					std::shared_ptr<Entity> e = std::make_shared<Entity>();
-					e->object = mObjects[options[current]];
-					e->translate = translate;
-					mEntities.insert({ name, e });
+					Entity e;
+					e.object = *mObjects.Find(mObjects.GetSortedIds()[current]);
+					e.translate = translate;
+					SetEntity(name, e);
 					LOG("Entity successfully created: %s", name);
 
+					JournalRecord record;
+					record.type = JournalRecordType::CreateEntity;
+					record.name = name;
+					record.object = options[current];
+					record.translate = translate;
+					RecordEdit(record);
+
 					memset(name, 0, 21);
 					translate = glm::vec3(0.0f);
 				}
@@ -700,35 +2601,85 @@ void App::ImGuiRender()
 	}
 	ImGui::End();
 
+	if (ImGui::Begin("Stress scene"))
+	{
+		static StressSceneSettings stress;
+		static char prefix[32] = "stress";
+		ImGui::InputScalar("Entities", ImGuiDataType_U32, &stress.entityCount);
+		ImGui::InputScalar("Objects", ImGuiDataType_U32, &stress.objectCount);
+		ImGui::InputScalar("Materials", ImGuiDataType_U32, &stress.materialCount);
+		stress.entityCount = std::clamp(stress.entityCount, 1u, 10000000u);
+		stress.objectCount = std::clamp(stress.objectCount, 1u, 4096u);
+		stress.materialCount = std::clamp(stress.materialCount, 1u, 1024u);
+
+		const char* layouts[] = { "Grid", "Random", "Clustered" };
+		ImGui::Combo("Layout", (int*)&stress.layout, layouts, IM_ARRAYSIZE(layouts));
+		if (stress.layout == StressLayout::Clustered)
+		{
+			ImGui::InputScalar("Clusters", ImGuiDataType_U32, &stress.clusterCount);
+			stress.clusterCount = std::clamp(stress.clusterCount, 1u, 100000u);
+		}
+		ImGui::DragFloat3("Center", &stress.center.x, 0.1f);
+		ImGui::DragFloat("Extent", &stress.extent, 0.5f, 1.0f, 1000.0f);
+
+		const uint32_t minDepth = 1, maxDepth = 8;
+		ImGui::SliderScalar("Hierarchy depth", ImGuiDataType_U32, &stress.hierarchyDepth, &minDepth, &maxDepth);
+		ImGui::BeginDisabled(stress.hierarchyDepth <= 1);
+		ImGui::InputScalar("Children per entity", ImGuiDataType_U32, &stress.childrenPerEntity);
+		stress.childrenPerEntity = std::clamp(stress.childrenPerEntity, 1u, 64u);
+		ImGui::EndDisabled();
+		ImGui::SliderFloat("Dynamic", &stress.dynamicRatio, 0.0f, 1.0f, "%.2f");
+		ImGui::InputScalar("Seed", ImGuiDataType_U64, &stress.seed);
+		ImGui::InputText("Prefix", prefix, sizeof(prefix));
+
+		ImGui::BeginDisabled(mPendingStressScene != nullptr || strlen(prefix) == 0);
+		if (ImGui::Button("Generate"))
+		{
+			stress.prefix = prefix;
+			GenerateStressScene(stress);
+		}
+		ImGui::EndDisabled();
+		if (mStressSceneSeconds > 0.0)
+		{
+			ImGui::SameLine();
+			ImGui::Text("Last one took %.2f s", mStressSceneSeconds);
+		}
+		ImGui::Text("%zu entities, %zu dynamic", mEntities.size(), mDynamicEntities.size());
+		ImGui::TextDisabled("Replaces the entities under the prefix and rewrites the autosave. Spinning is not saved.");
+	}
+	ImGui::End();
+
 	if (ImGui::Begin("Objects"))
 	{
-		for (auto& entry : mObjects)
+		for (NameId id : mObjects.GetSortedIds())
 		{
-			if (ImGui::CollapsingHeader(entry.first.c_str()))
+			const Object* object = mObjectPool.Get(*mObjects.Find(id));
+			if (ImGui::CollapsingHeader(GetName(id)))
 			{
-				auto& mat = entry.second->matName;
+				NameId mat = object->matName;
 				ImGui::Text("Material: ");
 				ImGui::SameLine();
-				if (ImGui::Button(mat.data()))
+				if (ImGui::Button(GetName(mat)))
 				{
-					selectedMaterial = selectedMaterial == mat ? "##" : mat;
-					if (selectedMaterial != "##")
+					selectedMaterial = selectedMaterial == mat ? InvalidName : mat;
+					if (selectedMaterial != InvalidName)
 					{
 						ImGui::SetNextWindowFocus();
 					}
 				}
 
-				auto& va = entry.second->vaName;
+				NameId va = object->vaName;
 				ImGui::Text("VA: ");
 				ImGui::SameLine();
-				if (ImGui::Button(va.data()))
+				if (ImGui::Button(GetName(va)))
 				{
 					// for future development
 				}
 
 				if (ImGui::Button("Delete"))
 				{
-					mObjects.erase(entry.first);
+					RecordEdit({ JournalRecordType::DestroyObject, GetName(id) });
+					DestroyObject(id);
 					break;
 				}
 			}
@@ -738,25 +2689,24 @@ void App::ImGuiRender()
 
 	if (ImGui::Begin("Materials"))
 	{
-		for (auto& entry : mMaterials)
+		for (NameId id : mMaterials.GetSortedIds())
 		{
-			auto& mat = entry.second;
-			if (selectedMaterial == entry.first)
+			const Material* mat = mMaterialPool.Get(*mMaterials.Find(id));
+			Shader* shader = mShaderPool.Get(mat->GetShader());
+			if (selectedMaterial == id)
 			{
 				ImGui::SetNextItemOpen(true);
-				selectedMaterial = "##";
+				selectedMaterial = InvalidName;
 			}
-			if (ImGui::CollapsingHeader(entry.first.c_str()))
+			if (ImGui::CollapsingHeader(GetName(id)))
 			{
 				ImGui::SeparatorText("Vertex shader");
-				auto vertex = mat->GetShader()->GetVertexShaderSource();
-				ImGui::TextColored({ 0.7f, 0.7f, 0.7f, 1.0f }, vertex.data());
+				ImGui::TextColored({ 0.7f, 0.7f, 0.7f, 1.0f }, "%s", shader->GetVertexShaderSource().c_str());
 
 				ImGui::SeparatorText("Fragment shader");
-				auto fragment = mat->GetShader()->GetFragmentShaderSource();
-				ImGui::TextColored({ 0.7f, 0.7f, 0.7f, 1.0f }, fragment.data());
+				ImGui::TextColored({ 0.7f, 0.7f, 0.7f, 1.0f }, "%s", shader->GetFragmentShaderSource().c_str());
 
-				auto tex = mat->GetTexture();
+				Texture* tex = mTexturePool.Get(mat->GetTexture());
 				if (tex)
 				{
 					ImGui::SeparatorText("Texture");
@@ -765,7 +2715,8 @@ void App::ImGuiRender()
 
 				if (ImGui::Button("Delete"))
 				{
-					mMaterials.erase(entry.first);
+					RecordEdit({ JournalRecordType::DestroyMaterial, GetName(id) });
+					DestroyMaterial(id);
 					break;
 				}
 			}
@@ -775,15 +2726,15 @@ void App::ImGuiRender()
 
 	if (ImGui::Begin("Textures"))
 	{
-		for (auto& t : mTextures)
+		for (NameId id : mTextures.GetSortedIds())
 		{
-			if (ImGui::Selectable(std::string(t.first + "##").c_str()))
+			if (ImGui::Selectable(GetName(id)))
 			{
 
 			}
 			if (ImGui::IsItemHovered() && ImGui::BeginTooltip())
 			{
-				auto& tex = t.second;
+				Texture* tex = mTexturePool.Get(*mTextures.Find(id));
 				ImGui::Image((void*)(intptr_t)tex->GetId(), { (float)tex->GetWidth(), (float)tex->GetHeight() }, { 0.0f, 1.0f }, { 1.0f, 0.0f });
 				ImGui::EndTooltip();
 			}
@@ -828,38 +2779,83 @@ void App::ImGuiRender()
 	ImGui::End();
 }
 
-void App::RenderEntity(std::shared_ptr<Entity> entity)
+void App::BuildEntityRows(std::vector<uint32_t>& rows, std::string_view query, NameId objectFilter, NameId materialFilter, EntitySort sort) const
 {
-	auto& va = entity->object->va;
-	auto shader = entity->object->mat->GetShader();
-	auto tex = entity->object->mat->GetTexture();
+	const Handle<Object>* filteredObject = mObjects.Find(objectFilter);
+	rows.clear();
+	mEntityIndex.Search(query, [&](uint32_t slot) {
+		const Entity* entity = mEntityIndex.GetItem(slot);
+		if (objectFilter != InvalidName && (!filteredObject || entity->object != *filteredObject))
+		{
+			return;
+		}
+		if (materialFilter != InvalidName)
+		{
+			const Object* object = mObjectPool.Get(entity->object);
+			if (!object || object->matName != materialFilter)
+			{
+				return;
+			}
+		}
+		rows.push_back(slot);
+	});
 
-	va->Bind();
-	shader->Bind();
-	if (tex)
+	auto byName = [this](uint32_t a, uint32_t b) { return mEntityIndex.GetName(a) < mEntityIndex.GetName(b); };
+	if (sort == EntitySort::Name)
 	{
-		tex->Bind();
+		std::sort(rows.begin(), rows.end(), byName);
+		return;
 	}
 
-	entity->object->mat->UpdateShaderUniforms();
-
-	shader->SetUniformMat4("model", entity->model);
-	shader->SetUniformMat4("proj", mProjection);
-	shader->SetUniformMat4("view", mView);
-
-	if (va->GetElementCount() > 0)
+	// rank of every entity's object or material name, entities without one go last
+	FlatHashMap<uint32_t, uint32_t> objectRanks; // by object handle index
+	if (sort == EntitySort::Object)
 	{
-		glDrawElements(GL_TRIANGLES, va->GetElementCount(), GL_UNSIGNED_INT, 0);
+		const auto& ids = mObjects.GetSortedIds();
+		for (uint32_t i = 0; i < (uint32_t)ids.size(); i++)
+		{
+			objectRanks.Insert(mObjects.Find(ids[i])->index, i);
+		}
 	}
 	else
 	{
-		glDrawArrays(GL_TRIANGLE_STRIP, 0, va->GetVertexCount());
+		FlatHashMap<NameId, uint32_t> materialRanks;
+		const auto& ids = mMaterials.GetSortedIds();
+		for (uint32_t i = 0; i < (uint32_t)ids.size(); i++)
+		{
+			materialRanks.Insert(ids[i], i);
+		}
+		mObjectPool.ForEach([&](Handle<Object> handle, const Object& object) {
+			const uint32_t* rank = materialRanks.Find(object.matName);
+			objectRanks.Insert(handle.index, rank ? *rank : UINT32_MAX);
+		});
+	}
+
+	std::vector<std::pair<uint32_t, uint32_t>> keyed; // rank, slot
+	keyed.reserve(rows.size());
+	for (uint32_t slot : rows)
+	{
+		Handle<Object> object = mEntityIndex.GetItem(slot)->object;
+		const uint32_t* rank = mObjectPool.IsAlive(object) ? objectRanks.Find(object.index) : nullptr;
+		keyed.push_back({ rank ? *rank : UINT32_MAX, slot });
+	}
+	std::sort(keyed.begin(), keyed.end(), [&byName](const auto& a, const auto& b) { return a.first != b.first ? a.first < b.first : byName(a.second, b.second); });
+	for (size_t i = 0; i < keyed.size(); i++)
+	{
+		rows[i] = keyed[i].second;
 	}
+}
 
-	if (tex)
+void App::BuildDrawList(FrameVector<DrawItem>& drawList)
+{
+	PROFILE_ZONE("BuildDrawList");
+	drawList.reserve(mEntities.size());
+	DrawListBuilder builder({ mObjectPool, mMaterialPool, mVertexArrayPool, mShaderPool, mTexturePool }, mProjection * mView, drawList);
+	for (const auto& entry : mEntities)
 	{
-		tex->Unbind();
+		builder.Add(entry.second);
 	}
-	shader->Unbind();
-	va->Unbind();
-}
\ No newline at end of file
+	builder.Finish();
+	mCulledCount = builder.GetCulledCount();
+	mDrawCount = (uint32_t)drawList.size();
+}
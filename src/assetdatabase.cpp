@@ -0,0 +1,326 @@
+#include "assetdatabase.hpp"
+#include "mappedfile.hpp"
+#include "threadpool.hpp"
+#include "hash.hpp"
+#include "vfs.hpp"
+#include "log.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+	constexpr char AssetDatabaseMagic[4] = { 'M', 'M', '3', 'A' };
+
+	struct AssetDatabaseHeader
+	{
+		char magic[4]; // "MM3A"
+		uint32_t version;
+		uint32_t recordCount;
+		uint32_t reserved;
+	};
+
+	class Writer
+	{
+	public:
+		template<typename T>
+		void Write(const T& value)
+		{
+			const uint8_t* bytes = (const uint8_t*)&value;
+			mData.insert(mData.end(), bytes, bytes + sizeof(T));
+		}
+
+		void WriteString(const std::string& str)
+		{
+			Write((uint32_t)str.size());
+			mData.insert(mData.end(), str.begin(), str.end());
+		}
+
+		const std::vector<uint8_t>& GetData() const { return mData; }
+
+	private:
+		std::vector<uint8_t> mData;
+	};
+
+	class Reader
+	{
+	public:
+		Reader(const uint8_t* data, size_t size)
+			: mData(data)
+			, mSize(size)
+			, mPos(0)
+		{
+
+		}
+
+		template<typename T>
+		bool Read(T& value)
+		{
+			if (mSize - mPos < sizeof(T))
+			{
+				return false;
+			}
+			memcpy(&value, mData + mPos, sizeof(T));
+			mPos += sizeof(T);
+			return true;
+		}
+
+		bool ReadString(std::string& str)
+		{
+			uint32_t size = 0;
+			if (!Read(size) || mSize - mPos < size)
+			{
+				return false;
+			}
+			str.assign((const char*)mData + mPos, size);
+			mPos += size;
+			return true;
+		}
+
+	private:
+		const uint8_t* mData;
+		size_t mSize;
+		size_t mPos;
+	};
+}
+
+AssetDatabase::AssetDatabase()
+	: mIsDirty(false)
+{
+
+}
+
+bool AssetDatabase::Load(const std::string& path)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	mPath = path;
+	mRecords.clear();
+	mIsDirty = false;
+
+	MappedFile file;
+	if (!file.Open(path))
+	{
+		return false;
+	}
+
+	Reader reader(file.GetData(), file.GetSize());
+	AssetDatabaseHeader header;
+	if (!reader.Read(header) || memcmp(header.magic, AssetDatabaseMagic, 4) != 0 || header.version != AssetDatabaseVersion)
+	{
+		return false;
+	}
+
+	for (uint32_t i = 0; i < header.recordCount; i++)
+	{
+		std::string recordPath;
+		AssetRecord record;
+		uint32_t artifactCount = 0;
+		if (!reader.ReadString(recordPath) || !reader.Read(record.contentHash) || !reader.Read(record.size) || !reader.Read(record.modifiedTime)
+			|| !reader.Read(record.settingsHash) || !reader.Read(artifactCount))
+		{
+			LOG("Asset database %s is corrupted", path.c_str());
+			mRecords.clear();
+			return false;
+		}
+		record.artifacts.resize(artifactCount);
+		for (auto& artifact : record.artifacts)
+		{
+			if (!reader.ReadString(artifact))
+			{
+				LOG("Asset database %s is corrupted", path.c_str());
+				mRecords.clear();
+				return false;
+			}
+		}
+		mRecords.insert({ std::move(recordPath), std::move(record) });
+	}
+	return true;
+}
+
+bool AssetDatabase::Save()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	if (!mIsDirty || mPath.empty())
+	{
+		return true;
+	}
+
+	Writer writer;
+	AssetDatabaseHeader header = {};
+	memcpy(header.magic, AssetDatabaseMagic, 4);
+	header.version = AssetDatabaseVersion;
+	header.recordCount = (uint32_t)mRecords.size();
+	writer.Write(header);
+	for (const auto& [path, record] : mRecords)
+	{
+		writer.WriteString(path);
+		writer.Write(record.contentHash);
+		writer.Write(record.size);
+		writer.Write(record.modifiedTime);
+		writer.Write(record.settingsHash);
+		writer.Write((uint32_t)record.artifacts.size());
+		for (const auto& artifact : record.artifacts)
+		{
+			writer.WriteString(artifact);
+		}
+	}
+
+	std::error_code ec;
+	std::filesystem::create_directories(std::filesystem::path(mPath).parent_path(), ec);
+
+	std::string tempPath = mPath + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		file.write((const char*)writer.GetData().data(), writer.GetData().size());
+		if (!file)
+		{
+			LOG("Could not write asset database %s", tempPath.c_str());
+			return false;
+		}
+	}
+
+	std::filesystem::rename(tempPath, mPath, ec);
+	if (ec)
+	{
+		LOG("Could not move asset database into place: %s", ec.message().c_str());
+		std::filesystem::remove(tempPath, ec);
+		return false;
+	}
+	mIsDirty = false;
+	return true;
+}
+
+void AssetDatabase::Refresh(const std::vector<std::string>& paths, AssetDatabaseStats* stats)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	struct Entry
+	{
+		std::string path;
+		AssetRecord record;
+		bool isKnown = false;
+		bool exists = false;
+		bool rehashed = false;
+		bool changed = false;
+	};
+
+	std::vector<Entry> entries(paths.size());
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		for (size_t i = 0; i < paths.size(); i++)
+		{
+			entries[i].path = VirtualFileSystem::NormalizePath(paths[i]);
+			auto it = mRecords.find(entries[i].path);
+			if (it != mRecords.end())
+			{
+				entries[i].record = it->second;
+				entries[i].isKnown = true;
+			}
+		}
+	}
+
+	ThreadPool::Get().ParallelFor((uint32_t)entries.size(), 8, [&entries](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++)
+		{
+			Entry& entry = entries[i];
+			std::error_code sizeError, timeError;
+			uint64_t size = std::filesystem::file_size(entry.path, sizeError);
+			int64_t modifiedTime = std::filesystem::last_write_time(entry.path, timeError).time_since_epoch().count();
+			if (sizeError || timeError)
+			{
+				continue;
+			}
+			entry.exists = true;
+			if (entry.isKnown && entry.record.size == size && entry.record.modifiedTime == modifiedTime)
+			{
+				continue;
+			}
+
+			MappedFile file;
+			if (!file.Open(entry.path))
+			{
+				entry.exists = false;
+				continue;
+			}
+			uint64_t contentHash = HashBytes(file.GetData(), file.GetSize());
+			entry.rehashed = true;
+			if (!entry.isKnown || entry.record.contentHash != contentHash)
+			{
+				entry.changed = true;
+				entry.record.artifacts.clear();
+				entry.record.settingsHash = 0;
+			}
+			entry.record.contentHash = contentHash;
+			entry.record.size = size;
+			entry.record.modifiedTime = modifiedTime;
+		}
+	});
+
+	AssetDatabaseStats result;
+	result.checked = (uint32_t)entries.size();
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	std::unordered_map<std::string, AssetRecord> records;
+	records.reserve(entries.size());
+	for (auto& entry : entries)
+	{
+		if (!entry.exists)
+		{
+			continue;
+		}
+		result.rehashed += entry.rehashed;
+		result.changed += entry.changed;
+		records.insert({ std::move(entry.path), std::move(entry.record) });
+	}
+	for (const auto& it : mRecords)
+	{
+		result.removed += !records.contains(it.first);
+	}
+	mIsDirty |= result.rehashed > 0 || result.removed > 0;
+	mRecords = std::move(records);
+
+	result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	if (stats)
+	{
+		*stats = result;
+	}
+}
+
+bool AssetDatabase::Find(const std::string& path, AssetRecord& record) const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	auto it = mRecords.find(VirtualFileSystem::NormalizePath(path));
+	if (it == mRecords.end())
+	{
+		return false;
+	}
+	record = it->second;
+	return true;
+}
+
+bool AssetDatabase::GetArtifacts(const std::string& path, uint64_t settingsHash, std::vector<std::string>& artifacts) const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	auto it = mRecords.find(VirtualFileSystem::NormalizePath(path));
+	if (it == mRecords.end() || it->second.artifacts.empty() || it->second.settingsHash != settingsHash)
+	{
+		return false;
+	}
+	artifacts = it->second.artifacts;
+	return true;
+}
+
+void AssetDatabase::SetArtifacts(const std::string& path, uint64_t settingsHash, std::vector<std::string> artifacts)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	auto it = mRecords.find(VirtualFileSystem::NormalizePath(path));
+	if (it == mRecords.end())
+	{
+		return;
+	}
+	it->second.settingsHash = settingsHash;
+	it->second.artifacts = std::move(artifacts);
+	mIsDirty = true;
+}
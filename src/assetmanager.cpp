@@ -0,0 +1,176 @@
+#include "assetmanager.hpp"
+#include "threadpool.hpp"
+#include "log.hpp"
+
+#include <chrono>
+
+AssetManager::AssetManager(ThreadPool& pool)
+	: mPool(pool)
+	, mLoadsInFlight(0)
+{
+
+}
+
+AssetManager::~AssetManager()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	mLoadsDone.wait(lock, [this]() { return mLoadsInFlight == 0; });
+}
+
+AssetId AssetManager::Request(const std::string& name, const std::vector<AssetId>& dependencies, std::function<bool()> load, std::function<bool()> upload)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	AssetId id = (AssetId)mAssets.size();
+	mAssets.emplace_back();
+	Asset& asset = mAssets.back();
+	asset.name = name;
+	asset.load = std::move(load);
+	asset.upload = std::move(upload);
+	mNames[name] = id;
+	mProgress.total++;
+
+	for (AssetId dependency : dependencies)
+	{
+		if (dependency >= id)
+		{
+			continue;
+		}
+		Asset& other = mAssets[dependency];
+		if (other.state != AssetState::Ready && other.state != AssetState::Failed)
+		{
+			other.dependents.push_back(id);
+			asset.waitingOn++;
+		}
+	}
+
+	if (asset.waitingOn == 0)
+	{
+		Start(id);
+	}
+	return id;
+}
+
+AssetId AssetManager::Find(const std::string& name) const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	auto it = mNames.find(name);
+	return it != mNames.end() ? it->second : InvalidAsset;
+}
+
+void AssetManager::Start(AssetId id)
+{
+	Asset& asset = mAssets[id];
+	if (!asset.load)
+	{
+		asset.state = AssetState::Uploading;
+		mUploads.push_back(id);
+		return;
+	}
+
+	asset.state = AssetState::Loading;
+	mLoadsInFlight++;
+	mPool.Submit([this, id, load = std::move(asset.load)]() {
+		bool succeeded = load();
+
+		std::lock_guard<std::mutex> lock(mMutex);
+		if (succeeded)
+		{
+			mAssets[id].state = AssetState::Uploading;
+			mUploads.push_back(id);
+		}
+		else
+		{
+			Finish(id, false);
+		}
+		mLoadsInFlight--;
+		mLoadsDone.notify_all();
+	});
+}
+
+void AssetManager::Finish(AssetId id, bool succeeded)
+{
+	Asset& asset = mAssets[id];
+	asset.state = succeeded ? AssetState::Ready : AssetState::Failed;
+	asset.load = nullptr;
+	asset.upload = nullptr;
+	if (succeeded)
+	{
+		mProgress.ready++;
+	}
+	else
+	{
+		mProgress.failed++;
+		LOG("Asset %s failed to load", asset.name.c_str());
+	}
+
+	std::vector<AssetId> dependents = std::move(asset.dependents);
+	for (AssetId dependent : dependents)
+	{
+		if (--mAssets[dependent].waitingOn == 0)
+		{
+			Start(dependent);
+		}
+	}
+}
+
+void AssetManager::Update(double budgetSeconds)
+{
+	auto start = std::chrono::steady_clock::now();
+	while (true)
+	{
+		AssetId id;
+		std::function<bool()> upload;
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			if (mUploads.empty())
+			{
+				return;
+			}
+			id = mUploads.front();
+			mUploads.pop_front();
+			upload = std::move(mAssets[id].upload);
+		}
+
+		// called without the lock so the upload can request further assets
+		bool succeeded = !upload || upload();
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			Finish(id, succeeded);
+		}
+
+		if (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() >= budgetSeconds)
+		{
+			return;
+		}
+	}
+}
+
+AssetState AssetManager::GetState(AssetId id) const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return id < mAssets.size() ? mAssets[id].state : AssetState::Failed;
+}
+
+AssetProgress AssetManager::GetProgress() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mProgress;
+}
+
+std::vector<std::string> AssetManager::GetPending(size_t maxCount) const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	std::vector<std::string> names;
+	for (const auto& asset : mAssets)
+	{
+		if (names.size() >= maxCount)
+		{
+			break;
+		}
+		if (asset.state == AssetState::Loading || asset.state == AssetState::Uploading)
+		{
+			names.push_back(asset.name);
+		}
+	}
+	return names;
+}
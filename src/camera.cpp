@@ -13,6 +13,15 @@ Camera::Camera(glm::vec3 position, glm::vec3 up, float yaw, float pitch) :
     UpdateCameraVectors();
 }
 
+void Camera::SetState(const glm::vec3& position, float yaw, float pitch, float zoom)
+{
+    mPosition = position;
+    mYaw = yaw;
+    mPitch = pitch;
+    mZoom = zoom;
+    UpdateCameraVectors();
+}
+
 void Camera::ProcessKeyboard(CameraMovement direction, float deltaTime)
 {
     float velocity = mMovementSpeed * deltaTime;
@@ -0,0 +1,262 @@
+#include "commandbuffer.hpp"
+
+#include <glad/glad.h>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <cstring>
+
+namespace
+{
+	constexpr size_t ChunkSize = 16 << 10;
+
+	struct CommandHeader
+	{
+		CommandType type;
+		uint16_t size; // header and arguments, the next command follows right after
+	};
+
+	// arguments are copied in and out with memcpy, commands are only 4 byte aligned
+	struct UniformArgs { int32_t location; };
+	struct DrawElementsArgs { uint32_t mode, count, indexType; };
+	struct DrawArraysArgs { uint32_t mode, count; };
+	struct CallbackArgs { void (*fn)(void*); void* data; };
+
+	constexpr size_t MaxTailSize = sizeof(CommandHeader) + sizeof(uint8_t*); // Jump or End
+
+	template<typename T>
+	T Read(const uint8_t* arguments)
+	{
+		T value;
+		memcpy(&value, arguments, sizeof(T));
+		return value;
+	}
+
+	template<typename T>
+	void Write(void* arguments, const T& value)
+	{
+		memcpy(arguments, &value, sizeof(T));
+	}
+
+	void WriteHeader(uint8_t* at, CommandType type, size_t size)
+	{
+		CommandHeader header = { type, (uint16_t)size };
+		memcpy(at, &header, sizeof(header));
+	}
+}
+
+CommandBuffer::CommandBuffer(size_t initialSize)
+	: mArena(initialSize)
+	, mFirst(nullptr)
+	, mWrite(nullptr)
+	, mChunkEnd(nullptr)
+	, mCommandCount(0)
+{
+	Reset();
+}
+
+void* CommandBuffer::Push(CommandType type, size_t argumentSize)
+{
+	size_t size = (sizeof(CommandHeader) + argumentSize + 3) & ~(size_t)3;
+	if (mWrite + size + MaxTailSize > mChunkEnd)
+	{
+		uint8_t* chunk = mArena.Allocate<uint8_t>(ChunkSize);
+		WriteHeader(mWrite, CommandType::Jump, MaxTailSize);
+		Write(mWrite + sizeof(CommandHeader), chunk);
+		mWrite = chunk;
+		mChunkEnd = chunk + ChunkSize;
+	}
+
+	uint8_t* command = mWrite;
+	WriteHeader(command, type, size);
+	mWrite += size;
+	WriteHeader(mWrite, CommandType::End, sizeof(CommandHeader)); // overwritten by the next command
+	mCommandCount++;
+	return command + sizeof(CommandHeader);
+}
+
+void CommandBuffer::BindFramebuffer(uint32_t framebuffer)
+{
+	Write(Push(CommandType::BindFramebuffer, sizeof(framebuffer)), framebuffer);
+}
+
+void CommandBuffer::Viewport(int32_t x, int32_t y, int32_t width, int32_t height)
+{
+	Write(Push(CommandType::Viewport, sizeof(glm::ivec4)), glm::ivec4(x, y, width, height));
+}
+
+void CommandBuffer::Enable(uint32_t capability)
+{
+	Write(Push(CommandType::Enable, sizeof(capability)), capability);
+}
+
+void CommandBuffer::Disable(uint32_t capability)
+{
+	Write(Push(CommandType::Disable, sizeof(capability)), capability);
+}
+
+void CommandBuffer::ClearColor(const glm::vec4& color)
+{
+	Write(Push(CommandType::ClearColor, sizeof(color)), color);
+}
+
+void CommandBuffer::Clear(uint32_t mask)
+{
+	Write(Push(CommandType::Clear, sizeof(mask)), mask);
+}
+
+void CommandBuffer::BindProgram(uint32_t program)
+{
+	Write(Push(CommandType::BindProgram, sizeof(program)), program);
+}
+
+void CommandBuffer::BindTexture(uint32_t texture)
+{
+	Write(Push(CommandType::BindTexture, sizeof(texture)), texture);
+}
+
+void CommandBuffer::BindVertexArray(uint32_t vertexArray)
+{
+	Write(Push(CommandType::BindVertexArray, sizeof(vertexArray)), vertexArray);
+}
+
+#define PUSHUNIFORM(commandType) \
+if (location < 0)\
+{\
+	return;\
+}\
+uint8_t* arguments = (uint8_t*)Push(commandType, sizeof(UniformArgs) + sizeof(val));\
+Write(arguments, UniformArgs{ location });\
+Write(arguments + sizeof(UniformArgs), val);
+
+void CommandBuffer::SetUniform(int32_t location, int val) { PUSHUNIFORM(CommandType::UniformInt) }
+void CommandBuffer::SetUniform(int32_t location, float val) { PUSHUNIFORM(CommandType::UniformFloat) }
+void CommandBuffer::SetUniform(int32_t location, const glm::vec2& val) { PUSHUNIFORM(CommandType::UniformFloat2) }
+void CommandBuffer::SetUniform(int32_t location, const glm::vec3& val) { PUSHUNIFORM(CommandType::UniformFloat3) }
+void CommandBuffer::SetUniform(int32_t location, const glm::vec4& val) { PUSHUNIFORM(CommandType::UniformFloat4) }
+void CommandBuffer::SetUniform(int32_t location, const glm::mat3& val) { PUSHUNIFORM(CommandType::UniformMat3) }
+void CommandBuffer::SetUniform(int32_t location, const glm::mat4& val) { PUSHUNIFORM(CommandType::UniformMat4) }
+#undef PUSHUNIFORM
+
+void CommandBuffer::DrawElements(uint32_t mode, uint32_t count, uint32_t indexType)
+{
+	Write(Push(CommandType::DrawElements, sizeof(DrawElementsArgs)), DrawElementsArgs{ mode, count, indexType });
+}
+
+void CommandBuffer::DrawArrays(uint32_t mode, uint32_t count)
+{
+	Write(Push(CommandType::DrawArrays, sizeof(DrawArraysArgs)), DrawArraysArgs{ mode, count });
+}
+
+void CommandBuffer::Callback(void (*fn)(void*), void* data)
+{
+	Write(Push(CommandType::Callback, sizeof(CallbackArgs)), CallbackArgs{ fn, data });
+}
+
+void CommandBuffer::Execute() const
+{
+	const uint8_t* command = mFirst;
+	while (true)
+	{
+		CommandHeader header = Read<CommandHeader>(command);
+		const uint8_t* arguments = command + sizeof(CommandHeader);
+		int32_t location = 0;
+		if (header.type >= CommandType::UniformInt && header.type <= CommandType::UniformMat4)
+		{
+			location = Read<UniformArgs>(arguments).location;
+			arguments += sizeof(UniformArgs);
+		}
+
+		switch (header.type)
+		{
+		case CommandType::Jump:
+			command = Read<const uint8_t*>(arguments);
+			continue;
+		case CommandType::End:
+			return;
+		case CommandType::BindFramebuffer:
+			glBindFramebuffer(GL_FRAMEBUFFER, Read<uint32_t>(arguments));
+			break;
+		case CommandType::Viewport:
+		{
+			glm::ivec4 viewport = Read<glm::ivec4>(arguments);
+			glViewport(viewport.x, viewport.y, viewport.z, viewport.w);
+			break;
+		}
+		case CommandType::Enable:
+			glEnable(Read<uint32_t>(arguments));
+			break;
+		case CommandType::Disable:
+			glDisable(Read<uint32_t>(arguments));
+			break;
+		case CommandType::ClearColor:
+		{
+			glm::vec4 color = Read<glm::vec4>(arguments);
+			glClearColor(color.r, color.g, color.b, color.a);
+			break;
+		}
+		case CommandType::Clear:
+			glClear(Read<uint32_t>(arguments));
+			break;
+		case CommandType::BindProgram:
+			glUseProgram(Read<uint32_t>(arguments));
+			break;
+		case CommandType::BindTexture:
+			glActiveTexture(GL_TEXTURE0);
+			glBindTexture(GL_TEXTURE_2D, Read<uint32_t>(arguments));
+			break;
+		case CommandType::BindVertexArray:
+			glBindVertexArray(Read<uint32_t>(arguments));
+			break;
+		case CommandType::UniformInt:
+			glUniform1i(location, Read<int>(arguments));
+			break;
+		case CommandType::UniformFloat:
+			glUniform1f(location, Read<float>(arguments));
+			break;
+		case CommandType::UniformFloat2:
+			glUniform2fv(location, 1, glm::value_ptr(Read<glm::vec2>(arguments)));
+			break;
+		case CommandType::UniformFloat3:
+			glUniform3fv(location, 1, glm::value_ptr(Read<glm::vec3>(arguments)));
+			break;
+		case CommandType::UniformFloat4:
+			glUniform4fv(location, 1, glm::value_ptr(Read<glm::vec4>(arguments)));
+			break;
+		case CommandType::UniformMat3:
+			glUniformMatrix3fv(location, 1, GL_FALSE, glm::value_ptr(Read<glm::mat3>(arguments)));
+			break;
+		case CommandType::UniformMat4:
+			glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(Read<glm::mat4>(arguments)));
+			break;
+		case CommandType::DrawElements:
+		{
+			DrawElementsArgs draw = Read<DrawElementsArgs>(arguments);
+			glDrawElements(draw.mode, draw.count, draw.indexType, 0);
+			break;
+		}
+		case CommandType::DrawArrays:
+		{
+			DrawArraysArgs draw = Read<DrawArraysArgs>(arguments);
+			glDrawArrays(draw.mode, 0, draw.count);
+			break;
+		}
+		case CommandType::Callback:
+		{
+			CallbackArgs callback = Read<CallbackArgs>(arguments);
+			callback.fn(callback.data);
+			break;
+		}
+		}
+		command += header.size;
+	}
+}
+
+void CommandBuffer::Reset()
+{
+	mArena.Reset();
+	mFirst = mArena.Allocate<uint8_t>(ChunkSize);
+	mWrite = mFirst;
+	mChunkEnd = mFirst + ChunkSize;
+	mCommandCount = 0;
+	WriteHeader(mWrite, CommandType::End, sizeof(CommandHeader));
+}
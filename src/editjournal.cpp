@@ -0,0 +1,420 @@
+#include "editjournal.hpp"
+#include "mappedfile.hpp"
+#include "hash.hpp"
+#include "log.hpp"
+
+#include <cstring>
+#include <filesystem>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace
+{
+	constexpr uint32_t RecordHeaderSize = 2 * sizeof(uint32_t);
+	constexpr uint32_t MaxRecordSize = 64 << 20;
+
+	inline uint32_t Checksum(const uint8_t* data, size_t size)
+	{
+		return (uint32_t)HashBytes(data, size, 0x4A524E4C);
+	}
+
+	class RecordWriter
+	{
+	public:
+		RecordWriter(std::vector<uint8_t>& out)
+			: mOut(out)
+			, mStart(out.size())
+		{
+			mOut.resize(mStart + RecordHeaderSize);
+		}
+
+		template<typename T>
+		void Write(const T& value)
+		{
+			const uint8_t* bytes = (const uint8_t*)&value;
+			mOut.insert(mOut.end(), bytes, bytes + sizeof(T));
+		}
+
+		void WriteString(const std::string& str)
+		{
+			Write((uint32_t)str.size());
+			mOut.insert(mOut.end(), str.begin(), str.end());
+		}
+
+		void Finish()
+		{
+			uint32_t size = (uint32_t)(mOut.size() - mStart - RecordHeaderSize);
+			uint32_t checksum = Checksum(&mOut[mStart + RecordHeaderSize], size);
+			memcpy(&mOut[mStart], &size, sizeof(size));
+			memcpy(&mOut[mStart + sizeof(size)], &checksum, sizeof(checksum));
+		}
+
+	private:
+		std::vector<uint8_t>& mOut;
+		size_t mStart;
+	};
+
+	class RecordReader
+	{
+	public:
+		RecordReader(const uint8_t* data, size_t size)
+			: mData(data)
+			, mSize(size)
+			, mPos(0)
+		{
+
+		}
+
+		template<typename T>
+		bool Read(T& value)
+		{
+			if (mSize - mPos < sizeof(T))
+			{
+				return false;
+			}
+			memcpy(&value, mData + mPos, sizeof(T));
+			mPos += sizeof(T);
+			return true;
+		}
+
+		bool ReadString(std::string& str)
+		{
+			uint32_t size = 0;
+			if (!Read(size) || mSize - mPos < size)
+			{
+				return false;
+			}
+			str.assign((const char*)mData + mPos, size);
+			mPos += size;
+			return true;
+		}
+
+	private:
+		const uint8_t* mData;
+		size_t mSize;
+		size_t mPos;
+	};
+
+	void EncodeRecord(const JournalRecord& record, std::vector<uint8_t>& out)
+	{
+		RecordWriter writer(out);
+		writer.Write(record.type);
+		writer.WriteString(record.name);
+		switch (record.type)
+		{
+		case JournalRecordType::CreateEntity:
+			writer.WriteString(record.object);
+			[[fallthrough]];
+		case JournalRecordType::SetEntityTransform:
+			writer.Write(record.translate);
+			writer.Write(record.angle);
+			writer.Write(record.axis);
+			writer.Write(record.scale);
+			break;
+		case JournalRecordType::CreateObject:
+			writer.WriteString(record.vaName);
+			writer.WriteString(record.matName);
+			break;
+		case JournalRecordType::CreateMaterial:
+			writer.WriteString(record.vertexSource);
+			writer.WriteString(record.fragmentSource);
+			writer.WriteString(record.texture);
+			break;
+		default:
+			break;
+		}
+		writer.Finish();
+	}
+
+	bool DecodeRecord(const uint8_t* data, size_t size, JournalRecord& record)
+	{
+		RecordReader reader(data, size);
+		if (!reader.Read(record.type) || !reader.ReadString(record.name))
+		{
+			return false;
+		}
+		switch (record.type)
+		{
+		case JournalRecordType::CreateEntity:
+			if (!reader.ReadString(record.object)) return false;
+			[[fallthrough]];
+		case JournalRecordType::SetEntityTransform:
+			return reader.Read(record.translate) && reader.Read(record.angle) && reader.Read(record.axis) && reader.Read(record.scale);
+		case JournalRecordType::CreateObject:
+			return reader.ReadString(record.vaName) && reader.ReadString(record.matName);
+		case JournalRecordType::CreateMaterial:
+			return reader.ReadString(record.vertexSource) && reader.ReadString(record.fragmentSource) && reader.ReadString(record.texture);
+		case JournalRecordType::DestroyEntity:
+		case JournalRecordType::DestroyObject:
+		case JournalRecordType::DestroyMaterial:
+			return true;
+		}
+		return false;
+	}
+
+	bool SyncFile(FILE* file)
+	{
+		if (fflush(file) != 0)
+		{
+			return false;
+		}
+#ifdef _WIN32
+		return _commit(_fileno(file)) == 0;
+#else
+		return fsync(fileno(file)) == 0;
+#endif
+	}
+}
+
+EditJournal::EditJournal()
+	: mFile(nullptr)
+	, mWrittenBytes(0)
+	, mIsStopping(false)
+{
+
+}
+
+EditJournal::~EditJournal()
+{
+	Close();
+}
+
+bool EditJournal::Open(const std::string& path, uint64_t validSize)
+{
+	Close();
+
+	std::error_code ec;
+	std::filesystem::path parent = std::filesystem::path(path).parent_path();
+	if (!parent.empty())
+	{
+		std::filesystem::create_directories(parent, ec);
+	}
+	if (std::filesystem::exists(path, ec) && std::filesystem::file_size(path, ec) > validSize)
+	{
+		LOG("Discarding %llu bytes of incomplete journal records", (unsigned long long)(std::filesystem::file_size(path, ec) - validSize));
+		std::filesystem::resize_file(path, validSize, ec);
+	}
+
+	mFile = fopen(path.c_str(), "ab");
+	if (!mFile)
+	{
+		LOG("Could not open edit journal %s", path.c_str());
+		return false;
+	}
+
+	mPath = path;
+	mWrittenBytes = validSize;
+	mIsStopping = false;
+	mWriter = std::thread(&EditJournal::WriterLoop, this);
+	return true;
+}
+
+void EditJournal::Close()
+{
+	if (!mWriter.joinable())
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mIsStopping = true;
+	}
+	mCondition.notify_all();
+	mWriter.join();
+
+	fclose(mFile);
+	mFile = nullptr;
+}
+
+void EditJournal::Append(const JournalRecord& record)
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		EncodeRecord(record, mPending);
+	}
+	mCondition.notify_one();
+}
+
+bool EditJournal::Reset()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	mPending.clear();
+
+	std::lock_guard<std::mutex> fileLock(mFileMutex);
+	if (!mFile)
+	{
+		return false;
+	}
+	mFile = freopen(mPath.c_str(), "wb", mFile);
+	if (!mFile || !SyncFile(mFile))
+	{
+		LOG("Could not truncate edit journal %s", mPath.c_str());
+		return false;
+	}
+	mWrittenBytes = 0;
+	return true;
+}
+
+bool EditJournal::Rotate(const std::string& retiredPath)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	std::lock_guard<std::mutex> fileLock(mFileMutex);
+	if (!mFile)
+	{
+		return false;
+	}
+
+	// pending records were made before the snapshot, they belong to the retired segment
+	if (!mPending.empty() && !WriteBatch(mPending))
+	{
+		LOG("Could not write edit journal %s", mPath.c_str());
+		return false;
+	}
+	mPending.clear();
+	fclose(mFile);
+	mFile = nullptr;
+
+	std::error_code ec;
+	bool isRetired = false;
+	if (!std::filesystem::exists(retiredPath, ec))
+	{
+		std::filesystem::rename(mPath, retiredPath, ec);
+		isRetired = !ec;
+	}
+	else
+	{
+		// the snapshot of the last rotation was never written, append behind its records
+		MappedFile segment;
+		FILE* retired = fopen(retiredPath.c_str(), "ab");
+		if (retired)
+		{
+			isRetired = segment.Open(mPath) && fwrite(segment.GetData(), 1, segment.GetSize(), retired) == segment.GetSize() && SyncFile(retired);
+			fclose(retired);
+		}
+	}
+
+	// on failure the records stay where they are and the journal goes on behind them
+	mFile = fopen(mPath.c_str(), isRetired ? "wb" : "ab");
+	if (!mFile || !SyncFile(mFile))
+	{
+		LOG("Could not reopen edit journal %s", mPath.c_str());
+		return false;
+	}
+	if (isRetired)
+	{
+		mWrittenBytes = 0;
+	}
+	else
+	{
+		LOG("Could not retire edit journal %s to %s", mPath.c_str(), retiredPath.c_str());
+	}
+	return isRetired;
+}
+
+uint64_t EditJournal::GetSize() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mWrittenBytes + mPending.size();
+}
+
+uint64_t EditJournal::Replay(const std::string& path, const std::function<void(const JournalRecord&)>& fn)
+{
+	MappedFile file;
+	if (!std::filesystem::exists(path) || !file.Open(path))
+	{
+		return 0;
+	}
+
+	const uint8_t* data = file.GetData();
+	uint64_t size = file.GetSize();
+	uint64_t pos = 0;
+	uint32_t count = 0;
+	JournalRecord record;
+	while (size_t recordSize = Decode(data + pos, size - pos, record))
+	{
+		fn(record);
+		pos += recordSize;
+		count++;
+	}
+
+	if (pos != size)
+	{
+		LOG("Edit journal %s ends in an incomplete record after %u records", path.c_str(), count);
+	}
+	return pos;
+}
+
+void EditJournal::Encode(const JournalRecord& record, std::vector<uint8_t>& out)
+{
+	EncodeRecord(record, out);
+}
+
+size_t EditJournal::Decode(const uint8_t* data, size_t size, JournalRecord& record)
+{
+	if (size < RecordHeaderSize)
+	{
+		return 0;
+	}
+	uint32_t recordSize, checksum;
+	memcpy(&recordSize, data, sizeof(recordSize));
+	memcpy(&checksum, data + sizeof(recordSize), sizeof(checksum));
+	if (recordSize > MaxRecordSize || size - RecordHeaderSize < recordSize)
+	{
+		return 0;
+	}
+
+	const uint8_t* payload = data + RecordHeaderSize;
+	record = JournalRecord();
+	if (Checksum(payload, recordSize) != checksum || !DecodeRecord(payload, recordSize, record))
+	{
+		return 0;
+	}
+	return RecordHeaderSize + recordSize;
+}
+
+void EditJournal::WriterLoop()
+{
+	std::vector<uint8_t> batch;
+	std::unique_lock<std::mutex> lock(mMutex);
+	while (true)
+	{
+		mCondition.wait(lock, [this]() { return mIsStopping || !mPending.empty(); });
+		if (mPending.empty())
+		{
+			break;
+		}
+
+		// give the edits of a drag or a burst of clicks time to pile up, one sync covers all of them
+		mCondition.wait_for(lock, BatchInterval, [this]() { return mIsStopping; });
+
+		// the file lock is taken before the pending records are released, so a Reset in between can not be
+		// followed by a write of records the snapshot already contains
+		std::unique_lock<std::mutex> fileLock(mFileMutex);
+		batch.swap(mPending);
+		lock.unlock();
+
+		if (!batch.empty() && !WriteBatch(batch))
+		{
+			LOG("Could not write edit journal %s", mPath.c_str());
+		}
+		fileLock.unlock();
+		batch.clear();
+
+		lock.lock();
+	}
+}
+
+bool EditJournal::WriteBatch(const std::vector<uint8_t>& batch)
+{
+	if (!mFile || fwrite(batch.data(), 1, batch.size(), mFile) != batch.size())
+	{
+		return false;
+	}
+	mWrittenBytes += batch.size();
+	return SyncFile(mFile);
+}
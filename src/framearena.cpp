@@ -0,0 +1,62 @@
+#include "framearena.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+FrameArena::FrameArena(size_t initialSize)
+	: mOffset(0)
+	, mUsed(0)
+{
+	mBlocks.reserve(8);
+	AddBlock(initialSize);
+}
+
+FrameArena::~FrameArena()
+{
+
+}
+
+void* FrameArena::Allocate(size_t size, size_t alignment)
+{
+	Block* block = &mBlocks.back();
+	uintptr_t base = (uintptr_t)block->data.get();
+	uintptr_t aligned = (base + mOffset + alignment - 1) & ~(uintptr_t)(alignment - 1);
+	if (aligned + size > base + block->size)
+	{
+		AddBlock(std::max(block->size * 2, size + alignment));
+		block = &mBlocks.back();
+		base = (uintptr_t)block->data.get();
+		aligned = (base + alignment - 1) & ~(uintptr_t)(alignment - 1);
+	}
+	mOffset = aligned + size - base;
+	mUsed += size;
+	return (void*)aligned;
+}
+
+void FrameArena::Reset()
+{
+	if (mBlocks.size() > 1)
+	{
+		size_t capacity = GetCapacity();
+		mBlocks.clear();
+		AddBlock(capacity);
+	}
+	mOffset = 0;
+	mUsed = 0;
+}
+
+size_t FrameArena::GetCapacity() const
+{
+	size_t capacity = 0;
+	for (const Block& block : mBlocks)
+	{
+		capacity += block.size;
+	}
+	return capacity;
+}
+
+void FrameArena::AddBlock(size_t size)
+{
+	mBlocks.push_back({ std::make_unique_for_overwrite<std::byte[]>(size), size });
+	mOffset = 0;
+}
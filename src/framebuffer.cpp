@@ -1,5 +1,6 @@
 #include "framebuffer.hpp"
 #include "log.hpp"
+#include "renderthread.hpp"
 
 #include <glad/glad.h>
 
@@ -10,38 +11,56 @@ Framebuffer::Framebuffer(uint32_t width, uint32_t height)
 	, mSize({ width, height })
 	, mClearColour(1.f)
 {
-	glGenFramebuffers(1, &mFB);
-	glBindFramebuffer(GL_FRAMEBUFFER, mFB);
-
-	// Create color texture
-	glGenTextures(1, &mTextureId);
-	glBindTexture(GL_TEXTURE_2D, mTextureId);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, mSize.x, mSize.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glBindTexture(GL_TEXTURE_2D, 0);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mTextureId, 0);
-
-	// Create depth/stencil renderbuffer
-	glGenRenderbuffers(1, &mRenderbufferId);
-	glBindRenderbuffer(GL_RENDERBUFFER, mRenderbufferId);
-	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, mSize.x, mSize.y);
-	glBindRenderbuffer(GL_RENDERBUFFER, 0);
-	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, mRenderbufferId);
-
-	// Check for completeness
-	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-	{
-		LOG("Framebuffer incomplete");
-	}
-
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	RenderThread::Get().Run([this]() {
+		glGenFramebuffers(1, &mFB);
+		glBindFramebuffer(GL_FRAMEBUFFER, mFB);
+
+		// Create color texture
+		glGenTextures(1, &mTextureId);
+		glBindTexture(GL_TEXTURE_2D, mTextureId);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, mSize.x, mSize.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mTextureId, 0);
+
+		// Create depth/stencil renderbuffer
+		glGenRenderbuffers(1, &mRenderbufferId);
+		glBindRenderbuffer(GL_RENDERBUFFER, mRenderbufferId);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, mSize.x, mSize.y);
+		glBindRenderbuffer(GL_RENDERBUFFER, 0);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, mRenderbufferId);
+
+		// Check for completeness
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		{
+			LOG("Framebuffer incomplete");
+		}
+
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	});
 }
 
 Framebuffer::~Framebuffer()
 {
-	glDeleteFramebuffers(1, &mFB);
+	uint32_t fb = mFB, textureId = mTextureId, renderbufferId = mRenderbufferId;
+	RenderThread::Get().Post([fb, textureId, renderbufferId]() {
+		glDeleteFramebuffers(1, &fb);
+		glDeleteTextures(1, &textureId);
+		glDeleteRenderbuffers(1, &renderbufferId);
+	});
 	mFB = 0;
 	mTextureId = 0;
 	mRenderbufferId = 0;
+}
+
+void Framebuffer::ReadPixels(std::vector<uint8_t>& pixels) const
+{
+	pixels.resize((size_t)mSize.x * mSize.y * 4);
+	RenderThread::Get().Run([this, &pixels]() {
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, mFB);
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		glReadPixels(0, 0, mSize.x, mSize.y, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+	});
 }
\ No newline at end of file
@@ -0,0 +1,34 @@
+#include "frustum.hpp"
+
+Frustum Frustum::FromMatrix(const glm::mat4& viewProjection)
+{
+	// rows of the matrix combined as in Gribb and Hartmann, glm is column major
+	glm::mat4 m = glm::transpose(viewProjection);
+	Frustum frustum;
+	frustum.planes[0] = m[3] + m[0]; // left
+	frustum.planes[1] = m[3] - m[0]; // right
+	frustum.planes[2] = m[3] + m[1]; // bottom
+	frustum.planes[3] = m[3] - m[1]; // top
+	frustum.planes[4] = m[3] + m[2]; // near
+	frustum.planes[5] = m[3] - m[2]; // far
+	return frustum;
+}
+
+bool Frustum::IsBoxVisible(const glm::vec3& boundsMin, const glm::vec3& boundsMax, const glm::mat4& model) const
+{
+	// world space center and half extents of the box around the transformed box
+	glm::vec3 center = glm::vec3(model * glm::vec4((boundsMin + boundsMax) * 0.5f, 1.0f));
+	glm::vec3 extent = (boundsMax - boundsMin) * 0.5f;
+	glm::mat3 axes(model);
+	glm::vec3 worldExtent = glm::abs(axes[0]) * extent.x + glm::abs(axes[1]) * extent.y + glm::abs(axes[2]) * extent.z;
+
+	for (const glm::vec4& plane : planes)
+	{
+		glm::vec3 normal(plane);
+		if (glm::dot(normal, center) + glm::dot(glm::abs(normal), worldExtent) + plane.w < 0.0f)
+		{
+			return false;
+		}
+	}
+	return true;
+}
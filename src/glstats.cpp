@@ -0,0 +1,694 @@
+#include "glstats.hpp"
+
+#include "glad/glad.h"
+
+#include <algorithm>
+
+// Every wrapped glad pointer, the original is kept in Originals under the same name
+#define GL_STATS_FUNCTIONS(X) \
+	X(DrawArrays) X(DrawElements) X(DrawArraysInstanced) X(DrawElementsInstanced) \
+	X(UseProgram) X(BindVertexArray) X(BindBuffer) X(ActiveTexture) X(BindTexture) X(BindFramebuffer) X(BindRenderbuffer) \
+	X(Enable) X(Disable) X(Viewport) \
+	X(Uniform1i) X(Uniform1f) X(Uniform2fv) X(Uniform3fv) X(Uniform4fv) X(UniformMatrix3fv) X(UniformMatrix4fv) \
+	X(BufferData) X(BufferSubData) X(TexImage2D) X(TexSubImage2D) X(RenderbufferStorage) \
+	X(GenBuffers) X(DeleteBuffers) X(GenTextures) X(DeleteTextures) X(GenVertexArrays) X(DeleteVertexArrays) \
+	X(GenFramebuffers) X(DeleteFramebuffers) X(GenRenderbuffers) X(DeleteRenderbuffers) \
+	X(CreateProgram) X(DeleteProgram) X(CreateShader) X(DeleteShader) X(GenQueries) X(DeleteQueries)
+
+namespace
+{
+	constexpr GLuint Unknown = 0xFFFFFFFF; // bound before the shim was installed
+	constexpr uint32_t MaxTextureUnits = 32;
+
+	struct Originals
+	{
+#define GL_STATS_ORIGINAL(name) decltype(glad_gl##name) name = nullptr;
+		GL_STATS_FUNCTIONS(GL_STATS_ORIGINAL)
+#undef GL_STATS_ORIGINAL
+	};
+
+	// What the wrapped calls left bound, redundant binds are told apart by it
+	struct BoundState
+	{
+		GLuint program = Unknown;
+		GLuint vertexArray = Unknown;
+		std::unordered_map<GLenum, GLuint> buffers; // by target, the element buffer belongs to the vertex array
+		std::unordered_map<GLuint, GLuint> elementBuffers; // by vertex array
+		uint32_t activeTexture = Unknown;
+		GLuint textures[MaxTextureUnits][2]; // 2d and cube map
+		GLuint drawFramebuffer = Unknown, readFramebuffer = Unknown;
+		GLuint renderbuffer = Unknown;
+		std::unordered_map<GLenum, bool> capabilities;
+		GLint viewport[4] = { 0, 0, -1, -1 };
+
+		BoundState() { std::fill(&textures[0][0], &textures[0][0] + MaxTextureUnits * 2, Unknown); }
+	};
+
+	Originals original;
+	BoundState bound;
+
+	GlFrameStats& Frame()
+	{
+		return GlStats::Get().GetCurrentFrame();
+	}
+
+	void CountBind(GLuint& current, GLuint name)
+	{
+		if (current == name)
+		{
+			Frame().redundantBinds++;
+		}
+		else
+		{
+			Frame().stateChanges++;
+			current = name;
+		}
+	}
+
+	uint64_t CountTriangles(GLenum mode, GLsizei count)
+	{
+		switch (mode)
+		{
+		case GL_TRIANGLES: return count / 3;
+		case GL_TRIANGLE_STRIP:
+		case GL_TRIANGLE_FAN: return count > 2 ? count - 2 : 0;
+		default: return 0;
+		}
+	}
+
+	GLuint* GetBoundTexture(GLenum target)
+	{
+		if (bound.activeTexture >= MaxTextureUnits)
+		{
+			return nullptr;
+		}
+		if (target == GL_TEXTURE_2D)
+		{
+			return &bound.textures[bound.activeTexture][0];
+		}
+		if (target == GL_TEXTURE_CUBE_MAP || (target >= GL_TEXTURE_CUBE_MAP_POSITIVE_X && target <= GL_TEXTURE_CUBE_MAP_NEGATIVE_Z))
+		{
+			return &bound.textures[bound.activeTexture][1];
+		}
+		return nullptr;
+	}
+
+	GLuint GetBoundBuffer(GLenum target)
+	{
+		if (target == GL_ELEMENT_ARRAY_BUFFER)
+		{
+			auto it = bound.elementBuffers.find(bound.vertexArray);
+			return it != bound.elementBuffers.end() ? it->second : Unknown;
+		}
+		auto it = bound.buffers.find(target);
+		return it != bound.buffers.end() ? it->second : Unknown;
+	}
+
+	// Bytes a texel takes in video memory, drivers pad three component formats to four
+	uint64_t GetTexelBytes(GLint internalFormat)
+	{
+		switch (internalFormat)
+		{
+		case GL_RED: case GL_R8: case GL_STENCIL_INDEX8: return 1;
+		case GL_RG: case GL_RG8: case GL_R16F: case GL_DEPTH_COMPONENT16: return 2;
+		case GL_RG16F: case GL_R32F: case GL_DEPTH_COMPONENT: case GL_DEPTH_COMPONENT24: case GL_DEPTH_COMPONENT32F:
+		case GL_DEPTH_STENCIL: case GL_DEPTH24_STENCIL8: return 4;
+		case GL_RGB16F: case GL_RGBA16F: case GL_RG32F: case GL_DEPTH32F_STENCIL8: return 8;
+		case GL_RGB32F: case GL_RGBA32F: return 16;
+		default: return 4;
+		}
+	}
+
+	// Bytes a pixel of client data takes, ignoring row alignment
+	uint64_t GetPixelBytes(GLenum format, GLenum type)
+	{
+		switch (type)
+		{
+		case GL_UNSIGNED_SHORT_5_6_5: case GL_UNSIGNED_SHORT_4_4_4_4: case GL_UNSIGNED_SHORT_5_5_5_1: return 2;
+		case GL_UNSIGNED_INT_8_8_8_8: case GL_UNSIGNED_INT_8_8_8_8_REV: case GL_UNSIGNED_INT_2_10_10_10_REV:
+		case GL_UNSIGNED_INT_24_8: case GL_UNSIGNED_INT_10F_11F_11F_REV: return 4;
+		}
+
+		uint64_t components = 4;
+		switch (format)
+		{
+		case GL_RED: case GL_RED_INTEGER: case GL_DEPTH_COMPONENT: case GL_STENCIL_INDEX: components = 1; break;
+		case GL_RG: case GL_RG_INTEGER: components = 2; break;
+		case GL_RGB: case GL_BGR: case GL_RGB_INTEGER: components = 3; break;
+		}
+
+		switch (type)
+		{
+		case GL_UNSIGNED_BYTE: case GL_BYTE: return components;
+		case GL_UNSIGNED_SHORT: case GL_SHORT: case GL_HALF_FLOAT: return components * 2;
+		default: return components * 4;
+		}
+	}
+
+	// what is bound when the shim goes in, so the first binds afterwards are judged right
+	void QueryBoundState()
+	{
+		bound = BoundState();
+		auto query = [](GLenum binding) {
+			GLint value = 0;
+			glGetIntegerv(binding, &value);
+			return (GLuint)value;
+		};
+		bound.program = query(GL_CURRENT_PROGRAM);
+		bound.vertexArray = query(GL_VERTEX_ARRAY_BINDING);
+		bound.buffers[GL_ARRAY_BUFFER] = query(GL_ARRAY_BUFFER_BINDING);
+		bound.buffers[GL_PIXEL_PACK_BUFFER] = query(GL_PIXEL_PACK_BUFFER_BINDING);
+		bound.buffers[GL_PIXEL_UNPACK_BUFFER] = query(GL_PIXEL_UNPACK_BUFFER_BINDING);
+		bound.elementBuffers[bound.vertexArray] = query(GL_ELEMENT_ARRAY_BUFFER_BINDING);
+		bound.activeTexture = query(GL_ACTIVE_TEXTURE) - GL_TEXTURE0;
+		if (bound.activeTexture < MaxTextureUnits)
+		{
+			bound.textures[bound.activeTexture][0] = query(GL_TEXTURE_BINDING_2D);
+			bound.textures[bound.activeTexture][1] = query(GL_TEXTURE_BINDING_CUBE_MAP);
+		}
+		bound.drawFramebuffer = query(GL_DRAW_FRAMEBUFFER_BINDING);
+		bound.readFramebuffer = query(GL_READ_FRAMEBUFFER_BINDING);
+		bound.renderbuffer = query(GL_RENDERBUFFER_BINDING);
+		glGetIntegerv(GL_VIEWPORT, bound.viewport);
+	}
+
+	bool IsUnpackingFromBuffer()
+	{
+		GLuint buffer = GetBoundBuffer(GL_PIXEL_UNPACK_BUFFER);
+		return buffer != 0 && buffer != Unknown;
+	}
+
+	void APIENTRY CountingDrawArrays(GLenum mode, GLint first, GLsizei count)
+	{
+		Frame().drawCalls++;
+		Frame().triangles += CountTriangles(mode, count);
+		original.DrawArrays(mode, first, count);
+	}
+
+	void APIENTRY CountingDrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices)
+	{
+		Frame().drawCalls++;
+		Frame().triangles += CountTriangles(mode, count);
+		original.DrawElements(mode, count, type, indices);
+	}
+
+	void APIENTRY CountingDrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instanceCount)
+	{
+		Frame().drawCalls++;
+		Frame().triangles += CountTriangles(mode, count) * instanceCount;
+		original.DrawArraysInstanced(mode, first, count, instanceCount);
+	}
+
+	void APIENTRY CountingDrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instanceCount)
+	{
+		Frame().drawCalls++;
+		Frame().triangles += CountTriangles(mode, count) * instanceCount;
+		original.DrawElementsInstanced(mode, count, type, indices, instanceCount);
+	}
+
+	void APIENTRY CountingUseProgram(GLuint program)
+	{
+		CountBind(bound.program, program);
+		original.UseProgram(program);
+	}
+
+	void APIENTRY CountingBindVertexArray(GLuint vertexArray)
+	{
+		CountBind(bound.vertexArray, vertexArray);
+		original.BindVertexArray(vertexArray);
+	}
+
+	void APIENTRY CountingBindBuffer(GLenum target, GLuint buffer)
+	{
+		if (target == GL_ELEMENT_ARRAY_BUFFER)
+		{
+			if (bound.vertexArray == Unknown)
+			{
+				Frame().stateChanges++;
+			}
+			else
+			{
+				auto [it, isNew] = bound.elementBuffers.emplace(bound.vertexArray, Unknown);
+				CountBind(it->second, buffer);
+			}
+		}
+		else
+		{
+			auto [it, isNew] = bound.buffers.emplace(target, Unknown);
+			CountBind(it->second, buffer);
+		}
+		original.BindBuffer(target, buffer);
+	}
+
+	void APIENTRY CountingActiveTexture(GLenum texture)
+	{
+		CountBind(bound.activeTexture, texture - GL_TEXTURE0);
+		original.ActiveTexture(texture);
+	}
+
+	void APIENTRY CountingBindTexture(GLenum target, GLuint texture)
+	{
+		GLuint* current = GetBoundTexture(target);
+		if (current)
+		{
+			CountBind(*current, texture);
+		}
+		else
+		{
+			Frame().stateChanges++;
+		}
+		original.BindTexture(target, texture);
+	}
+
+	void APIENTRY CountingBindFramebuffer(GLenum target, GLuint framebuffer)
+	{
+		if (target == GL_FRAMEBUFFER)
+		{
+			if (bound.drawFramebuffer == framebuffer && bound.readFramebuffer == framebuffer)
+			{
+				Frame().redundantBinds++;
+			}
+			else
+			{
+				Frame().stateChanges++;
+			}
+			bound.drawFramebuffer = bound.readFramebuffer = framebuffer;
+		}
+		else
+		{
+			CountBind(target == GL_READ_FRAMEBUFFER ? bound.readFramebuffer : bound.drawFramebuffer, framebuffer);
+		}
+		original.BindFramebuffer(target, framebuffer);
+	}
+
+	void APIENTRY CountingBindRenderbuffer(GLenum target, GLuint renderbuffer)
+	{
+		CountBind(bound.renderbuffer, renderbuffer);
+		original.BindRenderbuffer(target, renderbuffer);
+	}
+
+	void SetCapability(GLenum capability, bool isEnabled)
+	{
+		auto [it, isNew] = bound.capabilities.emplace(capability, isEnabled);
+		if (isNew || it->second != isEnabled)
+		{
+			Frame().stateChanges++;
+			it->second = isEnabled;
+		}
+	}
+
+	void APIENTRY CountingEnable(GLenum capability)
+	{
+		SetCapability(capability, true);
+		original.Enable(capability);
+	}
+
+	void APIENTRY CountingDisable(GLenum capability)
+	{
+		SetCapability(capability, false);
+		original.Disable(capability);
+	}
+
+	void APIENTRY CountingViewport(GLint x, GLint y, GLsizei width, GLsizei height)
+	{
+		GLint viewport[4] = { x, y, width, height };
+		if (!std::equal(viewport, viewport + 4, bound.viewport))
+		{
+			Frame().stateChanges++;
+			std::copy(viewport, viewport + 4, bound.viewport);
+		}
+		original.Viewport(x, y, width, height);
+	}
+
+	void APIENTRY CountingUniform1i(GLint location, GLint v0)
+	{
+		Frame().uniformUploads++;
+		original.Uniform1i(location, v0);
+	}
+
+	void APIENTRY CountingUniform1f(GLint location, GLfloat v0)
+	{
+		Frame().uniformUploads++;
+		original.Uniform1f(location, v0);
+	}
+
+	void APIENTRY CountingUniform2fv(GLint location, GLsizei count, const GLfloat* value)
+	{
+		Frame().uniformUploads++;
+		original.Uniform2fv(location, count, value);
+	}
+
+	void APIENTRY CountingUniform3fv(GLint location, GLsizei count, const GLfloat* value)
+	{
+		Frame().uniformUploads++;
+		original.Uniform3fv(location, count, value);
+	}
+
+	void APIENTRY CountingUniform4fv(GLint location, GLsizei count, const GLfloat* value)
+	{
+		Frame().uniformUploads++;
+		original.Uniform4fv(location, count, value);
+	}
+
+	void APIENTRY CountingUniformMatrix3fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value)
+	{
+		Frame().uniformUploads++;
+		original.UniformMatrix3fv(location, count, transpose, value);
+	}
+
+	void APIENTRY CountingUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value)
+	{
+		Frame().uniformUploads++;
+		original.UniformMatrix4fv(location, count, transpose, value);
+	}
+
+	void APIENTRY CountingBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage)
+	{
+		if (data)
+		{
+			Frame().bufferUploadBytes += size;
+		}
+		GlStats::Get().SetObjectBytes(GlObjectType::Buffer, GetBoundBuffer(target), size);
+		original.BufferData(target, size, data, usage);
+	}
+
+	void APIENTRY CountingBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data)
+	{
+		Frame().bufferUploadBytes += size;
+		original.BufferSubData(target, offset, size, data);
+	}
+
+	void APIENTRY CountingTexImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void* pixels)
+	{
+		if (pixels || IsUnpackingFromBuffer())
+		{
+			Frame().textureUploadBytes += GetPixelBytes(format, type) * width * height;
+		}
+		GLuint* texture = GetBoundTexture(target);
+		if (texture)
+		{
+			uint32_t face = target == GL_TEXTURE_2D ? 0 : target - GL_TEXTURE_CUBE_MAP_POSITIVE_X;
+			GlStats::Get().SetTextureImageBytes(*texture, face << 8 | level, GetTexelBytes(internalFormat) * width * height);
+		}
+		original.TexImage2D(target, level, internalFormat, width, height, border, format, type, pixels);
+	}
+
+	void APIENTRY CountingTexSubImage2D(GLenum target, GLint level, GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels)
+	{
+		Frame().textureUploadBytes += GetPixelBytes(format, type) * width * height;
+		original.TexSubImage2D(target, level, x, y, width, height, format, type, pixels);
+	}
+
+	void APIENTRY CountingRenderbufferStorage(GLenum target, GLenum internalFormat, GLsizei width, GLsizei height)
+	{
+		GlStats::Get().SetObjectBytes(GlObjectType::Renderbuffer, bound.renderbuffer, GetTexelBytes(internalFormat) * width * height);
+		original.RenderbufferStorage(target, internalFormat, width, height);
+	}
+
+	void AddObjects(GlObjectType type, GLsizei count, const GLuint* names)
+	{
+		for (GLsizei i = 0; i < count; i++)
+		{
+			GlStats::Get().AddObject(type, names[i]);
+		}
+	}
+
+	// deleting a bound object unbinds it
+	void RemoveObjects(GlObjectType type, GLsizei count, const GLuint* names)
+	{
+		for (GLsizei i = 0; i < count; i++)
+		{
+			GLuint name = names[i];
+			if (name == 0)
+			{
+				continue;
+			}
+			GlStats::Get().RemoveObject(type, name);
+
+			auto unbind = [name](GLuint& current) { current = current == name ? 0 : current; };
+			switch (type)
+			{
+			case GlObjectType::Buffer:
+				for (auto& [target, buffer] : bound.buffers) unbind(buffer);
+				for (auto& [vertexArray, buffer] : bound.elementBuffers) unbind(buffer);
+				break;
+			case GlObjectType::Texture:
+				std::for_each(&bound.textures[0][0], &bound.textures[0][0] + MaxTextureUnits * 2, unbind);
+				break;
+			case GlObjectType::VertexArray:
+				unbind(bound.vertexArray);
+				bound.elementBuffers.erase(name);
+				break;
+			case GlObjectType::Framebuffer:
+				unbind(bound.drawFramebuffer);
+				unbind(bound.readFramebuffer);
+				break;
+			case GlObjectType::Renderbuffer:
+				unbind(bound.renderbuffer);
+				break;
+			default:
+				break;
+			}
+		}
+	}
+
+	void APIENTRY CountingGenBuffers(GLsizei count, GLuint* names)
+	{
+		original.GenBuffers(count, names);
+		AddObjects(GlObjectType::Buffer, count, names);
+	}
+
+	void APIENTRY CountingDeleteBuffers(GLsizei count, const GLuint* names)
+	{
+		RemoveObjects(GlObjectType::Buffer, count, names);
+		original.DeleteBuffers(count, names);
+	}
+
+	void APIENTRY CountingGenTextures(GLsizei count, GLuint* names)
+	{
+		original.GenTextures(count, names);
+		AddObjects(GlObjectType::Texture, count, names);
+	}
+
+	void APIENTRY CountingDeleteTextures(GLsizei count, const GLuint* names)
+	{
+		RemoveObjects(GlObjectType::Texture, count, names);
+		original.DeleteTextures(count, names);
+	}
+
+	void APIENTRY CountingGenVertexArrays(GLsizei count, GLuint* names)
+	{
+		original.GenVertexArrays(count, names);
+		AddObjects(GlObjectType::VertexArray, count, names);
+	}
+
+	void APIENTRY CountingDeleteVertexArrays(GLsizei count, const GLuint* names)
+	{
+		RemoveObjects(GlObjectType::VertexArray, count, names);
+		original.DeleteVertexArrays(count, names);
+	}
+
+	void APIENTRY CountingGenFramebuffers(GLsizei count, GLuint* names)
+	{
+		original.GenFramebuffers(count, names);
+		AddObjects(GlObjectType::Framebuffer, count, names);
+	}
+
+	void APIENTRY CountingDeleteFramebuffers(GLsizei count, const GLuint* names)
+	{
+		RemoveObjects(GlObjectType::Framebuffer, count, names);
+		original.DeleteFramebuffers(count, names);
+	}
+
+	void APIENTRY CountingGenRenderbuffers(GLsizei count, GLuint* names)
+	{
+		original.GenRenderbuffers(count, names);
+		AddObjects(GlObjectType::Renderbuffer, count, names);
+	}
+
+	void APIENTRY CountingDeleteRenderbuffers(GLsizei count, const GLuint* names)
+	{
+		RemoveObjects(GlObjectType::Renderbuffer, count, names);
+		original.DeleteRenderbuffers(count, names);
+	}
+
+	GLuint APIENTRY CountingCreateProgram()
+	{
+		GLuint program = original.CreateProgram();
+		GlStats::Get().AddObject(GlObjectType::Program, program);
+		return program;
+	}
+
+	void APIENTRY CountingDeleteProgram(GLuint program)
+	{
+		RemoveObjects(GlObjectType::Program, 1, &program);
+		original.DeleteProgram(program);
+	}
+
+	GLuint APIENTRY CountingCreateShader(GLenum type)
+	{
+		GLuint shader = original.CreateShader(type);
+		GlStats::Get().AddObject(GlObjectType::Shader, shader);
+		return shader;
+	}
+
+	void APIENTRY CountingDeleteShader(GLuint shader)
+	{
+		RemoveObjects(GlObjectType::Shader, 1, &shader);
+		original.DeleteShader(shader);
+	}
+
+	void APIENTRY CountingGenQueries(GLsizei count, GLuint* names)
+	{
+		original.GenQueries(count, names);
+		AddObjects(GlObjectType::Query, count, names);
+	}
+
+	void APIENTRY CountingDeleteQueries(GLsizei count, const GLuint* names)
+	{
+		RemoveObjects(GlObjectType::Query, count, names);
+		original.DeleteQueries(count, names);
+	}
+}
+
+GlStats::GlStats()
+	: mIsInstalled(false)
+{
+
+}
+
+GlStats& GlStats::Get()
+{
+	static GlStats glStats;
+	return glStats;
+}
+
+const char* GlStats::GetObjectTypeName(GlObjectType type)
+{
+	switch (type)
+	{
+	case GlObjectType::Buffer: return "Buffers";
+	case GlObjectType::Texture: return "Textures";
+	case GlObjectType::VertexArray: return "Vertex arrays";
+	case GlObjectType::Framebuffer: return "Framebuffers";
+	case GlObjectType::Renderbuffer: return "Renderbuffers";
+	case GlObjectType::Program: return "Programs";
+	case GlObjectType::Shader: return "Shaders";
+	case GlObjectType::Query: return "Queries";
+	default: return "";
+	}
+}
+
+void GlStats::Install()
+{
+	if (mIsInstalled)
+	{
+		return;
+	}
+	QueryBoundState();
+	mFrame = GlFrameStats();
+
+#define GL_STATS_INSTALL(name) original.name = glad_gl##name; glad_gl##name = Counting##name;
+	GL_STATS_FUNCTIONS(GL_STATS_INSTALL)
+#undef GL_STATS_INSTALL
+	mIsInstalled = true;
+}
+
+void GlStats::Uninstall()
+{
+	if (!mIsInstalled)
+	{
+		return;
+	}
+
+#define GL_STATS_UNINSTALL(name) glad_gl##name = original.name;
+	GL_STATS_FUNCTIONS(GL_STATS_UNINSTALL)
+#undef GL_STATS_UNINSTALL
+	mIsInstalled = false;
+
+	// objects made or deleted from here on go unseen, the counts would drift
+	for (auto& objects : mObjects)
+	{
+		objects.clear();
+	}
+	mTextureImages.clear();
+	mObjectStats = GlObjectStats();
+	std::lock_guard<std::mutex> lock(mPublishedMutex);
+	mPublishedFrame = GlFrameStats();
+	mPublishedObjects = GlObjectStats();
+}
+
+void GlStats::EndFrame()
+{
+	if (!mIsInstalled)
+	{
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(mPublishedMutex);
+		mPublishedFrame = mFrame;
+		mPublishedObjects = mObjectStats;
+	}
+	mFrame = GlFrameStats();
+}
+
+GlFrameStats GlStats::GetFrameStats() const
+{
+	std::lock_guard<std::mutex> lock(mPublishedMutex);
+	return mPublishedFrame;
+}
+
+GlObjectStats GlStats::GetObjectStats() const
+{
+	std::lock_guard<std::mutex> lock(mPublishedMutex);
+	return mPublishedObjects;
+}
+
+void GlStats::AddObject(GlObjectType type, uint32_t name)
+{
+	if (name != 0 && mObjects[(int)type].emplace(name, 0).second)
+	{
+		mObjectStats.counts[(int)type]++;
+	}
+}
+
+void GlStats::RemoveObject(GlObjectType type, uint32_t name)
+{
+	auto it = mObjects[(int)type].find(name);
+	if (it == mObjects[(int)type].end())
+	{
+		return;
+	}
+	mObjectStats.counts[(int)type]--;
+	mObjectStats.bytes[(int)type] -= it->second;
+	mObjects[(int)type].erase(it);
+
+	if (type == GlObjectType::Texture)
+	{
+		uint64_t first = (uint64_t)name << 32;
+		mTextureImages.erase(mTextureImages.lower_bound(first), mTextureImages.lower_bound(first + (1ull << 32)));
+	}
+}
+
+void GlStats::SetObjectBytes(GlObjectType type, uint32_t name, uint64_t bytes)
+{
+	auto it = mObjects[(int)type].find(name);
+	if (it != mObjects[(int)type].end())
+	{
+		mObjectStats.bytes[(int)type] += bytes - it->second;
+		it->second = bytes;
+	}
+}
+
+void GlStats::SetTextureImageBytes(uint32_t name, uint32_t image, uint64_t bytes)
+{
+	auto texture = mObjects[(int)GlObjectType::Texture].find(name);
+	if (texture == mObjects[(int)GlObjectType::Texture].end())
+	{
+		return;
+	}
+	uint64_t& imageBytes = mTextureImages[(uint64_t)name << 32 | image];
+	texture->second += bytes - imageBytes;
+	mObjectStats.bytes[(int)GlObjectType::Texture] += bytes - imageBytes;
+	imageBytes = bytes;
+}
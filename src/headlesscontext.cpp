@@ -0,0 +1,296 @@
+#include "headlesscontext.hpp"
+#include "log.hpp"
+
+#include <cstdint>
+#include <vector>
+
+#ifndef _WIN32
+#include <dlfcn.h>
+#endif
+
+namespace
+{
+	// the few EGL and OSMesa declarations used, their headers are not needed to build
+	using EGLDisplay = void*;
+	using EGLConfig = void*;
+	using EGLContext = void*;
+	using EGLSurface = void*;
+	using EGLint = int32_t;
+	using EGLBoolean = uint32_t;
+	using EGLenum = uint32_t;
+
+	constexpr EGLint EGL_NONE = 0x3038;
+	constexpr EGLint EGL_SURFACE_TYPE = 0x3033;
+	constexpr EGLint EGL_PBUFFER_BIT = 0x0001;
+	constexpr EGLint EGL_RENDERABLE_TYPE = 0x3040;
+	constexpr EGLint EGL_OPENGL_BIT = 0x0008;
+	constexpr EGLenum EGL_OPENGL_API = 0x30A2;
+	constexpr EGLint EGL_CONTEXT_MAJOR_VERSION = 0x3098;
+	constexpr EGLint EGL_CONTEXT_MINOR_VERSION = 0x30FB;
+	constexpr EGLint EGL_CONTEXT_OPENGL_PROFILE_MASK = 0x30FD;
+	constexpr EGLint EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT = 0x0001;
+	constexpr EGLenum EGL_PLATFORM_SURFACELESS_MESA = 0x31DD;
+
+	using OSMesaContext = void*;
+
+	constexpr int OSMESA_FORMAT = 0x22;
+	constexpr int OSMESA_RGBA = 0x1908;
+	constexpr int OSMESA_DEPTH_BITS = 0x30;
+	constexpr int OSMESA_STENCIL_BITS = 0x31;
+	constexpr int OSMESA_PROFILE = 0x33;
+	constexpr int OSMESA_CORE_PROFILE = 0x34;
+	constexpr int OSMESA_CONTEXT_MAJOR_VERSION = 0x36;
+	constexpr int OSMESA_CONTEXT_MINOR_VERSION = 0x37;
+	constexpr uint32_t GL_UNSIGNED_BYTE_TYPE = 0x1401;
+
+	constexpr int OsMesaBufferSize = 1; // never drawn to, everything goes into framebuffer objects
+}
+
+struct HeadlessContext::Library
+{
+	void* handle = nullptr;
+	bool isEgl = false;
+
+	void* (*getProcAddress)(const char*) = nullptr;
+
+	EGLBoolean (*eglInitialize)(EGLDisplay, EGLint*, EGLint*) = nullptr;
+	EGLBoolean (*eglTerminate)(EGLDisplay) = nullptr;
+	EGLBoolean (*eglBindAPI)(EGLenum) = nullptr;
+	EGLBoolean (*eglChooseConfig)(EGLDisplay, const EGLint*, EGLConfig*, EGLint, EGLint*) = nullptr;
+	EGLContext (*eglCreateContext)(EGLDisplay, EGLConfig, EGLContext, const EGLint*) = nullptr;
+	EGLBoolean (*eglDestroyContext)(EGLDisplay, EGLContext) = nullptr;
+	EGLBoolean (*eglMakeCurrent)(EGLDisplay, EGLSurface, EGLSurface, EGLContext) = nullptr;
+	EGLDisplay display = nullptr;
+	EGLContext eglContext = nullptr;
+
+	OSMesaContext (*OSMesaCreateContextAttribs)(const int*, OSMesaContext) = nullptr;
+	void (*OSMesaDestroyContext)(OSMesaContext) = nullptr;
+	unsigned char (*OSMesaMakeCurrent)(OSMesaContext, void*, uint32_t, int, int) = nullptr;
+	OSMesaContext osMesaContext = nullptr;
+	std::vector<uint8_t> osMesaBuffer;
+
+	template<typename T>
+	bool Resolve(T& function, const char* name)
+	{
+#ifndef _WIN32
+		function = reinterpret_cast<T>(dlsym(handle, name));
+#endif
+		return function != nullptr;
+	}
+
+	~Library()
+	{
+#ifndef _WIN32
+		if (handle)
+		{
+			dlclose(handle);
+		}
+#endif
+	}
+};
+
+HeadlessContext::HeadlessContext()
+{
+
+}
+
+HeadlessContext::~HeadlessContext()
+{
+	Destroy();
+}
+
+bool HeadlessContext::Create()
+{
+	Destroy();
+	if (CreateEgl() || CreateOsMesa())
+	{
+		mActiveLibrary = mLibrary.get();
+		LOG("Created headless context on %s", GetBackendName());
+		return true;
+	}
+	LOG("Could not create a headless context, neither EGL nor OSMesa is usable");
+	return false;
+}
+
+void HeadlessContext::Destroy()
+{
+	if (!mLibrary)
+	{
+		return;
+	}
+
+	ReleaseCurrent();
+	Library& library = *mLibrary;
+	if (library.isEgl)
+	{
+		library.eglDestroyContext(library.display, library.eglContext);
+		library.eglTerminate(library.display);
+	}
+	else
+	{
+		library.OSMesaDestroyContext(library.osMesaContext);
+	}
+
+	if (mActiveLibrary == mLibrary.get())
+	{
+		mActiveLibrary = nullptr;
+	}
+	mLibrary.reset();
+}
+
+bool HeadlessContext::MakeCurrent()
+{
+	if (!mLibrary)
+	{
+		return false;
+	}
+	Library& library = *mLibrary;
+	if (library.isEgl)
+	{
+		return library.eglMakeCurrent(library.display, nullptr, nullptr, library.eglContext) != 0;
+	}
+	return library.OSMesaMakeCurrent(library.osMesaContext, library.osMesaBuffer.data(), GL_UNSIGNED_BYTE_TYPE, OsMesaBufferSize, OsMesaBufferSize) != 0;
+}
+
+void HeadlessContext::ReleaseCurrent()
+{
+	if (!mLibrary)
+	{
+		return;
+	}
+	Library& library = *mLibrary;
+	if (library.isEgl)
+	{
+		library.eglMakeCurrent(library.display, nullptr, nullptr, nullptr);
+	}
+	else
+	{
+		library.OSMesaMakeCurrent(nullptr, nullptr, 0, 0, 0);
+	}
+}
+
+const char* HeadlessContext::GetBackendName() const
+{
+	if (!mLibrary)
+	{
+		return "none";
+	}
+	return mLibrary->isEgl ? "EGL" : "OSMesa";
+}
+
+void* HeadlessContext::GetProcAddress(const char* name)
+{
+	return mActiveLibrary ? mActiveLibrary->getProcAddress(name) : nullptr;
+}
+
+#ifdef _WIN32
+bool HeadlessContext::CreateEgl()
+{
+	return false;
+}
+
+bool HeadlessContext::CreateOsMesa()
+{
+	return false;
+}
+#else
+bool HeadlessContext::CreateEgl()
+{
+	auto library = std::make_unique<Library>();
+	library->isEgl = true;
+	library->handle = dlopen("libEGL.so.1", RTLD_NOW | RTLD_LOCAL);
+	if (!library->handle)
+	{
+		return false;
+	}
+
+	void* (*eglGetProcAddress)(const char*) = nullptr;
+	EGLDisplay (*eglGetDisplay)(void*) = nullptr;
+	if (!library->Resolve(eglGetProcAddress, "eglGetProcAddress") || !library->Resolve(eglGetDisplay, "eglGetDisplay") ||
+		!library->Resolve(library->eglInitialize, "eglInitialize") || !library->Resolve(library->eglTerminate, "eglTerminate") ||
+		!library->Resolve(library->eglBindAPI, "eglBindAPI") || !library->Resolve(library->eglChooseConfig, "eglChooseConfig") ||
+		!library->Resolve(library->eglCreateContext, "eglCreateContext") || !library->Resolve(library->eglDestroyContext, "eglDestroyContext") ||
+		!library->Resolve(library->eglMakeCurrent, "eglMakeCurrent"))
+	{
+		return false;
+	}
+	library->getProcAddress = eglGetProcAddress;
+
+	// the surfaceless platform needs no display server at all, the default display is the fallback for other vendors
+	auto eglGetPlatformDisplayEXT = reinterpret_cast<EGLDisplay (*)(EGLenum, void*, const EGLint*)>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+	if (eglGetPlatformDisplayEXT)
+	{
+		library->display = eglGetPlatformDisplayEXT(EGL_PLATFORM_SURFACELESS_MESA, nullptr, nullptr);
+	}
+	if (!library->display || !library->eglInitialize(library->display, nullptr, nullptr))
+	{
+		library->display = eglGetDisplay(nullptr);
+		if (!library->display || !library->eglInitialize(library->display, nullptr, nullptr))
+		{
+			return false;
+		}
+	}
+
+	// configs default to window surfaces, which a surfaceless display has none of
+	const EGLint configAttributes[] = { EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+	const EGLint contextAttributes[] = {
+		EGL_CONTEXT_MAJOR_VERSION, 3,
+		EGL_CONTEXT_MINOR_VERSION, 3,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+	EGLConfig config = nullptr;
+	EGLint configCount = 0;
+	if (!library->eglBindAPI(EGL_OPENGL_API) || !library->eglChooseConfig(library->display, configAttributes, &config, 1, &configCount) || configCount == 0 ||
+		!(library->eglContext = library->eglCreateContext(library->display, config, nullptr, contextAttributes)))
+	{
+		library->eglTerminate(library->display);
+		return false;
+	}
+
+	mLibrary = std::move(library);
+	return true;
+}
+
+bool HeadlessContext::CreateOsMesa()
+{
+	auto library = std::make_unique<Library>();
+	for (const char* name : { "libOSMesa.so.8", "libOSMesa.so.6", "libOSMesa.so" })
+	{
+		library->handle = dlopen(name, RTLD_NOW | RTLD_LOCAL);
+		if (library->handle)
+		{
+			break;
+		}
+	}
+	if (!library->handle)
+	{
+		return false;
+	}
+
+	if (!library->Resolve(library->getProcAddress, "OSMesaGetProcAddress") || !library->Resolve(library->OSMesaCreateContextAttribs, "OSMesaCreateContextAttribs") ||
+		!library->Resolve(library->OSMesaDestroyContext, "OSMesaDestroyContext") || !library->Resolve(library->OSMesaMakeCurrent, "OSMesaMakeCurrent"))
+	{
+		return false;
+	}
+
+	const int attributes[] = {
+		OSMESA_FORMAT, OSMESA_RGBA,
+		OSMESA_DEPTH_BITS, 24,
+		OSMESA_STENCIL_BITS, 8,
+		OSMESA_PROFILE, OSMESA_CORE_PROFILE,
+		OSMESA_CONTEXT_MAJOR_VERSION, 3,
+		OSMESA_CONTEXT_MINOR_VERSION, 3,
+		0
+	};
+	library->osMesaContext = library->OSMesaCreateContextAttribs(attributes, nullptr);
+	if (!library->osMesaContext)
+	{
+		return false;
+	}
+	library->osMesaBuffer.resize(OsMesaBufferSize * OsMesaBufferSize * 4);
+
+	mLibrary = std::move(library);
+	return true;
+}
+#endif
@@ -0,0 +1,548 @@
+#include "imageexport.hpp"
+#include "threadpool.hpp"
+#include "log.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+
+namespace
+{
+	constexpr uint32_t DeflateWindow = 32768;
+	constexpr uint32_t MinMatch = 3;
+	constexpr uint32_t MaxMatch = 258;
+	constexpr uint32_t HashBits = 15;
+	constexpr uint32_t MaxChainLength = 16; // candidates tried per position, more packs tighter and runs slower
+
+	constexpr uint16_t LengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	constexpr uint8_t LengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	constexpr uint16_t DistanceBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+	constexpr uint8_t DistanceExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+	const std::array<uint32_t, 256>& GetCrcTable()
+	{
+		static const std::array<uint32_t, 256> table = []() {
+			std::array<uint32_t, 256> table;
+			for (uint32_t i = 0; i < 256; i++)
+			{
+				uint32_t c = i;
+				for (int k = 0; k < 8; k++)
+				{
+					c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+				}
+				table[i] = c;
+			}
+			return table;
+		}();
+		return table;
+	}
+
+	uint32_t Crc32(const uint8_t* data, size_t size, uint32_t crc = 0)
+	{
+		const auto& table = GetCrcTable();
+		crc = ~crc;
+		for (size_t i = 0; i < size; i++)
+		{
+			crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+		}
+		return ~crc;
+	}
+
+	uint32_t Adler32(const uint8_t* data, size_t size)
+	{
+		uint32_t a = 1, b = 0;
+		while (size > 0)
+		{
+			size_t block = std::min<size_t>(size, 5552); // sums stay below 2^32 before the modulo
+			for (size_t i = 0; i < block; i++)
+			{
+				a += data[i];
+				b += a;
+			}
+			a %= 65521;
+			b %= 65521;
+			data += block;
+			size -= block;
+		}
+		return b << 16 | a;
+	}
+
+	// Deflate writes bits from the least significant end, Huffman codes go in most significant bit first
+	class BitWriter
+	{
+	public:
+		explicit BitWriter(std::vector<uint8_t>& out) : mOut(out), mBits(0), mCount(0) {}
+
+		void Write(uint32_t bits, uint32_t count)
+		{
+			mBits |= (uint64_t)bits << mCount;
+			mCount += count;
+			while (mCount >= 8)
+			{
+				mOut.push_back((uint8_t)mBits);
+				mBits >>= 8;
+				mCount -= 8;
+			}
+		}
+
+		void WriteCode(uint32_t code, uint32_t length)
+		{
+			uint32_t reversed = 0;
+			for (uint32_t i = 0; i < length; i++)
+			{
+				reversed |= ((code >> i) & 1) << (length - 1 - i);
+			}
+			Write(reversed, length);
+		}
+
+		void Flush()
+		{
+			if (mCount > 0)
+			{
+				mOut.push_back((uint8_t)mBits);
+			}
+			mBits = 0;
+			mCount = 0;
+		}
+
+	private:
+		std::vector<uint8_t>& mOut;
+		uint64_t mBits;
+		uint32_t mCount;
+	};
+
+	// the fixed literal/length code of RFC 1951 3.2.6
+	void WriteLiteralLength(BitWriter& bits, uint32_t symbol)
+	{
+		if (symbol < 144)
+		{
+			bits.WriteCode(0x30 + symbol, 8);
+		}
+		else if (symbol < 256)
+		{
+			bits.WriteCode(0x190 + symbol - 144, 9);
+		}
+		else if (symbol < 280)
+		{
+			bits.WriteCode(symbol - 256, 7);
+		}
+		else
+		{
+			bits.WriteCode(0xC0 + symbol - 280, 8);
+		}
+	}
+
+	void WriteMatch(BitWriter& bits, uint32_t length, uint32_t distance)
+	{
+		uint32_t lengthCode = (uint32_t)(std::upper_bound(std::begin(LengthBase), std::end(LengthBase), length) - std::begin(LengthBase)) - 1;
+		WriteLiteralLength(bits, 257 + lengthCode);
+		bits.Write(length - LengthBase[lengthCode], LengthExtra[lengthCode]);
+
+		uint32_t distanceCode = (uint32_t)(std::upper_bound(std::begin(DistanceBase), std::end(DistanceBase), distance) - std::begin(DistanceBase)) - 1;
+		bits.WriteCode(distanceCode, 5);
+		bits.Write(distance - DistanceBase[distanceCode], DistanceExtra[distanceCode]);
+	}
+
+	// zlib stream of one block with the fixed codes, matches found greedily through hash chains. Renders are mostly
+	// flat color after filtering, a dynamic code would gain little over this.
+	void Deflate(const std::vector<uint8_t>& data, std::vector<uint8_t>& out)
+	{
+		out.push_back(0x78);
+		out.push_back(0x01);
+
+		BitWriter bits(out);
+		bits.Write(1, 1); // last block
+		bits.Write(1, 2); // fixed codes
+
+		std::vector<int32_t> head(1 << HashBits, -1);
+		std::vector<int32_t> previous(DeflateWindow, -1);
+		auto hash = [&data](size_t i) { return ((data[i] << 10) ^ (data[i + 1] << 5) ^ data[i + 2]) & ((1 << HashBits) - 1); };
+		auto insert = [&](size_t i) {
+			uint32_t h = hash(i);
+			previous[i % DeflateWindow] = head[h];
+			head[h] = (int32_t)i;
+		};
+
+		size_t size = data.size();
+		size_t i = 0;
+		while (i < size)
+		{
+			uint32_t bestLength = 0, bestDistance = 0;
+			if (i + MinMatch <= size)
+			{
+				uint32_t maxLength = (uint32_t)std::min<size_t>(MaxMatch, size - i);
+				int32_t candidate = head[hash(i)];
+				for (uint32_t chain = 0; candidate >= 0 && i - candidate <= DeflateWindow && chain < MaxChainLength; chain++)
+				{
+					uint32_t length = 0;
+					while (length < maxLength && data[candidate + length] == data[i + length])
+					{
+						length++;
+					}
+					if (length > bestLength)
+					{
+						bestLength = length;
+						bestDistance = (uint32_t)(i - candidate);
+						if (length == maxLength)
+						{
+							break;
+						}
+					}
+					candidate = previous[candidate % DeflateWindow];
+				}
+			}
+
+			if (bestLength >= MinMatch)
+			{
+				WriteMatch(bits, bestLength, bestDistance);
+				for (size_t end = i + bestLength; i < end; i++)
+				{
+					if (i + MinMatch <= size)
+					{
+						insert(i);
+					}
+				}
+			}
+			else
+			{
+				if (i + MinMatch <= size)
+				{
+					insert(i);
+				}
+				WriteLiteralLength(bits, data[i]);
+				i++;
+			}
+		}
+		WriteLiteralLength(bits, 256);
+		bits.Flush();
+
+		uint32_t adler = Adler32(data.data(), data.size());
+		for (int shift = 24; shift >= 0; shift -= 8)
+		{
+			out.push_back((uint8_t)(adler >> shift));
+		}
+	}
+
+	uint8_t Paeth(uint8_t a, uint8_t b, uint8_t c)
+	{
+		int p = a + b - c;
+		int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+		return pa <= pb && pa <= pc ? a : pb <= pc ? b : c;
+	}
+
+	// Each row gets the filter whose output has the smallest sum of magnitudes, the usual heuristic
+	void FilterRows(const ImageRgba8& image, std::vector<uint8_t>& filtered)
+	{
+		size_t stride = (size_t)image.width * 4;
+		filtered.resize((stride + 1) * image.height);
+		std::vector<uint8_t> zeroRow(stride, 0);
+		std::array<std::vector<uint8_t>, 5> candidates;
+		for (auto& candidate : candidates)
+		{
+			candidate.resize(stride);
+		}
+
+		for (uint32_t y = 0; y < image.height; y++)
+		{
+			const uint8_t* row = image.pixels.data() + y * stride;
+			const uint8_t* above = y > 0 ? row - stride : zeroRow.data();
+			uint64_t bestSum = UINT64_MAX;
+			uint32_t bestFilter = 0;
+			for (uint32_t filter = 0; filter < 5; filter++)
+			{
+				uint8_t* out = candidates[filter].data();
+				uint64_t sum = 0;
+				for (size_t x = 0; x < stride; x++)
+				{
+					uint8_t left = x >= 4 ? row[x - 4] : 0;
+					uint8_t upLeft = x >= 4 ? above[x - 4] : 0;
+					uint8_t predicted = 0;
+					switch (filter)
+					{
+					case 1: predicted = left; break;
+					case 2: predicted = above[x]; break;
+					case 3: predicted = (uint8_t)((left + above[x]) / 2); break;
+					case 4: predicted = Paeth(left, above[x], upLeft); break;
+					}
+					out[x] = (uint8_t)(row[x] - predicted);
+					sum += (int8_t)out[x] < 0 ? -(int8_t)out[x] : out[x];
+				}
+				if (sum < bestSum)
+				{
+					bestSum = sum;
+					bestFilter = filter;
+				}
+			}
+
+			uint8_t* destination = filtered.data() + y * (stride + 1);
+			destination[0] = (uint8_t)bestFilter;
+			std::memcpy(destination + 1, candidates[bestFilter].data(), stride);
+		}
+	}
+
+	void AppendUint32(std::vector<uint8_t>& out, uint32_t value)
+	{
+		for (int shift = 24; shift >= 0; shift -= 8)
+		{
+			out.push_back((uint8_t)(value >> shift));
+		}
+	}
+
+	void AppendChunk(std::vector<uint8_t>& out, const char* type, const std::vector<uint8_t>& data)
+	{
+		AppendUint32(out, (uint32_t)data.size());
+		size_t start = out.size();
+		out.insert(out.end(), type, type + 4);
+		out.insert(out.end(), data.begin(), data.end());
+		AppendUint32(out, Crc32(out.data() + start, out.size() - start));
+	}
+
+	uint16_t FloatToHalf(float value)
+	{
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		uint32_t sign = (bits >> 16) & 0x8000;
+		int32_t exponent = (int32_t)((bits >> 23) & 0xFF) - 127 + 15;
+		uint32_t mantissa = bits & 0x7FFFFF;
+		if (exponent <= 0)
+		{
+			if (exponent < -10)
+			{
+				return (uint16_t)sign;
+			}
+			mantissa |= 0x800000;
+			uint32_t shift = 14 - exponent;
+			return (uint16_t)(sign | ((mantissa + (1u << (shift - 1))) >> shift));
+		}
+		if (exponent >= 31)
+		{
+			return (uint16_t)(sign | 0x7C00);
+		}
+		uint32_t half = sign | (exponent << 10) | (mantissa >> 13);
+		return (uint16_t)(half + ((mantissa >> 12) & 1)); // rounds, a carry moves into the exponent as it should
+	}
+
+	template<typename T>
+	void AppendLittleEndian(std::vector<uint8_t>& out, T value)
+	{
+		size_t n = out.size();
+		out.resize(n + sizeof(T));
+		std::memcpy(out.data() + n, &value, sizeof(T)); // every platform built for is little endian
+	}
+
+	void AppendExrAttribute(std::vector<uint8_t>& out, const char* name, const char* type, const std::vector<uint8_t>& value)
+	{
+		out.insert(out.end(), name, name + strlen(name) + 1);
+		out.insert(out.end(), type, type + strlen(type) + 1);
+		AppendLittleEndian(out, (int32_t)value.size());
+		out.insert(out.end(), value.begin(), value.end());
+	}
+
+	bool WriteFile(const std::string& path, const uint8_t* data, size_t size)
+	{
+		std::error_code ec;
+		std::filesystem::path parent = std::filesystem::path(path).parent_path();
+		if (!parent.empty())
+		{
+			std::filesystem::create_directories(parent, ec);
+		}
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		file.write((const char*)data, size);
+		return (bool)file;
+	}
+}
+
+bool WritePng(const std::string& path, const ImageRgba8& image)
+{
+	std::vector<uint8_t> filtered;
+	FilterRows(image, filtered);
+
+	std::vector<uint8_t> header;
+	AppendUint32(header, image.width);
+	AppendUint32(header, image.height);
+	header.insert(header.end(), { 8, 6, 0, 0, 0 }); // 8 bits, RGBA, deflate, adaptive filters, no interlace
+
+	std::vector<uint8_t> compressed;
+	compressed.reserve(filtered.size() / 4);
+	Deflate(filtered, compressed);
+
+	static const uint8_t signature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	std::vector<uint8_t> png(std::begin(signature), std::end(signature));
+	AppendChunk(png, "IHDR", header);
+	AppendChunk(png, "IDAT", compressed);
+	AppendChunk(png, "IEND", {});
+	return WriteFile(path, png.data(), png.size());
+}
+
+bool WriteExr(const std::string& path, const ImageRgba8& image)
+{
+	// linear values of the 8 bit sRGB levels, alpha stays linear
+	std::array<uint16_t, 256> linear, alpha;
+	for (uint32_t i = 0; i < 256; i++)
+	{
+		float c = i / 255.0f;
+		linear[i] = FloatToHalf(c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f));
+		alpha[i] = FloatToHalf(c);
+	}
+
+	std::vector<uint8_t> exr = { 0x76, 0x2F, 0x31, 0x01, 2, 0, 0, 0 }; // magic, version 2 with single part scanlines
+
+	std::vector<uint8_t> channels;
+	for (const char* name : { "A", "B", "G", "R" }) // sorted by name, as the format wants
+	{
+		channels.push_back((uint8_t)name[0]);
+		channels.push_back(0);
+		AppendLittleEndian(channels, (int32_t)1); // half
+		channels.insert(channels.end(), { 0, 0, 0, 0 }); // not perceptually linear, reserved
+		AppendLittleEndian(channels, (int32_t)1);
+		AppendLittleEndian(channels, (int32_t)1);
+	}
+	channels.push_back(0);
+
+	std::vector<uint8_t> box;
+	for (int32_t value : { 0, 0, (int32_t)image.width - 1, (int32_t)image.height - 1 })
+	{
+		AppendLittleEndian(box, value);
+	}
+	std::vector<uint8_t> one, center;
+	AppendLittleEndian(one, 1.0f);
+	AppendLittleEndian(center, 0.0f);
+	AppendLittleEndian(center, 0.0f);
+
+	AppendExrAttribute(exr, "channels", "chlist", channels);
+	AppendExrAttribute(exr, "compression", "compression", { 0 });
+	AppendExrAttribute(exr, "dataWindow", "box2i", box);
+	AppendExrAttribute(exr, "displayWindow", "box2i", box);
+	AppendExrAttribute(exr, "lineOrder", "lineOrder", { 0 });
+	AppendExrAttribute(exr, "pixelAspectRatio", "float", one);
+	AppendExrAttribute(exr, "screenWindowCenter", "v2f", center);
+	AppendExrAttribute(exr, "screenWindowWidth", "float", one);
+	exr.push_back(0);
+
+	// uncompressed, every block is one scanline: y, size, then each channel's halves in turn
+	uint32_t lineSize = image.width * 4 * sizeof(uint16_t);
+	uint64_t offset = exr.size() + (uint64_t)image.height * sizeof(uint64_t);
+	for (uint32_t y = 0; y < image.height; y++)
+	{
+		AppendLittleEndian(exr, offset + (uint64_t)y * (8 + lineSize));
+	}
+	for (uint32_t y = 0; y < image.height; y++)
+	{
+		AppendLittleEndian(exr, (int32_t)y);
+		AppendLittleEndian(exr, (int32_t)lineSize);
+		const uint8_t* row = image.pixels.data() + (size_t)y * image.width * 4;
+		for (uint32_t channel : { 3, 2, 1, 0 })
+		{
+			const auto& table = channel == 3 ? alpha : linear;
+			for (uint32_t x = 0; x < image.width; x++)
+			{
+				AppendLittleEndian(exr, table[row[x * 4 + channel]]);
+			}
+		}
+	}
+	return WriteFile(path, exr.data(), exr.size());
+}
+
+bool WritePpm(const std::string& path, const ImageRgba8& image)
+{
+	std::string header = "P6\n" + std::to_string(image.width) + " " + std::to_string(image.height) + "\n255\n";
+	std::vector<uint8_t> ppm(header.begin(), header.end());
+	ppm.reserve(ppm.size() + (size_t)image.width * image.height * 3);
+	for (size_t i = 0; i < image.pixels.size(); i += 4)
+	{
+		ppm.insert(ppm.end(), image.pixels.begin() + i, image.pixels.begin() + i + 3);
+	}
+	return WriteFile(path, ppm.data(), ppm.size());
+}
+
+bool WriteImage(const std::string& path, const ImageRgba8& image)
+{
+	std::string extension = std::filesystem::path(path).extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return (char)std::tolower((unsigned char)c); });
+	if (extension == ".png")
+	{
+		return WritePng(path, image);
+	}
+	if (extension == ".exr")
+	{
+		return WriteExr(path, image);
+	}
+	if (extension == ".ppm")
+	{
+		return WritePpm(path, image);
+	}
+	LOG("Unknown image format %s, use .png, .exr or .ppm", extension.c_str());
+	return false;
+}
+
+std::string FormatSequencePath(const std::string& pattern, uint32_t index)
+{
+	size_t end = pattern.find_last_of('#');
+	if (end == std::string::npos)
+	{
+		std::filesystem::path path(pattern);
+		std::string stem = path.stem().string() + "-####" + path.extension().string();
+		return FormatSequencePath((path.parent_path() / stem).string(), index);
+	}
+	size_t begin = pattern.find_last_not_of('#', end);
+	begin = begin == std::string::npos ? 0 : begin + 1;
+
+	std::string number = std::to_string(index);
+	if (number.size() < end + 1 - begin)
+	{
+		number.insert(0, end + 1 - begin - number.size(), '0');
+	}
+	return pattern.substr(0, begin) + number + pattern.substr(end + 1);
+}
+
+ImageExporter::ImageExporter(uint32_t maxInFlight)
+	: mMaxInFlight(std::max(maxInFlight, 1u))
+	, mInFlight(0)
+	, mWritten(0)
+	, mFailed(0)
+{
+
+}
+
+ImageExporter::~ImageExporter()
+{
+	WaitIdle();
+}
+
+void ImageExporter::Write(std::string path, ImageRgba8&& image)
+{
+	mInFlight++;
+	auto shared = std::make_shared<ImageRgba8>(std::move(image));
+	ThreadPool::Get().Submit([this, path = std::move(path), shared]() {
+		if (WriteImage(path, *shared))
+		{
+			mWritten++;
+		}
+		else
+		{
+			LOG("Could not write %s", path.c_str());
+			mFailed++;
+		}
+
+		std::lock_guard<std::mutex> lock(mMutex);
+		mInFlight--;
+		mImageDone.notify_all();
+	});
+}
+
+void ImageExporter::WaitIdle()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	mImageDone.wait(lock, [this]() { return mInFlight.load() == 0; });
+}
+
+void ImageExporter::WaitForRoom()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	mImageDone.wait(lock, [this]() { return mInFlight.load() < mMaxInFlight; });
+}
@@ -0,0 +1,290 @@
+#include "inputrecording.hpp"
+#include "mappedfile.hpp"
+#include "log.hpp"
+
+#include <cstring>
+#include <filesystem>
+
+namespace
+{
+	constexpr char RecordingMagic[4] = { 'M', 'M', '3', 'R' };
+	constexpr size_t FlushSize = 64 << 10;
+
+	template<typename T>
+	void Write(std::vector<uint8_t>& out, const T& value)
+	{
+		size_t n = out.size();
+		out.resize(n + sizeof(T));
+		memcpy(out.data() + n, &value, sizeof(T));
+	}
+
+	void WriteVarint(std::vector<uint8_t>& out, uint64_t value)
+	{
+		while (value >= 0x80)
+		{
+			out.push_back((uint8_t)(value | 0x80));
+			value >>= 7;
+		}
+		out.push_back((uint8_t)value);
+	}
+
+	class EventReader
+	{
+	public:
+		EventReader(const uint8_t* data, size_t size)
+			: mData(data)
+			, mSize(size)
+			, mPos(0)
+		{
+
+		}
+
+		template<typename T>
+		bool Read(T& value)
+		{
+			if (mSize - mPos < sizeof(T))
+			{
+				return false;
+			}
+			memcpy(&value, mData + mPos, sizeof(T));
+			mPos += sizeof(T);
+			return true;
+		}
+
+		bool ReadVarint(uint64_t& value)
+		{
+			value = 0;
+			for (uint32_t shift = 0; shift < 64 && mPos < mSize; shift += 7)
+			{
+				uint8_t byte = mData[mPos++];
+				value |= (uint64_t)(byte & 0x7F) << shift;
+				if (!(byte & 0x80))
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+
+		bool ReadEdit(JournalRecord& record)
+		{
+			size_t size = EditJournal::Decode(mData + mPos, mSize - mPos, record);
+			mPos += size;
+			return size > 0;
+		}
+
+		bool IsAtEnd() const { return mPos == mSize; }
+
+	private:
+		const uint8_t* mData;
+		size_t mSize;
+		size_t mPos;
+	};
+}
+
+InputRecorder::InputRecorder()
+	: mFile(nullptr)
+	, mLastMicroseconds(0)
+	, mLastKeys(~0u)
+	, mLastCameraMode(~0u)
+	, mEventCount(0)
+{
+
+}
+
+InputRecorder::~InputRecorder()
+{
+	Close();
+}
+
+bool InputRecorder::Open(const std::string& path, const InputRecordingStart& start)
+{
+	Close();
+	std::error_code ec;
+	std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+	mFile = fopen(path.c_str(), "wb");
+	if (!mFile)
+	{
+		LOG("Could not open input recording %s", path.c_str());
+		return false;
+	}
+
+	mPath = path;
+	mStart = std::chrono::steady_clock::now();
+	mLastMicroseconds = 0;
+	mLastKeys = ~0u; // the first states are always written
+	mLastCameraMode = ~0u;
+	mEventCount = 0;
+	mBuffer.clear();
+	Write(mBuffer, RecordingMagic);
+	Write(mBuffer, InputRecordingVersion);
+	Write(mBuffer, start);
+	return true;
+}
+
+void InputRecorder::Close()
+{
+	if (!mFile)
+	{
+		return;
+	}
+
+	InputEvent end;
+	end.type = InputEventType::End;
+	Record(end);
+	Flush();
+	if (ferror(mFile))
+	{
+		LOG("Could not write input recording %s", mPath.c_str());
+	}
+	else
+	{
+		LOG("Recorded %u input events over %.1f s to %s", mEventCount, GetTime(), mPath.c_str());
+	}
+	fclose(mFile);
+	mFile = nullptr;
+}
+
+double InputRecorder::GetTime() const
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - mStart).count();
+}
+
+void InputRecorder::Record(const InputEvent& event)
+{
+	if (!mFile)
+	{
+		return;
+	}
+
+	if (event.type == InputEventType::Keys || event.type == InputEventType::CameraMode)
+	{
+		uint32_t& last = event.type == InputEventType::Keys ? mLastKeys : mLastCameraMode;
+		if (event.bits == last)
+		{
+			return;
+		}
+		last = event.bits;
+	}
+
+	uint64_t microseconds = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - mStart).count();
+	Write(mBuffer, event.type);
+	WriteVarint(mBuffer, microseconds - mLastMicroseconds);
+	mLastMicroseconds = microseconds;
+
+	switch (event.type)
+	{
+	case InputEventType::Keys:
+	case InputEventType::CameraMode:
+		WriteVarint(mBuffer, event.bits);
+		break;
+	case InputEventType::MouseMove:
+		Write(mBuffer, event.value);
+		break;
+	case InputEventType::Scroll:
+		Write(mBuffer, event.value.y);
+		break;
+	case InputEventType::Edit:
+		EditJournal::Encode(event.edit, mBuffer);
+		break;
+	case InputEventType::End:
+		break;
+	}
+	mEventCount++;
+
+	if (mBuffer.size() >= FlushSize)
+	{
+		Flush();
+	}
+}
+
+void InputRecorder::Flush()
+{
+	fwrite(mBuffer.data(), 1, mBuffer.size(), mFile);
+	mBuffer.clear();
+}
+
+bool InputReplay::Open(const std::string& path)
+{
+	MappedFile file;
+	if (!std::filesystem::exists(path) || !file.Open(path))
+	{
+		LOG("Could not open input recording %s", path.c_str());
+		return false;
+	}
+
+	EventReader reader(file.GetData(), file.GetSize());
+	char magic[4];
+	uint32_t version = 0;
+	if (!reader.Read(magic) || memcmp(magic, RecordingMagic, sizeof(magic)) != 0 || !reader.Read(version) || version != InputRecordingVersion || !reader.Read(mStart))
+	{
+		LOG("%s is not an input recording of version %u", path.c_str(), InputRecordingVersion);
+		return false;
+	}
+
+	mEvents.clear();
+	mNext = 0;
+	mTime = 0.0;
+	uint64_t microseconds = 0;
+	while (!reader.IsAtEnd())
+	{
+		InputEvent event;
+		uint64_t delta = 0, bits = 0;
+		if (!reader.Read(event.type) || !reader.ReadVarint(delta))
+		{
+			break;
+		}
+		microseconds += delta;
+		event.time = microseconds / 1e6;
+
+		bool isRead = true;
+		switch (event.type)
+		{
+		case InputEventType::Keys:
+		case InputEventType::CameraMode:
+			isRead = reader.ReadVarint(bits);
+			event.bits = (uint32_t)bits;
+			break;
+		case InputEventType::MouseMove:
+			isRead = reader.Read(event.value);
+			break;
+		case InputEventType::Scroll:
+			isRead = reader.Read(event.value.y);
+			break;
+		case InputEventType::Edit:
+			isRead = reader.ReadEdit(event.edit);
+			break;
+		case InputEventType::End:
+			break;
+		default:
+			isRead = false;
+			break;
+		}
+		if (!isRead)
+		{
+			break;
+		}
+		mEvents.push_back(std::move(event));
+		if (mEvents.back().type == InputEventType::End)
+		{
+			break;
+		}
+	}
+
+	// a recording cut short by a crash still plays up to its last whole event
+	if (mEvents.empty() || mEvents.back().type != InputEventType::End)
+	{
+		LOG("Input recording %s ends early, playing its first %zu events", path.c_str(), mEvents.size());
+	}
+	LOG("Opened input recording %s: %zu events over %.1f s", path.c_str(), mEvents.size(), GetDuration());
+	return true;
+}
+
+void InputReplay::Advance(double deltaTime, const std::function<void(const InputEvent&)>& fn)
+{
+	while (mNext < mEvents.size() && mEvents[mNext].time <= mTime)
+	{
+		fn(mEvents[mNext++]);
+	}
+	mTime += deltaTime;
+}
@@ -0,0 +1,337 @@
+#include "json.hpp"
+
+#include <charconv>
+
+class JsonParser
+{
+public:
+	JsonParser(std::string_view text)
+		: mText(text)
+		, mPos(0)
+	{
+
+	}
+
+	bool Parse(JsonValue& out)
+	{
+		if (!ParseValue(out, 0))
+		{
+			return false;
+		}
+		SkipWhitespace();
+		return mPos == mText.size() || Fail("Unexpected trailing characters");
+	}
+
+	const std::string& GetError() const { return mError; }
+
+private:
+	static constexpr int MaxDepth = 256;
+
+	bool Fail(const char* msg)
+	{
+		if (mError.empty())
+		{
+			mError = std::string(msg) + " at offset " + std::to_string(mPos);
+		}
+		return false;
+	}
+
+	void SkipWhitespace()
+	{
+		while (mPos < mText.size() && (mText[mPos] == ' ' || mText[mPos] == '\t' || mText[mPos] == '\n' || mText[mPos] == '\r'))
+		{
+			mPos++;
+		}
+	}
+
+	bool Consume(std::string_view literal)
+	{
+		if (mText.substr(mPos, literal.size()) != literal)
+		{
+			return false;
+		}
+		mPos += literal.size();
+		return true;
+	}
+
+	bool ParseValue(JsonValue& out, int depth)
+	{
+		if (depth > MaxDepth)
+		{
+			return Fail("Nesting too deep");
+		}
+
+		SkipWhitespace();
+		if (mPos >= mText.size())
+		{
+			return Fail("Unexpected end of input");
+		}
+
+		char c = mText[mPos];
+		if (c == '{') return ParseObject(out, depth);
+		if (c == '[') return ParseArray(out, depth);
+		if (c == '"')
+		{
+			out.mType = JsonType::String;
+			return ParseString(out.mString);
+		}
+		if (Consume("true"))
+		{
+			out.mType = JsonType::Bool;
+			out.mBool = true;
+			return true;
+		}
+		if (Consume("false"))
+		{
+			out.mType = JsonType::Bool;
+			out.mBool = false;
+			return true;
+		}
+		if (Consume("null"))
+		{
+			out.mType = JsonType::Null;
+			return true;
+		}
+
+		const char* begin = mText.data() + mPos;
+		const char* end = mText.data() + mText.size();
+		if (*begin == '+')
+		{
+			return Fail("Invalid number");
+		}
+		auto result = std::from_chars(begin, end, out.mNumber);
+		if (result.ec != std::errc())
+		{
+			return Fail("Invalid value");
+		}
+		out.mType = JsonType::Number;
+		mPos += result.ptr - begin;
+		return true;
+	}
+
+	bool ParseObject(JsonValue& out, int depth)
+	{
+		out.mType = JsonType::Object;
+		mPos++;
+
+		SkipWhitespace();
+		if (mPos < mText.size() && mText[mPos] == '}')
+		{
+			mPos++;
+			return true;
+		}
+
+		while (true)
+		{
+			SkipWhitespace();
+			if (mPos >= mText.size() || mText[mPos] != '"')
+			{
+				return Fail("Expected object key");
+			}
+
+			out.mMembers.emplace_back();
+			auto& member = out.mMembers.back();
+			if (!ParseString(member.first))
+			{
+				return false;
+			}
+
+			SkipWhitespace();
+			if (mPos >= mText.size() || mText[mPos] != ':')
+			{
+				return Fail("Expected ':'");
+			}
+			mPos++;
+
+			if (!ParseValue(member.second, depth + 1))
+			{
+				return false;
+			}
+
+			SkipWhitespace();
+			if (mPos < mText.size() && mText[mPos] == ',')
+			{
+				mPos++;
+				continue;
+			}
+			if (mPos < mText.size() && mText[mPos] == '}')
+			{
+				mPos++;
+				return true;
+			}
+			return Fail("Expected ',' or '}'");
+		}
+	}
+
+	bool ParseArray(JsonValue& out, int depth)
+	{
+		out.mType = JsonType::Array;
+		mPos++;
+
+		SkipWhitespace();
+		if (mPos < mText.size() && mText[mPos] == ']')
+		{
+			mPos++;
+			return true;
+		}
+
+		while (true)
+		{
+			out.mElements.emplace_back();
+			if (!ParseValue(out.mElements.back(), depth + 1))
+			{
+				return false;
+			}
+
+			SkipWhitespace();
+			if (mPos < mText.size() && mText[mPos] == ',')
+			{
+				mPos++;
+				continue;
+			}
+			if (mPos < mText.size() && mText[mPos] == ']')
+			{
+				mPos++;
+				return true;
+			}
+			return Fail("Expected ',' or ']'");
+		}
+	}
+
+	bool ParseHex4(uint32_t& out)
+	{
+		if (mPos + 4 > mText.size())
+		{
+			return Fail("Truncated unicode escape");
+		}
+		const char* begin = mText.data() + mPos;
+		auto result = std::from_chars(begin, begin + 4, out, 16);
+		if (result.ec != std::errc() || result.ptr != begin + 4)
+		{
+			return Fail("Invalid unicode escape");
+		}
+		mPos += 4;
+		return true;
+	}
+
+	static void AppendUtf8(std::string& str, uint32_t cp)
+	{
+		if (cp < 0x80)
+		{
+			str += (char)cp;
+		}
+		else if (cp < 0x800)
+		{
+			str += (char)(0xC0 | (cp >> 6));
+			str += (char)(0x80 | (cp & 0x3F));
+		}
+		else if (cp < 0x10000)
+		{
+			str += (char)(0xE0 | (cp >> 12));
+			str += (char)(0x80 | ((cp >> 6) & 0x3F));
+			str += (char)(0x80 | (cp & 0x3F));
+		}
+		else
+		{
+			str += (char)(0xF0 | (cp >> 18));
+			str += (char)(0x80 | ((cp >> 12) & 0x3F));
+			str += (char)(0x80 | ((cp >> 6) & 0x3F));
+			str += (char)(0x80 | (cp & 0x3F));
+		}
+	}
+
+	bool ParseString(std::string& out)
+	{
+		mPos++; // opening quote
+		while (mPos < mText.size())
+		{
+			char c = mText[mPos++];
+			if (c == '"')
+			{
+				return true;
+			}
+			if (c != '\\')
+			{
+				out += c;
+				continue;
+			}
+
+			if (mPos >= mText.size())
+			{
+				break;
+			}
+			char esc = mText[mPos++];
+			switch (esc)
+			{
+			case '"': out += '"'; break;
+			case '\\': out += '\\'; break;
+			case '/': out += '/'; break;
+			case 'b': out += '\b'; break;
+			case 'f': out += '\f'; break;
+			case 'n': out += '\n'; break;
+			case 'r': out += '\r'; break;
+			case 't': out += '\t'; break;
+			case 'u':
+			{
+				uint32_t cp = 0;
+				if (!ParseHex4(cp))
+				{
+					return false;
+				}
+				if (cp >= 0xD800 && cp <= 0xDBFF && Consume("\\u"))
+				{
+					uint32_t low = 0;
+					if (!ParseHex4(low))
+					{
+						return false;
+					}
+					cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+				}
+				AppendUtf8(out, cp);
+				break;
+			}
+			default:
+				return Fail("Invalid escape sequence");
+			}
+		}
+		return Fail("Unterminated string");
+	}
+
+private:
+	std::string_view mText;
+	size_t mPos;
+	std::string mError;
+};
+
+const JsonValue& JsonValue::operator[](size_t index) const
+{
+	static const JsonValue null;
+	return index < mElements.size() ? mElements[index] : null;
+}
+
+const JsonValue* JsonValue::Find(std::string_view key) const
+{
+	for (const auto& member : mMembers)
+	{
+		if (member.first == key)
+		{
+			return &member.second;
+		}
+	}
+	return nullptr;
+}
+
+bool ParseJson(std::string_view text, JsonValue& out, std::string* error)
+{
+	JsonParser parser(text);
+	out = JsonValue();
+	if (!parser.Parse(out))
+	{
+		if (error)
+		{
+			*error = parser.GetError();
+		}
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,193 @@
+#include "lz4.hpp"
+
+#include <cstring>
+#include <vector>
+
+namespace
+{
+	constexpr size_t MinMatch = 4;
+	constexpr size_t LastLiterals = 5; // the block always ends in at least this many literals
+	constexpr size_t MatchFindLimit = 12; // no match may start within this many bytes of the end
+	constexpr size_t MaxOffset = 65535;
+	constexpr uint32_t HashLog = 16;
+	constexpr uint32_t EmptySlot = UINT32_MAX;
+
+	inline uint32_t Read32(const uint8_t* p)
+	{
+		uint32_t v;
+		memcpy(&v, p, sizeof(v));
+		return v;
+	}
+
+	inline uint32_t HashSequence(uint32_t sequence)
+	{
+		return (sequence * 2654435761u) >> (32 - HashLog);
+	}
+
+	inline uint8_t* WriteLength(uint8_t* op, size_t length)
+	{
+		while (length >= 255)
+		{
+			*op++ = 255;
+			length -= 255;
+		}
+		*op++ = (uint8_t)length;
+		return op;
+	}
+
+	uint8_t* WriteSequence(uint8_t* op, const uint8_t* literals, size_t literalCount, size_t offset, size_t matchLength)
+	{
+		uint8_t* token = op++;
+		*token = (uint8_t)((literalCount >= 15 ? 15 : literalCount) << 4);
+		if (literalCount >= 15)
+		{
+			op = WriteLength(op, literalCount - 15);
+		}
+		memcpy(op, literals, literalCount);
+		op += literalCount;
+
+		if (matchLength == 0)
+		{
+			return op; // last sequence, literals only
+		}
+
+		*op++ = (uint8_t)(offset & 0xFF);
+		*op++ = (uint8_t)(offset >> 8);
+		size_t length = matchLength - MinMatch;
+		*token |= (uint8_t)(length >= 15 ? 15 : length);
+		if (length >= 15)
+		{
+			op = WriteLength(op, length - 15);
+		}
+		return op;
+	}
+
+	bool ReadLength(const uint8_t*& ip, const uint8_t* end, size_t& length)
+	{
+		uint8_t b;
+		do
+		{
+			if (ip >= end)
+			{
+				return false;
+			}
+			b = *ip++;
+			length += b;
+		} while (b == 255);
+		return true;
+	}
+}
+
+size_t Lz4Compress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity)
+{
+	if (dstCapacity < Lz4CompressBound(srcSize))
+	{
+		return 0;
+	}
+
+	uint8_t* op = dst;
+	size_t anchor = 0;
+	if (srcSize > MatchFindLimit)
+	{
+		std::vector<uint32_t> table((size_t)1 << HashLog, EmptySlot);
+		size_t matchFindLimit = srcSize - MatchFindLimit;
+		size_t matchLimit = srcSize - LastLiterals;
+
+		size_t ip = 0;
+		while (ip < matchFindLimit)
+		{
+			uint32_t sequence = Read32(src + ip);
+			uint32_t& slot = table[HashSequence(sequence)];
+			size_t ref = slot;
+			slot = (uint32_t)ip;
+			if (ref == EmptySlot || ip - ref > MaxOffset || Read32(src + ref) != sequence)
+			{
+				ip++;
+				continue;
+			}
+
+			while (ip > anchor && ref > 0 && src[ip - 1] == src[ref - 1])
+			{
+				ip--;
+				ref--;
+			}
+			size_t length = MinMatch;
+			while (ip + length < matchLimit && src[ip + length] == src[ref + length])
+			{
+				length++;
+			}
+
+			op = WriteSequence(op, src + anchor, ip - anchor, ip - ref, length);
+			ip += length;
+			anchor = ip;
+			if (ip - 2 < matchFindLimit)
+			{
+				table[HashSequence(Read32(src + ip - 2))] = (uint32_t)(ip - 2);
+			}
+		}
+	}
+
+	op = WriteSequence(op, src + anchor, srcSize - anchor, 0, 0);
+	return (size_t)(op - dst);
+}
+
+bool Lz4Decompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize)
+{
+	const uint8_t* ip = src;
+	const uint8_t* ipEnd = src + srcSize;
+	uint8_t* op = dst;
+	uint8_t* opEnd = dst + dstSize;
+
+	while (ip < ipEnd)
+	{
+		uint8_t token = *ip++;
+		size_t literalCount = token >> 4;
+		if (literalCount == 15 && !ReadLength(ip, ipEnd, literalCount))
+		{
+			return false;
+		}
+		if ((size_t)(ipEnd - ip) < literalCount || (size_t)(opEnd - op) < literalCount)
+		{
+			return false;
+		}
+		memcpy(op, ip, literalCount);
+		ip += literalCount;
+		op += literalCount;
+
+		if (ip == ipEnd)
+		{
+			break;
+		}
+
+		if (ipEnd - ip < 2)
+		{
+			return false;
+		}
+		size_t offset = ip[0] | (size_t)ip[1] << 8;
+		ip += 2;
+		if (offset == 0 || offset > (size_t)(op - dst))
+		{
+			return false;
+		}
+
+		size_t length = token & 15;
+		if (length == 15 && !ReadLength(ip, ipEnd, length))
+		{
+			return false;
+		}
+		length += MinMatch;
+		if ((size_t)(opEnd - op) < length)
+		{
+			return false;
+		}
+
+		// byte wise, matches may overlap the bytes they produce
+		const uint8_t* match = op - offset;
+		for (size_t i = 0; i < length; i++)
+		{
+			op[i] = match[i];
+		}
+		op += length;
+	}
+	return op == opEnd;
+}
@@ -1,10 +1,147 @@
 #include "app.hpp"
+#include "vfs.hpp"
+#include "stressscene.hpp"
+#include "log.hpp"
 
-int main()
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+int main(int argc, char** argv)
 {
+	// --pack <output> <directories...> [--no-compress] builds a resource pack and exits
+	if (argc > 1 && strcmp(argv[1], "--pack") == 0)
+	{
+		std::vector<std::string> directories;
+		bool compress = true;
+		for (int i = 3; i < argc; i++)
+		{
+			if (strcmp(argv[i], "--no-compress") == 0)
+			{
+				compress = false;
+			}
+			else
+			{
+				directories.push_back(argv[i]);
+			}
+		}
+		if (argc < 4 || directories.empty())
+		{
+			LOG("Usage: %s --pack <output> <directories...> [--no-compress]", argv[0]);
+			return 1;
+		}
+		return BuildPack(argv[2], directories, compress) ? 0 : 1;
+	}
+
+	// --capture <frames> [path] profiles the first frames after startup
+	// --headless [--frames <count>] [--scene <path>] [--output <image>] [--turntable <frames>] renders without a window and exits,
+	// with a turntable the output is a sequence pattern like renders/turntable-####.png
+	// --headless --replay <recording> [--timings <path>] plays an input recording back and profiles its frames
+	// --record <recording> records input and edits of the session, see App::StartInputRecording
+	// --stress <entities> [--stress-layout grid|random|clustered] [--stress-objects <count>] [--stress-materials <count>]
+	// [--stress-depth <levels>] [--stress-dynamic <ratio>] [--stress-seed <seed>] generates a stress scene once loaded
+	uint32_t captureFrames = 0;
+	std::string capturePath;
+	bool isHeadless = false;
+	std::string recordPath;
+	HeadlessSettings headless;
+	bool isStressScene = false;
+	StressSceneSettings stress;
+	for (int i = 1; i < argc; i++)
+	{
+		bool hasValue = i + 1 < argc;
+		if (strcmp(argv[i], "--capture") == 0 && hasValue)
+		{
+			captureFrames = (uint32_t)std::max(atoi(argv[i + 1]), 0);
+			if (i + 2 < argc && argv[i + 2][0] != '-')
+			{
+				capturePath = argv[i + 2];
+			}
+		}
+		else if (strcmp(argv[i], "--headless") == 0)
+		{
+			isHeadless = true;
+		}
+		else if (strcmp(argv[i], "--frames") == 0 && hasValue)
+		{
+			headless.frameCount = (uint32_t)std::max(atoi(argv[++i]), 1);
+		}
+		else if (strcmp(argv[i], "--scene") == 0 && hasValue)
+		{
+			headless.scenePath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--output") == 0 && hasValue)
+		{
+			headless.outputPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--turntable") == 0 && hasValue)
+		{
+			headless.turntableFrames = (uint32_t)std::max(atoi(argv[++i]), 0);
+		}
+		else if (strcmp(argv[i], "--replay") == 0 && hasValue)
+		{
+			headless.replayPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--timings") == 0 && hasValue)
+		{
+			headless.timingsPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--record") == 0 && hasValue)
+		{
+			recordPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--stress") == 0 && hasValue)
+		{
+			isStressScene = true;
+			stress.entityCount = (uint32_t)std::max(atoi(argv[++i]), 1);
+		}
+		else if (strcmp(argv[i], "--stress-layout") == 0 && hasValue)
+		{
+			if (!ParseStressLayout(argv[++i], stress.layout))
+			{
+				LOG("Unknown stress layout %s, using %s", argv[i], GetStressLayoutName(stress.layout));
+			}
+		}
+		else if (strcmp(argv[i], "--stress-objects") == 0 && hasValue)
+		{
+			stress.objectCount = (uint32_t)std::max(atoi(argv[++i]), 1);
+		}
+		else if (strcmp(argv[i], "--stress-materials") == 0 && hasValue)
+		{
+			stress.materialCount = (uint32_t)std::max(atoi(argv[++i]), 1);
+		}
+		else if (strcmp(argv[i], "--stress-depth") == 0 && hasValue)
+		{
+			stress.hierarchyDepth = (uint32_t)std::max(atoi(argv[++i]), 1);
+		}
+		else if (strcmp(argv[i], "--stress-dynamic") == 0 && hasValue)
+		{
+			stress.dynamicRatio = std::clamp((float)atof(argv[++i]), 0.0f, 1.0f);
+		}
+		else if (strcmp(argv[i], "--stress-seed") == 0 && hasValue)
+		{
+			stress.seed = strtoull(argv[++i], nullptr, 10);
+		}
+	}
+
 	App myApp;
-	if (myApp.Initialize())
+	bool isInitialized = isHeadless ? myApp.InitializeHeadless(headless) : myApp.Initialize();
+	if (isInitialized)
 	{
+		if (captureFrames > 0)
+		{
+			myApp.StartProfileCapture(captureFrames, capturePath);
+		}
+		if (!recordPath.empty())
+		{
+			myApp.StartInputRecording(recordPath);
+		}
+		if (isStressScene)
+		{
+			myApp.GenerateStressScene(stress);
+		}
 		while(myApp.IsRunning())
 		{
 			myApp.Update();
@@ -12,5 +149,5 @@ int main()
 		}
 		myApp.Shutdown();
 	}
-	return 0;
-}
\ No newline at end of file
+	return isInitialized ? 0 : 1;
+}
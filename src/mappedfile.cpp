@@ -0,0 +1,138 @@
+#include "mappedfile.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+	: mData(nullptr)
+	, mSize(0)
+	, mIsEmptyFile(false)
+#ifdef _WIN32
+	, mFileHandle(INVALID_HANDLE_VALUE)
+	, mMappingHandle(nullptr)
+#endif
+{
+
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+#ifdef _WIN32
+bool MappedFile::Open(const std::string& path)
+{
+	Close();
+
+	mFileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (mFileHandle == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(mFileHandle, &size))
+	{
+		Close();
+		return false;
+	}
+	mSize = (size_t)size.QuadPart;
+	if (mSize == 0)
+	{
+		mIsEmptyFile = true;
+		return true;
+	}
+
+	mMappingHandle = CreateFileMappingA(mFileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mMappingHandle)
+	{
+		Close();
+		return false;
+	}
+
+	mData = (const uint8_t*)MapViewOfFile(mMappingHandle, FILE_MAP_READ, 0, 0, 0);
+	if (!mData)
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (mData)
+	{
+		UnmapViewOfFile(mData);
+	}
+	if (mMappingHandle)
+	{
+		CloseHandle(mMappingHandle);
+	}
+	if (mFileHandle != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(mFileHandle);
+	}
+	mData = nullptr;
+	mMappingHandle = nullptr;
+	mFileHandle = INVALID_HANDLE_VALUE;
+	mSize = 0;
+	mIsEmptyFile = false;
+}
+#else
+bool MappedFile::Open(const std::string& path)
+{
+	Close();
+
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		return false;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) != 0)
+	{
+		close(fd);
+		return false;
+	}
+	mSize = (size_t)st.st_size;
+	if (mSize == 0)
+	{
+		close(fd);
+		mIsEmptyFile = true;
+		return true;
+	}
+
+	void* data = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd); // the mapping keeps the file alive
+	if (data == MAP_FAILED)
+	{
+		mSize = 0;
+		return false;
+	}
+	madvise(data, mSize, MADV_WILLNEED);
+	mData = (const uint8_t*)data;
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (mData)
+	{
+		munmap((void*)mData, mSize);
+	}
+	mData = nullptr;
+	mSize = 0;
+	mIsEmptyFile = false;
+}
+#endif
@@ -1,7 +1,7 @@
 #include "material.hpp"
 #include "shader.hpp"
 
-Material::Material(std::shared_ptr<Shader> shader, std::shared_ptr<Texture> texture)
+Material::Material(Handle<Shader> shader, Handle<Texture> texture)
 	: mShader(shader)
 	, mTexture(texture)
 {
@@ -22,50 +22,47 @@ Material::Material(const Material& other)
 	mUniformMat4s = other.mUniformMat4s;
 }
 
-void Material::SetShader(std::shared_ptr<Shader> shader)
+void Material::SetShader(Handle<Shader> shader)
 {
-	if (shader)
+	if (shader.IsValid())
 	{
 		mShader = shader;
 	}
 }
 
-void Material::SetTexture(std::shared_ptr<Texture> texture)
+void Material::SetTexture(Handle<Texture> texture)
 {
 	mTexture = texture;
 }
 
-void Material::UpdateShaderUniforms()
+void Material::UpdateShaderUniforms(CommandBuffer& commands, const Shader& shader) const
 {
-	if (mShader)
+	for (const auto& it : mUniformInts)
 	{
-		for (const auto& it : mUniformInts)
-		{
-			mShader->SetUniformInt(it.first, it.second);
-		}
-		for (const auto& it : mUniformFloats)
-		{
-			mShader->SetUniformFloat(it.first, it.second);
-		}
-		for (const auto& it : mUniformFloat2s)
-		{
-			mShader->SetUniformFloat2(it.first, it.second);
-		}
-		for (const auto& it : mUniformFloat3s)
-		{
-			mShader->SetUniformFloat3(it.first, it.second);
-		}
-		for (const auto& it : mUniformFloat4s)
-		{
-			mShader->SetUniformFloat4(it.first, it.second);
-		}
-		for (const auto& it : mUniformMat3s)
-		{
-			mShader->SetUniformMat3(it.first, it.second);
-		}
-		for (const auto& it : mUniformMat4s)
-		{
-			mShader->SetUniformMat4(it.first, it.second);
-		}
+		shader.SetUniformInt(commands, it.first, it.second);
+	}
+	for (const auto& it : mUniformFloats)
+	{
+		shader.SetUniformFloat(commands, it.first, it.second);
+	}
+	for (const auto& it : mUniformFloat2s)
+	{
+		shader.SetUniformFloat2(commands, it.first, it.second);
+	}
+	for (const auto& it : mUniformFloat3s)
+	{
+		shader.SetUniformFloat3(commands, it.first, it.second);
+	}
+	for (const auto& it : mUniformFloat4s)
+	{
+		shader.SetUniformFloat4(commands, it.first, it.second);
+	}
+	for (const auto& it : mUniformMat3s)
+	{
+		shader.SetUniformMat3(commands, it.first, it.second);
+	}
+	for (const auto& it : mUniformMat4s)
+	{
+		shader.SetUniformMat4(commands, it.first, it.second);
 	}
 }
\ No newline at end of file
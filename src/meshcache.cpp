@@ -0,0 +1,392 @@
+#include "meshcache.hpp"
+#include "meshimporter.hpp"
+#include "meshoptimizer.hpp"
+#include "vertex.hpp"
+#include "hash.hpp"
+#include "vfs.hpp"
+#include "log.hpp"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+	constexpr char MeshCacheMagic[4] = { 'M', 'M', '3', 'M' };
+
+	inline uint64_t AlignUp(uint64_t v)
+	{
+		return (v + MeshCacheAlignment - 1) & ~(uint64_t)(MeshCacheAlignment - 1);
+	}
+
+	inline uint32_t EncodeAttribute(const VertexAttribute& attrib)
+	{
+		return attrib.count | (uint32_t)attrib.type << 8 | (attrib.normalized ? 1u : 0u) << 16;
+	}
+
+	inline VertexAttribute DecodeAttribute(uint32_t bits)
+	{
+		return { bits & 0xFF, (VertexAttribType)((bits >> 8) & 0xFF), ((bits >> 16) & 1) != 0 };
+	}
+
+	void WritePadding(std::ofstream& file, uint64_t target)
+	{
+		static const char zeros[MeshCacheAlignment] = {};
+		uint64_t pos = (uint64_t)file.tellp();
+		if (target > pos)
+		{
+			file.write(zeros, target - pos);
+		}
+	}
+}
+
+MeshCache::MeshCache()
+	: mHeader(nullptr)
+{
+
+}
+
+bool MeshCache::Open(const std::string& path, uint64_t sourceHash)
+{
+	if (!Open(path))
+	{
+		return false;
+	}
+	if (mHeader->sourceHash != sourceHash)
+	{
+		mHeader = nullptr;
+		return false;
+	}
+	return true;
+}
+
+bool MeshCache::Open(const std::string& path)
+{
+	mHeader = nullptr;
+	if (!mFile.Open(path))
+	{
+		return false;
+	}
+
+	if (mFile.GetSize() < sizeof(MeshCacheHeader))
+	{
+		LOG("Mesh cache %s is truncated", path.c_str());
+		return false;
+	}
+
+	const MeshCacheHeader* header = (const MeshCacheHeader*)mFile.GetData();
+	if (memcmp(header->magic, MeshCacheMagic, 4) != 0 || header->version != MeshCacheVersion)
+	{
+		return false;
+	}
+
+	// the stride has to be what the layout decodes to, the vertices are uploaded with it
+	bool isLayoutValid = header->attributeCount <= MeshCacheMaxAttributes;
+	uint32_t layoutSize = 0;
+	for (uint32_t i = 0; isLayoutValid && i < header->attributeCount; i++)
+	{
+		VertexAttribute attribute = DecodeAttribute(header->layout[i]);
+		isLayoutValid = attribute.count >= 1 && attribute.count <= 4 && attribute.type <= VertexAttribType::UnsignedByte;
+		layoutSize += attribute.GetSize();
+	}
+
+	uint64_t vertexBytes = (uint64_t)header->vertexCount * header->stride;
+	uint64_t indexBytes = (uint64_t)header->indexCount * header->indexSize;
+	uint64_t lodBytes = (uint64_t)header->lodCount * sizeof(MeshCacheLod);
+	if (header->fileSize != mFile.GetSize() || !isLayoutValid || header->stride != layoutSize
+		|| (header->indexSize != sizeof(uint16_t) && header->indexSize != sizeof(uint32_t))
+		|| header->vertexOffset > header->indexOffset || vertexBytes > header->indexOffset - header->vertexOffset
+		|| header->indexOffset + indexBytes > mFile.GetSize() || header->lodOffset + lodBytes > mFile.GetSize())
+	{
+		LOG("Mesh cache %s is corrupted", path.c_str());
+		return false;
+	}
+
+	mHeader = header;
+
+	// the write time doubles as the last use for TrimMeshCache
+	std::error_code ec;
+	std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), ec);
+	return true;
+}
+
+std::unique_ptr<VertexArray> MeshCache::CreateVertexArray() const
+{
+	std::unique_ptr<VertexArray> va = std::make_unique<VertexArray>();
+	{
+		std::unique_ptr<VertexBuffer> vb = std::make_unique<VertexBuffer>();
+		std::vector<VertexAttribute> layout;
+		for (uint32_t i = 0; i < mHeader->attributeCount; i++)
+		{
+			layout.push_back(DecodeAttribute(mHeader->layout[i]));
+		}
+		vb->SetLayout(layout);
+		vb->Upload(GetVertexData(), mHeader->vertexCount);
+		va->PushBuffer(std::move(vb));
+	}
+	if (mHeader->indexCount > 0 && mHeader->indexSize == sizeof(uint16_t))
+	{
+		va->SetElements((const uint16_t*)GetIndexData(), mHeader->indexCount);
+	}
+	else if (mHeader->indexCount > 0)
+	{
+		va->SetElements((const uint32_t*)GetIndexData(), mHeader->indexCount);
+	}
+	va->SetBounds(glm::make_vec3(mHeader->boundsMin), glm::make_vec3(mHeader->boundsMax));
+	va->Upload();
+	return va;
+}
+
+uint64_t HashMeshSource(const void* data, size_t size)
+{
+	// the version is part of the seed so a format change never picks up stale entries
+	return HashBytes(data, size, MeshCacheVersion);
+}
+
+std::string GetMeshCachePath(const std::string& cacheDirectory, uint64_t sourceHash)
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.mesh", (unsigned long long)sourceHash);
+	return cacheDirectory + "/" + name;
+}
+
+bool WriteMeshCache(const std::string& path, const MeshData& mesh, uint64_t sourceHash)
+{
+	if (mesh.layout.size() > MeshCacheMaxAttributes)
+	{
+		LOG("Mesh layout has too many attributes for the cache");
+		return false;
+	}
+
+	MeshCacheHeader header = {};
+	memcpy(header.magic, MeshCacheMagic, 4);
+	header.version = MeshCacheVersion;
+	header.sourceHash = sourceHash;
+	header.vertexCount = mesh.GetVertexCount();
+	header.indexCount = (uint32_t)mesh.indices.size();
+	header.stride = mesh.GetVertexStride();
+	header.attributeCount = (uint32_t)mesh.layout.size();
+	for (size_t i = 0; i < mesh.layout.size(); i++)
+	{
+		header.layout[i] = EncodeAttribute(mesh.layout[i]);
+	}
+	memcpy(header.boundsMin, &mesh.boundsMin[0], sizeof(header.boundsMin));
+	memcpy(header.boundsMax, &mesh.boundsMax[0], sizeof(header.boundsMax));
+
+	MeshCacheLod lod0 = { 0, header.indexCount, 0.0f, 0 };
+	header.lodCount = 1;
+
+	// meshes addressable with 16 bit indices store them that way, halving the index data
+	std::vector<uint16_t> shortIndices;
+	if (header.vertexCount <= (uint32_t)UINT16_MAX + 1)
+	{
+		shortIndices.assign(mesh.indices.begin(), mesh.indices.end());
+	}
+	header.indexSize = shortIndices.empty() && header.indexCount > 0 ? sizeof(uint32_t) : sizeof(uint16_t);
+	const void* indexData = header.indexSize == sizeof(uint16_t) ? (const void*)shortIndices.data() : (const void*)mesh.indices.data();
+
+	uint64_t vertexBytes = (uint64_t)header.vertexCount * header.stride;
+	uint64_t indexBytes = (uint64_t)header.indexCount * header.indexSize;
+	header.vertexOffset = AlignUp(sizeof(MeshCacheHeader));
+	header.indexOffset = AlignUp(header.vertexOffset + vertexBytes);
+	header.lodOffset = AlignUp(header.indexOffset + indexBytes);
+	header.fileSize = header.lodOffset + header.lodCount * sizeof(MeshCacheLod);
+
+	std::error_code ec;
+	std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+
+	// write next to the target and rename, a crash never leaves a half written entry behind
+	std::string tempPath = path + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file)
+		{
+			LOG("Could not create mesh cache %s", tempPath.c_str());
+			return false;
+		}
+
+		file.write((const char*)&header, sizeof(header));
+		WritePadding(file, header.vertexOffset);
+		file.write((const char*)mesh.vertices.data(), vertexBytes);
+		WritePadding(file, header.indexOffset);
+		file.write((const char*)indexData, indexBytes);
+		WritePadding(file, header.lodOffset);
+		file.write((const char*)&lod0, sizeof(lod0));
+		if (!file)
+		{
+			LOG("Could not write mesh cache %s", tempPath.c_str());
+			return false;
+		}
+	}
+
+	std::filesystem::rename(tempPath, path, ec);
+	if (ec)
+	{
+		LOG("Could not move mesh cache into place: %s", ec.message().c_str());
+		std::filesystem::remove(tempPath, ec);
+		return false;
+	}
+	return true;
+}
+
+uint32_t TrimMeshCache(const std::string& cacheDirectory, uint64_t maxBytes)
+{
+	struct Entry
+	{
+		std::filesystem::path path;
+		uint64_t size;
+		std::filesystem::file_time_type lastUse;
+	};
+
+	std::error_code ec;
+	std::vector<Entry> entries;
+	uint64_t totalBytes = 0;
+	uint32_t removed = 0;
+	for (std::filesystem::directory_iterator it(cacheDirectory, ec), end; !ec && it != end; it.increment(ec))
+	{
+		std::error_code entryError;
+		if (!it->is_regular_file(entryError))
+		{
+			continue;
+		}
+		if (it->path().extension() == ".tmp")
+		{
+			// left behind by a write that never finished
+			removed += std::filesystem::remove(it->path(), entryError);
+			continue;
+		}
+		if (it->path().extension() != ".mesh")
+		{
+			continue;
+		}
+		Entry entry = { it->path(), it->file_size(entryError), it->last_write_time(entryError) };
+		if (!entryError)
+		{
+			totalBytes += entry.size;
+			entries.push_back(std::move(entry));
+		}
+	}
+
+	std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.lastUse < b.lastUse; });
+	for (size_t i = 0; i < entries.size() && totalBytes > maxBytes; i++)
+	{
+		if (std::filesystem::remove(entries[i].path, ec))
+		{
+			totalBytes -= entries[i].size;
+			removed++;
+		}
+	}
+	return removed;
+}
+
+PreparedMesh::PreparedMesh()
+	: mFromCache(false)
+{
+
+}
+
+bool PreparedMesh::Prepare(const std::string& path, const std::string& cacheDirectory, MeshImportStats* stats)
+{
+	auto start = std::chrono::steady_clock::now();
+	mFromCache = false;
+
+	VfsFile source;
+	if (!VirtualFileSystem::Get().Open(path, source))
+	{
+		LOG("Could not open mesh file: %s", path.c_str());
+		return false;
+	}
+
+	uint64_t sourceHash = HashMeshSource(source.GetData(), source.GetSize());
+	mCachePath = GetMeshCachePath(cacheDirectory, sourceHash);
+
+	if (mCache.Open(mCachePath, sourceHash))
+	{
+		if (stats)
+		{
+			stats->bytes = source.GetSize();
+			stats->vertices = mCache.GetHeader().vertexCount;
+			stats->triangles = mCache.GetHeader().indexCount / 3;
+			stats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		}
+		mFromCache = true;
+		return true;
+	}
+
+	if (!ImportMesh(path, (const char*)source.GetData(), source.GetSize(), mMesh, stats))
+	{
+		return false;
+	}
+	source.Close();
+
+	MeshOptimizationStats optimization;
+	if (OptimizeMesh(mMesh, &optimization))
+	{
+		LOG("Optimized %s in %.3fs: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f, %u overdraw clusters", path.c_str(), optimization.seconds,
+			optimization.before.acmr, optimization.after.acmr, optimization.before.atvr, optimization.after.atvr, optimization.clusterCount);
+	}
+
+	MeshQuantizationResult quantization;
+	if (QuantizeMesh(mMesh, {}, &quantization))
+	{
+		LOG("Quantized %s: positions %s (error %g), uvs %s (error %g), normals %s (error %g rad)", path.c_str(),
+			quantization.halfPositions ? "half" : "float", quantization.positionError,
+			quantization.halfUvs ? "half" : "float", quantization.uvError,
+			quantization.packedNormals ? "packed" : "float", quantization.normalError);
+	}
+
+	if (!WriteMeshCache(mCachePath, mMesh, sourceHash))
+	{
+		LOG("Mesh %s could not be cached", path.c_str());
+		mCachePath.clear();
+	}
+
+	if (stats)
+	{
+		stats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+	return true;
+}
+
+bool PreparedMesh::PrepareFromCache(const std::string& cachePath, MeshImportStats* stats)
+{
+	auto start = std::chrono::steady_clock::now();
+	mFromCache = false;
+	if (!mCache.Open(cachePath))
+	{
+		return false;
+	}
+
+	if (stats)
+	{
+		stats->vertices = mCache.GetHeader().vertexCount;
+		stats->triangles = mCache.GetHeader().indexCount / 3;
+		stats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+	mCachePath = cachePath;
+	mFromCache = true;
+	return true;
+}
+
+std::unique_ptr<VertexArray> PreparedMesh::CreateVertexArray() const
+{
+	return mFromCache ? mCache.CreateVertexArray() : ::CreateVertexArray(mMesh);
+}
+
+std::shared_ptr<VertexArray> LoadMeshCached(const std::string& path, const std::string& cacheDirectory, MeshImportStats* stats, bool* fromCache)
+{
+	PreparedMesh mesh;
+	if (!mesh.Prepare(path, cacheDirectory, stats))
+	{
+		return nullptr;
+	}
+	if (fromCache)
+	{
+		*fromCache = mesh.IsFromCache();
+	}
+	return mesh.CreateVertexArray();
+}
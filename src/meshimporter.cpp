@@ -0,0 +1,1146 @@
+#include "meshimporter.hpp"
+#include "vertex.hpp"
+#include "json.hpp"
+#include "threadpool.hpp"
+#include "vfs.hpp"
+#include "log.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/packing.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cfloat>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+
+namespace
+{
+	constexpr uint32_t VertexSize = 8; // floats per imported vertex: position, texcoords, normal
+	const std::vector<VertexAttribute> ImportLayout = { { 3 }, { 2 }, { 3 } };
+	constexpr uint32_t MissingIndex = UINT32_MAX;
+	constexpr size_t MinChunkBytes = 1 << 20;
+
+	// Open addressing table mapping a vertex key to its index in the output, sized once up front
+	// so welding does not allocate per vertex
+	class WeldTable
+	{
+	public:
+		WeldTable(size_t maxEntries)
+		{
+			size_t capacity = 16;
+			while (capacity < maxEntries * 2)
+			{
+				capacity <<= 1;
+			}
+			mSlots.assign(capacity, MissingIndex);
+			mMask = capacity - 1;
+		}
+
+		// Returns the slot holding key or the empty slot where it should go
+		template<typename Equals>
+		uint32_t& Find(uint64_t hash, Equals equals)
+		{
+			size_t slot = hash & mMask;
+			while (mSlots[slot] != MissingIndex && !equals(mSlots[slot]))
+			{
+				slot = (slot + 1) & mMask;
+			}
+			return mSlots[slot];
+		}
+
+	private:
+		std::vector<uint32_t> mSlots;
+		size_t mMask;
+	};
+
+	inline uint64_t HashMix(uint64_t h)
+	{
+		h ^= h >> 33;
+		h *= 0xff51afd7ed558ccdULL;
+		h ^= h >> 33;
+		h *= 0xc4ceb9fe1a85ec53ULL;
+		h ^= h >> 33;
+		return h;
+	}
+
+	void ComputeBounds(MeshData& mesh)
+	{
+		uint32_t stride = mesh.GetVertexStride();
+		uint32_t vertexCount = mesh.GetVertexCount();
+		if (vertexCount == 0)
+		{
+			mesh.boundsMin = mesh.boundsMax = glm::vec3(0.0f);
+			return;
+		}
+
+		glm::vec3 bmin(FLT_MAX), bmax(-FLT_MAX);
+		for (uint32_t i = 0; i < vertexCount; i++)
+		{
+			glm::vec3 p = glm::make_vec3((const float*)&mesh.vertices[(size_t)i * stride]);
+			bmin = glm::min(bmin, p);
+			bmax = glm::max(bmax, p);
+		}
+		mesh.boundsMin = bmin;
+		mesh.boundsMax = bmax;
+	}
+
+	// Deduplicates bit identical vertices. indices refer to vertices and are remapped in place.
+	void WeldVertices(const std::vector<float>& vertices, std::vector<uint32_t>& indices, MeshData& mesh)
+	{
+		uint32_t vertexCount = (uint32_t)(vertices.size() / VertexSize);
+		std::vector<uint32_t> remap(vertexCount);
+		mesh.vertices.clear();
+		mesh.vertices.reserve(vertices.size() * sizeof(float));
+		constexpr size_t VertexBytes = VertexSize * sizeof(float);
+
+		WeldTable table(vertexCount);
+		for (uint32_t i = 0; i < vertexCount; i++)
+		{
+			const float* v = &vertices[(size_t)i * VertexSize];
+			uint64_t hash = 0;
+			for (uint32_t c = 0; c < VertexSize; c++)
+			{
+				uint32_t bits;
+				memcpy(&bits, &v[c], sizeof(bits));
+				hash = HashMix(hash ^ bits);
+			}
+
+			uint32_t& slot = table.Find(hash, [&](uint32_t existing) {
+				return memcmp(&mesh.vertices[(size_t)existing * VertexBytes], v, VertexBytes) == 0;
+			});
+			if (slot == MissingIndex)
+			{
+				slot = (uint32_t)(mesh.vertices.size() / VertexBytes);
+				mesh.vertices.insert(mesh.vertices.end(), (const uint8_t*)v, (const uint8_t*)(v + VertexSize));
+			}
+			remap[i] = slot;
+		}
+
+		for (auto& index : indices)
+		{
+			index = remap[index];
+		}
+		mesh.indices = std::move(indices);
+	}
+
+	// ---------------------------------------------------------------- OBJ
+
+	struct ObjChunk
+	{
+		const char* begin = nullptr;
+		const char* end = nullptr;
+
+		uint32_t positionCount = 0, uvCount = 0, normalCount = 0;
+		uint32_t positionOffset = 0, uvOffset = 0, normalOffset = 0;
+
+		std::vector<uint32_t> corners; // position, texcoord, normal per triangle corner, 0-based
+		bool isValid = true;
+	};
+
+	inline const char* SkipSpaces(const char* p, const char* end)
+	{
+		while (p < end && (*p == ' ' || *p == '\t'))
+		{
+			p++;
+		}
+		return p;
+	}
+
+	inline const char* FindLineEnd(const char* p, const char* end)
+	{
+		const char* nl = (const char*)memchr(p, '\n', end - p);
+		return nl ? nl : end;
+	}
+
+	inline bool IsSpace(char c)
+	{
+		return c == ' ' || c == '\t';
+	}
+
+	inline const char* ParseFloat(const char* p, const char* end, float& out)
+	{
+		p = SkipSpaces(p, end);
+		if (p < end && *p == '+')
+		{
+			p++;
+		}
+		auto result = std::from_chars(p, end, out);
+		if (result.ec != std::errc())
+		{
+			out = 0.0f;
+			return nullptr;
+		}
+		return result.ptr;
+	}
+
+	inline void ParseFloats(const char* p, const char* end, float* out, uint32_t count)
+	{
+		for (uint32_t i = 0; i < count; i++)
+		{
+			p = p ? ParseFloat(p, end, out[i]) : (out[i] = 0.0f, nullptr);
+		}
+	}
+
+	// Counts attribute lines so every chunk knows where its attributes land in the merged arrays
+	void CountObjChunk(ObjChunk& chunk)
+	{
+		const char* p = chunk.begin;
+		while (p < chunk.end)
+		{
+			const char* lineEnd = FindLineEnd(p, chunk.end);
+			p = SkipSpaces(p, lineEnd);
+			if (lineEnd - p >= 2 && p[0] == 'v')
+			{
+				if (IsSpace(p[1])) chunk.positionCount++;
+				else if (p[1] == 't' && lineEnd - p >= 3 && IsSpace(p[2])) chunk.uvCount++;
+				else if (p[1] == 'n' && lineEnd - p >= 3 && IsSpace(p[2])) chunk.normalCount++;
+			}
+			p = lineEnd + 1;
+		}
+	}
+
+	inline bool ResolveObjIndex(int64_t index, uint32_t seenSoFar, uint32_t total, uint32_t& out)
+	{
+		int64_t resolved = index > 0 ? index - 1 : (int64_t)seenSoFar + index;
+		if (index == 0 || resolved < 0 || resolved >= total)
+		{
+			return false;
+		}
+		out = (uint32_t)resolved;
+		return true;
+	}
+
+	void ParseObjChunk(ObjChunk& chunk, uint32_t totalPositions, uint32_t totalUvs, uint32_t totalNormals,
+		float* positions, float* uvs, float* normals)
+	{
+		uint32_t positionIndex = chunk.positionOffset;
+		uint32_t uvIndex = chunk.uvOffset;
+		uint32_t normalIndex = chunk.normalOffset;
+
+		std::vector<uint32_t> polygon; // reused for every face
+		polygon.reserve(3 * 16);
+
+		const char* p = chunk.begin;
+		while (p < chunk.end && chunk.isValid)
+		{
+			const char* lineEnd = FindLineEnd(p, chunk.end);
+			const char* next = lineEnd + 1;
+			p = SkipSpaces(p, lineEnd);
+
+			if (lineEnd - p >= 2 && p[0] == 'v')
+			{
+				if (IsSpace(p[1]))
+				{
+					ParseFloats(p + 2, lineEnd, &positions[(size_t)positionIndex++ * 3], 3);
+				}
+				else if (p[1] == 't' && lineEnd - p >= 3 && IsSpace(p[2]))
+				{
+					ParseFloats(p + 3, lineEnd, &uvs[(size_t)uvIndex++ * 2], 2);
+				}
+				else if (p[1] == 'n' && lineEnd - p >= 3 && IsSpace(p[2]))
+				{
+					ParseFloats(p + 3, lineEnd, &normals[(size_t)normalIndex++ * 3], 3);
+				}
+			}
+			else if (lineEnd - p >= 2 && p[0] == 'f' && IsSpace(p[1]))
+			{
+				polygon.clear();
+				const char* q = p + 2;
+				while (true)
+				{
+					q = SkipSpaces(q, lineEnd);
+					if (q >= lineEnd || *q == '\r' || *q == '#')
+					{
+						break;
+					}
+
+					int64_t values[3] = { 0, 0, 0 };
+					for (int i = 0; i < 3 && q < lineEnd; i++)
+					{
+						if (*q != '/')
+						{
+							auto result = std::from_chars(q, lineEnd, values[i]);
+							if (result.ec != std::errc())
+							{
+								chunk.isValid = false;
+								break;
+							}
+							q = result.ptr;
+						}
+						if (q < lineEnd && *q == '/')
+						{
+							q++;
+						}
+						else
+						{
+							break;
+						}
+					}
+					while (q < lineEnd && !IsSpace(*q) && *q != '\r')
+					{
+						q++;
+					}
+
+					uint32_t corner[3] = { MissingIndex, MissingIndex, MissingIndex };
+					if (!chunk.isValid || !ResolveObjIndex(values[0], positionIndex, totalPositions, corner[0])
+						|| (values[1] != 0 && !ResolveObjIndex(values[1], uvIndex, totalUvs, corner[1]))
+						|| (values[2] != 0 && !ResolveObjIndex(values[2], normalIndex, totalNormals, corner[2])))
+					{
+						chunk.isValid = false;
+						break;
+					}
+					polygon.insert(polygon.end(), corner, corner + 3);
+				}
+
+				// fan triangulation
+				uint32_t cornerCount = (uint32_t)polygon.size() / 3;
+				for (uint32_t i = 1; i + 1 < cornerCount && chunk.isValid; i++)
+				{
+					chunk.corners.insert(chunk.corners.end(), polygon.data(), polygon.data() + 3);
+					chunk.corners.insert(chunk.corners.end(), polygon.data() + i * 3, polygon.data() + i * 3 + 6);
+				}
+			}
+
+			p = next;
+		}
+	}
+
+	// ---------------------------------------------------------------- glTF
+
+	struct GltfBuffer
+	{
+		const uint8_t* data = nullptr;
+		size_t size = 0;
+	};
+
+	// What the buffers point into besides the GLB chunk: decoded data uris and the mapped external files
+	struct GltfBufferStorage
+	{
+		std::vector<std::vector<uint8_t>> decoded;
+		std::deque<VfsFile> files; // not movable, a deque constructs them in place
+	};
+
+	bool DecodeBase64(std::string_view in, std::vector<uint8_t>& out)
+	{
+		static int8_t table[256];
+		static bool tableReady = []() {
+			memset(table, -1, sizeof(table));
+			const char* chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+			for (int i = 0; i < 64; i++)
+			{
+				table[(uint8_t)chars[i]] = (int8_t)i;
+			}
+			return true;
+		}();
+		(void)tableReady;
+
+		out.clear();
+		out.reserve(in.size() * 3 / 4);
+		uint32_t accumulator = 0;
+		int bits = 0;
+		for (char c : in)
+		{
+			if (c == '=')
+			{
+				break;
+			}
+			int8_t value = table[(uint8_t)c];
+			if (value < 0)
+			{
+				return false;
+			}
+			accumulator = (accumulator << 6) | (uint32_t)value;
+			bits += 6;
+			if (bits >= 8)
+			{
+				bits -= 8;
+				out.push_back((uint8_t)(accumulator >> bits));
+			}
+		}
+		return true;
+	}
+
+	bool LoadGltfBuffers(const JsonValue& root, const uint8_t* glbChunk, size_t glbChunkSize, const std::string& baseDirectory,
+		GltfBufferStorage& storage, std::vector<GltfBuffer>& buffers)
+	{
+		const JsonValue* jsonBuffers = root.Find("buffers");
+		if (!jsonBuffers)
+		{
+			return true;
+		}
+
+		storage.decoded.resize(jsonBuffers->GetSize());
+		for (size_t i = 0; i < jsonBuffers->GetSize(); i++)
+		{
+			const JsonValue& jsonBuffer = (*jsonBuffers)[i];
+			const JsonValue* byteLengthValue = jsonBuffer.Find("byteLength");
+			size_t byteLength = byteLengthValue ? (size_t)byteLengthValue->GetNumber() : 0;
+			const JsonValue* uri = jsonBuffer.Find("uri");
+
+			GltfBuffer buffer;
+			if (!uri)
+			{
+				// the first buffer without uri is the GLB binary chunk
+				if (i != 0 || !glbChunk)
+				{
+					LOG("glTF buffer %zu has no data", i);
+					return false;
+				}
+				buffer.data = glbChunk;
+				buffer.size = glbChunkSize;
+			}
+			else if (uri->GetString().rfind("data:", 0) == 0)
+			{
+				auto comma = uri->GetString().find(',');
+				if (comma == std::string::npos || !DecodeBase64(std::string_view(uri->GetString()).substr(comma + 1), storage.decoded[i]))
+				{
+					LOG("glTF buffer %zu has an invalid data uri", i);
+					return false;
+				}
+				buffer.data = storage.decoded[i].data();
+				buffer.size = storage.decoded[i].size();
+			}
+			else
+			{
+				VfsFile& file = storage.files.emplace_back();
+				if (!VirtualFileSystem::Get().Open(baseDirectory + "/" + uri->GetString(), file))
+				{
+					LOG("Could not read glTF buffer %s", uri->GetString().c_str());
+					return false;
+				}
+				buffer.data = file.GetData();
+				buffer.size = file.GetSize();
+			}
+
+			if (buffer.size < byteLength)
+			{
+				LOG("glTF buffer %zu is smaller than its byteLength", i);
+				return false;
+			}
+			buffers.push_back(buffer);
+		}
+		return true;
+	}
+
+	uint32_t GltfComponentCount(const std::string& type)
+	{
+		if (type == "SCALAR") return 1;
+		if (type == "VEC2") return 2;
+		if (type == "VEC3") return 3;
+		if (type == "VEC4") return 4;
+		return 0;
+	}
+
+	uint32_t GltfComponentSize(uint32_t componentType)
+	{
+		switch (componentType)
+		{
+		case 5120: case 5121: return 1; // (unsigned) byte
+		case 5122: case 5123: return 2; // (unsigned) short
+		case 5125: case 5126: return 4; // unsigned int, float
+		}
+		return 0;
+	}
+
+	inline float ReadGltfComponent(const uint8_t* p, uint32_t componentType, bool normalized)
+	{
+		switch (componentType)
+		{
+		case 5126: { float v; memcpy(&v, p, 4); return v; }
+		case 5121: return normalized ? *p / 255.0f : (float)*p;
+		case 5120: return normalized ? std::max(*(const int8_t*)p / 127.0f, -1.0f) : (float)*(const int8_t*)p;
+		case 5123: { uint16_t v; memcpy(&v, p, 2); return normalized ? v / 65535.0f : (float)v; }
+		case 5122: { int16_t v; memcpy(&v, p, 2); return normalized ? std::max(v / 32767.0f, -1.0f) : (float)v; }
+		case 5125: { uint32_t v; memcpy(&v, p, 4); return (float)v; }
+		}
+		return 0.0f;
+	}
+
+	// Indices stay integers, going through float loses everything above 2^24
+	inline uint32_t ReadGltfIndex(const uint8_t* p, uint32_t componentType)
+	{
+		switch (componentType)
+		{
+		case 5121: { uint8_t v; memcpy(&v, p, 1); return v; }
+		case 5123: { uint16_t v; memcpy(&v, p, 2); return v; }
+		case 5125: { uint32_t v; memcpy(&v, p, 4); return v; }
+		}
+		return 0;
+	}
+
+	struct GltfAccessor
+	{
+		const uint8_t* data = nullptr;
+		uint32_t count = 0;
+		uint32_t components = 0;
+		uint32_t componentType = 0;
+		uint32_t stride = 0;
+		bool normalized = false;
+	};
+
+	bool GetGltfAccessor(const JsonValue& root, const std::vector<GltfBuffer>& buffers, size_t index, GltfAccessor& out)
+	{
+		const JsonValue* accessors = root.Find("accessors");
+		const JsonValue* views = root.Find("bufferViews");
+		if (!accessors || index >= accessors->GetSize())
+		{
+			return false;
+		}
+
+		const JsonValue& accessor = (*accessors)[index];
+		const JsonValue* viewIndex = accessor.Find("bufferView");
+		const JsonValue* type = accessor.Find("type");
+		const JsonValue* componentType = accessor.Find("componentType");
+		const JsonValue* count = accessor.Find("count");
+		if (!viewIndex || !type || !componentType || !count || !views || viewIndex->GetNumber() >= views->GetSize())
+		{
+			LOG("Unsupported glTF accessor %zu", index);
+			return false;
+		}
+
+		const JsonValue& view = (*views)[(size_t)viewIndex->GetNumber()];
+		const JsonValue* buffer = view.Find("buffer");
+		size_t bufferIndex = buffer ? (size_t)buffer->GetNumber() : SIZE_MAX;
+		if (bufferIndex >= buffers.size())
+		{
+			return false;
+		}
+
+		out.count = (uint32_t)count->GetNumber();
+		out.components = GltfComponentCount(type->GetString());
+		out.componentType = (uint32_t)componentType->GetNumber();
+		out.normalized = accessor.Find("normalized") && accessor.Find("normalized")->GetBool();
+
+		uint32_t elementSize = out.components * GltfComponentSize(out.componentType);
+		const JsonValue* stride = view.Find("byteStride");
+		out.stride = stride ? (uint32_t)stride->GetNumber() : elementSize;
+
+		size_t offset = (size_t)(view.Find("byteOffset") ? view.Find("byteOffset")->GetNumber() : 0.0)
+			+ (size_t)(accessor.Find("byteOffset") ? accessor.Find("byteOffset")->GetNumber() : 0.0);
+		size_t needed = out.count ? offset + (size_t)(out.count - 1) * out.stride + elementSize : offset;
+		if (elementSize == 0 || needed > buffers[bufferIndex].size)
+		{
+			LOG("glTF accessor %zu is out of bounds", index);
+			return false;
+		}
+
+		out.data = buffers[bufferIndex].data + offset;
+		return true;
+	}
+
+	glm::mat4 GetGltfNodeTransform(const JsonValue& node)
+	{
+		const JsonValue* matrix = node.Find("matrix");
+		if (matrix && matrix->GetSize() == 16)
+		{
+			glm::mat4 m;
+			for (int i = 0; i < 16; i++)
+			{
+				glm::value_ptr(m)[i] = (float)(*matrix)[i].GetNumber();
+			}
+			return m;
+		}
+
+		glm::mat4 m(1.0f);
+		if (const JsonValue* t = node.Find("translation"))
+		{
+			m = glm::translate(m, glm::vec3((float)(*t)[0].GetNumber(), (float)(*t)[1].GetNumber(), (float)(*t)[2].GetNumber()));
+		}
+		if (const JsonValue* r = node.Find("rotation"))
+		{
+			glm::quat q((float)(*r)[3].GetNumber(), (float)(*r)[0].GetNumber(), (float)(*r)[1].GetNumber(), (float)(*r)[2].GetNumber());
+			m = m * glm::mat4_cast(q);
+		}
+		if (const JsonValue* s = node.Find("scale"))
+		{
+			m = glm::scale(m, glm::vec3((float)(*s)[0].GetNumber(), (float)(*s)[1].GetNumber(), (float)(*s)[2].GetNumber()));
+		}
+		return m;
+	}
+
+	struct GltfInstance
+	{
+		size_t mesh;
+		glm::mat4 transform;
+	};
+
+	void CollectGltfInstances(const JsonValue& nodes, size_t nodeIndex, const glm::mat4& parent, int depth, std::vector<GltfInstance>& out)
+	{
+		if (nodeIndex >= nodes.GetSize() || depth > 64)
+		{
+			return;
+		}
+
+		const JsonValue& node = nodes[nodeIndex];
+		glm::mat4 transform = parent * GetGltfNodeTransform(node);
+		if (const JsonValue* mesh = node.Find("mesh"))
+		{
+			out.push_back({ (size_t)mesh->GetNumber(), transform });
+		}
+		if (const JsonValue* children = node.Find("children"))
+		{
+			for (const auto& child : children->GetElements())
+			{
+				CollectGltfInstances(nodes, (size_t)child.GetNumber(), transform, depth + 1, out);
+			}
+		}
+	}
+
+	bool AppendGltfPrimitive(const JsonValue& root, const std::vector<GltfBuffer>& buffers, const JsonValue& primitive,
+		const glm::mat4& transform, std::vector<float>& vertices, std::vector<uint32_t>& indices)
+	{
+		const JsonValue* mode = primitive.Find("mode");
+		if (mode && mode->GetNumber() != 4)
+		{
+			LOG("Skipping glTF primitive with mode %d, only triangles are supported", (int)mode->GetNumber());
+			return true;
+		}
+
+		const JsonValue* attributes = primitive.Find("attributes");
+		const JsonValue* positionIndex = attributes ? attributes->Find("POSITION") : nullptr;
+		GltfAccessor positions, uvs, normals;
+		if (!positionIndex || !GetGltfAccessor(root, buffers, (size_t)positionIndex->GetNumber(), positions) || positions.components != 3)
+		{
+			LOG("glTF primitive without usable POSITION attribute");
+			return false;
+		}
+		const JsonValue* uvIndex = attributes->Find("TEXCOORD_0");
+		const JsonValue* normalIndex = attributes->Find("NORMAL");
+		bool hasUvs = uvIndex && GetGltfAccessor(root, buffers, (size_t)uvIndex->GetNumber(), uvs) && uvs.count == positions.count;
+		bool hasNormals = normalIndex && GetGltfAccessor(root, buffers, (size_t)normalIndex->GetNumber(), normals) && normals.count == positions.count;
+
+		uint32_t baseVertex = (uint32_t)(vertices.size() / VertexSize);
+		vertices.resize(vertices.size() + (size_t)positions.count * VertexSize);
+		float* out = &vertices[(size_t)baseVertex * VertexSize];
+		glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(transform)));
+
+		ThreadPool::Get().ParallelFor(positions.count, 64 * 1024, [&](uint32_t begin, uint32_t end) {
+			uint32_t positionSize = GltfComponentSize(positions.componentType);
+			for (uint32_t i = begin; i < end; i++)
+			{
+				float* v = &out[(size_t)i * VertexSize];
+				const uint8_t* p = positions.data + (size_t)i * positions.stride;
+				glm::vec3 position(ReadGltfComponent(p, positions.componentType, positions.normalized),
+					ReadGltfComponent(p + positionSize, positions.componentType, positions.normalized),
+					ReadGltfComponent(p + positionSize * 2, positions.componentType, positions.normalized));
+				position = glm::vec3(transform * glm::vec4(position, 1.0f));
+				v[0] = position.x; v[1] = position.y; v[2] = position.z;
+
+				if (hasUvs)
+				{
+					const uint8_t* t = uvs.data + (size_t)i * uvs.stride;
+					uint32_t size = GltfComponentSize(uvs.componentType);
+					v[3] = ReadGltfComponent(t, uvs.componentType, uvs.normalized);
+					v[4] = 1.0f - ReadGltfComponent(t + size, uvs.componentType, uvs.normalized); // glTF uv origin is top left
+				}
+				else
+				{
+					v[3] = v[4] = 0.0f;
+				}
+
+				if (hasNormals)
+				{
+					const uint8_t* n = normals.data + (size_t)i * normals.stride;
+					uint32_t size = GltfComponentSize(normals.componentType);
+					glm::vec3 normal(ReadGltfComponent(n, normals.componentType, normals.normalized),
+						ReadGltfComponent(n + size, normals.componentType, normals.normalized),
+						ReadGltfComponent(n + size * 2, normals.componentType, normals.normalized));
+					normal = normalMatrix * normal;
+					float length = glm::length(normal);
+					normal = length > 0.0f ? normal / length : normal;
+					v[5] = normal.x; v[6] = normal.y; v[7] = normal.z;
+				}
+				else
+				{
+					v[5] = v[6] = v[7] = 0.0f;
+				}
+			}
+		});
+
+		const JsonValue* indicesIndex = primitive.Find("indices");
+		if (indicesIndex)
+		{
+			GltfAccessor accessor;
+			if (!GetGltfAccessor(root, buffers, (size_t)indicesIndex->GetNumber(), accessor) || accessor.components != 1
+				|| (accessor.componentType != 5121 && accessor.componentType != 5123 && accessor.componentType != 5125))
+			{
+				LOG("glTF primitive with unusable indices");
+				return false;
+			}
+
+			size_t first = indices.size();
+			indices.resize(first + accessor.count - accessor.count % 3);
+			for (size_t i = 0; i < indices.size() - first; i++)
+			{
+				uint32_t index = ReadGltfIndex(accessor.data + i * accessor.stride, accessor.componentType);
+				if (index >= positions.count)
+				{
+					LOG("glTF index %u out of range", index);
+					return false;
+				}
+				indices[first + i] = baseVertex + index;
+			}
+		}
+		else
+		{
+			for (uint32_t i = 0; i + 2 < positions.count; i += 3)
+			{
+				indices.push_back(baseVertex + i);
+				indices.push_back(baseVertex + i + 1);
+				indices.push_back(baseVertex + i + 2);
+			}
+		}
+		return true;
+	}
+
+	bool ImportGltfDocument(std::string_view json, const uint8_t* glbChunk, size_t glbChunkSize, const std::string& baseDirectory, MeshData& mesh)
+	{
+		JsonValue root;
+		std::string error;
+		if (!ParseJson(json, root, &error))
+		{
+			LOG("Invalid glTF json: %s", error.c_str());
+			return false;
+		}
+
+		GltfBufferStorage storage;
+		std::vector<GltfBuffer> buffers;
+		if (!LoadGltfBuffers(root, glbChunk, glbChunkSize, baseDirectory, storage, buffers))
+		{
+			return false;
+		}
+
+		const JsonValue* meshes = root.Find("meshes");
+		if (!meshes || meshes->GetSize() == 0)
+		{
+			LOG("glTF file has no meshes");
+			return false;
+		}
+
+		// Bake the default scene's node hierarchy into the vertices, or take every mesh as is without one
+		std::vector<GltfInstance> instances;
+		const JsonValue* nodes = root.Find("nodes");
+		const JsonValue* scenes = root.Find("scenes");
+		if (nodes && scenes && scenes->GetSize() > 0)
+		{
+			const JsonValue* sceneIndex = root.Find("scene");
+			const JsonValue& scene = (*scenes)[sceneIndex ? (size_t)sceneIndex->GetNumber() : 0];
+			if (const JsonValue* sceneNodes = scene.Find("nodes"))
+			{
+				for (const auto& node : sceneNodes->GetElements())
+				{
+					CollectGltfInstances(*nodes, (size_t)node.GetNumber(), glm::mat4(1.0f), 0, instances);
+				}
+			}
+		}
+		else
+		{
+			for (size_t i = 0; i < meshes->GetSize(); i++)
+			{
+				instances.push_back({ i, glm::mat4(1.0f) });
+			}
+		}
+
+		std::vector<float> vertices;
+		std::vector<uint32_t> indices;
+		for (const auto& instance : instances)
+		{
+			if (instance.mesh >= meshes->GetSize())
+			{
+				continue;
+			}
+			const JsonValue* primitives = (*meshes)[instance.mesh].Find("primitives");
+			if (!primitives)
+			{
+				continue;
+			}
+			for (const auto& primitive : primitives->GetElements())
+			{
+				if (!AppendGltfPrimitive(root, buffers, primitive, instance.transform, vertices, indices))
+				{
+					return false;
+				}
+			}
+		}
+
+		mesh.layout = ImportLayout;
+		WeldVertices(vertices, indices, mesh);
+		ComputeBounds(mesh);
+		return true;
+	}
+}
+
+uint32_t MeshData::GetVertexStride() const
+{
+	uint32_t stride = 0;
+	for (const auto& attrib : layout)
+	{
+		stride += attrib.GetSize();
+	}
+	return stride;
+}
+
+uint32_t MeshData::GetVertexCount() const
+{
+	uint32_t stride = GetVertexStride();
+	return stride ? (uint32_t)(vertices.size() / stride) : 0;
+}
+
+bool ImportObj(const char* data, size_t size, MeshData& mesh)
+{
+	const char* end = data + size;
+
+	// Split at line boundaries so every worker gets roughly the same amount of text
+	uint32_t chunkCount = std::max<uint32_t>(1, std::min<uint32_t>((uint32_t)(size / MinChunkBytes), ThreadPool::Get().GetThreadCount() * 4));
+	std::vector<ObjChunk> chunks(chunkCount);
+	const char* p = data;
+	for (uint32_t i = 0; i < chunkCount; i++)
+	{
+		const char* chunkEnd = i + 1 == chunkCount ? end : std::max(p, data + size * (i + 1) / chunkCount);
+		if (chunkEnd < end)
+		{
+			chunkEnd = FindLineEnd(chunkEnd, end);
+			chunkEnd = chunkEnd < end ? chunkEnd + 1 : end;
+		}
+		chunks[i].begin = p;
+		chunks[i].end = chunkEnd;
+		p = chunkEnd;
+	}
+
+	ThreadPool::Get().ParallelFor(chunkCount, 1, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++)
+		{
+			CountObjChunk(chunks[i]);
+		}
+	});
+
+	uint32_t positionCount = 0, uvCount = 0, normalCount = 0;
+	for (auto& chunk : chunks)
+	{
+		chunk.positionOffset = positionCount;
+		chunk.uvOffset = uvCount;
+		chunk.normalOffset = normalCount;
+		positionCount += chunk.positionCount;
+		uvCount += chunk.uvCount;
+		normalCount += chunk.normalCount;
+	}
+
+	std::vector<float> positions((size_t)positionCount * 3);
+	std::vector<float> uvs((size_t)uvCount * 2);
+	std::vector<float> normals((size_t)normalCount * 3);
+
+	ThreadPool::Get().ParallelFor(chunkCount, 1, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++)
+		{
+			ParseObjChunk(chunks[i], positionCount, uvCount, normalCount, positions.data(), uvs.data(), normals.data());
+		}
+	});
+
+	size_t cornerCount = 0;
+	for (auto& chunk : chunks)
+	{
+		if (!chunk.isValid)
+		{
+			LOG("Invalid face in OBJ data");
+			return false;
+		}
+		cornerCount += chunk.corners.size() / 3;
+	}
+
+	// Weld on the (position, texcoord, normal) index triple, every distinct triple becomes one vertex
+	std::vector<uint32_t> keys;
+	keys.reserve(cornerCount * 3);
+	mesh.indices.resize(cornerCount);
+	WeldTable table(cornerCount);
+	size_t corner = 0;
+	for (auto& chunk : chunks)
+	{
+		const uint32_t* c = chunk.corners.data();
+		for (size_t i = 0; i < chunk.corners.size(); i += 3, corner++)
+		{
+			uint64_t hash = HashMix(((uint64_t)c[i] << 32) ^ HashMix(((uint64_t)c[i + 1] << 32) | c[i + 2]));
+			uint32_t& slot = table.Find(hash, [&](uint32_t existing) {
+				return memcmp(&keys[(size_t)existing * 3], &c[i], sizeof(uint32_t) * 3) == 0;
+			});
+			if (slot == MissingIndex)
+			{
+				slot = (uint32_t)(keys.size() / 3);
+				keys.insert(keys.end(), &c[i], &c[i + 3]);
+			}
+			mesh.indices[corner] = slot;
+		}
+		chunk.corners = std::vector<uint32_t>();
+	}
+
+	uint32_t vertexCount = (uint32_t)(keys.size() / 3);
+	mesh.layout = ImportLayout;
+	mesh.vertices.resize((size_t)vertexCount * VertexSize * sizeof(float));
+	float* vertices = (float*)mesh.vertices.data();
+	ThreadPool::Get().ParallelFor(vertexCount, 64 * 1024, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++)
+		{
+			float* v = &vertices[(size_t)i * VertexSize];
+			const uint32_t* key = &keys[(size_t)i * 3];
+			memcpy(v, &positions[(size_t)key[0] * 3], sizeof(float) * 3);
+			if (key[1] != MissingIndex)
+			{
+				memcpy(v + 3, &uvs[(size_t)key[1] * 2], sizeof(float) * 2);
+			}
+			else
+			{
+				v[3] = v[4] = 0.0f;
+			}
+			if (key[2] != MissingIndex)
+			{
+				memcpy(v + 5, &normals[(size_t)key[2] * 3], sizeof(float) * 3);
+			}
+			else
+			{
+				v[5] = v[6] = v[7] = 0.0f;
+			}
+		}
+	});
+
+	ComputeBounds(mesh);
+	return true;
+}
+
+bool ImportGltf(const char* data, size_t size, const std::string& baseDirectory, MeshData& mesh)
+{
+	return ImportGltfDocument(std::string_view(data, size), nullptr, 0, baseDirectory, mesh);
+}
+
+bool ImportGlb(const char* data, size_t size, const std::string& baseDirectory, MeshData& mesh)
+{
+	auto readU32 = [&](size_t offset) {
+		uint32_t v = 0;
+		memcpy(&v, data + offset, sizeof(v));
+		return v;
+	};
+
+	if (size < 20 || readU32(0) != 0x46546C67 || readU32(4) != 2) // "glTF", version 2
+	{
+		LOG("Invalid GLB header");
+		return false;
+	}
+
+	size_t length = std::min<size_t>(readU32(8), size);
+	std::string_view json;
+	const uint8_t* bin = nullptr;
+	size_t binSize = 0;
+	for (size_t offset = 12; offset + 8 <= length;)
+	{
+		uint32_t chunkLength = readU32(offset);
+		uint32_t chunkType = readU32(offset + 4);
+		offset += 8;
+		if (offset + chunkLength > length)
+		{
+			LOG("Truncated GLB chunk");
+			return false;
+		}
+		if (chunkType == 0x4E4F534A) // "JSON"
+		{
+			json = std::string_view(data + offset, chunkLength);
+		}
+		else if (chunkType == 0x004E4942 && !bin) // "BIN"
+		{
+			bin = (const uint8_t*)data + offset;
+			binSize = chunkLength;
+		}
+		offset += (chunkLength + 3) & ~3u;
+	}
+
+	if (json.empty())
+	{
+		LOG("GLB file without JSON chunk");
+		return false;
+	}
+	return ImportGltfDocument(json, bin, binSize, baseDirectory, mesh);
+}
+
+bool ImportMesh(const std::string& path, MeshData& mesh, MeshImportStats* stats)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	// parsed straight from the mapping or the decompressed pack entry
+	VfsFile file;
+	if (!VirtualFileSystem::Get().Open(path, file))
+	{
+		LOG("Could not read mesh file: %s", path.c_str());
+		return false;
+	}
+
+	bool result = ImportMesh(path, (const char*)file.GetData(), file.GetSize(), mesh, stats);
+	if (stats)
+	{
+		stats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+	return result;
+}
+
+bool ImportMesh(const std::string& path, const char* data, size_t size, MeshData& mesh, MeshImportStats* stats)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	std::filesystem::path fsPath(path);
+	std::string extension = fsPath.extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return (char)tolower(c); });
+	std::string baseDirectory = fsPath.parent_path().string();
+	if (baseDirectory.empty())
+	{
+		baseDirectory = ".";
+	}
+
+	bool result = false;
+	if (extension == ".obj")
+	{
+		result = ImportObj(data, size, mesh);
+	}
+	else if (extension == ".gltf")
+	{
+		result = ImportGltf(data, size, baseDirectory, mesh);
+	}
+	else if (extension == ".glb")
+	{
+		result = ImportGlb(data, size, baseDirectory, mesh);
+	}
+	else
+	{
+		LOG("Unsupported mesh format: %s", extension.c_str());
+	}
+
+	if (stats)
+	{
+		stats->bytes = size;
+		stats->vertices = mesh.GetVertexCount();
+		stats->triangles = mesh.GetTriangleCount();
+		stats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+	return result;
+}
+
+bool QuantizeMesh(MeshData& mesh, const MeshQuantizationSettings& settings, MeshQuantizationResult* result)
+{
+	if (mesh.layout != ImportLayout)
+	{
+		LOG("Only meshes in the import layout can be quantized");
+		return false;
+	}
+
+	uint32_t vertexCount = mesh.GetVertexCount();
+	const float* source = (const float*)mesh.vertices.data();
+	float diagonal = glm::length(mesh.boundsMax - mesh.boundsMin);
+
+	// measure the error each conversion would introduce before committing to it
+	MeshQuantizationResult quantization;
+	for (uint32_t i = 0; i < vertexCount; i++)
+	{
+		const float* v = &source[(size_t)i * VertexSize];
+		for (int c = 0; c < 3; c++)
+		{
+			quantization.positionError = std::max(quantization.positionError, std::abs(glm::unpackHalf1x16(glm::packHalf1x16(v[c])) - v[c]));
+		}
+		for (int c = 3; c < 5; c++)
+		{
+			quantization.uvError = std::max(quantization.uvError, std::abs(glm::unpackHalf1x16(glm::packHalf1x16(v[c])) - v[c]));
+		}
+		glm::vec3 normal = glm::make_vec3(v + 5);
+		if (settings.packNormals && glm::dot(normal, normal) > 0.0f)
+		{
+			glm::vec3 unpacked = glm::vec3(glm::unpackSnorm3x10_1x2(glm::packSnorm3x10_1x2(glm::vec4(normal, 0.0f))));
+			float cosAngle = glm::dot(glm::normalize(normal), glm::normalize(unpacked));
+			quantization.normalError = std::max(quantization.normalError, std::acos(glm::clamp(cosAngle, -1.0f, 1.0f)));
+		}
+	}
+
+	quantization.halfPositions = quantization.positionError <= settings.maxPositionError * diagonal;
+	quantization.halfUvs = quantization.uvError <= settings.maxUvError;
+	quantization.packedNormals = settings.packNormals && quantization.normalError <= settings.maxNormalError;
+	if (!quantization.halfPositions) quantization.positionError = 0.0f;
+	if (!quantization.halfUvs) quantization.uvError = 0.0f;
+	if (!quantization.packedNormals) quantization.normalError = 0.0f;
+
+	std::vector<VertexAttribute> layout = {
+		quantization.halfPositions ? VertexAttribTraits<HalfVec4>::Attribute : VertexAttribTraits<glm::vec3>::Attribute,
+		quantization.halfUvs ? VertexAttribTraits<HalfVec2>::Attribute : VertexAttribTraits<glm::vec2>::Attribute,
+		quantization.packedNormals ? VertexAttribTraits<PackedNormal>::Attribute : VertexAttribTraits<glm::vec3>::Attribute
+	};
+	uint32_t stride = 0;
+	for (const auto& attrib : layout)
+	{
+		stride += attrib.GetSize();
+	}
+
+	std::vector<uint8_t> vertices((size_t)vertexCount * stride);
+	ThreadPool::Get().ParallelFor(vertexCount, 64 * 1024, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++)
+		{
+			const float* v = &source[(size_t)i * VertexSize];
+			uint8_t* out = &vertices[(size_t)i * stride];
+			if (quantization.halfPositions)
+			{
+				HalfVec4 position = { glm::packHalf1x16(v[0]), glm::packHalf1x16(v[1]), glm::packHalf1x16(v[2]), glm::packHalf1x16(1.0f) };
+				memcpy(out, &position, sizeof(position));
+				out += sizeof(position);
+			}
+			else
+			{
+				memcpy(out, v, sizeof(float) * 3);
+				out += sizeof(float) * 3;
+			}
+
+			if (quantization.halfUvs)
+			{
+				HalfVec2 uv = { glm::packHalf1x16(v[3]), glm::packHalf1x16(v[4]) };
+				memcpy(out, &uv, sizeof(uv));
+				out += sizeof(uv);
+			}
+			else
+			{
+				memcpy(out, v + 3, sizeof(float) * 2);
+				out += sizeof(float) * 2;
+			}
+
+			if (quantization.packedNormals)
+			{
+				PackedNormal normal = { glm::packSnorm3x10_1x2(glm::vec4(glm::make_vec3(v + 5), 0.0f)) };
+				memcpy(out, &normal, sizeof(normal));
+			}
+			else
+			{
+				memcpy(out, v + 5, sizeof(float) * 3);
+			}
+		}
+	});
+
+	mesh.vertices = std::move(vertices);
+	mesh.layout = std::move(layout);
+	if (result)
+	{
+		*result = quantization;
+	}
+	return true;
+}
+
+std::unique_ptr<VertexArray> CreateVertexArray(const MeshData& mesh)
+{
+	std::unique_ptr<VertexArray> va = std::make_unique<VertexArray>();
+	{
+		std::unique_ptr<VertexBuffer> vb = std::make_unique<VertexBuffer>();
+		vb->SetData(mesh.vertices.data(), mesh.GetVertexCount(), mesh.GetVertexStride());
+		vb->SetLayout(mesh.layout);
+		va->PushBuffer(std::move(vb));
+	}
+	if (!mesh.indices.empty())
+	{
+		va->SetElements(mesh.indices);
+	}
+	va->SetBounds(mesh.boundsMin, mesh.boundsMax);
+	va->Upload();
+	return va;
+}
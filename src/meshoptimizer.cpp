@@ -0,0 +1,341 @@
+#include "meshoptimizer.hpp"
+#include "meshimporter.hpp"
+#include "log.hpp"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <numeric>
+
+namespace
+{
+	constexpr uint32_t MissingIndex = UINT32_MAX;
+
+	// FIFO cache simulation: a vertex is cached while fewer than cacheSize vertices were inserted after it.
+	// Bumping timestamp by cacheSize + 1 flushes the whole cache.
+	struct CacheSimulation
+	{
+		CacheSimulation(uint32_t vertexCount, uint32_t cacheSize)
+			: cacheTime(vertexCount, 0)
+			, timestamp(cacheSize + 1)
+			, size(cacheSize)
+		{
+
+		}
+
+		bool IsCached(uint32_t v) const { return timestamp - cacheTime[v] <= size; }
+
+		// Returns 1 on a cache miss
+		uint32_t Access(uint32_t v)
+		{
+			if (IsCached(v))
+			{
+				return 0;
+			}
+			cacheTime[v] = timestamp++;
+			return 1;
+		}
+
+		void Flush() { timestamp += size + 1; }
+
+		std::vector<uint32_t> cacheTime;
+		uint32_t timestamp;
+		uint32_t size;
+	};
+
+	inline glm::vec3 GetPosition(const float* positions, size_t stride, uint32_t v)
+	{
+		const float* p = (const float*)((const uint8_t*)positions + v * stride);
+		return glm::vec3(p[0], p[1], p[2]);
+	}
+}
+
+VertexCacheStatistics AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, uint32_t vertexCount, uint32_t cacheSize)
+{
+	VertexCacheStatistics stats;
+	CacheSimulation cache(vertexCount, cacheSize);
+	std::vector<bool> referenced(vertexCount, false);
+	uint32_t referencedCount = 0;
+	for (size_t i = 0; i < indexCount; i++)
+	{
+		uint32_t v = indices[i];
+		stats.vertexTransforms += cache.Access(v);
+		if (!referenced[v])
+		{
+			referenced[v] = true;
+			referencedCount++;
+		}
+	}
+
+	size_t triangleCount = indexCount / 3;
+	stats.acmr = triangleCount ? (float)stats.vertexTransforms / triangleCount : 0.0f;
+	stats.atvr = referencedCount ? (float)stats.vertexTransforms / referencedCount : 0.0f;
+	return stats;
+}
+
+void OptimizeVertexCache(uint32_t* destination, const uint32_t* indices, size_t indexCount, uint32_t vertexCount, uint32_t cacheSize, std::vector<uint32_t>* clusters)
+{
+	uint32_t triangleCount = (uint32_t)(indexCount / 3);
+
+	// vertex to triangle adjacency in compressed rows
+	std::vector<uint32_t> offsets(vertexCount + 1, 0);
+	for (size_t i = 0; i < indexCount; i++)
+	{
+		offsets[indices[i] + 1]++;
+	}
+	std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+	std::vector<uint32_t> adjacency(indexCount);
+	std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+	for (size_t i = 0; i < indexCount; i++)
+	{
+		adjacency[fill[indices[i]]++] = (uint32_t)(i / 3);
+	}
+
+	std::vector<uint32_t> live(vertexCount); // triangles not emitted yet per vertex
+	for (uint32_t v = 0; v < vertexCount; v++)
+	{
+		live[v] = offsets[v + 1] - offsets[v];
+	}
+
+	CacheSimulation cache(vertexCount, cacheSize);
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<uint32_t> deadEnd;
+	deadEnd.reserve(indexCount);
+	std::vector<uint32_t> candidates;
+	uint32_t cursor = 0;
+	uint32_t outputTriangle = 0;
+
+	auto nextLiveVertex = [&]() {
+		while (cursor < vertexCount && live[cursor] == 0)
+		{
+			cursor++;
+		}
+		return cursor < vertexCount ? cursor : MissingIndex;
+	};
+
+	uint32_t fan = nextLiveVertex();
+	while (fan != MissingIndex)
+	{
+		if (clusters && !cache.IsCached(fan))
+		{
+			clusters->push_back(outputTriangle);
+		}
+
+		// emit every remaining triangle around the fanning vertex
+		candidates.clear();
+		for (uint32_t a = offsets[fan]; a < offsets[fan + 1]; a++)
+		{
+			uint32_t t = adjacency[a];
+			if (emitted[t])
+			{
+				continue;
+			}
+			for (uint32_t c = 0; c < 3; c++)
+			{
+				uint32_t v = indices[t * 3 + c];
+				destination[outputTriangle * 3 + c] = v;
+				deadEnd.push_back(v);
+				candidates.push_back(v);
+				live[v]--;
+				cache.Access(v);
+			}
+			emitted[t] = true;
+			outputTriangle++;
+		}
+
+		// continue with the oldest candidate that is still cached after its own fan is emitted, a candidate that would
+		// not be has priority 0 and is never picked, the dead end stack below takes over then
+		fan = MissingIndex;
+		int64_t bestPriority = 0;
+		for (uint32_t v : candidates)
+		{
+			if (live[v] == 0)
+			{
+				continue;
+			}
+			int64_t priority = 0;
+			uint32_t age = cache.timestamp - cache.cacheTime[v];
+			if (age + 2 * live[v] <= cacheSize)
+			{
+				priority = age;
+			}
+			if (priority > bestPriority)
+			{
+				bestPriority = priority;
+				fan = v;
+			}
+		}
+
+		// dead end, fall back to recently used vertices and then to the input order
+		while (fan == MissingIndex && !deadEnd.empty())
+		{
+			uint32_t v = deadEnd.back();
+			deadEnd.pop_back();
+			if (live[v] > 0)
+			{
+				fan = v;
+			}
+		}
+		if (fan == MissingIndex)
+		{
+			fan = nextLiveVertex();
+		}
+	}
+
+	if (clusters)
+	{
+		clusters->push_back(triangleCount);
+	}
+}
+
+uint32_t OptimizeOverdraw(uint32_t* destination, const uint32_t* indices, size_t indexCount, const float* positions, uint32_t vertexCount,
+	size_t positionStride, const std::vector<uint32_t>& hardClusters, uint32_t cacheSize, float threshold)
+{
+	uint32_t triangleCount = (uint32_t)(indexCount / 3);
+
+	// split every cold start run further wherever the local ACMR already is within threshold of the run's ACMR,
+	// so sorting the pieces costs little vertex cache efficiency
+	std::vector<uint32_t> clusters;
+	CacheSimulation cache(vertexCount, cacheSize);
+	for (size_t h = 0; h + 1 < hardClusters.size(); h++)
+	{
+		uint32_t begin = hardClusters[h];
+		uint32_t end = hardClusters[h + 1];
+		if (begin >= end)
+		{
+			continue;
+		}
+
+		cache.Flush();
+		uint32_t misses = 0;
+		for (uint32_t i = begin * 3; i < end * 3; i++)
+		{
+			misses += cache.Access(indices[i]);
+		}
+		float clusterThreshold = threshold * misses / (end - begin);
+
+		clusters.push_back(begin);
+		cache.Flush();
+		uint32_t runMisses = 0, runTriangles = 0;
+		for (uint32_t t = begin; t < end; t++)
+		{
+			for (uint32_t c = 0; c < 3; c++)
+			{
+				runMisses += cache.Access(indices[t * 3 + c]);
+			}
+			runTriangles++;
+			if (t + 1 < end && (float)runMisses / runTriangles <= clusterThreshold)
+			{
+				clusters.push_back(t + 1);
+				cache.Flush();
+				runMisses = runTriangles = 0;
+			}
+		}
+	}
+	clusters.push_back(triangleCount);
+
+	uint32_t clusterCount = (uint32_t)clusters.size() - 1;
+	std::vector<glm::vec3> centroids(clusterCount);
+	std::vector<glm::vec3> normals(clusterCount);
+	glm::vec3 meshCentroid(0.0f);
+	float meshArea = 0.0f;
+	for (uint32_t c = 0; c < clusterCount; c++)
+	{
+		glm::vec3 centroid(0.0f), normal(0.0f);
+		float area = 0.0f;
+		for (uint32_t t = clusters[c]; t < clusters[c + 1]; t++)
+		{
+			glm::vec3 p0 = GetPosition(positions, positionStride, indices[t * 3 + 0]);
+			glm::vec3 p1 = GetPosition(positions, positionStride, indices[t * 3 + 1]);
+			glm::vec3 p2 = GetPosition(positions, positionStride, indices[t * 3 + 2]);
+			glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+			float triangleArea = glm::length(n);
+			centroid += (p0 + p1 + p2) * (triangleArea / 3.0f);
+			normal += n;
+			area += triangleArea;
+		}
+		meshCentroid += centroid;
+		meshArea += area;
+		centroids[c] = area > 0.0f ? centroid / area : GetPosition(positions, positionStride, indices[clusters[c] * 3]);
+		float length = glm::length(normal);
+		normals[c] = length > 0.0f ? normal / length : glm::vec3(0.0f);
+	}
+	if (meshArea > 0.0f)
+	{
+		meshCentroid /= meshArea;
+	}
+
+	// clusters facing away from the center are likely to occlude the others, draw them first
+	std::vector<float> sortKeys(clusterCount);
+	for (uint32_t c = 0; c < clusterCount; c++)
+	{
+		sortKeys[c] = glm::dot(centroids[c] - meshCentroid, normals[c]);
+	}
+	std::vector<uint32_t> order(clusterCount);
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+	uint32_t* out = destination;
+	for (uint32_t c : order)
+	{
+		size_t count = (size_t)(clusters[c + 1] - clusters[c]) * 3;
+		memcpy(out, &indices[(size_t)clusters[c] * 3], count * sizeof(uint32_t));
+		out += count;
+	}
+	return clusterCount;
+}
+
+void OptimizeVertexFetch(MeshData& mesh)
+{
+	uint32_t stride = mesh.GetVertexStride();
+	uint32_t vertexCount = mesh.GetVertexCount();
+
+	std::vector<uint32_t> remap(vertexCount, MissingIndex);
+	std::vector<uint8_t> vertices;
+	vertices.reserve(mesh.vertices.size());
+	uint32_t next = 0;
+	for (uint32_t& index : mesh.indices)
+	{
+		if (remap[index] == MissingIndex)
+		{
+			remap[index] = next++;
+			const uint8_t* v = &mesh.vertices[(size_t)index * stride];
+			vertices.insert(vertices.end(), v, v + stride);
+		}
+		index = remap[index];
+	}
+	mesh.vertices = std::move(vertices);
+}
+
+bool OptimizeMesh(MeshData& mesh, MeshOptimizationStats* stats)
+{
+	if (mesh.layout.empty() || mesh.layout[0] != VertexAttribute{ 3 } || mesh.indices.size() % 3 != 0)
+	{
+		LOG("Mesh optimization needs float positions as the first attribute and a triangle list");
+		return false;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	size_t indexCount = mesh.indices.size();
+	uint32_t vertexCount = mesh.GetVertexCount();
+	MeshOptimizationStats result;
+	result.before = AnalyzeVertexCache(mesh.indices.data(), indexCount, vertexCount);
+
+	std::vector<uint32_t> cacheOrder(indexCount);
+	std::vector<uint32_t> clusters;
+	OptimizeVertexCache(cacheOrder.data(), mesh.indices.data(), indexCount, vertexCount, DefaultVertexCacheSize, &clusters);
+	result.clusterCount = OptimizeOverdraw(mesh.indices.data(), cacheOrder.data(), indexCount, (const float*)mesh.vertices.data(), vertexCount,
+		mesh.GetVertexStride(), clusters);
+	OptimizeVertexFetch(mesh);
+
+	result.after = AnalyzeVertexCache(mesh.indices.data(), indexCount, mesh.GetVertexCount());
+	result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	if (stats)
+	{
+		*stats = result;
+	}
+	return true;
+}
@@ -0,0 +1,204 @@
+#include "profileexport.hpp"
+#include "profiler.hpp"
+#include "log.hpp"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+	void WriteJsonString(std::ostream& out, std::string_view text)
+	{
+		out << '"';
+		for (char c : text)
+		{
+			if (c == '"' || c == '\\')
+			{
+				out << '\\' << c;
+			}
+			else if ((unsigned char)c < 0x20)
+			{
+				char escaped[8];
+				snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+				out << escaped;
+			}
+			else
+			{
+				out << c;
+			}
+		}
+		out << '"';
+	}
+
+	void WriteCsvField(std::ostream& out, std::string_view text)
+	{
+		out << '"';
+		for (char c : text)
+		{
+			if (c == '"')
+			{
+				out << '"';
+			}
+			out << c;
+		}
+		out << '"';
+	}
+
+	bool OpenOutput(const std::string& path, std::ofstream& out)
+	{
+		std::error_code ec;
+		std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+		out.open(path, std::ios::binary | std::ios::trunc);
+		if (!out)
+		{
+			LOG("Could not open %s for writing", path.c_str());
+			return false;
+		}
+		return true;
+	}
+}
+
+bool WriteChromeTrace(const ProfileCapture& capture, const std::string& path)
+{
+	std::ofstream out;
+	if (!OpenOutput(path, out))
+	{
+		return false;
+	}
+
+	// timestamps are microseconds, relative to the first captured frame
+	uint64_t origin = capture.frames.empty() ? 0 : capture.frames.front().begin;
+	auto toMicroseconds = [origin](uint64_t time) { return (double)(int64_t)(time - origin) / 1000.0; };
+
+	out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	out << "{\"ph\":\"M\",\"pid\":1,\"name\":\"process_name\",\"args\":{\"name\":\"MicroModeler3D\"}}";
+	for (size_t lane = 0; lane < capture.laneNames.size(); lane++)
+	{
+		out << ",\n{\"ph\":\"M\",\"pid\":1,\"tid\":" << lane << ",\"name\":\"thread_name\",\"args\":{\"name\":";
+		WriteJsonString(out, capture.laneNames[lane]);
+		out << "}}";
+	}
+
+	char number[64];
+	for (size_t frameIndex = 0; frameIndex < capture.frames.size(); frameIndex++)
+	{
+		const ProfileCapture::Frame& frame = capture.frames[frameIndex];
+		snprintf(number, sizeof(number), "%.3f,\"dur\":%.3f", toMicroseconds(frame.begin), (frame.end - frame.begin) / 1000.0);
+		out << ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":" << capture.laneNames.size() << ",\"name\":\"Frame " << frameIndex << "\",\"ts\":" << number << "}";
+
+		for (const auto& [lane, event] : frame.events)
+		{
+			out << ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":" << lane << ",\"name\":";
+			WriteJsonString(out, event.name);
+			snprintf(number, sizeof(number), "%.3f,\"dur\":%.3f", toMicroseconds(event.start), (event.end - event.start) / 1000.0);
+			out << ",\"ts\":" << number << "}";
+		}
+
+		for (const auto& [name, value] : frame.counters)
+		{
+			out << ",\n{\"ph\":\"C\",\"pid\":1,\"name\":";
+			WriteJsonString(out, name);
+			snprintf(number, sizeof(number), "%.3f,\"args\":{\"value\":%.17g}", toMicroseconds(frame.begin), value);
+			out << ",\"ts\":" << number << "}";
+		}
+	}
+	out << ",\n{\"ph\":\"M\",\"pid\":1,\"tid\":" << capture.laneNames.size() << ",\"name\":\"thread_name\",\"args\":{\"name\":\"Frames\"}}";
+	out << "\n]}\n";
+
+	if (!out)
+	{
+		LOG("Failed writing %s", path.c_str());
+		return false;
+	}
+	return true;
+}
+
+bool WriteProfileCsv(const ProfileCapture& capture, const std::string& path)
+{
+	std::ofstream out;
+	if (!OpenOutput(path, out))
+	{
+		return false;
+	}
+
+	// columns are every counter and zone seen in any frame, in order of first appearance
+	std::vector<const char*> counters;
+	std::unordered_map<std::string_view, size_t> counterColumns;
+	std::vector<std::string> zones;
+	std::unordered_map<std::string, size_t> zoneColumns;
+	for (const ProfileCapture::Frame& frame : capture.frames)
+	{
+		for (const auto& counter : frame.counters)
+		{
+			if (counterColumns.emplace(counter.first, counters.size()).second)
+			{
+				counters.push_back(counter.first);
+			}
+		}
+		for (const auto& [lane, event] : frame.events)
+		{
+			std::string zone = capture.laneIsGpu[lane] ? std::string("GPU ") + event.name : std::string(event.name);
+			if (zoneColumns.emplace(zone, zones.size()).second)
+			{
+				zones.push_back(zone);
+			}
+		}
+	}
+
+	out << "Frame,Frame ms";
+	for (const char* counter : counters)
+	{
+		out << ',';
+		WriteCsvField(out, counter);
+	}
+	for (const std::string& zone : zones)
+	{
+		out << ',';
+		WriteCsvField(out, zone + " ms");
+	}
+	out << '\n';
+
+	std::vector<double> counterValues(counters.size());
+	std::vector<double> zoneTimes(zones.size());
+	char number[32];
+	for (size_t frameIndex = 0; frameIndex < capture.frames.size(); frameIndex++)
+	{
+		const ProfileCapture::Frame& frame = capture.frames[frameIndex];
+		std::fill(counterValues.begin(), counterValues.end(), 0.0);
+		std::fill(zoneTimes.begin(), zoneTimes.end(), 0.0);
+		for (const auto& counter : frame.counters)
+		{
+			counterValues[counterColumns[counter.first]] = counter.second;
+		}
+		for (const auto& [lane, event] : frame.events)
+		{
+			std::string zone = capture.laneIsGpu[lane] ? std::string("GPU ") + event.name : std::string(event.name);
+			zoneTimes[zoneColumns[zone]] += (event.end - event.start) / 1e6;
+		}
+
+		snprintf(number, sizeof(number), "%.4f", (frame.end - frame.begin) / 1e6);
+		out << frameIndex << ',' << number;
+		for (double value : counterValues)
+		{
+			snprintf(number, sizeof(number), "%.17g", value);
+			out << ',' << number;
+		}
+		for (double time : zoneTimes)
+		{
+			snprintf(number, sizeof(number), "%.4f", time);
+			out << ',' << number;
+		}
+		out << '\n';
+	}
+
+	if (!out)
+	{
+		LOG("Failed writing %s", path.c_str());
+		return false;
+	}
+	return true;
+}
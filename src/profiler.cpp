@@ -0,0 +1,417 @@
+#include "profiler.hpp"
+#include "commandbuffer.hpp"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace
+{
+	constexpr uint32_t RingSize = 1 << 13; // events per thread between two drains
+	constexpr uint32_t StatsWindow = 240; // frames per zone the statistics look back over
+	constexpr uint32_t MaxGpuZones = 16; // per frame
+
+	const std::chrono::steady_clock::time_point ProfilerEpoch = std::chrono::steady_clock::now();
+}
+
+// Single producer, single consumer: the owning thread pushes, EndFrame on the main thread drains
+struct Profiler::Ring
+{
+	std::string name;
+	bool isGpu = false;
+	std::unique_ptr<ProfileEvent[]> events = std::make_unique<ProfileEvent[]>(RingSize);
+	std::atomic<uint32_t> head = 0;
+	std::atomic<uint32_t> tail = 0;
+	std::atomic<uint64_t> dropped = 0;
+	std::atomic<bool> isFree = false; // its thread exited
+	uint32_t depth = 0; // owning thread only
+
+	void Push(const ProfileEvent& event)
+	{
+		uint32_t position = head.load(std::memory_order_relaxed);
+		if (position - tail.load(std::memory_order_acquire) >= RingSize)
+		{
+			dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		events[position & (RingSize - 1)] = event;
+		head.store(position + 1, std::memory_order_release);
+	}
+
+	void Drain(std::vector<ProfileEvent>& out)
+	{
+		uint32_t position = tail.load(std::memory_order_relaxed);
+		uint32_t end = head.load(std::memory_order_acquire);
+		for (; position != end; position++)
+		{
+			out.push_back(events[position & (RingSize - 1)]);
+		}
+		tail.store(position, std::memory_order_release);
+	}
+};
+
+struct Profiler::ZoneSamples
+{
+	std::string_view name;
+	bool isGpu;
+	float samples[StatsWindow]; // ms per frame, a ring
+	uint32_t count, next;
+	float frameMs; // summed while draining
+};
+
+struct Profiler::GpuQuerySet
+{
+	uint32_t queries[MaxGpuZones] = {};
+	const char* names[MaxGpuZones] = {};
+	uint64_t starts[MaxGpuZones] = {};
+	uint32_t count = 0;
+	bool isOpen = false;
+};
+
+thread_local Profiler::ThreadRing Profiler::mThreadRing;
+
+Profiler::Profiler()
+	: mIsPaused(false)
+	, mGpuRing(nullptr)
+	, mFrameBegin(0)
+	, mFrameEnd(0)
+	, mCurrentFrameBegin(0)
+	, mCaptureFrameCount(0)
+	, mWasEnabledBeforeCapture(false)
+	, mGpuQuerySets(std::make_unique<GpuQuerySet[]>(2))
+	, mGpuQuerySet(0)
+{
+	mGpuRing = CreateRing("GPU", true);
+}
+
+Profiler::~Profiler()
+{
+
+}
+
+Profiler& Profiler::Get()
+{
+	// never destroyed, pool threads may still close zones while statics are torn down
+	static Profiler* profiler = new Profiler();
+	return *profiler;
+}
+
+uint64_t Profiler::GetTime()
+{
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - ProfilerEpoch).count();
+}
+
+void Profiler::SetEnabled(bool isEnabled)
+{
+	mIsEnabled.store(isEnabled, std::memory_order_relaxed);
+}
+
+void Profiler::SetThreadName(const char* name)
+{
+	Ring* ring = GetThreadRing();
+	std::lock_guard<std::mutex> lock(mRingsMutex);
+	ring->name = name;
+}
+
+Profiler::ThreadRing::~ThreadRing()
+{
+	if (ring)
+	{
+		ring->isFree.store(true, std::memory_order_release);
+	}
+}
+
+Profiler::Ring* Profiler::CreateRing(const char* name, bool isGpu)
+{
+	std::lock_guard<std::mutex> lock(mRingsMutex);
+	for (auto& ring : mRings)
+	{
+		if (ring->isFree.load(std::memory_order_acquire))
+		{
+			ring->isFree.store(false, std::memory_order_relaxed);
+			ring->name = name ? name : "Thread";
+			ring->depth = 0;
+			return ring.get();
+		}
+	}
+	mRings.push_back(std::make_unique<Ring>());
+	mRings.back()->name = name ? name : "Thread " + std::to_string(mRings.size() - 1);
+	mRings.back()->isGpu = isGpu;
+	return mRings.back().get();
+}
+
+Profiler::Ring* Profiler::GetThreadRing()
+{
+	if (!mThreadRing.ring)
+	{
+		mThreadRing.ring = CreateRing(nullptr, false);
+	}
+	return mThreadRing.ring;
+}
+
+uint32_t Profiler::EnterZone()
+{
+	return GetThreadRing()->depth++;
+}
+
+void Profiler::PushEvent(const ProfileEvent& event)
+{
+	Ring* ring = GetThreadRing();
+	ring->depth--;
+	ring->Push(event);
+}
+
+void Profiler::BeginFrame()
+{
+	mCurrentFrameBegin = GetTime();
+}
+
+void Profiler::EndFrame()
+{
+	uint64_t now = GetTime();
+	std::unique_lock<std::mutex> lock(mRingsMutex);
+	if (!mIsPaused)
+	{
+		mFrameBegin = mCurrentFrameBegin;
+		mFrameEnd = now;
+		mLanes.resize(mRings.size());
+	}
+
+	ProfileCapture::Frame* captureFrame = nullptr;
+	if (mCapture)
+	{
+		captureFrame = &mCapture->frames.emplace_back();
+		captureFrame->begin = mCurrentFrameBegin;
+		captureFrame->end = now;
+		captureFrame->counters = mCounters;
+	}
+
+	for (size_t i = 0; i < mRings.size(); i++)
+	{
+		Ring& ring = *mRings[i];
+		mDrained.clear();
+		ring.Drain(mDrained); // also while paused, so the rings do not fill up
+		if (captureFrame)
+		{
+			for (const ProfileEvent& event : mDrained)
+			{
+				captureFrame->events.push_back({ (uint32_t)i, event });
+			}
+		}
+		if (mIsPaused)
+		{
+			continue;
+		}
+
+		ProfileLane& lane = mLanes[i];
+		lane.name = ring.name;
+		lane.isGpu = ring.isGpu;
+		lane.events.clear();
+
+		// GPU results arrive two frames late, they are shown from the start of the frame with their own durations
+		uint64_t gpuOffset = ring.isGpu && !mDrained.empty() ? mDrained.front().start - mFrameBegin : 0;
+		for (const ProfileEvent& event : mDrained)
+		{
+			ProfileEvent shown = { event.name, event.start - gpuOffset, event.end - gpuOffset, event.depth };
+			if (shown.end > mFrameBegin && shown.start < mFrameEnd)
+			{
+				lane.events.push_back(shown);
+			}
+
+			ZoneSamples& zone = mZones[GetZoneIndex(event.name, ring.isGpu)];
+			if (zone.frameMs < 0.0f)
+			{
+				zone.frameMs = 0.0f;
+				mTouchedZones.push_back((uint32_t)(&zone - mZones.data()));
+			}
+			zone.frameMs += (float)((event.end - event.start) / 1e6);
+		}
+	}
+
+	for (uint32_t index : mTouchedZones)
+	{
+		ZoneSamples& zone = mZones[index];
+		zone.samples[zone.next] = zone.frameMs;
+		zone.next = (zone.next + 1) % StatsWindow;
+		zone.count = std::min(zone.count + 1, StatsWindow);
+		zone.frameMs = -1.0f;
+	}
+	mTouchedZones.clear();
+
+	if (mCapture && mCapture->frames.size() >= mCaptureFrameCount)
+	{
+		for (const auto& ring : mRings)
+		{
+			mCapture->laneNames.push_back(ring->name);
+			mCapture->laneIsGpu.push_back(ring->isGpu);
+		}
+		lock.unlock();
+		SetEnabled(mWasEnabledBeforeCapture);
+		std::shared_ptr<ProfileCapture> capture = std::move(mCapture);
+		mCapture.reset();
+		auto onComplete = std::move(mOnCaptureComplete);
+		onComplete(std::move(capture));
+	}
+}
+
+void Profiler::SetCounter(const char* name, double value)
+{
+	for (auto& counter : mCounters)
+	{
+		if (counter.first == name)
+		{
+			counter.second = value;
+			return;
+		}
+	}
+	mCounters.push_back({ name, value });
+}
+
+void Profiler::StartCapture(uint32_t frameCount, std::function<void(std::shared_ptr<ProfileCapture>)> onComplete)
+{
+	if (mCapture || frameCount == 0)
+	{
+		return;
+	}
+	mCapture = std::make_shared<ProfileCapture>();
+	mCapture->frames.reserve(frameCount);
+	mCaptureFrameCount = frameCount;
+	mOnCaptureComplete = std::move(onComplete);
+	mWasEnabledBeforeCapture = IsEnabled();
+	SetEnabled(true);
+}
+
+uint32_t Profiler::GetZoneIndex(const char* name, bool isGpu)
+{
+	auto it = mZonesByPointer[isGpu].find(name);
+	if (it != mZonesByPointer[isGpu].end())
+	{
+		return it->second;
+	}
+
+	// the same name may come from literals in different translation units
+	auto byName = mZonesByName[isGpu].find(name);
+	uint32_t index = (uint32_t)mZones.size();
+	if (byName != mZonesByName[isGpu].end())
+	{
+		index = byName->second;
+	}
+	else
+	{
+		ZoneSamples zone = {};
+		zone.name = name;
+		zone.isGpu = isGpu;
+		zone.frameMs = -1.0f;
+		mZones.push_back(zone);
+		mZonesByName[isGpu][name] = index;
+	}
+	mZonesByPointer[isGpu][name] = index;
+	return index;
+}
+
+void Profiler::GetZoneStats(std::vector<ProfileZoneStats>& stats) const
+{
+	stats.clear();
+	float sorted[StatsWindow];
+	for (const ZoneSamples& zone : mZones)
+	{
+		if (zone.count == 0)
+		{
+			continue;
+		}
+		float sum = 0.0f;
+		for (uint32_t i = 0; i < zone.count; i++)
+		{
+			sorted[i] = zone.samples[i];
+			sum += zone.samples[i];
+		}
+		std::sort(sorted, sorted + zone.count);
+		uint32_t p99 = std::min(zone.count - 1, (uint32_t)std::ceil(zone.count * 0.99f) - 1);
+		float last = zone.samples[(zone.next + StatsWindow - 1) % StatsWindow];
+		stats.push_back({ zone.name, zone.isGpu, last, sorted[0], sum / zone.count, sorted[p99], zone.count });
+	}
+}
+
+uint64_t Profiler::GetDroppedEvents() const
+{
+	std::lock_guard<std::mutex> lock(mRingsMutex);
+	uint64_t dropped = 0;
+	for (const auto& ring : mRings)
+	{
+		dropped += ring->dropped.load(std::memory_order_relaxed);
+	}
+	return dropped;
+}
+
+void Profiler::BeginGpuZone(CommandBuffer& commands, const char* name)
+{
+	commands.Callback(&Profiler::GpuBegin, const_cast<char*>(name));
+}
+
+void Profiler::EndGpuZone(CommandBuffer& commands)
+{
+	commands.Callback(&Profiler::GpuEnd, nullptr);
+}
+
+void Profiler::EndGpuFrame(CommandBuffer& commands)
+{
+	if (IsEnabled())
+	{
+		commands.Callback(&Profiler::GpuFrameEnd, nullptr);
+	}
+}
+
+void Profiler::GpuBegin(void* name)
+{
+	Profiler& profiler = Get();
+	GpuQuerySet& set = profiler.mGpuQuerySets[profiler.mGpuQuerySet];
+	if (set.isOpen || set.count == MaxGpuZones)
+	{
+		return;
+	}
+	if (set.queries[0] == 0)
+	{
+		glGenQueries(MaxGpuZones, set.queries);
+	}
+	set.names[set.count] = (const char*)name;
+	set.starts[set.count] = GetTime();
+	glBeginQuery(GL_TIME_ELAPSED, set.queries[set.count]);
+	set.isOpen = true;
+}
+
+void Profiler::GpuEnd(void*)
+{
+	Profiler& profiler = Get();
+	GpuQuerySet& set = profiler.mGpuQuerySets[profiler.mGpuQuerySet];
+	if (!set.isOpen)
+	{
+		return;
+	}
+	glEndQuery(GL_TIME_ELAPSED);
+	set.count++;
+	set.isOpen = false;
+}
+
+void Profiler::GpuFrameEnd(void*)
+{
+	// the other set was issued the frame before last, results that are still not ready are dropped
+	Profiler& profiler = Get();
+	profiler.mGpuQuerySet ^= 1;
+	GpuQuerySet& set = profiler.mGpuQuerySets[profiler.mGpuQuerySet];
+	for (uint32_t i = 0; i < set.count; i++)
+	{
+		GLint isAvailable = 0;
+		glGetQueryObjectiv(set.queries[i], GL_QUERY_RESULT_AVAILABLE, &isAvailable);
+		if (!isAvailable)
+		{
+			profiler.mGpuRing->dropped.fetch_add(1, std::memory_order_relaxed);
+			continue;
+		}
+		GLuint64 elapsed = 0;
+		glGetQueryObjectui64v(set.queries[i], GL_QUERY_RESULT, &elapsed);
+		profiler.mGpuRing->Push({ set.names[i], set.starts[i], set.starts[i] + elapsed, 0 });
+	}
+	set.count = 0;
+}
@@ -0,0 +1,167 @@
+#include "readback.hpp"
+#include "commandbuffer.hpp"
+#include "framebuffer.hpp"
+#include "renderthread.hpp"
+#include "profiler.hpp"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+	constexpr GLuint64 FenceWaitTimeout = 100'000'000; // nanoseconds per wait, repeated until the fence signals
+}
+
+struct FramebufferReadback::Read
+{
+	FramebufferReadback* readback;
+	uint32_t framebuffer;
+	uint32_t width, height;
+	std::function<void(ImageRgba8&&)> onReady;
+	uint32_t slot = 0;
+	GLsync fence = nullptr;
+};
+
+FramebufferReadback::FramebufferReadback(uint32_t ringSize)
+	: mRingSize(std::max(ringSize, 1u))
+	, mPendingCount(0)
+{
+
+}
+
+FramebufferReadback::~FramebufferReadback()
+{
+	RenderThread::Get().Run([this]() {
+		for (Read* read : mInFlight)
+		{
+			glDeleteSync(read->fence);
+			delete read;
+		}
+		mInFlight.clear();
+		for (const Slot& slot : mSlots)
+		{
+			glDeleteBuffers(1, &slot.buffer);
+		}
+	});
+}
+
+void FramebufferReadback::Request(CommandBuffer& commands, Framebuffer& framebuffer, std::function<void(ImageRgba8&&)> onReady)
+{
+	mPendingCount++;
+	Read* read = new Read{ this, framebuffer.GetFB(), (uint32_t)framebuffer.GetSize().x, (uint32_t)framebuffer.GetSize().y, std::move(onReady) };
+	commands.Callback(&FramebufferReadback::IssueRead, read);
+}
+
+void FramebufferReadback::Poll(CommandBuffer& commands)
+{
+	commands.Callback(&FramebufferReadback::PollReads, this);
+}
+
+void FramebufferReadback::Flush()
+{
+	RenderThread::Get().Run([this]() {
+		while (!mInFlight.empty())
+		{
+			Complete(true);
+		}
+	});
+}
+
+void FramebufferReadback::IssueRead(void* data)
+{
+	PROFILE_ZONE("Readback");
+	Read* read = (Read*)data;
+	FramebufferReadback& readback = *read->readback;
+
+	if (readback.mFreeSlots.empty())
+	{
+		if (readback.mSlots.size() < readback.mRingSize)
+		{
+			readback.mFreeSlots.push_back((uint32_t)readback.mSlots.size());
+			readback.mSlots.emplace_back();
+			glGenBuffers(1, &readback.mSlots.back().buffer);
+		}
+		else
+		{
+			readback.Complete(true); // the ring is full, the GPU is further behind than it holds
+		}
+	}
+	read->slot = readback.mFreeSlots.back();
+	readback.mFreeSlots.pop_back();
+	Slot& slot = readback.mSlots[read->slot];
+
+	size_t size = (size_t)read->width * read->height * 4;
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+	if (slot.size != size)
+	{
+		glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+		slot.size = size;
+	}
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, read->framebuffer);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, read->width, read->height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr); // into the buffer, returns at once
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	read->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	readback.mInFlight.push_back(read);
+}
+
+void FramebufferReadback::PollReads(void* data)
+{
+	FramebufferReadback& readback = *(FramebufferReadback*)data;
+	while (!readback.mInFlight.empty())
+	{
+		GLenum status = glClientWaitSync(readback.mInFlight.front()->fence, 0, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+		{
+			break; // reads finish in order, the newer ones are not done either
+		}
+		readback.Complete(false);
+	}
+}
+
+void FramebufferReadback::Complete(bool isWaiting)
+{
+	Read* read = mInFlight.front();
+	if (isWaiting)
+	{
+		PROFILE_ZONE("Readback wait");
+		GLenum status;
+		do
+		{
+			status = glClientWaitSync(read->fence, GL_SYNC_FLUSH_COMMANDS_BIT, FenceWaitTimeout);
+		} while (status == GL_TIMEOUT_EXPIRED);
+	}
+	mInFlight.pop_front();
+	glDeleteSync(read->fence);
+
+	// GL has the bottom row first, images are top down
+	PROFILE_ZONE("Readback copy");
+	ImageRgba8 image;
+	image.width = read->width;
+	image.height = read->height;
+	image.pixels.resize((size_t)read->width * read->height * 4);
+	size_t stride = (size_t)read->width * 4;
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, mSlots[read->slot].buffer);
+	const uint8_t* mapped = (const uint8_t*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, image.pixels.size(), GL_MAP_READ_BIT);
+	if (mapped)
+	{
+		for (uint32_t y = 0; y < read->height; y++)
+		{
+			std::memcpy(image.pixels.data() + y * stride, mapped + (size_t)(read->height - 1 - y) * stride, stride);
+		}
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	mFreeSlots.push_back(read->slot);
+
+	if (mapped)
+	{
+		read->onReady(std::move(image));
+	}
+	delete read;
+	mPendingCount--;
+}
@@ -0,0 +1,160 @@
+#include "renderthread.hpp"
+#include "commandbuffer.hpp"
+#include "profiler.hpp"
+
+RenderThread::RenderThread()
+	: mSubmittedJobs(0)
+	, mCompletedJobs(0)
+	, mSubmittedFrames(0)
+	, mCompletedFrames(0)
+	, mIsStopping(false)
+{
+
+}
+
+RenderThread::~RenderThread()
+{
+	Stop();
+}
+
+RenderThread& RenderThread::Get()
+{
+	static RenderThread renderThread;
+	return renderThread;
+}
+
+void RenderThread::Start(std::function<void()> makeCurrent, std::function<void()> releaseContext)
+{
+	if (IsRunning())
+	{
+		return;
+	}
+	mIsStopping = false;
+	mThread = std::thread(&RenderThread::ThreadLoop, this, std::move(makeCurrent), std::move(releaseContext));
+}
+
+void RenderThread::Stop()
+{
+	if (!IsRunning())
+	{
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mIsStopping = true;
+	}
+	mJobAdded.notify_one();
+	mThread.join();
+}
+
+bool RenderThread::IsRenderThread() const
+{
+	return std::this_thread::get_id() == mThread.get_id();
+}
+
+void RenderThread::Run(const std::function<void()>& fn)
+{
+	if (!IsRunning() || IsRenderThread())
+	{
+		fn();
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(mMutex);
+	mJobs.push_back({ nullptr, [&fn]() { fn(); } });
+	uint64_t job = ++mSubmittedJobs;
+	mJobAdded.notify_one();
+	mJobDone.wait(lock, [&]() { return mCompletedJobs >= job; });
+}
+
+void RenderThread::Post(std::function<void()> fn)
+{
+	if (!IsRunning() || IsRenderThread())
+	{
+		fn();
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mJobs.push_back({ nullptr, std::move(fn) });
+		mSubmittedJobs++;
+	}
+	mJobAdded.notify_one();
+}
+
+void RenderThread::Submit(const CommandBuffer& commands)
+{
+	if (!IsRunning())
+	{
+		commands.Execute();
+		mSubmittedFrames++;
+		mCompletedFrames++;
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(mMutex);
+	mJobs.push_back({ &commands, nullptr });
+	mSubmittedJobs++;
+	uint64_t previousFrame = mSubmittedFrames++;
+	mJobAdded.notify_one();
+	mJobDone.wait(lock, [&]() { return mCompletedFrames >= previousFrame; });
+}
+
+void RenderThread::WaitIdle()
+{
+	if (!IsRunning() || IsRenderThread())
+	{
+		return;
+	}
+	std::unique_lock<std::mutex> lock(mMutex);
+	uint64_t job = mSubmittedJobs;
+	mJobDone.wait(lock, [&]() { return mCompletedJobs >= job; });
+}
+
+uint64_t RenderThread::GetCompletedFrames() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mCompletedFrames;
+}
+
+void RenderThread::ThreadLoop(std::function<void()> makeCurrent, std::function<void()> releaseContext)
+{
+	makeCurrent();
+	Profiler::Get().SetThreadName("Render");
+
+	std::unique_lock<std::mutex> lock(mMutex);
+	while (true)
+	{
+		mJobAdded.wait(lock, [this]() { return mIsStopping || !mJobs.empty(); });
+		if (mJobs.empty())
+		{
+			break;
+		}
+
+		Job job = std::move(mJobs.front());
+		mJobs.pop_front();
+		lock.unlock();
+		if (job.commands)
+		{
+			PROFILE_ZONE("Execute");
+			job.commands->Execute();
+		}
+		else
+		{
+			PROFILE_ZONE("Render task");
+			job.task();
+		}
+		lock.lock();
+
+		mCompletedJobs++;
+		if (job.commands)
+		{
+			mCompletedFrames++;
+		}
+		mJobDone.notify_all();
+	}
+	lock.unlock();
+
+	releaseContext();
+}
@@ -0,0 +1,438 @@
+#include "scenefile.hpp"
+#include "mappedfile.hpp"
+#include "log.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string_view>
+#include <unordered_map>
+
+namespace
+{
+	constexpr char SceneFileMagic[4] = { 'M', 'M', '3', 'S' };
+	constexpr uint32_t NoString = UINT32_MAX;
+
+	struct TextureRecord { uint32_t name, path; };
+	struct ShaderRecord { uint32_t name, code; };
+	struct MaterialRecord { uint32_t name, vertexSource, fragmentSource, texture, firstUniform, uniformCount; };
+	struct UniformRecord { uint32_t name, type; float values[16]; };
+	struct ObjectRecord { uint32_t name, vaName, matName; };
+
+	class StringTableWriter
+	{
+	public:
+		uint32_t Add(const std::string& str)
+		{
+			if (str.empty())
+			{
+				return NoString;
+			}
+			auto [it, inserted] = mIds.try_emplace(str, (uint32_t)mStrings.size());
+			if (inserted)
+			{
+				mStrings.push_back(&it->first);
+			}
+			return it->second;
+		}
+
+		// For strings known to be unique, skips the lookup. str has to outlive Serialize.
+		uint32_t AddUnique(const std::string& str)
+		{
+			if (str.empty())
+			{
+				return NoString;
+			}
+			mStrings.push_back(&str);
+			return (uint32_t)mStrings.size() - 1;
+		}
+
+		std::vector<uint8_t> Serialize() const
+		{
+			std::vector<uint32_t> offsets(mStrings.size() + 1, 0);
+			for (size_t i = 0; i < mStrings.size(); i++)
+			{
+				offsets[i + 1] = offsets[i] + (uint32_t)mStrings[i]->size();
+			}
+			size_t offsetBytes = offsets.size() * sizeof(uint32_t);
+			std::vector<uint8_t> data(offsetBytes + offsets.back());
+			memcpy(data.data(), offsets.data(), offsetBytes);
+			for (size_t i = 0; i < mStrings.size(); i++)
+			{
+				memcpy(&data[offsetBytes + offsets[i]], mStrings[i]->data(), mStrings[i]->size());
+			}
+			return data;
+		}
+
+		uint32_t GetCount() const { return (uint32_t)mStrings.size(); }
+
+	private:
+		std::unordered_map<std::string, uint32_t> mIds;
+		std::vector<const std::string*> mStrings; // in id order, keys of mIds are node based so they stay put
+	};
+
+	struct SectionData
+	{
+		uint32_t count = 0;
+		const void* data = nullptr;
+		uint64_t size = 0;
+	};
+
+	template<typename T>
+	SectionData MakeSection(const std::vector<T>& values)
+	{
+		return { (uint32_t)values.size(), values.data(), values.size() * sizeof(T) };
+	}
+
+	inline uint64_t AlignUp(uint64_t v)
+	{
+		return (v + SceneFileAlignment - 1) & ~(uint64_t)(SceneFileAlignment - 1);
+	}
+
+	class SceneFileReader
+	{
+	public:
+		bool Open(const std::string& path)
+		{
+			if (!mFile.Open(path))
+			{
+				LOG("Could not open scene file %s", path.c_str());
+				return false;
+			}
+			if (mFile.GetSize() < sizeof(SceneFileHeader))
+			{
+				LOG("Scene file %s is truncated", path.c_str());
+				return false;
+			}
+
+			mHeader = (const SceneFileHeader*)mFile.GetData();
+			if (memcmp(mHeader->magic, SceneFileMagic, 4) != 0)
+			{
+				LOG("%s is not a scene file", path.c_str());
+				return false;
+			}
+			if (mHeader->version != SceneFileVersion)
+			{
+				LOG("Scene file %s has unsupported version %u", path.c_str(), mHeader->version);
+				return false;
+			}
+			if (mHeader->fileSize != mFile.GetSize() || mHeader->sectionCount != (uint32_t)SceneSection::Count)
+			{
+				LOG("Scene file %s is corrupted", path.c_str());
+				return false;
+			}
+			for (const auto& section : mHeader->sections)
+			{
+				if (section.offset > mFile.GetSize() || section.size > mFile.GetSize() - section.offset)
+				{
+					LOG("Scene file %s is corrupted", path.c_str());
+					return false;
+				}
+			}
+			return ReadStrings();
+		}
+
+		// Returns the records of a section or nullptr when the section does not hold count whole records
+		template<typename T>
+		const T* GetSection(SceneSection type, uint32_t& count) const
+		{
+			const SceneSectionEntry& section = mHeader->sections[(uint32_t)type];
+			count = section.count;
+			if (section.size != (uint64_t)section.count * sizeof(T) || section.offset % alignof(T) != 0)
+			{
+				return nullptr;
+			}
+			return (const T*)(mFile.GetData() + section.offset);
+		}
+
+		bool GetString(uint32_t id, std::string& out) const
+		{
+			if (id == NoString)
+			{
+				out.clear();
+				return true;
+			}
+			if (id >= mStrings.size())
+			{
+				return false;
+			}
+			out.assign(mStrings[id]);
+			return true;
+		}
+
+	private:
+		bool ReadStrings()
+		{
+			const SceneSectionEntry& section = mHeader->sections[(uint32_t)SceneSection::Strings];
+			uint64_t offsetBytes = ((uint64_t)section.count + 1) * sizeof(uint32_t);
+			if (section.size < offsetBytes)
+			{
+				LOG("Scene string table is corrupted");
+				return false;
+			}
+
+			const uint32_t* offsets = (const uint32_t*)(mFile.GetData() + section.offset);
+			const char* chars = (const char*)(mFile.GetData() + section.offset + offsetBytes);
+			uint64_t charBytes = section.size - offsetBytes;
+			mStrings.resize(section.count);
+			for (uint32_t i = 0; i < section.count; i++)
+			{
+				if (offsets[i] > offsets[i + 1] || offsets[i + 1] > charBytes)
+				{
+					LOG("Scene string table is corrupted");
+					return false;
+				}
+				mStrings[i] = std::string_view(chars + offsets[i], offsets[i + 1] - offsets[i]);
+			}
+			return true;
+		}
+
+	private:
+		MappedFile mFile;
+		const SceneFileHeader* mHeader = nullptr;
+		std::vector<std::string_view> mStrings;
+	};
+}
+
+void SceneEntities::Resize(size_t count)
+{
+	names.resize(count);
+	objects.resize(count);
+	translates.resize(count, glm::vec3(0.0f));
+	angles.resize(count, 0.0f);
+	axes.resize(count, glm::vec3(0.0f, 1.0f, 0.0f));
+	scales.resize(count, glm::vec3(1.0f));
+}
+
+bool WriteSceneFile(const std::string& path, const SceneFileData& scene)
+{
+	StringTableWriter strings;
+
+	std::vector<TextureRecord> textures;
+	for (const auto& texture : scene.textures)
+	{
+		textures.push_back({ strings.Add(texture.first), strings.Add(texture.second) });
+	}
+
+	std::vector<ShaderRecord> shaders;
+	for (const auto& shader : scene.shaders)
+	{
+		shaders.push_back({ strings.Add(shader.first), strings.Add(shader.second) });
+	}
+
+	std::vector<MaterialRecord> materials;
+	std::vector<UniformRecord> uniforms;
+	for (const auto& material : scene.materials)
+	{
+		materials.push_back({ strings.Add(material.name), strings.Add(material.vertexSource), strings.Add(material.fragmentSource),
+			strings.Add(material.texture), (uint32_t)uniforms.size(), (uint32_t)material.uniforms.size() });
+		for (const auto& uniform : material.uniforms)
+		{
+			UniformRecord record = { strings.Add(uniform.name), (uint32_t)uniform.type };
+			memcpy(record.values, uniform.values, sizeof(record.values));
+			uniforms.push_back(record);
+		}
+	}
+
+	std::vector<ObjectRecord> objects;
+	for (const auto& object : scene.objects)
+	{
+		objects.push_back({ strings.Add(object.name), strings.Add(object.vaName), strings.Add(object.matName) });
+	}
+
+	const SceneEntities& entities = scene.entities;
+	size_t entityCount = entities.GetCount();
+	if (entities.objects.size() != entityCount || entities.translates.size() != entityCount || entities.angles.size() != entityCount
+		|| entities.axes.size() != entityCount || entities.scales.size() != entityCount)
+	{
+		LOG("Scene entity arrays differ in size");
+		return false;
+	}
+	std::vector<uint32_t> entityNames(entityCount), entityObjects(entityCount);
+	for (size_t i = 0; i < entityCount; i++)
+	{
+		entityNames[i] = strings.AddUnique(entities.names[i]);
+		entityObjects[i] = strings.Add(entities.objects[i]);
+	}
+
+	std::vector<uint8_t> stringData = strings.Serialize();
+
+	SectionData sections[(uint32_t)SceneSection::Count];
+	sections[(uint32_t)SceneSection::Strings] = { strings.GetCount(), stringData.data(), stringData.size() };
+	sections[(uint32_t)SceneSection::Textures] = MakeSection(textures);
+	sections[(uint32_t)SceneSection::Shaders] = MakeSection(shaders);
+	sections[(uint32_t)SceneSection::Materials] = MakeSection(materials);
+	sections[(uint32_t)SceneSection::Uniforms] = MakeSection(uniforms);
+	sections[(uint32_t)SceneSection::Objects] = MakeSection(objects);
+	sections[(uint32_t)SceneSection::EntityNames] = MakeSection(entityNames);
+	sections[(uint32_t)SceneSection::EntityObjects] = MakeSection(entityObjects);
+	sections[(uint32_t)SceneSection::EntityTranslates] = MakeSection(entities.translates);
+	sections[(uint32_t)SceneSection::EntityAngles] = MakeSection(entities.angles);
+	sections[(uint32_t)SceneSection::EntityAxes] = MakeSection(entities.axes);
+	sections[(uint32_t)SceneSection::EntityScales] = MakeSection(entities.scales);
+
+	SceneFileHeader header = {};
+	memcpy(header.magic, SceneFileMagic, 4);
+	header.version = SceneFileVersion;
+	header.sectionCount = (uint32_t)SceneSection::Count;
+	uint64_t offset = AlignUp(sizeof(SceneFileHeader));
+	for (uint32_t i = 0; i < (uint32_t)SceneSection::Count; i++)
+	{
+		header.sections[i] = { i, sections[i].count, offset, sections[i].size };
+		offset = AlignUp(offset + sections[i].size);
+	}
+	header.fileSize = offset;
+
+	std::error_code ec;
+	std::filesystem::path parent = std::filesystem::path(path).parent_path();
+	if (!parent.empty())
+	{
+		std::filesystem::create_directories(parent, ec);
+	}
+
+	// write next to the target and rename, a failed save never destroys the previous scene
+	std::string tempPath = path + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file)
+		{
+			LOG("Could not create scene file %s", tempPath.c_str());
+			return false;
+		}
+
+		static const char zeros[SceneFileAlignment] = {};
+		file.write((const char*)&header, sizeof(header));
+		uint64_t pos = sizeof(header);
+		for (uint32_t i = 0; i < (uint32_t)SceneSection::Count; i++)
+		{
+			file.write(zeros, header.sections[i].offset - pos);
+			file.write((const char*)sections[i].data, sections[i].size);
+			pos = header.sections[i].offset + sections[i].size;
+		}
+		file.write(zeros, header.fileSize - pos);
+		if (!file)
+		{
+			LOG("Could not write scene file %s", tempPath.c_str());
+			return false;
+		}
+	}
+
+	std::filesystem::rename(tempPath, path, ec);
+	if (ec)
+	{
+		LOG("Could not move scene file into place: %s", ec.message().c_str());
+		std::filesystem::remove(tempPath, ec);
+		return false;
+	}
+	return true;
+}
+
+bool ReadSceneFile(const std::string& path, SceneFileData& scene)
+{
+	SceneFileReader reader;
+	if (!reader.Open(path))
+	{
+		return false;
+	}
+
+	scene = SceneFileData();
+	uint32_t count = 0;
+	bool valid = true;
+
+	if (const TextureRecord* textures = reader.GetSection<TextureRecord>(SceneSection::Textures, count))
+	{
+		scene.textures.resize(count);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			valid &= reader.GetString(textures[i].name, scene.textures[i].first) && reader.GetString(textures[i].path, scene.textures[i].second);
+		}
+	}
+	else valid = false;
+
+	if (const ShaderRecord* shaders = reader.GetSection<ShaderRecord>(SceneSection::Shaders, count))
+	{
+		scene.shaders.resize(count);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			valid &= reader.GetString(shaders[i].name, scene.shaders[i].first) && reader.GetString(shaders[i].code, scene.shaders[i].second);
+		}
+	}
+	else valid = false;
+
+	uint32_t uniformCount = 0;
+	const UniformRecord* uniforms = reader.GetSection<UniformRecord>(SceneSection::Uniforms, uniformCount);
+	if (const MaterialRecord* materials = reader.GetSection<MaterialRecord>(SceneSection::Materials, count); materials && uniforms)
+	{
+		scene.materials.resize(count);
+		for (uint32_t i = 0; i < count && valid; i++)
+		{
+			const MaterialRecord& record = materials[i];
+			SceneMaterial& material = scene.materials[i];
+			valid &= reader.GetString(record.name, material.name) && reader.GetString(record.vertexSource, material.vertexSource)
+				&& reader.GetString(record.fragmentSource, material.fragmentSource) && reader.GetString(record.texture, material.texture)
+				&& record.firstUniform <= uniformCount && record.uniformCount <= uniformCount - record.firstUniform;
+			if (!valid)
+			{
+				break;
+			}
+
+			material.uniforms.resize(record.uniformCount);
+			for (uint32_t u = 0; u < record.uniformCount; u++)
+			{
+				const UniformRecord& uniformRecord = uniforms[record.firstUniform + u];
+				SceneUniform& uniform = material.uniforms[u];
+				valid &= reader.GetString(uniformRecord.name, uniform.name) && uniformRecord.type <= (uint32_t)SceneUniformType::Mat4;
+				uniform.type = (SceneUniformType)uniformRecord.type;
+				memcpy(uniform.values, uniformRecord.values, sizeof(uniform.values));
+			}
+		}
+	}
+	else valid = false;
+
+	if (const ObjectRecord* objects = reader.GetSection<ObjectRecord>(SceneSection::Objects, count))
+	{
+		scene.objects.resize(count);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			valid &= reader.GetString(objects[i].name, scene.objects[i].name) && reader.GetString(objects[i].vaName, scene.objects[i].vaName)
+				&& reader.GetString(objects[i].matName, scene.objects[i].matName);
+		}
+	}
+	else valid = false;
+
+	uint32_t entityCount = 0, fieldCount = 0;
+	const uint32_t* names = reader.GetSection<uint32_t>(SceneSection::EntityNames, entityCount);
+	const uint32_t* objects = reader.GetSection<uint32_t>(SceneSection::EntityObjects, fieldCount);
+	valid &= names && objects && fieldCount == entityCount;
+	const glm::vec3* translates = reader.GetSection<glm::vec3>(SceneSection::EntityTranslates, fieldCount);
+	valid &= translates && fieldCount == entityCount;
+	const float* angles = reader.GetSection<float>(SceneSection::EntityAngles, fieldCount);
+	valid &= angles && fieldCount == entityCount;
+	const glm::vec3* axes = reader.GetSection<glm::vec3>(SceneSection::EntityAxes, fieldCount);
+	valid &= axes && fieldCount == entityCount;
+	const glm::vec3* scales = reader.GetSection<glm::vec3>(SceneSection::EntityScales, fieldCount);
+	valid &= scales && fieldCount == entityCount;
+
+	if (valid)
+	{
+		SceneEntities& entities = scene.entities;
+		entities.names.resize(entityCount);
+		entities.objects.resize(entityCount);
+		for (uint32_t i = 0; i < entityCount && valid; i++)
+		{
+			valid &= reader.GetString(names[i], entities.names[i]) && reader.GetString(objects[i], entities.objects[i]);
+		}
+		entities.translates.assign(translates, translates + entityCount);
+		entities.angles.assign(angles, angles + entityCount);
+		entities.axes.assign(axes, axes + entityCount);
+		entities.scales.assign(scales, scales + entityCount);
+	}
+
+	if (!valid)
+	{
+		LOG("Scene file %s is corrupted", path.c_str());
+		scene = SceneFileData();
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,100 @@
+#include "scenerenderer.hpp"
+#include "commandbuffer.hpp"
+#include "material.hpp"
+#include "shader.hpp"
+#include "texture.hpp"
+#include "vertex.hpp"
+#include "profiler.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+
+glm::mat4 ComposeModel(const glm::vec3& translate, float angle, const glm::vec3& axis, const glm::vec3& scale)
+{
+	glm::mat4 model(1.0f);
+	model = glm::translate(model, translate);
+	model = glm::rotate(model, glm::radians(angle), axis);
+	model = glm::scale(model, scale);
+	return model;
+}
+
+void UpdateModel(Entity& e)
+{
+	e.model = ComposeModel(e.translate, e.angle, e.rotate, e.scale);
+}
+
+DrawListBuilder::DrawListBuilder(const SceneResources& resources, const glm::mat4& viewProjection, FrameVector<DrawItem>& drawList)
+	: mResources(resources)
+	, mFrustum(Frustum::FromMatrix(viewProjection))
+	, mDrawList(drawList)
+	, mCulledCount(0)
+{
+}
+
+void DrawListBuilder::Add(const Entity& entity)
+{
+	// a destroyed object, material or mesh resolves to nullptr
+	const Object* object = mResources.objects.Get(entity.object);
+	const Material* material = object ? mResources.materials.Get(object->mat) : nullptr;
+	VertexArray* va = object ? mResources.vertexArrays.Get(object->va) : nullptr;
+	Shader* shader = material ? mResources.shaders.Get(material->GetShader()) : nullptr;
+	if (!va || !shader)
+	{
+		return;
+	}
+	if (va->HasBounds() && !mFrustum.IsBoxVisible(va->GetBoundsMin(), va->GetBoundsMax(), entity.model))
+	{
+		mCulledCount++;
+		return;
+	}
+	uint64_t sortKey = ((uint64_t)object->mat.index << 32) | object->va.index;
+	mDrawList.push_back({ sortKey, &entity.model, va, material, shader, mResources.textures.Get(material->GetTexture()) });
+}
+
+void DrawListBuilder::Finish()
+{
+	std::sort(mDrawList.begin(), mDrawList.end(), [](const DrawItem& a, const DrawItem& b) { return a.sortKey < b.sortKey; });
+}
+
+void RecordDrawList(CommandBuffer& commands, const FrameVector<DrawItem>& drawList, const glm::mat4& view, const glm::mat4& projection)
+{
+	PROFILE_ZONE("RecordDrawList");
+	const Material* boundMaterial = nullptr;
+	VertexArray* boundVA = nullptr;
+	for (const DrawItem& draw : drawList)
+	{
+		// every material owns its shader, so a new material always means a new program
+		if (draw.material != boundMaterial)
+		{
+			draw.shader->Bind(commands);
+			if (draw.texture)
+			{
+				draw.texture->Bind(commands);
+			}
+			else
+			{
+				commands.BindTexture(0);
+			}
+			draw.material->UpdateShaderUniforms(commands, *draw.shader);
+			draw.shader->SetUniformMat4(commands, "proj", projection);
+			draw.shader->SetUniformMat4(commands, "view", view);
+			boundMaterial = draw.material;
+		}
+		if (draw.va != boundVA)
+		{
+			draw.va->Bind(commands);
+			boundVA = draw.va;
+		}
+
+		draw.shader->SetUniformMat4(commands, "model", *draw.model);
+		draw.va->Draw(commands);
+	}
+
+	if (!drawList.empty())
+	{
+		commands.BindTexture(0);
+		commands.BindProgram(0);
+		commands.BindVertexArray(0);
+	}
+}
@@ -1,8 +1,9 @@
 #include "shader.hpp"
 #include "log.hpp"
+#include "commandbuffer.hpp"
+#include "renderthread.hpp"
 
 #include <glad/glad.h>
-#include <glm/gtc/type_ptr.hpp>
 
 #include <fstream>
 
@@ -11,6 +12,11 @@ Shader::Shader(const std::string& vertexCode, const std::string& fragmentCode)
 	mVertexShader = vertexCode;
 	mFragmentShader = fragmentCode;
 
+	RenderThread::Get().Run([this]() { Compile(); });
+}
+
+void Shader::Compile()
+{
 	mProgramId = glCreateProgram();
 	bool status = true;
 
@@ -62,6 +68,7 @@ Shader::Shader(const std::string& vertexCode, const std::string& fragmentCode)
 		else
 		{
 			LOG("Successfully linked shader program");
+			CacheUniformLocations();
 		}
 	}
 
@@ -80,86 +87,88 @@ Shader::Shader(const std::string& vertexCode, const std::string& fragmentCode)
 
 Shader::~Shader()
 {
-	glUseProgram(0);
-	glDeleteProgram(mProgramId);
-}
-
-void Shader::Bind()
-{
-	glUseProgram(mProgramId);
-}
-
-void Shader::Unbind()
-{
-	glUseProgram(0);
+	// frames recorded before may still draw with it
+	uint32_t programId = mProgramId;
+	RenderThread::Get().Post([programId]() { glDeleteProgram(programId); });
 }
 
-void Shader::SetUniformInt(const std::string& name, int val)
+void Shader::Bind(CommandBuffer& commands) const
 {
-	glUseProgram(mProgramId);
-	glUniform1i(GetUniformLocation(name), val);
+	commands.BindProgram(mProgramId);
 }
 
-void Shader::SetUniformFloat(const std::string& name, float val)
+void Shader::Unbind(CommandBuffer& commands) const
 {
-	glUseProgram(mProgramId);
-	glUniform1f(GetUniformLocation(name), val);
+	commands.BindProgram(0);
 }
 
-void Shader::SetUniformFloat2(const std::string& name, float val1, float val2)
+void Shader::SetUniformInt(CommandBuffer& commands, const std::string& name, int val) const
 {
-	glUseProgram(mProgramId);
-	glUniform2f(GetUniformLocation(name), val1, val2);
+	commands.SetUniform(GetUniformLocation(name), val);
 }
 
-void Shader::SetUniformFloat2(const std::string& name, const glm::vec2& val)
+void Shader::SetUniformFloat(CommandBuffer& commands, const std::string& name, float val) const
 {
-	SetUniformFloat2(name, val.x, val.y);
+	commands.SetUniform(GetUniformLocation(name), val);
 }
 
-void Shader::SetUniformFloat3(const std::string& name, float val1, float val2, float val3)
+void Shader::SetUniformFloat2(CommandBuffer& commands, const std::string& name, const glm::vec2& val) const
 {
-	glUseProgram(mProgramId);
-	glUniform3f(GetUniformLocation(name), val1, val2, val3);
+	commands.SetUniform(GetUniformLocation(name), val);
 }
 
-void Shader::SetUniformFloat3(const std::string& name, const glm::vec3& val)
+void Shader::SetUniformFloat3(CommandBuffer& commands, const std::string& name, const glm::vec3& val) const
 {
-	SetUniformFloat3(name, val.x, val.y, val.z);
+	commands.SetUniform(GetUniformLocation(name), val);
 }
 
-void Shader::SetUniformFloat4(const std::string& name, float val1, float val2, float val3, float val4)
+void Shader::SetUniformFloat4(CommandBuffer& commands, const std::string& name, const glm::vec4& val) const
 {
-	glUseProgram(mProgramId);
-	glUniform4f(GetUniformLocation(name), val1, val2, val3, val4);
+	commands.SetUniform(GetUniformLocation(name), val);
 }
 
-void Shader::SetUniformFloat4(const std::string& name, const glm::vec4& val)
+void Shader::SetUniformMat3(CommandBuffer& commands, const std::string& name, const glm::mat3& mat) const
 {
-	SetUniformFloat4(name, val.x, val.y, val.z, val.w);
+	commands.SetUniform(GetUniformLocation(name), mat);
 }
 
-void Shader::SetUniformMat3(const std::string& name, const glm::mat3& mat)
+void Shader::SetUniformMat4(CommandBuffer& commands, const std::string& name, const glm::mat4& mat) const
 {
-	glUseProgram(mProgramId);
-	glUniformMatrix3fv(GetUniformLocation(name), 1, GL_FALSE, glm::value_ptr(mat));
+	commands.SetUniform(GetUniformLocation(name), mat);
 }
 
-void Shader::SetUniformMat4(const std::string& name, const glm::mat4& mat)
+int Shader::GetUniformLocation(const std::string& name) const
 {
-	glUseProgram(mProgramId);
-	glUniformMatrix4fv(GetUniformLocation(name), 1, GL_FALSE, glm::value_ptr(mat));
+	auto it = mUniformLocations.find(name);
+	return it != mUniformLocations.end() ? it->second : -1;
 }
 
-int Shader::GetUniformLocation(const std::string& name)
+void Shader::CacheUniformLocations()
 {
-	auto it = mUniformLocations.find(name);
-	if (it == mUniformLocations.end())
+	// every location is looked up once after linking, recording a frame never has to ask GL
+	int count = 0;
+	glGetProgramiv(mProgramId, GL_ACTIVE_UNIFORMS, &count);
+	for (int i = 0; i < count; i++)
 	{
-		mUniformLocations[name] = glGetUniformLocation(mProgramId, name.c_str());
+		char name[256];
+		GLsizei length = 0;
+		GLint size = 0;
+		GLenum type = 0;
+		glGetActiveUniform(mProgramId, i, sizeof(name), &length, &size, &type, name);
+		std::string uniformName(name, length);
+		mUniformLocations[uniformName] = glGetUniformLocation(mProgramId, name);
+		if (uniformName.ends_with("[0]"))
+		{
+			// arrays are reported as name[0], every element and the bare name get an entry too
+			uniformName.resize(uniformName.size() - 3);
+			mUniformLocations[uniformName] = mUniformLocations[uniformName + "[0]"];
+			for (int element = 1; element < size; element++)
+			{
+				std::string elementName = uniformName + "[" + std::to_string(element) + "]";
+				mUniformLocations[elementName] = glGetUniformLocation(mProgramId, elementName.c_str());
+			}
+		}
 	}
-
-	return mUniformLocations[name];
 }
 
 bool Shader::CheckForErrors(unsigned int shaderId, std::string type)
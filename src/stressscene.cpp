@@ -0,0 +1,183 @@
+#include "stressscene.hpp"
+#include "threadpool.hpp"
+#include "log.hpp"
+
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	constexpr uint32_t MinEntitiesPerJob = 4096;
+	constexpr uint64_t ClusterStream = 0xC1A5C1A5C1A5C1A5ull; // cluster centers draw from their own sequences
+	constexpr float EntityFill = 0.4f; // of the spacing a top level entity covers
+	constexpr float ChildDistance = 2.0f; // in parent sizes
+	constexpr float MinSpin = 30.0f, MaxSpin = 180.0f; // degrees per second
+
+	// SplitMix64, one per entity so the result does not depend on how the work is split
+	class EntityRandom
+	{
+	public:
+		EntityRandom(uint64_t seed, uint64_t index)
+			: mState(seed ^ ((index + 1) * 0x9E3779B97F4A7C15ull))
+		{
+
+		}
+
+		uint64_t Next()
+		{
+			uint64_t z = (mState += 0x9E3779B97F4A7C15ull);
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+			return z ^ (z >> 31);
+		}
+
+		float Uniform() { return (Next() >> 40) * (1.0f / (1 << 24)); } // [0, 1)
+		float Uniform(float min, float max) { return min + (max - min) * Uniform(); }
+		uint32_t Index(uint32_t count) { return (uint32_t)((Next() >> 32) * count >> 32); }
+
+		float Normal()
+		{
+			float u = std::max(Uniform(), 1e-7f);
+			return std::sqrt(-2.0f * std::log(u)) * std::cos(glm::two_pi<float>() * Uniform());
+		}
+
+		glm::vec3 Direction()
+		{
+			float z = Uniform(-1.0f, 1.0f), angle = Uniform(0.0f, glm::two_pi<float>());
+			float r = std::sqrt(1.0f - z * z);
+			return glm::vec3(r * std::cos(angle), r * std::sin(angle), z);
+		}
+
+	private:
+		uint64_t mState;
+	};
+
+	// Entities per level, the top level gets just enough entities for the levels below to hold the rest
+	std::vector<uint32_t> GetLevelSizes(uint32_t entityCount, uint32_t depth, uint32_t children)
+	{
+		double perRoot = 0.0, width = 1.0;
+		for (uint32_t level = 0; level < depth; level++, width *= children)
+		{
+			perRoot += width;
+		}
+		uint32_t size = std::max(1u, (uint32_t)std::ceil(entityCount / perRoot));
+		std::vector<uint32_t> sizes;
+		for (uint32_t remaining = entityCount; remaining > 0 && sizes.size() < depth; size *= children)
+		{
+			sizes.push_back(std::min(size, remaining));
+			remaining -= sizes.back();
+		}
+		return sizes;
+	}
+}
+
+const char* GetStressLayoutName(StressLayout layout)
+{
+	switch (layout)
+	{
+	case StressLayout::Grid: return "grid";
+	case StressLayout::Random: return "random";
+	case StressLayout::Clustered: return "clustered";
+	}
+	return "";
+}
+
+bool ParseStressLayout(const std::string& name, StressLayout& layout)
+{
+	for (StressLayout candidate : { StressLayout::Grid, StressLayout::Random, StressLayout::Clustered })
+	{
+		if (name == GetStressLayoutName(candidate))
+		{
+			layout = candidate;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool GenerateStressEntities(const StressSceneSettings& settings, const std::vector<std::string>& objects, StressSceneEntities& out)
+{
+	if (objects.empty())
+	{
+		LOG("No objects to generate a stress scene with");
+		return false;
+	}
+
+	uint32_t count = settings.entityCount;
+	uint32_t children = std::max(settings.childrenPerEntity, 1u);
+	std::vector<uint32_t> levelSizes = GetLevelSizes(count, std::max(settings.hierarchyDepth, 1u), children);
+	uint32_t rootCount = levelSizes.empty() ? 0 : levelSizes[0];
+
+	SceneEntities& entities = out.entities;
+	entities.Resize(count);
+	out.spins.assign(count, 0.0f);
+
+	uint32_t gridSide = std::max(1u, (uint32_t)std::ceil(std::cbrt((double)rootCount)));
+	while ((uint64_t)gridSide * gridSide * gridSide < rootCount)
+	{
+		gridSide++; // cbrt of a cube may come out just below
+	}
+	float spacing = settings.extent / gridSide;
+	glm::vec3 corner = settings.center - glm::vec3(settings.extent * 0.5f);
+
+	std::vector<glm::vec3> clusters(std::max(settings.clusterCount, 1u));
+	for (uint32_t i = 0; i < clusters.size(); i++)
+	{
+		EntityRandom random(settings.seed ^ ClusterStream, i);
+		clusters[i] = corner + glm::vec3(random.Uniform(), random.Uniform(), random.Uniform()) * settings.extent;
+	}
+	float clusterSpread = settings.extent / (4.0f * std::cbrt((float)clusters.size()));
+
+	// levels are generated in order, each entity is placed relative to its parent of the level before
+	uint32_t levelBegin = 0, parentBegin = 0;
+	for (size_t level = 0; level < levelSizes.size(); level++)
+	{
+		uint32_t levelEnd = levelBegin + levelSizes[level];
+		ThreadPool::Get().ParallelFor(levelSizes[level], MinEntitiesPerJob, [&](uint32_t begin, uint32_t end) {
+			for (uint32_t local = begin; local < end; local++)
+			{
+				uint32_t i = levelBegin + local;
+				EntityRandom random(settings.seed, i);
+				if (level == 0)
+				{
+					glm::vec3 position;
+					switch (settings.layout)
+					{
+					case StressLayout::Grid:
+						position = corner + (glm::vec3(local % gridSide, local / gridSide % gridSide, local / (gridSide * gridSide)) + 0.5f) * spacing;
+						break;
+					case StressLayout::Random:
+						position = corner + glm::vec3(random.Uniform(), random.Uniform(), random.Uniform()) * settings.extent;
+						break;
+					case StressLayout::Clustered:
+						position = clusters[random.Index((uint32_t)clusters.size())] + glm::vec3(random.Normal(), random.Normal(), random.Normal()) * clusterSpread;
+						break;
+					}
+					entities.names[i] = settings.prefix + "/" + std::to_string(local);
+					entities.translates[i] = position;
+					entities.scales[i] = glm::vec3(spacing * EntityFill);
+				}
+				else
+				{
+					uint32_t parent = parentBegin + local / children;
+					float parentSize = entities.scales[parent].x;
+					entities.names[i] = entities.names[parent] + "/" + std::to_string(local % children);
+					entities.translates[i] = entities.translates[parent] + random.Direction() * parentSize * ChildDistance;
+					entities.scales[i] = glm::vec3(parentSize * 0.5f);
+				}
+				entities.objects[i] = objects[random.Index((uint32_t)objects.size())];
+				entities.angles[i] = random.Uniform(0.0f, 360.0f);
+				entities.axes[i] = random.Direction();
+				if (random.Uniform() < settings.dynamicRatio)
+				{
+					out.spins[i] = random.Uniform(MinSpin, MaxSpin) * (random.Uniform() < 0.5f ? -1.0f : 1.0f);
+				}
+			}
+		});
+		parentBegin = levelBegin;
+		levelBegin = levelEnd;
+	}
+	return true;
+}
@@ -0,0 +1,94 @@
+#include "stringinterner.hpp"
+#include "hash.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+	constexpr size_t BlockSize = 64 * 1024;
+}
+
+StringInterner::StringInterner()
+	: mBlockUsed(0)
+	, mBlockSize(0)
+{
+
+}
+
+StringInterner& StringInterner::Get()
+{
+	static StringInterner interner;
+	return interner;
+}
+
+size_t StringInterner::FindSlot(std::string_view str, uint64_t hash) const
+{
+	size_t mask = mTable.size() - 1;
+	for (size_t i = (size_t)hash & mask;; i = (i + 1) & mask)
+	{
+		NameId id = mTable[i];
+		if (id == InvalidName || (mHashes[id] == hash && mStrings[id] == str))
+		{
+			return i;
+		}
+	}
+}
+
+NameId StringInterner::Find(std::string_view str) const
+{
+	if (mTable.empty())
+	{
+		return InvalidName;
+	}
+	return mTable[FindSlot(str, HashString(str))];
+}
+
+NameId StringInterner::Intern(std::string_view str)
+{
+	if ((mStrings.size() + 1) * 2 > mTable.size())
+	{
+		Grow();
+	}
+
+	uint64_t hash = HashString(str);
+	size_t slot = FindSlot(str, hash);
+	if (mTable[slot] != InvalidName)
+	{
+		return mTable[slot];
+	}
+
+	// strings are copied into blocks that are never reallocated, long ones get a block of their own
+	size_t size = str.size() + 1;
+	if (mBlockUsed + size > mBlockSize)
+	{
+		mBlockSize = std::max(BlockSize, size);
+		mBlocks.push_back(std::make_unique<char[]>(mBlockSize));
+		mBlockUsed = 0;
+	}
+	char* storage = mBlocks.back().get() + mBlockUsed;
+	memcpy(storage, str.data(), str.size());
+	storage[str.size()] = '\0';
+	mBlockUsed += size;
+
+	NameId id = (NameId)mStrings.size();
+	mStrings.emplace_back(storage, str.size());
+	mHashes.push_back(hash);
+	mTable[slot] = id;
+	return id;
+}
+
+void StringInterner::Grow()
+{
+	mTable.assign(std::max<size_t>(64, mTable.size() * 2), InvalidName);
+	size_t mask = mTable.size() - 1;
+	for (NameId id = 0; id < (NameId)mStrings.size(); id++)
+	{
+		size_t i = (size_t)mHashes[id] & mask;
+		while (mTable[i] != InvalidName)
+		{
+			i = (i + 1) & mask;
+		}
+		mTable[i] = id;
+	}
+}
@@ -1,12 +1,142 @@
 #include "texture.hpp"
+#include "vfs.hpp"
+#include "mappedfile.hpp"
 #include "log.hpp"
+#include "commandbuffer.hpp"
+#include "renderthread.hpp"
 
 #include <glad/glad.h>
 
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
 #define STB_IMAGE_IMPLEMENTATION
 #include "../external/stb_image.h"
 
+void TexturePixelsDeleter::operator()(unsigned char* pixels) const
+{
+	stbi_image_free(pixels);
+}
+
+bool DecodeTexture(const std::string& path, TextureImage& image)
+{
+	VfsFile file;
+	if (!VirtualFileSystem::Get().Open(path, file))
+	{
+		return false;
+	}
+
+	int width, height, numChannels;
+	stbi_set_flip_vertically_on_load_thread(true);
+	image.pixels.reset(stbi_load_from_memory(file.GetData(), (int)file.GetSize(), &width, &height, &numChannels, 0));
+	if (!image.pixels)
+	{
+		return false;
+	}
+	image.width = (uint32_t)width;
+	image.height = (uint32_t)height;
+	image.numChannels = (uint32_t)numChannels;
+	return true;
+}
+
+namespace
+{
+	constexpr char TextureCacheMagic[4] = { 'M', 'M', '3', 'T' };
+
+	struct TextureCacheHeader
+	{
+		char magic[4]; // "MM3T"
+		uint32_t version;
+		uint32_t width;
+		uint32_t height;
+		uint32_t numChannels;
+		uint32_t reserved[3];
+	};
+}
+
+std::string GetTextureCachePath(const std::string& cacheDirectory, uint64_t sourceHash)
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.tex", (unsigned long long)sourceHash);
+	return cacheDirectory + "/" + name;
+}
+
+bool WriteTextureCache(const std::string& path, const TextureImage& image)
+{
+	if (!image.pixels)
+	{
+		return false;
+	}
+
+	TextureCacheHeader header = {};
+	memcpy(header.magic, TextureCacheMagic, 4);
+	header.version = TextureCacheVersion;
+	header.width = image.width;
+	header.height = image.height;
+	header.numChannels = image.numChannels;
+
+	std::error_code ec;
+	std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+
+	std::string tempPath = path + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		file.write((const char*)&header, sizeof(header));
+		file.write((const char*)image.pixels.get(), (size_t)image.width * image.height * image.numChannels);
+		if (!file)
+		{
+			LOG("Could not write texture cache %s", tempPath.c_str());
+			return false;
+		}
+	}
+
+	std::filesystem::rename(tempPath, path, ec);
+	if (ec)
+	{
+		std::filesystem::remove(tempPath, ec);
+		return false;
+	}
+	return true;
+}
+
+bool ReadTextureCache(const std::string& path, TextureImage& image)
+{
+	MappedFile file;
+	if (!file.Open(path) || file.GetSize() < sizeof(TextureCacheHeader))
+	{
+		return false;
+	}
+
+	const TextureCacheHeader* header = (const TextureCacheHeader*)file.GetData();
+	size_t pixelBytes = (size_t)header->width * header->height * header->numChannels;
+	if (memcmp(header->magic, TextureCacheMagic, 4) != 0 || header->version != TextureCacheVersion
+		|| header->numChannels == 0 || header->numChannels > 4 || file.GetSize() != sizeof(TextureCacheHeader) + pixelBytes)
+	{
+		return false;
+	}
+
+	// malloc to match the stbi_image_free in TexturePixelsDeleter
+	image.pixels.reset((unsigned char*)malloc(pixelBytes));
+	if (!image.pixels)
+	{
+		return false;
+	}
+	memcpy(image.pixels.get(), file.GetData() + sizeof(TextureCacheHeader), pixelBytes);
+	image.width = header->width;
+	image.height = header->height;
+	image.numChannels = header->numChannels;
+	return true;
+}
+
 Texture::Texture(const std::string& path)
+	: Texture(path, TextureImage())
+{
+
+}
+
+Texture::Texture(const std::string& path, TextureImage image)
 	: mPath(path)
 	, mWidth(0)
 	, mHeight(0)
@@ -14,34 +144,33 @@ Texture::Texture(const std::string& path)
 	, mPixels(nullptr)
 	, mFilter(TextureFilter::Linear)
 {
-	int width, height, numChannels;
-	stbi_set_flip_vertically_on_load(true);
-	mPixels = stbi_load(path.c_str(), &width, &height, &numChannels, 0);
-	if (mPixels)
+	if (image.pixels || DecodeTexture(path, image))
 	{
-		mWidth = (uint32_t)width;
-		mHeight = (uint32_t)height;
-		mNumChannels = (uint32_t)numChannels;
+		mWidth = image.width;
+		mHeight = image.height;
+		mNumChannels = image.numChannels;
+		mPixels = image.pixels.release();
 	}
 
-	LoadTexture();
+	RenderThread::Get().Run([this]() { LoadTexture(); });
 }
 
 Texture::~Texture()
 {
 	stbi_image_free(mPixels);
 	mPixels = nullptr;
+	uint32_t id = mId;
+	RenderThread::Get().Post([id]() { glDeleteTextures(1, &id); });
 }
 
-void Texture::Bind()
+void Texture::Bind(CommandBuffer& commands) const
 {
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, mId);
+	commands.BindTexture(mId);
 }
 
-void Texture::Unbind()
+void Texture::Unbind(CommandBuffer& commands) const
 {
-	glBindTexture(GL_TEXTURE_2D, 0);
+	commands.BindTexture(0);
 }
 
 void Texture::LoadTexture()
@@ -99,9 +228,13 @@ void Texture::LoadTexture()
 void Texture::SetTextureFilter(TextureFilter filter)
 {
 	mFilter = filter;
+	RenderThread::Get().Post([id = mId, filter]() { ApplyTextureFilter(id, filter); });
+}
 
-	glBindTexture(GL_TEXTURE_2D, mId);
-	switch (mFilter)
+void Texture::ApplyTextureFilter(uint32_t id, TextureFilter filter)
+{
+	glBindTexture(GL_TEXTURE_2D, id);
+	switch (filter)
 	{
 	case TextureFilter::Linear:
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
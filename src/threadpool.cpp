@@ -0,0 +1,129 @@
+#include "threadpool.hpp"
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+ThreadPool::ThreadPool(uint32_t threadCount)
+	: mIsStopping(false)
+{
+	if (threadCount == 0)
+	{
+		uint32_t hardwareThreads = std::thread::hardware_concurrency();
+		threadCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+	}
+
+	for (uint32_t i = 0; i < threadCount; i++)
+	{
+		mThreads.emplace_back(&ThreadPool::WorkerLoop, this);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mIsStopping = true;
+	}
+	mCondition.notify_all();
+
+	for (auto& thread : mThreads)
+	{
+		thread.join();
+	}
+}
+
+ThreadPool& ThreadPool::Get()
+{
+	static ThreadPool pool;
+	return pool;
+}
+
+void ThreadPool::Submit(std::function<void()> job)
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mJobs.push_back(std::move(job));
+	}
+	mCondition.notify_one();
+}
+
+void ThreadPool::ParallelFor(uint32_t count, uint32_t minRange, const std::function<void(uint32_t begin, uint32_t end)>& fn)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	uint32_t rangeCount = std::min((count + std::max(minRange, 1u) - 1) / std::max(minRange, 1u), GetThreadCount() + 1);
+	if (rangeCount <= 1)
+	{
+		fn(0, count);
+		return;
+	}
+
+	// The ranges are claimed from a shared counter by the submitted jobs and by the caller alike, so the caller only
+	// ever helps with its own work and never picks up an unrelated job that could hold it up. A job that starts
+	// after every range is claimed finds nothing left and only touches the shared state.
+	struct State
+	{
+		std::atomic<uint32_t> next = 0;
+		uint32_t done = 0; // under mutex
+		std::mutex mutex;
+		std::condition_variable finished;
+	};
+	auto state = std::make_shared<State>();
+	uint32_t rangeSize = (count + rangeCount - 1) / rangeCount;
+	auto runRanges = [state, fn = &fn, count, rangeCount, rangeSize]() {
+		uint32_t ran = 0;
+		for (uint32_t i = state->next++; i < rangeCount; i = state->next++, ran++)
+		{
+			uint32_t begin = std::min(i * rangeSize, count);
+			uint32_t end = std::min(begin + rangeSize, count);
+			if (begin < end)
+			{
+				(*fn)(begin, end);
+			}
+		}
+		if (ran > 0)
+		{
+			std::lock_guard<std::mutex> lock(state->mutex);
+			state->done += ran;
+			if (state->done == rangeCount)
+			{
+				state->finished.notify_all();
+			}
+		}
+	};
+
+	for (uint32_t i = 1; i < rangeCount; i++)
+	{
+		Submit(runRanges);
+	}
+	runRanges();
+
+	std::unique_lock<std::mutex> lock(state->mutex);
+	state->finished.wait(lock, [&]() { return state->done == rangeCount; });
+}
+
+void ThreadPool::WorkerLoop()
+{
+	Profiler::Get().SetThreadName("Worker");
+	while (true)
+	{
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mCondition.wait(lock, [this]() { return mIsStopping || !mJobs.empty(); });
+			if (mIsStopping && mJobs.empty())
+			{
+				return;
+			}
+			job = std::move(mJobs.front());
+			mJobs.pop_front();
+		}
+		PROFILE_ZONE("Job");
+		job();
+	}
+}
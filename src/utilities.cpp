@@ -1,5 +1,9 @@
 #include "utilities.hpp"
 #include "texture.hpp"
+#include "vertex.hpp"
+#include "meshimporter.hpp"
+#include "meshcache.hpp"
+#include "vfs.hpp"
 #include "log.hpp"
 
 #include <filesystem>
@@ -7,23 +11,13 @@
 
 std::map<std::string, std::string> LoadShaders(std::string directory, std::unordered_set<std::string> extensions)
 {
-	std::filesystem::path path(directory);
 	std::map<std::string, std::string> files;
-	const std::filesystem::directory_iterator end{};
-	for (std::filesystem::directory_iterator iter{ path }; iter != end; ++iter)
+	for (const auto& path : VirtualFileSystem::Get().List(directory, extensions))
 	{
-		if (!std::filesystem::is_regular_file(*iter)) continue;
-
-		auto extension = std::filesystem::path(iter->path()).extension().string();
-		if (extensions.contains(extension))
+		std::string code;
+		if (VirtualFileSystem::Get().ReadText(path, code))
 		{
-			auto path = iter->path().string();
-
-			std::ifstream file(path);
-			std::string code = std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
-			std::string name = path.substr(path.find_last_of('\\') + 1);
-
-			files.insert({ name, code });
+			files.insert({ std::filesystem::path(path).filename().string(), std::move(code) });
 		}
 	}
 	return files;
@@ -31,8 +25,23 @@ std::map<std::string, std::string> LoadShaders(std::string directory, std::unord
 
 std::map<std::string, std::shared_ptr<Texture>> LoadTextures(std::string directory, std::unordered_set<std::string> extensions)
 {
-	std::filesystem::path path(directory);
 	std::map<std::string, std::shared_ptr<Texture>> files;
+	for (const auto& path : VirtualFileSystem::Get().List(directory, extensions))
+	{
+		files.insert({ std::filesystem::path(path).filename().string(), std::make_shared<Texture>(path) });
+	}
+	return files;
+}
+
+std::map<std::string, std::shared_ptr<VertexArray>> LoadMeshes(std::string directory, std::unordered_set<std::string> extensions)
+{
+	std::filesystem::path path(directory);
+	std::map<std::string, std::shared_ptr<VertexArray>> files;
+	if (!std::filesystem::is_directory(path))
+	{
+		return files;
+	}
+
 	const std::filesystem::directory_iterator end{};
 	for (std::filesystem::directory_iterator iter{ path }; iter != end; ++iter)
 	{
@@ -41,13 +50,20 @@ std::map<std::string, std::shared_ptr<Texture>> LoadTextures(std::string directo
 		auto extension = std::filesystem::path(iter->path()).extension().string();
 		if (extensions.contains(extension))
 		{
-			auto path = iter->path().string();
-
-			std::ifstream file(path);
-			std::shared_ptr<Texture> tex = std::make_shared<Texture>(path);
-			std::string name = path.substr(path.find_last_of('\\') + 1);
-
-			files.insert({ name, tex });
+			MeshImportStats stats;
+			bool fromCache = false;
+			auto va = LoadMeshCached(iter->path().string(), "resources/cache/meshes", &stats, &fromCache);
+			if (!va)
+			{
+				LOG("Could not import mesh %s", iter->path().string().c_str());
+				continue;
+			}
+
+			LOG("%s %s: %u vertices, %u triangles in %.3f s (%.1f MB/s, %.0f triangles/s)", fromCache ? "Loaded cached" : "Imported",
+				iter->path().filename().string().c_str(), stats.vertices, stats.triangles, stats.seconds,
+				stats.GetMegabytesPerSecond(), stats.GetTrianglesPerSecond());
+
+			files.insert({ iter->path().filename().string(), va });
 		}
 	}
 	return files;
@@ -1,23 +1,50 @@
 #include "vertex.hpp"
+#include "commandbuffer.hpp"
+#include "renderthread.hpp"
+#include "log.hpp"
 
 #include <glad/glad.h>
 
-#include <numeric>
+#include <algorithm>
+#include <string>
+
+namespace
+{
+	// "3f 2h 4i" for count and type of every attribute, n marks normalized ones
+	std::string FormatLayout(std::span<const VertexAttribute> layout)
+	{
+		std::string text;
+		for (const VertexAttribute& attribute : layout)
+		{
+			const char* types[] = { "f", "h", "i", "ub" };
+			text += (text.empty() ? "" : " ") + std::to_string(attribute.count) + types[(int)attribute.type] + (attribute.normalized ? "n" : "");
+		}
+		return text;
+	}
+}
 
 VertexArray::VertexArray()
 	: mVA(0)
 	, mEB(0)
 	, mVertexCount(0)
 	, mElementCount(0)
+	, mIndexType(GL_UNSIGNED_INT)
 	, mIsValid(false)
+	, mHasBounds(false)
+	, mBoundsMin(0.0f)
+	, mBoundsMax(0.0f)
 {
-	glGenVertexArrays(1, &mVA);
+
 }
 
 VertexArray::~VertexArray()
 {
 	mVBs.clear();
-	glDeleteVertexArrays(1, &mVA);
+	uint32_t va = mVA, eb = mEB;
+	RenderThread::Get().Post([va, eb]() {
+		glDeleteVertexArrays(1, &va);
+		glDeleteBuffers(1, &eb);
+	});
 }
 
 void VertexArray::PushBuffer(std::unique_ptr<VertexBuffer> vb)
@@ -29,103 +56,211 @@ void VertexArray::PushBuffer(std::unique_ptr<VertexBuffer> vb)
 	}
 }
 
+void VertexArray::SetBounds(const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+	mBoundsMin = boundsMin;
+	mBoundsMax = boundsMax;
+	mHasBounds = true;
+}
+
 void VertexArray::SetElements(const std::vector<uint32_t>& elements)
 {
-	mElementCount = (uint32_t)elements.size();
-	glBindVertexArray(mVA);
-	glGenBuffers(1, &mEB);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mEB);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, elements.size() * sizeof(uint32_t), &elements[0], GL_STATIC_DRAW);
-	glBindVertexArray(0);
+	SetElements(elements.data(), (uint32_t)elements.size());
 }
 
-void VertexArray::Upload()
+void VertexArray::SetElements(const uint32_t* elements, uint32_t count)
+{
+	uint32_t maxIndex = 0;
+	for (uint32_t i = 0; i < count; i++)
+	{
+		maxIndex = std::max(maxIndex, elements[i]);
+	}
+
+	if (maxIndex <= UINT16_MAX)
+	{
+		std::vector<uint16_t> shortElements(elements, elements + count);
+		UploadElements(shortElements.data(), count, GL_UNSIGNED_SHORT, sizeof(uint16_t));
+	}
+	else
+	{
+		UploadElements(elements, count, GL_UNSIGNED_INT, sizeof(uint32_t));
+	}
+}
+
+void VertexArray::SetElements(const uint16_t* elements, uint32_t count)
+{
+	UploadElements(elements, count, GL_UNSIGNED_SHORT, sizeof(uint16_t));
+}
+
+void VertexArray::UploadElements(const void* elements, uint32_t count, uint32_t indexType, uint32_t indexSize)
 {
-	glBindVertexArray(mVA);
-	uint32_t attributeIndex = 0;
-	for (auto& vb : mVBs) {
-		if (!vb->IsUploaded()) {
-			vb->Upload(false);
+	mElementCount = count;
+	mIndexType = indexType;
+	RenderThread::Get().Run([&]() {
+		if (mVA == 0)
+		{
+			glGenVertexArrays(1, &mVA);
+		}
+		glBindVertexArray(mVA);
+		if (mEB == 0)
+		{
+			glGenBuffers(1, &mEB);
 		}
-		vb->Bind();
-		uint32_t offset = 0;
-		for (uint32_t attribSize : vb->GetLayout())
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mEB);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)count * indexSize, elements, GL_STATIC_DRAW);
+		glBindVertexArray(0);
+	});
+}
+
+void VertexArray::Upload()
+{
+	RenderThread::Get().Run([this]() {
+		if (mVA == 0)
 		{
-			glEnableVertexAttribArray(attributeIndex);
-			glVertexAttribPointer(attributeIndex, attribSize, GL_FLOAT, GL_FALSE, vb->GetStride(), (void*)(intptr_t)offset);
+			glGenVertexArrays(1, &mVA);
+		}
+		glBindVertexArray(mVA);
+		uint32_t attributeIndex = 0;
+		for (auto& vb : mVBs) {
+			if (!vb->IsUploaded()) {
+				vb->Upload(false);
+			}
+			glBindBuffer(GL_ARRAY_BUFFER, vb->GetId());
+			uint32_t offset = 0;
+			for (const auto& attrib : vb->GetLayout())
+			{
+				GLenum type = GL_FLOAT;
+				switch (attrib.type)
+				{
+				case VertexAttribType::HalfFloat: type = GL_HALF_FLOAT; break;
+				case VertexAttribType::Int2101010Rev: type = GL_INT_2_10_10_10_REV; break;
+				case VertexAttribType::UnsignedByte: type = GL_UNSIGNED_BYTE; break;
+				default: break;
+				}
+
+				glEnableVertexAttribArray(attributeIndex);
+				glVertexAttribPointer(attributeIndex, attrib.count, type, attrib.normalized ? GL_TRUE : GL_FALSE, vb->GetStride(), (void*)(intptr_t)offset);
 
-			attributeIndex++;
-			offset += (attribSize * sizeof(float));
+				attributeIndex++;
+				offset += attrib.GetSize();
+			}
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
 		}
-		vb->Unbind();
-	}
-	glBindVertexArray(0);
+		glBindVertexArray(0);
+	});
 	mIsValid = true;
 }
 
-void VertexArray::Bind()
+void VertexArray::Bind(CommandBuffer& commands) const
 {
-	glBindVertexArray(mVA);
+	commands.BindVertexArray(mVA);
 }
 
-void VertexArray::Unbind()
+void VertexArray::Unbind(CommandBuffer& commands) const
 {
-	glBindVertexArray(0);
+	commands.BindVertexArray(0);
+}
+
+void VertexArray::Draw(CommandBuffer& commands) const
+{
+	if (mElementCount > 0)
+	{
+		commands.DrawElements(GL_TRIANGLES, mElementCount, mIndexType);
+	}
+	else
+	{
+		commands.DrawArrays(GL_TRIANGLE_STRIP, mVertexCount);
+	}
 }
 
 VertexBuffer::VertexBuffer()
 	: mVB(0)
 	, mVertexCount(0)
-	, mPerVertexValueCount(0)
+	, mVertexSize(0)
 	, mStride(0)
 	, mIsUploaded(false)
 {
-	glGenBuffers(1, &mVB);
+
 }
 
 VertexBuffer::~VertexBuffer()
 {
-	glDeleteBuffers(1, &mVB);
+	uint32_t vb = mVB;
+	RenderThread::Get().Post([vb]() { glDeleteBuffers(1, &vb); });
 }
 
 void VertexBuffer::PushVertex(const std::vector<float>& vert)
 {
 	if (mBufferData.size() == 0)
 	{
-		mPerVertexValueCount = (uint32_t)vert.size();
+		mVertexSize = (uint32_t)(vert.size() * sizeof(float));
 	}
 
-	if (vert.size() == mPerVertexValueCount)
+	if (vert.size() * sizeof(float) == mVertexSize)
 	{
 		mVertexCount++;
-		mBufferData.insert(mBufferData.end(), vert.begin(), vert.end());
+		const uint8_t* bytes = (const uint8_t*)vert.data();
+		mBufferData.insert(mBufferData.end(), bytes, bytes + mVertexSize);
 	}
 }
 
-void VertexBuffer::Bind()
+void VertexBuffer::SetData(const void* data, uint32_t vertexCount, uint32_t vertexSize)
 {
-	glBindBuffer(GL_ARRAY_BUFFER, mVB);
+	mVertexSize = vertexSize;
+	mVertexCount = vertexCount;
+	const uint8_t* bytes = (const uint8_t*)data;
+	mBufferData.assign(bytes, bytes + (size_t)vertexCount * vertexSize);
 }
 
-void VertexBuffer::Unbind()
+void VertexBuffer::LogLayoutMismatch(std::span<const VertexAttribute> layout, uint32_t vertexSize) const
 {
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	LOG("Vertex write refused: the buffer holds [%s] vertices of %u bytes, the written ones are [%s] of %u bytes",
+		FormatLayout(mLayout).c_str(), mVertexSize, FormatLayout(layout).c_str(), vertexSize);
 }
 
 void VertexBuffer::SetLayout(const std::vector<uint32_t>& layout)
+{
+	std::vector<VertexAttribute> attributes;
+	for (uint32_t attribSize : layout)
+	{
+		attributes.push_back({ attribSize });
+	}
+	SetLayout(attributes);
+}
+
+void VertexBuffer::SetLayout(const std::vector<VertexAttribute>& layout)
 {
 	mLayout = layout;
-	mStride = std::accumulate(layout.begin(), layout.end(), (uint32_t)0);
+	mStride = 0;
+	for (const auto& attrib : layout)
+	{
+		mStride += attrib.GetSize();
+	}
 }
 
 void VertexBuffer::Upload(bool dynamic)
 {
-	mStride *= sizeof(float);
-	uint32_t size = sizeof(float) * mBufferData.size();
+	UploadData(mBufferData.data(), mBufferData.size(), dynamic);
+}
 
-	glBindBuffer(GL_ARRAY_BUFFER, mVB);
-	glBufferData(GL_ARRAY_BUFFER, size, mBufferData.data(), dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+void VertexBuffer::Upload(const void* data, uint32_t vertexCount, bool dynamic)
+{
+	mVertexCount = vertexCount;
+	mVertexSize = mStride;
+	UploadData(data, (size_t)vertexCount * mStride, dynamic);
+}
 
+void VertexBuffer::UploadData(const void* data, size_t size, bool dynamic)
+{
+	// synchronous, data only has to live until the call returns
+	RenderThread::Get().Run([&]() {
+		if (mVB == 0)
+		{
+			glGenBuffers(1, &mVB);
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, mVB);
+		glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)size, data, dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	});
 	mIsUploaded = true;
 }
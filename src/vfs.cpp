@@ -0,0 +1,329 @@
+#include "vfs.hpp"
+#include "hash.hpp"
+#include "lz4.hpp"
+#include "log.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+	constexpr char PackMagic[4] = { 'M', 'M', '3', 'P' };
+
+	inline uint64_t AlignUp(uint64_t v)
+	{
+		return (v + PackAlignment - 1) & ~(uint64_t)(PackAlignment - 1);
+	}
+}
+
+VfsFile::VfsFile()
+	: mData(nullptr)
+	, mSize(0)
+{
+
+}
+
+void VfsFile::Close()
+{
+	mMapping.Close();
+	mBuffer = {};
+	mData = nullptr;
+	mSize = 0;
+}
+
+VirtualFileSystem::VirtualFileSystem()
+	: mLooseFallback(true)
+{
+
+}
+
+VirtualFileSystem& VirtualFileSystem::Get()
+{
+	static VirtualFileSystem vfs;
+	return vfs;
+}
+
+std::string VirtualFileSystem::NormalizePath(const std::string& path)
+{
+	std::string normalized = path;
+	std::replace(normalized.begin(), normalized.end(), '\\', '/');
+	while (normalized.starts_with("./"))
+	{
+		normalized.erase(0, 2);
+	}
+	return normalized;
+}
+
+bool VirtualFileSystem::MountPack(const std::string& path)
+{
+	auto pack = std::make_unique<Pack>();
+	if (!pack->file.Open(path))
+	{
+		return false;
+	}
+
+	const uint8_t* data = pack->file.GetData();
+	uint64_t size = pack->file.GetSize();
+	const PackHeader* header = (const PackHeader*)data;
+	if (size < sizeof(PackHeader) || memcmp(header->magic, PackMagic, 4) != 0 || header->version != PackVersion)
+	{
+		LOG("%s is not a supported pack file", path.c_str());
+		return false;
+	}
+	if (header->fileSize != size || header->tocOffset > size || (uint64_t)header->entryCount * sizeof(PackEntry) > size - header->tocOffset
+		|| header->namesOffset > size || header->namesSize > size - header->namesOffset)
+	{
+		LOG("Pack file %s is corrupted", path.c_str());
+		return false;
+	}
+
+	const PackEntry* entries = (const PackEntry*)(data + header->tocOffset);
+	for (uint32_t i = 0; i < header->entryCount; i++)
+	{
+		const PackEntry& entry = entries[i];
+		if (entry.offset > size || entry.storedSize > size - entry.offset || (uint64_t)entry.nameOffset + entry.nameLength > header->namesSize)
+		{
+			LOG("Pack file %s is corrupted", path.c_str());
+			return false;
+		}
+	}
+
+	pack->header = header;
+	pack->entries = entries;
+	pack->names = (const char*)(data + header->namesOffset);
+	LOG("Mounted pack %s with %u entries", path.c_str(), header->entryCount);
+	mPacks.push_back(std::move(pack));
+	return true;
+}
+
+const PackEntry* VirtualFileSystem::Find(const std::string& normalizedPath, const Pack** pack) const
+{
+	uint64_t hash = HashString(normalizedPath);
+	for (const auto& p : mPacks)
+	{
+		const PackEntry* begin = p->entries;
+		const PackEntry* end = p->entries + p->header->entryCount;
+		const PackEntry* it = std::lower_bound(begin, end, hash, [](const PackEntry& entry, uint64_t h) { return entry.nameHash < h; });
+		for (; it != end && it->nameHash == hash; ++it)
+		{
+			if (std::string_view(p->names + it->nameOffset, it->nameLength) == normalizedPath)
+			{
+				*pack = p.get();
+				return it;
+			}
+		}
+	}
+	return nullptr;
+}
+
+bool VirtualFileSystem::Exists(const std::string& path) const
+{
+	const Pack* pack = nullptr;
+	std::error_code ec;
+	return Find(NormalizePath(path), &pack) || (mLooseFallback && std::filesystem::is_regular_file(path, ec));
+}
+
+bool VirtualFileSystem::IsPacked(const std::string& path) const
+{
+	const Pack* pack = nullptr;
+	return Find(NormalizePath(path), &pack) != nullptr;
+}
+
+bool VirtualFileSystem::Open(const std::string& path, VfsFile& file) const
+{
+	file.Close();
+
+	const Pack* pack = nullptr;
+	if (const PackEntry* entry = Find(NormalizePath(path), &pack))
+	{
+		const uint8_t* stored = pack->file.GetData() + entry->offset;
+		if (entry->flags & PackEntryCompressed)
+		{
+			file.mBuffer.resize(entry->size);
+			if (!Lz4Decompress(stored, entry->storedSize, file.mBuffer.data(), entry->size))
+			{
+				LOG("Pack entry %s is corrupted", path.c_str());
+				return false;
+			}
+			file.mData = file.mBuffer.data();
+		}
+		else
+		{
+			file.mData = stored;
+		}
+		file.mSize = entry->size;
+		return true;
+	}
+
+	if (!mLooseFallback || !file.mMapping.Open(path))
+	{
+		return false;
+	}
+	file.mData = file.mMapping.GetData();
+	file.mSize = file.mMapping.GetSize();
+	return true;
+}
+
+bool VirtualFileSystem::ReadText(const std::string& path, std::string& text) const
+{
+	VfsFile file;
+	if (!Open(path, file))
+	{
+		return false;
+	}
+	text.assign((const char*)file.GetData(), file.GetSize());
+	return true;
+}
+
+std::vector<std::string> VirtualFileSystem::List(const std::string& directory, const std::unordered_set<std::string>& extensions) const
+{
+	std::string prefix = NormalizePath(directory);
+	if (!prefix.empty() && prefix.back() != '/')
+	{
+		prefix += '/';
+	}
+
+	std::vector<std::string> files;
+	for (const auto& pack : mPacks)
+	{
+		for (uint32_t i = 0; i < pack->header->entryCount; i++)
+		{
+			std::string_view name(pack->names + pack->entries[i].nameOffset, pack->entries[i].nameLength);
+			if (name.starts_with(prefix) && name.find('/', prefix.size()) == std::string_view::npos
+				&& extensions.contains(std::filesystem::path(name).extension().string()))
+			{
+				files.emplace_back(name);
+			}
+		}
+	}
+
+	if (mLooseFallback)
+	{
+		std::error_code ec;
+		for (std::filesystem::directory_iterator iter{ directory, ec }, end; !ec && iter != end; iter.increment(ec))
+		{
+			if (iter->is_regular_file(ec) && extensions.contains(iter->path().extension().string()))
+			{
+				files.push_back(NormalizePath(iter->path().string()));
+			}
+		}
+	}
+
+	std::sort(files.begin(), files.end());
+	files.erase(std::unique(files.begin(), files.end()), files.end());
+	return files;
+}
+
+bool BuildPack(const std::string& outputPath, const std::vector<std::string>& directories, bool compress)
+{
+	std::vector<std::string> paths;
+	for (const auto& directory : directories)
+	{
+		std::error_code ec;
+		for (std::filesystem::recursive_directory_iterator iter{ directory, ec }, end; !ec && iter != end; iter.increment(ec))
+		{
+			if (iter->is_regular_file(ec))
+			{
+				paths.push_back(VirtualFileSystem::NormalizePath(iter->path().string()));
+			}
+		}
+	}
+	std::sort(paths.begin(), paths.end());
+	paths.erase(std::unique(paths.begin(), paths.end()), paths.end());
+
+	std::string tempPath = outputPath + ".tmp";
+	std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+	if (!file)
+	{
+		LOG("Could not create pack %s", tempPath.c_str());
+		return false;
+	}
+
+	PackHeader header = {};
+	memcpy(header.magic, PackMagic, 4);
+	header.version = PackVersion;
+	file.write((const char*)&header, sizeof(header));
+
+	static const char zeros[PackAlignment] = {};
+	std::vector<PackEntry> entries;
+	std::string names;
+	std::vector<uint8_t> compressed;
+	uint64_t offset = sizeof(header);
+	uint64_t totalSize = 0, totalStored = 0;
+	for (const auto& path : paths)
+	{
+		MappedFile source;
+		if (!source.Open(path))
+		{
+			LOG("Could not read %s, left out of the pack", path.c_str());
+			continue;
+		}
+
+		PackEntry entry = {};
+		entry.nameHash = HashString(path);
+		entry.nameOffset = (uint32_t)names.size();
+		entry.nameLength = (uint32_t)path.size();
+		entry.size = source.GetSize();
+		names += path;
+
+		const uint8_t* stored = source.GetData();
+		entry.storedSize = entry.size;
+		if (compress && entry.size > 0)
+		{
+			compressed.resize(Lz4CompressBound(entry.size));
+			size_t compressedSize = Lz4Compress(source.GetData(), entry.size, compressed.data(), compressed.size());
+			// only worth a decompression on load when it saves a meaningful amount
+			if (compressedSize > 0 && compressedSize < entry.size - entry.size / 8)
+			{
+				stored = compressed.data();
+				entry.storedSize = compressedSize;
+				entry.flags |= PackEntryCompressed;
+			}
+		}
+
+		uint64_t aligned = AlignUp(offset);
+		file.write(zeros, aligned - offset);
+		entry.offset = aligned;
+		file.write((const char*)stored, entry.storedSize);
+		offset = aligned + entry.storedSize;
+
+		totalSize += entry.size;
+		totalStored += entry.storedSize;
+		entries.push_back(entry);
+	}
+
+	std::sort(entries.begin(), entries.end(), [](const PackEntry& a, const PackEntry& b) { return a.nameHash < b.nameHash; });
+
+	header.entryCount = (uint32_t)entries.size();
+	header.tocOffset = AlignUp(offset);
+	file.write(zeros, header.tocOffset - offset);
+	file.write((const char*)entries.data(), entries.size() * sizeof(PackEntry));
+	header.namesOffset = header.tocOffset + entries.size() * sizeof(PackEntry);
+	header.namesSize = names.size();
+	file.write(names.data(), names.size());
+	header.fileSize = header.namesOffset + header.namesSize;
+
+	file.seekp(0);
+	file.write((const char*)&header, sizeof(header));
+	file.close();
+	if (!file)
+	{
+		LOG("Could not write pack %s", tempPath.c_str());
+		return false;
+	}
+
+	std::error_code ec;
+	std::filesystem::rename(tempPath, outputPath, ec);
+	if (ec)
+	{
+		LOG("Could not move pack into place: %s", ec.message().c_str());
+		std::filesystem::remove(tempPath, ec);
+		return false;
+	}
+
+	LOG("Packed %zu files into %s: %llu bytes stored for %llu bytes of data", entries.size(), outputPath.c_str(),
+		(unsigned long long)totalStored, (unsigned long long)totalSize);
+	return true;
+}